@@ -0,0 +1,140 @@
+#include "animation.h"
+
+#include "sprite.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include "log.h"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+static_assert(sizeof(AnimationLibrary::GpuClip) == 16, "GpuClip has to match the std430 layout");
+static_assert(sizeof(AnimationLibrary::GpuFrame) == 16, "GpuFrame has to match the std430 layout");
+
+uint32_t AnimationLibrary::addClip(const std::vector<Frame>& clipFrames, LoopMode loopMode) {
+	if (isUploaded()) {
+		LOG_CRITICAL("Animation clips have to be added before the library is uploaded");
+		throw std::runtime_error("Animation clips have to be added before the library is uploaded");
+	}
+	if (clips.size() >= Sprite::NO_CLIP) {
+		LOG_CRITICAL("Too many animation clips, sprite instances only have 16 bits for the id");
+		throw std::runtime_error("Too many animation clips");
+	}
+	if (clipFrames.empty()) {
+		LOG_CRITICAL("Animation clip has no frames");
+		throw std::runtime_error("Animation clip has no frames");
+	}
+	for (const Frame& frame : clipFrames) {
+		//the shader and getFrameAt wrap time by the clip's length, which has to be above zero
+		if (!(frame.duration > 0.0f)) {
+			LOG_CRITICAL("Animation frame duration {} is not positive", frame.duration);
+			throw std::runtime_error("Animation frame duration is not positive");
+		}
+	}
+
+	GpuClip clip{};
+	clip.firstFrame = static_cast<uint32_t>(frames.size());
+	clip.frameCount = static_cast<uint32_t>(clipFrames.size());
+	clip.loopMode = static_cast<uint32_t>(loopMode);
+
+	//end times rather than durations let the shader binary search for the frame
+	float endTime = 0.0f;
+	for (const Frame& frame : clipFrames) {
+		endTime += frame.duration;
+		GpuFrame gpuFrame{};
+		gpuFrame.uvOffset = glm::packUnorm2x16({ frame.uvRect.x, frame.uvRect.y });
+		gpuFrame.uvSize = glm::packUnorm2x16({ frame.uvRect.z, frame.uvRect.w });
+		gpuFrame.endTime = endTime;
+		frames.push_back(gpuFrame);
+	}
+	clip.duration = endTime;
+
+	clips.push_back(clip);
+	return static_cast<uint32_t>(clips.size() - 1);
+}
+
+std::vector<AnimationLibrary::Frame> AnimationLibrary::gridFrames(glm::vec4 firstRect, int columns, int count, float frameDuration) {
+	std::vector<Frame> result;
+	result.reserve(count);
+	for (int i = 0; i < count; i++) {
+		glm::vec2 offset{ firstRect.x + (i % columns) * firstRect.z, firstRect.y + (i / columns) * firstRect.w };
+		result.push_back({ { offset, firstRect.z, firstRect.w }, frameDuration });
+	}
+	return result;
+}
+
+std::unique_ptr<Buffer> AnimationLibrary::createStorageBuffer(VkCommandBuffer commandBuffer, const void* data, VkDeviceSize size,
+	std::vector<std::unique_ptr<Buffer>>& stagingBuffers) {
+	auto staging = std::make_unique<Buffer>(
+		device,
+		size,
+		1,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	staging->map();
+	staging->writeToBuffer(const_cast<void*>(data));
+
+	auto buffer = std::make_unique<Buffer>(
+		device,
+		size,
+		1,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkBufferCopy copy{};
+	copy.size = size;
+	vkCmdCopyBuffer(commandBuffer, staging->getBuffer(), buffer->getBuffer(), 1, &copy);
+	stagingBuffers.push_back(std::move(staging));
+	return buffer;
+}
+
+void AnimationLibrary::upload() {
+	assert(!isUploaded() && "Animation library already uploaded");
+
+	//descriptors can't point at empty buffers, so an unused library still gets one clip
+	if (clips.empty()) {
+		addClip({ { { 0.0f, 0.0f, 1.0f, 1.0f }, 1.0f } }, LoopMode::Once);
+	}
+
+	std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+	VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+	clipBuffer = createStorageBuffer(commandBuffer, clips.data(), sizeof(GpuClip) * clips.size(), stagingBuffers);
+	frameBuffer = createStorageBuffer(commandBuffer, frames.data(), sizeof(GpuFrame) * frames.size(), stagingBuffers);
+	device.endSingleTimeCommands(commandBuffer);
+
+	LOG_DEBUG("Uploaded {} animation clips with {} frames", clips.size(), frames.size());
+}
+
+uint32_t AnimationLibrary::getFrameAt(uint32_t clipId, float time, float startTime, float speed) const {
+	assert(clipId < clips.size() && "Invalid animation clip");
+	const GpuClip& clip = clips[clipId];
+
+	//same steps as animatedRect in sprite.vert
+	float t = (time - startTime) * speed;
+	switch (static_cast<LoopMode>(clip.loopMode)) {
+	case LoopMode::Loop:
+		t -= clip.duration * std::floor(t / clip.duration);
+		break;
+	case LoopMode::PingPong:
+		t -= 2.0f * clip.duration * std::floor(t / (2.0f * clip.duration));
+		if (t > clip.duration) t = 2.0f * clip.duration - t;
+		break;
+	default:
+		t = glm::clamp(t, 0.0f, clip.duration);
+		break;
+	}
+
+	uint32_t low = 0;
+	uint32_t high = clip.frameCount - 1;
+	while (low < high) {
+		uint32_t mid = (low + high) / 2;
+		if (frames[clip.firstFrame + mid].endTime > t) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+	return low;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "buffer.h"
+#include "device.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// sprite sheet animation clips evaluated in the vertex shader
+// clips and their frames live in two storage buffers, an animated sprite instance only
+// carries a clip id, a start time and a speed, and the shader picks the frame from the
+// frame time in the ubo. animating any number of sprites then costs no cpu per frame
+class AnimationLibrary {
+public:
+	enum class LoopMode : uint32_t { Once = 0, Loop = 1, PingPong = 2 };
+
+	struct Frame {
+		glm::vec4 uvRect;
+		float duration;
+	};
+
+	// gpu layouts, std430
+	struct GpuClip {
+		uint32_t firstFrame;
+		uint32_t frameCount;
+		uint32_t loopMode;
+		float duration;
+	};
+	struct GpuFrame {
+		uint32_t uvOffset;		// unorm16x2
+		uint32_t uvSize;		// unorm16x2
+		float endTime;			// since the start of the clip
+		uint32_t padding;
+	};
+
+	AnimationLibrary(Device& device) : device{ device } {}
+
+	AnimationLibrary(const AnimationLibrary&) = delete;
+	AnimationLibrary& operator=(const AnimationLibrary&) = delete;
+
+	// returns the clip id, clips have to be added before upload
+	uint32_t addClip(const std::vector<Frame>& frames, LoopMode loopMode);
+	// frames laid out left to right, wrapping onto the next row of the sheet
+	static std::vector<Frame> gridFrames(glm::vec4 firstRect, int columns, int count, float frameDuration);
+
+	// copies every clip to device local storage buffers, call once at load time
+	void upload();
+	bool isUploaded() const { return clipBuffer != nullptr; }
+	VkDescriptorBufferInfo getClipBufferInfo() { return clipBuffer->descriptorInfo(); }
+	VkDescriptorBufferInfo getFrameBufferInfo() { return frameBuffer->descriptorInfo(); }
+
+	// the frame the shader shows at time, for gameplay that has to follow the animation
+	uint32_t getFrameAt(uint32_t clip, float time, float startTime, float speed) const;
+	uint32_t getClipCount() const { return static_cast<uint32_t>(clips.size()); }
+
+private:
+	Device& device;
+
+	std::vector<GpuClip> clips;
+	std::vector<GpuFrame> frames;
+	std::unique_ptr<Buffer> clipBuffer;
+	std::unique_ptr<Buffer> frameBuffer;
+
+	std::unique_ptr<Buffer> createStorageBuffer(VkCommandBuffer commandBuffer, const void* data, VkDeviceSize size,
+		std::vector<std::unique_ptr<Buffer>>& stagingBuffers);
+};
@@ -0,0 +1,48 @@
+#include "assetRegistry.h"
+
+#include "log.h"
+
+template <typename T>
+AssetHandle<T> AssetRegistry::find(const std::string& key) {
+	Pool<T>& assets = pool<T>();
+	auto found = assets.byKey.find(key);
+	if (found == assets.byKey.end()) return {};
+
+	Slot<T>& loaded = assets.slots[found->second];
+	loaded.references++;
+	sharedLoads++;
+	return { found->second, loaded.generation };
+}
+
+template <typename T>
+AssetHandle<T> AssetRegistry::insert(const std::string& key, std::unique_ptr<T> asset) {
+	Pool<T>& assets = pool<T>();
+	uint32_t slot;
+	if (!assets.freeSlots.empty()) {
+		slot = assets.freeSlots.back();
+		assets.freeSlots.pop_back();
+	}
+	else {
+		slot = static_cast<uint32_t>(assets.slots.size());
+		assets.slots.emplace_back();
+	}
+	assets.slots[slot].asset = std::move(asset);
+	assets.slots[slot].references = 1;
+	assets.slots[slot].key = key;
+	assets.byKey[key] = slot;
+	return { slot, assets.slots[slot].generation };
+}
+
+TextureHandle AssetRegistry::loadTexture(const std::string& path) {
+	if (TextureHandle loaded = find<Texture>(path)) return loaded;
+
+	LOG_DEBUG("Loading texture {}", path);
+	//built before taking a slot, so a load that throws leaves nothing registered under path
+	return insert(path, std::make_unique<Texture>(device, path));
+}
+
+SpriteHandle AssetRegistry::loadSprite(const std::string& name, glm::vec4 uvRect) {
+	if (SpriteHandle loaded = find<Sprite>(name)) return loaded;
+
+	return insert(name, std::make_unique<Sprite>(uvRect));
+}
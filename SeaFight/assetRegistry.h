@@ -0,0 +1,134 @@
+#pragma once
+
+#include "deletionQueue.h"
+#include "device.h"
+#include "sprite.h"
+#include "texture.h"
+
+#include <glm/glm.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// handle to an asset of type T, copying one is copying two integers
+// the generation tells a reused slot apart from the asset that had it before, so a handle
+// kept past its asset's unload resolves to nothing instead of to whatever replaced it
+template <typename T>
+struct AssetHandle {
+	uint32_t index = ~0u;
+	uint32_t generation = 0;
+
+	explicit operator bool() const { return index != ~0u; }
+	bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const AssetHandle& other) const { return !(*this == other); }
+};
+
+using SpriteHandle = AssetHandle<Sprite>;
+using TextureHandle = AssetHandle<Texture>;
+
+// owns the loaded sprites and textures, handed out as handles
+// loading by a path or name that is already loaded returns the same asset and counts one
+// more reference. references are only counted by load and release, never by copying a
+// handle, so nothing in a frame touches them. the last release unloads the asset through the
+// renderer's deletion queue, which destroys it once no frame in flight can still use it
+// not thread safe, assets are loaded and released from the main thread
+class AssetRegistry {
+public:
+	AssetRegistry(Device& device, DeletionQueue& deletionQueue) : device{ device }, deletionQueue{ deletionQueue } {}
+
+	AssetRegistry(const AssetRegistry&) = delete;
+	AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+	TextureHandle loadTexture(const std::string& path);
+	// sprites are regions of the sprite texture, named so they can be shared
+	SpriteHandle loadSprite(const std::string& name, glm::vec4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f });
+
+	// one more reference to an asset that is already loaded
+	template <typename T>
+	void acquire(AssetHandle<T> handle) {
+		auto& slots = pool<T>().slots;
+		assert(isLoaded(handle) && "Asset has been unloaded");
+		slots[handle.index].references++;
+	}
+
+	// the last release unloads the asset, handles to it stop resolving right away
+	template <typename T>
+	void release(AssetHandle<T> handle) {
+		Pool<T>& assets = pool<T>();
+		assert(isLoaded(handle) && "Asset has been unloaded");
+		Slot<T>& slot = assets.slots[handle.index];
+		if (--slot.references > 0) return;
+
+		assets.byKey.erase(slot.key);
+		slot.key.clear();
+		slot.generation++;
+		assets.freeSlots.push_back(handle.index);
+		//std::function has to be copyable, so the deleter holds the raw pointer
+		T* asset = slot.asset.release();
+		deletionQueue.push([asset]() { delete asset; });
+		unloads++;
+	}
+
+	template <typename T>
+	bool isLoaded(AssetHandle<T> handle) const {
+		const auto& slots = pool<T>().slots;
+		return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+	}
+
+	// nullptr for handles that are empty or whose asset has been unloaded
+	template <typename T>
+	T* get(AssetHandle<T> handle) const {
+		return isLoaded(handle) ? pool<T>().slots[handle.index].asset.get() : nullptr;
+	}
+
+	// loads that found the asset already loaded, and unloads so far
+	uint32_t getSharedLoads() const { return sharedLoads; }
+	uint32_t getUnloads() const { return unloads; }
+
+private:
+	template <typename T>
+	struct Slot {
+		std::unique_ptr<T> asset;
+		// starts at one, so a default constructed handle is never loaded
+		uint32_t generation = 1;
+		uint32_t references = 0;
+		std::string key;
+	};
+
+	template <typename T>
+	struct Pool {
+		std::vector<Slot<T>> slots;
+		std::vector<uint32_t> freeSlots;
+		std::unordered_map<std::string, uint32_t> byKey;
+	};
+
+	Device& device;
+	DeletionQueue& deletionQueue;
+	Pool<Sprite> sprites;
+	Pool<Texture> textures;
+	uint32_t sharedLoads = 0;
+	uint32_t unloads = 0;
+
+	template <typename T>
+	Pool<T>& pool() {
+		if constexpr (std::is_same_v<T, Sprite>) return sprites;
+		else return textures;
+	}
+	template <typename T>
+	const Pool<T>& pool() const {
+		if constexpr (std::is_same_v<T, Sprite>) return sprites;
+		else return textures;
+	}
+
+	// the loaded asset under key with one more reference, or an empty handle
+	template <typename T>
+	AssetHandle<T> find(const std::string& key);
+	// registers an asset that has been built, with the one reference of the load
+	template <typename T>
+	AssetHandle<T> insert(const std::string& key, std::unique_ptr<T> asset);
+};
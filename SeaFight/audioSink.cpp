@@ -0,0 +1,57 @@
+#include "audioSink.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+static void writeLittleEndian(std::ofstream& file, uint32_t value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		file.put(static_cast<char>((value >> (i * 8)) & 0xff));
+	}
+}
+
+WavFileSink::WavFileSink(const std::string& path, uint32_t sampleRate) : sampleRate{ sampleRate } {
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		LOG_CRITICAL("Failed to open audio capture file {}", path);
+		throw std::runtime_error("Failed to open audio capture file!");
+	}
+	//written with a zero length now and patched once the length is known
+	writeHeader();
+}
+
+WavFileSink::~WavFileSink() {
+	file.seekp(0);
+	writeHeader();
+}
+
+void WavFileSink::writeHeader() {
+	const uint32_t channels = 2;
+	const uint32_t bytesPerSample = 2;
+	uint32_t dataBytes = framesWritten * channels * bytesPerSample;
+
+	file.write("RIFF", 4);
+	writeLittleEndian(file, 36 + dataBytes, 4);
+	file.write("WAVEfmt ", 8);
+	writeLittleEndian(file, 16, 4);
+	writeLittleEndian(file, 1, 2);		//pcm
+	writeLittleEndian(file, channels, 2);
+	writeLittleEndian(file, sampleRate, 4);
+	writeLittleEndian(file, sampleRate * channels * bytesPerSample, 4);
+	writeLittleEndian(file, channels * bytesPerSample, 2);
+	writeLittleEndian(file, bytesPerSample * 8, 2);
+	file.write("data", 4);
+	writeLittleEndian(file, dataBytes, 4);
+}
+
+void WavFileSink::write(const float* samples, uint32_t frames) {
+	pcm.resize(static_cast<size_t>(frames) * 2);
+	for (size_t i = 0; i < pcm.size(); i++) {
+		pcm[i] = static_cast<int16_t>(std::lround(std::clamp(samples[i], -1.0f, 1.0f) * 32767.0f));
+	}
+	//wav is little endian, as is every platform this builds for
+	file.write(reinterpret_cast<const char*>(pcm.data()), pcm.size() * sizeof(int16_t));
+	framesWritten += frames;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// where the mixer's output goes, one interleaved stereo block at a time
+// write is called from the mixer thread only and must not block for longer than a block lasts
+class AudioSink {
+public:
+	virtual ~AudioSink() = default;
+
+	virtual void write(const float* samples, uint32_t frames) = 0;
+};
+
+// discards everything, for running without sound hardware
+class NullSink : public AudioSink {
+public:
+	void write(const float* /*samples*/, uint32_t frames) override { written += frames; }
+
+	uint64_t getFramesWritten() const { return written; }
+
+private:
+	uint64_t written = 0;
+};
+
+// records the output into a 16 bit stereo wav file, the header is finished when the sink is destroyed
+// writes go straight to the file stream, fine for captures and tests but not for shipping
+class WavFileSink : public AudioSink {
+public:
+	WavFileSink(const std::string& path, uint32_t sampleRate);
+	~WavFileSink();
+
+	WavFileSink(const WavFileSink&) = delete;
+	WavFileSink& operator=(const WavFileSink&) = delete;
+
+	void write(const float* samples, uint32_t frames) override;
+
+private:
+	std::ofstream file;
+	uint32_t sampleRate;
+	uint32_t framesWritten = 0;
+	// conversion scratch, kept so the mixer thread doesn't allocate per block
+	std::vector<int16_t> pcm;
+
+	void writeHeader();
+};
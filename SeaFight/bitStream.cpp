@@ -0,0 +1,55 @@
+#include "bitStream.h"
+
+#include <cassert>
+
+BitWriter::BitWriter(size_t maxBytes) : maxBytes{ maxBytes } {
+	bytes.reserve(maxBytes);
+}
+
+void BitWriter::reset() {
+	bytes.clear();
+	bitCount = 0;
+	overflowed = false;
+}
+
+void BitWriter::writeBits(uint32_t value, uint32_t bits) {
+	assert(bits <= 32 && "Can't write more than 32 bits at once");
+	if (overflowed || bitCount + bits > maxBytes * 8) {
+		overflowed = true;
+		return;
+	}
+
+	for (uint32_t i = 0; i < bits; i++) {
+		if ((bitCount & 7) == 0) {
+			bytes.push_back(0);
+		}
+		if ((value >> i) & 1u) {
+			bytes[bitCount >> 3] |= static_cast<uint8_t>(1u << (bitCount & 7));
+		}
+		bitCount++;
+	}
+}
+
+uint32_t BitReader::readBits(uint32_t bits) {
+	assert(bits <= 32 && "Can't read more than 32 bits at once");
+	if (overflowed || bitPosition + bits > size * 8) {
+		overflowed = true;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	for (uint32_t i = 0; i < bits; i++) {
+		if ((data[bitPosition >> 3] >> (bitPosition & 7)) & 1u) {
+			value |= 1u << i;
+		}
+		bitPosition++;
+	}
+	return value;
+}
+
+int32_t BitReader::readSigned(uint32_t bits) {
+	uint32_t value = readBits(bits);
+	//sign extend from the top written bit
+	uint32_t sign = 1u << (bits - 1);
+	return static_cast<int32_t>((value ^ sign) - sign);
+}
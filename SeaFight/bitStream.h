@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// packs values of arbitrary bit widths back to back, lsb first
+// writes past the byte budget are dropped and flag overflow instead of growing the packet
+class BitWriter {
+public:
+	BitWriter(size_t maxBytes);
+
+	void writeBits(uint32_t value, uint32_t bits);
+	void writeBool(bool value) { writeBits(value ? 1u : 0u, 1); }
+	// two's complement in bits, value has to fit
+	void writeSigned(int32_t value, uint32_t bits) { writeBits(static_cast<uint32_t>(value), bits); }
+
+	size_t getBitCount() const { return bitCount; }
+	size_t getByteCount() const { return (bitCount + 7) / 8; }
+	size_t getRemainingBits() const { return maxBytes * 8 - bitCount; }
+	bool hasOverflowed() const { return overflowed; }
+	const uint8_t* data() const { return bytes.data(); }
+
+	void reset();
+
+private:
+	std::vector<uint8_t> bytes;
+	size_t maxBytes;
+	size_t bitCount = 0;
+	bool overflowed = false;
+};
+
+// reads what BitWriter wrote, reads past the end return zero and flag overflow
+class BitReader {
+public:
+	BitReader(const uint8_t* data, size_t size) : data{ data }, size{ size } {}
+
+	uint32_t readBits(uint32_t bits);
+	bool readBool() { return readBits(1) != 0; }
+	int32_t readSigned(uint32_t bits);
+
+	bool hasOverflowed() const { return overflowed; }
+
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t bitPosition = 0;
+	bool overflowed = false;
+};
@@ -0,0 +1,496 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+//below this, overlap is allowed to persist so resting contacts don't jitter
+static constexpr float LINEAR_SLOP = 0.005f;
+
+static float cross(glm::vec2 a, glm::vec2 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+static void computeNormals(Shape& shape) {
+	if (shape.count < 2) return;
+	for (int i = 0; i < shape.count; i++) {
+		glm::vec2 edge = shape.vertices[(i + 1) % shape.count] - shape.vertices[i];
+		shape.normals[i] = glm::normalize(glm::vec2(edge.y, -edge.x));
+	}
+}
+
+Shape Shape::circle(float radius) {
+	Shape shape{};
+	shape.vertices[0] = glm::vec2(0.0f);
+	shape.count = 1;
+	shape.radius = radius;
+	return shape;
+}
+
+Shape Shape::capsule(float halfLength, float radius) {
+	Shape shape{};
+	shape.vertices[0] = { -halfLength, 0.0f };
+	shape.vertices[1] = { halfLength, 0.0f };
+	shape.count = 2;
+	shape.radius = radius;
+	computeNormals(shape);
+	return shape;
+}
+
+Shape Shape::box(glm::vec2 halfExtents) {
+	glm::vec2 corners[4] = {
+		{ -halfExtents.x, -halfExtents.y }, { halfExtents.x, -halfExtents.y },
+		{ halfExtents.x, halfExtents.y }, { -halfExtents.x, halfExtents.y } };
+	return polygon(corners, 4);
+}
+
+Shape Shape::polygon(const glm::vec2* points, int count, float radius) {
+	assert(count >= 3 && count <= MAX_VERTICES && "Polygons need 3 to 8 points");
+
+	//monotone chain, counter clockwise
+	glm::vec2 sorted[MAX_VERTICES];
+	std::copy(points, points + count, sorted);
+	std::sort(sorted, sorted + count, [](glm::vec2 a, glm::vec2 b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+	glm::vec2 hull[MAX_VERTICES * 2];
+	int size = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		int start = size;
+		for (int i = 0; i < count; i++) {
+			glm::vec2 point = pass == 0 ? sorted[i] : sorted[count - 1 - i];
+			while (size >= start + 2 && cross(hull[size - 1] - hull[size - 2], point - hull[size - 2]) <= 0.0f) {
+				size--;
+			}
+			hull[size++] = point;
+		}
+		//the last point of each chain starts the other one
+		size--;
+	}
+	assert(size >= 3 && "Polygon points are collinear");
+
+	//centroid by area, so the origin ends up at the center of mass
+	glm::vec2 centroid{ 0.0f };
+	float area = 0.0f;
+	for (int i = 0; i < size; i++) {
+		glm::vec2 a = hull[i];
+		glm::vec2 b = hull[(i + 1) % size];
+		float triangle = cross(a, b) * 0.5f;
+		area += triangle;
+		centroid += triangle * (a + b) / 3.0f;
+	}
+	centroid /= area;
+
+	Shape shape{};
+	shape.count = size;
+	shape.radius = radius;
+	for (int i = 0; i < size; i++) {
+		shape.vertices[i] = hull[i] - centroid;
+	}
+	computeNormals(shape);
+	return shape;
+}
+
+void Shape::massProperties(float density, float& mass, float& inertia) const {
+	const float pi = 3.14159265f;
+	if (count == 1) {
+		mass = density * pi * radius * radius;
+		inertia = mass * (0.5f * radius * radius + glm::dot(vertices[0], vertices[0]));
+		return;
+	}
+	if (count == 2) {
+		//a box between the caps, the caps counted as one circle at the ends' distance
+		float halfLength = glm::length(vertices[1] - vertices[0]) * 0.5f;
+		float boxMass = density * 4.0f * halfLength * radius;
+		float capMass = density * pi * radius * radius;
+		mass = boxMass + capMass;
+		inertia = boxMass * (4.0f * halfLength * halfLength + 4.0f * radius * radius) / 12.0f
+			+ capMass * (0.5f * radius * radius + halfLength * halfLength);
+		return;
+	}
+
+	//triangle fan from the origin, which is the centroid, rounding is left out
+	float area = 0.0f;
+	float integral = 0.0f;
+	for (int i = 0; i < count; i++) {
+		glm::vec2 e1 = vertices[i];
+		glm::vec2 e2 = vertices[(i + 1) % count];
+		float d = cross(e1, e2);
+		area += 0.5f * d;
+		float intx2 = e1.x * e1.x + e2.x * e1.x + e2.x * e2.x;
+		float inty2 = e1.y * e1.y + e2.y * e1.y + e2.y * e2.y;
+		integral += (0.25f / 3.0f) * d * (intx2 + inty2);
+	}
+	mass = density * area;
+	inertia = density * integral;
+}
+
+AABB Shape::computeAABB(const Transform2D& transform) const {
+	glm::vec2 min = transform.apply(vertices[0]);
+	glm::vec2 max = min;
+	for (int i = 1; i < count; i++) {
+		glm::vec2 vertex = transform.apply(vertices[i]);
+		min = glm::min(min, vertex);
+		max = glm::max(max, vertex);
+	}
+	return { min - radius, max + radius };
+}
+
+// shape with its vertices and normals moved into world space
+struct WorldShape {
+	glm::vec2 vertices[Shape::MAX_VERTICES];
+	glm::vec2 normals[Shape::MAX_VERTICES];
+	int count;
+	float radius;
+};
+
+static WorldShape toWorld(const Shape& shape, const Transform2D& transform) {
+	WorldShape world;
+	world.count = shape.count;
+	world.radius = shape.radius;
+	for (int i = 0; i < shape.count; i++) {
+		world.vertices[i] = transform.apply(shape.vertices[i]);
+		world.normals[i] = transform.rotate(shape.normals[i]);
+	}
+	return world;
+}
+
+// the edge of a that b's core is furthest outside of
+static float findMaxSeparation(const WorldShape& a, const WorldShape& b, int& edge) {
+	float best = -FLT_MAX;
+	edge = 0;
+	for (int i = 0; i < a.count; i++) {
+		float separation = FLT_MAX;
+		for (int j = 0; j < b.count; j++) {
+			separation = std::min(separation, glm::dot(a.normals[i], b.vertices[j] - a.vertices[i]));
+		}
+		if (separation > best) {
+			best = separation;
+			edge = i;
+		}
+	}
+	return best;
+}
+
+// closest points of segments p1 q1 and p2 q2, s and t are how far along each they are
+static void segmentDistance(glm::vec2 p1, glm::vec2 q1, glm::vec2 p2, glm::vec2 q2, float& s, float& t, glm::vec2& c1, glm::vec2& c2) {
+	glm::vec2 d1 = q1 - p1;
+	glm::vec2 d2 = q2 - p2;
+	glm::vec2 r = p1 - p2;
+	float a = glm::dot(d1, d1);
+	float e = glm::dot(d2, d2);
+	float f = glm::dot(d2, r);
+	const float epsilon = 1e-12f;
+
+	if (a <= epsilon && e <= epsilon) {
+		s = t = 0.0f;
+	}
+	else if (a <= epsilon) {
+		s = 0.0f;
+		t = std::clamp(f / e, 0.0f, 1.0f);
+	}
+	else {
+		float c = glm::dot(d1, r);
+		if (e <= epsilon) {
+			t = 0.0f;
+			s = std::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else {
+			float b = glm::dot(d1, d2);
+			float denominator = a * e - b * b;
+			s = denominator > epsilon ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = std::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f) {
+				t = 1.0f;
+				s = std::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+}
+
+static Manifold collideCircles(const WorldShape& a, const WorldShape& b, float margin) {
+	Manifold manifold{};
+	glm::vec2 offset = b.vertices[0] - a.vertices[0];
+	float distance = glm::length(offset);
+	float separation = distance - a.radius - b.radius;
+	if (separation > margin) return manifold;
+
+	manifold.normal = distance > 1e-6f ? offset / distance : glm::vec2(0.0f, 1.0f);
+	glm::vec2 surfaceA = a.vertices[0] + manifold.normal * a.radius;
+	glm::vec2 surfaceB = b.vertices[0] - manifold.normal * b.radius;
+	manifold.points[0] = { 0.5f * (surfaceA + surfaceB), {}, separation, 0 };
+	manifold.pointCount = 1;
+	return manifold;
+}
+
+// a has an edge or more, b is a circle
+static Manifold collidePolygonCircle(const WorldShape& a, const WorldShape& b, float margin) {
+	Manifold manifold{};
+	glm::vec2 center = b.vertices[0];
+	float radius = a.radius + b.radius;
+
+	int edge = 0;
+	float separation = -FLT_MAX;
+	for (int i = 0; i < a.count; i++) {
+		float s = glm::dot(a.normals[i], center - a.vertices[i]);
+		if (s > separation) {
+			separation = s;
+			edge = i;
+		}
+	}
+	if (separation > radius + margin) return manifold;
+
+	glm::vec2 v1 = a.vertices[edge];
+	glm::vec2 v2 = a.vertices[(edge + 1) % a.count];
+	glm::vec2 closest;
+	if (separation <= 0.0f) {
+		//center inside the core, pushed out through the nearest face
+		manifold.normal = a.normals[edge];
+		closest = center - manifold.normal * separation;
+	}
+	else {
+		//outside, the closest feature is the face or one of its vertices
+		float u1 = glm::dot(center - v1, v2 - v1);
+		float u2 = glm::dot(center - v2, v1 - v2);
+		closest = u1 <= 0.0f ? v1 : u2 <= 0.0f ? v2 : center - a.normals[edge] * separation;
+		glm::vec2 offset = center - closest;
+		float distance = glm::length(offset);
+		if (distance - radius > margin) return manifold;
+		manifold.normal = distance > 1e-6f ? offset / distance : a.normals[edge];
+		separation = distance;
+	}
+
+	glm::vec2 surfaceA = closest + manifold.normal * a.radius;
+	glm::vec2 surfaceB = center - manifold.normal * b.radius;
+	manifold.points[0] = { 0.5f * (surfaceA + surfaceB), {}, separation - radius, static_cast<uint16_t>(edge) };
+	manifold.pointCount = 1;
+	return manifold;
+}
+
+// both have at least one edge, capsules included
+static Manifold collidePolygons(const WorldShape& a, const WorldShape& b, float margin) {
+	Manifold manifold{};
+	int edgeA, edgeB;
+	float separationA = findMaxSeparation(a, b, edgeA);
+	float separationB = findMaxSeparation(b, a, edgeB);
+	float radius = a.radius + b.radius;
+	if (std::max(separationA, separationB) > radius + margin) return manifold;
+
+	//prefer a's face unless b's is clearly better, so the choice doesn't flicker
+	const float tolerance = 0.1f * LINEAR_SLOP;
+	bool flip = separationB > separationA + tolerance;
+	const WorldShape& reference = flip ? b : a;
+	const WorldShape& incident = flip ? a : b;
+	int referenceEdge = flip ? edgeB : edgeA;
+	float separation = flip ? separationB : separationA;
+
+	glm::vec2 normal = reference.normals[referenceEdge];
+	int incidentEdge = 0;
+	float mostAnti = FLT_MAX;
+	for (int i = 0; i < incident.count; i++) {
+		float d = glm::dot(normal, incident.normals[i]);
+		if (d < mostAnti) {
+			mostAnti = d;
+			incidentEdge = i;
+		}
+	}
+
+	glm::vec2 v1 = reference.vertices[referenceEdge];
+	glm::vec2 v2 = reference.vertices[(referenceEdge + 1) % reference.count];
+	glm::vec2 w1 = incident.vertices[incidentEdge];
+	glm::vec2 w2 = incident.vertices[(incidentEdge + 1) % incident.count];
+
+	//cores apart and closest at a vertex of each, the separating axis runs between the two
+	//vertices, which no face normal covers, so it gets a single point along it
+	if (separation > 0.1f * LINEAR_SLOP) {
+		float s, t;
+		glm::vec2 closestReference, closestIncident;
+		segmentDistance(v1, v2, w1, w2, s, t, closestReference, closestIncident);
+		bool vertexVertex = (s == 0.0f || s == 1.0f) && (t == 0.0f || t == 1.0f);
+		if (vertexVertex) {
+			glm::vec2 offset = closestIncident - closestReference;
+			float distance = glm::length(offset);
+			if (distance - radius > margin || distance < 1e-6f) return manifold;
+			normal = offset / distance;
+			glm::vec2 surfaceReference = closestReference + normal * reference.radius;
+			glm::vec2 surfaceIncident = closestIncident - normal * incident.radius;
+			manifold.normal = flip ? -normal : normal;
+			manifold.points[0] = { 0.5f * (surfaceReference + surfaceIncident), {}, distance - radius,
+				static_cast<uint16_t>((referenceEdge << 8) | (incidentEdge << 4)) };
+			manifold.pointCount = 1;
+			return manifold;
+		}
+	}
+
+	//clip the incident edge to the sides of the reference face
+	glm::vec2 tangent = glm::normalize(v2 - v1);
+	glm::vec2 clipped[2] = { w1, w2 };
+	float lower = glm::dot(tangent, v1);
+	float upper = glm::dot(tangent, v2);
+	for (int side = 0; side < 2; side++) {
+		float d1 = side == 0 ? glm::dot(tangent, clipped[0]) - lower : upper - glm::dot(tangent, clipped[0]);
+		float d2 = side == 0 ? glm::dot(tangent, clipped[1]) - lower : upper - glm::dot(tangent, clipped[1]);
+		if (d1 < 0.0f && d2 < 0.0f) return manifold;
+		if (d1 < 0.0f) {
+			clipped[0] = clipped[0] + (clipped[1] - clipped[0]) * (d1 / (d1 - d2));
+		}
+		else if (d2 < 0.0f) {
+			clipped[1] = clipped[1] + (clipped[0] - clipped[1]) * (d2 / (d2 - d1));
+		}
+	}
+
+	manifold.normal = flip ? -normal : normal;
+	for (int i = 0; i < 2; i++) {
+		float coreSeparation = glm::dot(clipped[i] - v1, normal);
+		float pointSeparation = coreSeparation - radius;
+		if (pointSeparation > margin) continue;
+
+		//halfway between the two rounded surfaces
+		glm::vec2 point = clipped[i] + normal * (0.5f * (reference.radius - coreSeparation - incident.radius));
+		manifold.points[manifold.pointCount++] = { point, {}, pointSeparation,
+			static_cast<uint16_t>((referenceEdge << 8) | (incidentEdge << 4) | (flip ? 2 : 0) | i) };
+	}
+	return manifold;
+}
+
+Manifold collide(const Shape& a, const Transform2D& transformA, const Shape& b, const Transform2D& transformB, float margin) {
+	WorldShape worldA = toWorld(a, transformA);
+	WorldShape worldB = toWorld(b, transformB);
+
+	Manifold manifold;
+	if (a.count == 1 && b.count == 1) {
+		manifold = collideCircles(worldA, worldB, margin);
+	}
+	else if (b.count == 1) {
+		manifold = collidePolygonCircle(worldA, worldB, margin);
+	}
+	else if (a.count == 1) {
+		manifold = collidePolygonCircle(worldB, worldA, margin);
+		manifold.normal = -manifold.normal;
+	}
+	else {
+		manifold = collidePolygons(worldA, worldB, margin);
+	}
+
+	//points come out in world space, the solver wants them relative to each body
+	for (int i = 0; i < manifold.pointCount; i++) {
+		glm::vec2 point = manifold.points[i].anchorA;
+		manifold.points[i].anchorA = point - transformA.p;
+		manifold.points[i].anchorB = point - transformB.p;
+	}
+	return manifold;
+}
+
+// distance from point to the shape's core, and the closest point of the core
+static float coreDistance(const WorldShape& shape, glm::vec2 point, glm::vec2& closest) {
+	if (shape.count == 1) {
+		closest = shape.vertices[0];
+		return glm::distance(point, closest);
+	}
+
+	bool inside = shape.count >= 3;
+	float best = FLT_MAX;
+	for (int i = 0; i < shape.count; i++) {
+		glm::vec2 v1 = shape.vertices[i];
+		glm::vec2 v2 = shape.vertices[(i + 1) % shape.count];
+		if (glm::dot(shape.normals[i], point - v1) > 0.0f) {
+			inside = false;
+		}
+		glm::vec2 edge = v2 - v1;
+		float t = std::clamp(glm::dot(point - v1, edge) / glm::dot(edge, edge), 0.0f, 1.0f);
+		float distance = glm::distance(point, v1 + edge * t);
+		if (distance < best) {
+			best = distance;
+			closest = v1 + edge * t;
+		}
+	}
+	if (inside) {
+		closest = point;
+		return 0.0f;
+	}
+	return best;
+}
+
+// first fraction in [0, 1] where the ray enters the circle
+static bool rayCastCircle(glm::vec2 center, float radius, glm::vec2 origin, glm::vec2 translation, float& fraction) {
+	glm::vec2 offset = origin - center;
+	float a = glm::dot(translation, translation);
+	float b = glm::dot(offset, translation);
+	float c = glm::dot(offset, offset) - radius * radius;
+	float discriminant = b * b - a * c;
+	if (a < 1e-12f || discriminant < 0.0f) return false;
+	fraction = (-b - std::sqrt(discriminant)) / a;
+	return fraction >= 0.0f && fraction <= 1.0f;
+}
+
+bool castShape(const Shape& shape, const Transform2D& transform, glm::vec2 origin, glm::vec2 translation, float radius, CastHit& hit) {
+	WorldShape world = toWorld(shape, transform);
+	float totalRadius = world.radius + radius;
+
+	glm::vec2 closest;
+	float distance = coreDistance(world, origin, closest);
+	if (distance <= totalRadius) {
+		float length = glm::length(translation);
+		hit.fraction = 0.0f;
+		hit.normal = distance > 1e-6f ? (origin - closest) / distance : length > 1e-6f ? -translation / length : glm::vec2(0.0f, 1.0f);
+		hit.point = origin - hit.normal * std::min(radius, distance);
+		return true;
+	}
+
+	//the core inflated by the radius is its edges pushed out along their normals with a
+	//circle on every vertex, the first of those the ray reaches is the hit
+	float best = FLT_MAX;
+	glm::vec2 normal{ 0.0f };
+	for (int i = 0; i < world.count; i++) {
+		glm::vec2 vertex = world.vertices[i];
+		float fraction;
+		if ((world.count == 1 || totalRadius > 0.0f) && rayCastCircle(vertex, totalRadius, origin, translation, fraction) && fraction < best) {
+			best = fraction;
+			normal = glm::normalize(origin + translation * fraction - vertex);
+		}
+		if (world.count == 1) break;
+
+		glm::vec2 edgeNormal = world.normals[i];
+		float approach = glm::dot(edgeNormal, translation);
+		if (approach >= 0.0f) continue;
+		glm::vec2 start = vertex + edgeNormal * totalRadius;
+		glm::vec2 edge = world.vertices[(i + 1) % world.count] - vertex;
+		fraction = glm::dot(edgeNormal, start - origin) / approach;
+		if (fraction < 0.0f || fraction > 1.0f || fraction >= best) continue;
+		float along = glm::dot(origin + translation * fraction - start, edge);
+		if (along < 0.0f || along > glm::dot(edge, edge)) continue;
+		best = fraction;
+		normal = edgeNormal;
+	}
+	if (best > 1.0f) return false;
+
+	hit.fraction = best;
+	hit.normal = normal;
+	hit.point = origin + translation * best - normal * radius;
+	return true;
+}
+
+bool rayCastAABB(const AABB& box, glm::vec2 origin, glm::vec2 translation, float& fraction) {
+	//slabs, the ray is inside the box while it is inside both
+	float enter = 0.0f;
+	float exit = 1.0f;
+	for (int axis = 0; axis < 2; axis++) {
+		if (std::abs(translation[axis]) < 1e-12f) {
+			if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis]) return false;
+			continue;
+		}
+		float inverse = 1.0f / translation[axis];
+		float t1 = (box.min[axis] - origin[axis]) * inverse;
+		float t2 = (box.max[axis] - origin[axis]) * inverse;
+		enter = std::max(enter, std::min(t1, t2));
+		exit = std::min(exit, std::max(t1, t2));
+		if (enter > exit) return false;
+	}
+	fraction = enter;
+	return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// position and rotation of a body, the rotation kept as its cosine and sine
+struct Transform2D {
+	glm::vec2 p{ 0.0f };
+	glm::vec2 q{ 1.0f, 0.0f };
+
+	glm::vec2 rotate(glm::vec2 v) const { return { q.x * v.x - q.y * v.y, q.y * v.x + q.x * v.y }; }
+	glm::vec2 apply(glm::vec2 v) const { return p + rotate(v); }
+};
+
+struct AABB {
+	glm::vec2 min;
+	glm::vec2 max;
+
+	bool overlaps(const AABB& other) const {
+		return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+	}
+};
+
+// convex collision shape in body space, always a convex core inflated by a radius
+// circles are one vertex, capsules two and polygons three or more, so one set of collision
+// routines covers every pair. polygons are recentered on their centroid so the body origin
+// is its center of mass
+struct Shape {
+	static constexpr int MAX_VERTICES = 8;
+
+	glm::vec2 vertices[MAX_VERTICES];
+	// outward normal of the edge from vertex i to vertex i + 1
+	glm::vec2 normals[MAX_VERTICES];
+	int count = 0;
+	float radius = 0.0f;
+
+	static Shape circle(float radius);
+	// segment along the local x axis
+	static Shape capsule(float halfLength, float radius);
+	static Shape box(glm::vec2 halfExtents);
+	// convex hull of the points, at most MAX_VERTICES of them
+	static Shape polygon(const glm::vec2* points, int count, float radius = 0.0f);
+
+	// mass and rotational inertia about the origin at the given density
+	void massProperties(float density, float& mass, float& inertia) const;
+	AABB computeAABB(const Transform2D& transform) const;
+};
+
+// up to two contact points between a pair of shapes
+struct ManifoldPoint {
+	// world space offsets of the contact from each body's origin
+	glm::vec2 anchorA;
+	glm::vec2 anchorB;
+	// negative when overlapping
+	float separation;
+	// identifies the features that made the point, to carry impulses over between steps
+	uint16_t id;
+};
+
+struct Manifold {
+	// points from a to b
+	glm::vec2 normal{ 0.0f };
+	ManifoldPoint points[2];
+	int pointCount = 0;
+};
+
+// contact points between a and b, including speculative ones up to margin apart
+Manifold collide(const Shape& a, const Transform2D& transformA, const Shape& b, const Transform2D& transformB, float margin);
+
+// where a cast first touched a shape
+struct CastHit {
+	// how far along the translation, 0 to 1
+	float fraction;
+	glm::vec2 point;
+	// surface normal at the point, facing back along the cast
+	glm::vec2 normal;
+};
+
+// moves a point, or a circle when radius isn't zero, from origin by translation and finds
+// where it first touches the shape. starting out touching it is a hit at fraction 0
+bool castShape(const Shape& shape, const Transform2D& transform, glm::vec2 origin, glm::vec2 translation, float radius, CastHit& hit);
+
+// fraction where the ray enters the box, 0 when it starts inside
+bool rayCastAABB(const AABB& box, glm::vec2 origin, glm::vec2 translation, float& fraction);
@@ -0,0 +1,240 @@
+#include "debugDraw.h"
+
+#if SEAFIGHT_DEBUG_DRAW
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "log.h"
+
+#include <cassert>
+#include <stdexcept>
+
+static_assert(sizeof(DebugDraw::Vertex) == 12, "DebugDraw::Vertex must stay tightly packed");
+
+std::vector<DebugDraw::Vertex> DebugDraw::lineVertices;
+std::vector<DebugDraw::Vertex> DebugDraw::triangleVertices;
+
+void DebugDraw::line(glm::vec2 from, glm::vec2 to, glm::vec4 color) {
+	uint32_t packed = glm::packUnorm4x8(color);
+	lineVertices.push_back({ from, packed });
+	lineVertices.push_back({ to, packed });
+}
+
+void DebugDraw::arrow(glm::vec2 from, glm::vec2 to, glm::vec4 color, float headSize) {
+	glm::vec2 delta = to - from;
+	float length = glm::length(delta);
+	if (length <= 0.0f) return;
+
+	//the shaft stops where the head starts so blended colors don't double up
+	glm::vec2 direction = delta / length;
+	glm::vec2 side{ -direction.y, direction.x };
+	float head = glm::min(headSize, length);
+	glm::vec2 base = to - direction * head;
+	line(from, base, color);
+
+	uint32_t packed = glm::packUnorm4x8(color);
+	triangleVertices.push_back({ to, packed });
+	triangleVertices.push_back({ base + side * head * 0.5f, packed });
+	triangleVertices.push_back({ base - side * head * 0.5f, packed });
+}
+
+void DebugDraw::circle(glm::vec2 center, float radius, glm::vec4 color) {
+	uint32_t packed = glm::packUnorm4x8(color);
+	glm::vec2 previous = center + glm::vec2(radius, 0.0f);
+	for (int i = 1; i <= CIRCLE_SEGMENTS; i++) {
+		float angle = glm::two_pi<float>() * i / CIRCLE_SEGMENTS;
+		glm::vec2 next = center + radius * glm::vec2(glm::cos(angle), glm::sin(angle));
+		lineVertices.push_back({ previous, packed });
+		lineVertices.push_back({ next, packed });
+		previous = next;
+	}
+}
+
+void DebugDraw::solidCircle(glm::vec2 center, float radius, glm::vec4 color) {
+	uint32_t packed = glm::packUnorm4x8(color);
+	glm::vec2 previous = center + glm::vec2(radius, 0.0f);
+	for (int i = 1; i <= CIRCLE_SEGMENTS; i++) {
+		float angle = glm::two_pi<float>() * i / CIRCLE_SEGMENTS;
+		glm::vec2 next = center + radius * glm::vec2(glm::cos(angle), glm::sin(angle));
+		triangleVertices.push_back({ center, packed });
+		triangleVertices.push_back({ previous, packed });
+		triangleVertices.push_back({ next, packed });
+		previous = next;
+	}
+}
+
+void DebugDraw::aabb(glm::vec2 min, glm::vec2 max, glm::vec4 color) {
+	line(min, { max.x, min.y }, color);
+	line({ max.x, min.y }, max, color);
+	line(max, { min.x, max.y }, color);
+	line({ min.x, max.y }, min, color);
+}
+
+void DebugDraw::solidAabb(glm::vec2 min, glm::vec2 max, glm::vec4 color) {
+	uint32_t packed = glm::packUnorm4x8(color);
+	triangleVertices.push_back({ min, packed });
+	triangleVertices.push_back({ { max.x, min.y }, packed });
+	triangleVertices.push_back({ max, packed });
+	triangleVertices.push_back({ max, packed });
+	triangleVertices.push_back({ { min.x, max.y }, packed });
+	triangleVertices.push_back({ min, packed });
+}
+
+void DebugDraw::clear() {
+	lineVertices.clear();
+	triangleVertices.clear();
+}
+
+std::vector<VkVertexInputBindingDescription> DebugDraw::Vertex::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(Vertex);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> DebugDraw::Vertex::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[0].offset = offsetof(Vertex, position);
+
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[1].offset = offsetof(Vertex, color);
+
+	return attributeDescriptions;
+}
+
+DebugRenderer::DebugRenderer(Device& device, VkRenderPass renderPass, uint32_t initialCapacity)
+	: device{ device } {
+	for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+		createVertexBuffer(i, initialCapacity);
+	}
+	createPipelineLayout();
+	createPipelines(renderPass);
+}
+
+DebugRenderer::~DebugRenderer() {
+	vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+}
+
+void DebugRenderer::createVertexBuffer(int index, uint32_t capacity) {
+	vertexBuffers[index] = std::make_unique<Buffer>(
+		device,
+		sizeof(DebugDraw::Vertex),
+		capacity,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	vertexBuffers[index]->map();
+}
+
+void DebugRenderer::createPipelineLayout() {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::mat4);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 0;
+	pipelineLayoutInfo.pSetLayouts = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create debug pipeline layout!");
+		throw std::runtime_error("Failed to create debug pipeline layout!");
+	}
+}
+
+void DebugRenderer::createPipelines(VkRenderPass renderPass) {
+	//debug shapes are drawn over everything, blended so they don't hide what they describe
+	PipelineConfigInfo lineConfig{};
+	Pipeline::defaultPipelineConfigInfo(lineConfig);
+	lineConfig.renderPass = renderPass;
+	lineConfig.pipelineLayout = pipelineLayout;
+	lineConfig.bindingDescriptions = DebugDraw::Vertex::getBindingDescriptions();
+	lineConfig.attributeDescriptions = DebugDraw::Vertex::getAttributeDescriptions();
+	lineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+	lineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+	lineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	lineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+	lineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	lineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	lineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	lineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	linePipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/debug.vert.spv",
+		"res/shaders/debug.frag.spv",
+		lineConfig);
+
+	PipelineConfigInfo triangleConfig{};
+	Pipeline::defaultPipelineConfigInfo(triangleConfig);
+	triangleConfig.renderPass = renderPass;
+	triangleConfig.pipelineLayout = pipelineLayout;
+	triangleConfig.bindingDescriptions = DebugDraw::Vertex::getBindingDescriptions();
+	triangleConfig.attributeDescriptions = DebugDraw::Vertex::getAttributeDescriptions();
+	triangleConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+	triangleConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	triangleConfig.colorBlendAttachment = lineConfig.colorBlendAttachment;
+	trianglePipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/debug.vert.spv",
+		"res/shaders/debug.frag.spv",
+		triangleConfig);
+}
+
+void DebugRenderer::upload(int index) {
+	assert(index >= 0 && index < Swapchain::MAX_FRAMES_IN_FLIGHT && "Invalid frame index");
+	frameIndex = index;
+
+	const auto& lines = DebugDraw::getLineVertices();
+	const auto& triangles = DebugDraw::getTriangleVertices();
+	lineCount = static_cast<uint32_t>(lines.size());
+	triangleCount = static_cast<uint32_t>(triangles.size());
+	uint32_t count = lineCount + triangleCount;
+	if (count == 0) return;
+
+	//the fence for this frame has been waited on, so its buffer is free to replace
+	if (count > vertexBuffers[frameIndex]->getInstanceCount()) {
+		uint32_t capacity = vertexBuffers[frameIndex]->getInstanceCount();
+		while (capacity < count) capacity *= 2;
+		createVertexBuffer(frameIndex, capacity);
+	}
+
+	//lines then triangles in the one buffer
+	vertexBuffers[frameIndex]->writeToBuffer((void*)lines.data(), sizeof(DebugDraw::Vertex) * lineCount);
+	vertexBuffers[frameIndex]->writeToBuffer(
+		(void*)triangles.data(),
+		sizeof(DebugDraw::Vertex) * triangleCount,
+		sizeof(DebugDraw::Vertex) * lineCount);
+}
+
+void DebugRenderer::draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProj) {
+	if (lineCount == 0 && triangleCount == 0) return;
+
+	VkBuffer buffers[] = { vertexBuffers[frameIndex]->getBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+	//filled shapes first so outlines drawn over them stay visible
+	if (triangleCount > 0) {
+		trianglePipeline->bind(commandBuffer);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProj);
+		vkCmdDraw(commandBuffer, triangleCount, 1, lineCount, 0);
+	}
+	if (lineCount > 0) {
+		linePipeline->bind(commandBuffer);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProj);
+		vkCmdDraw(commandBuffer, lineCount, 1, 0, 0);
+	}
+}
+
+#endif
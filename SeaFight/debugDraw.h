@@ -0,0 +1,110 @@
+#pragma once
+
+// immediate mode debug shapes for hitboxes, grid cells, velocities and the like
+// anything can queue shapes while a tick runs and they are drawn on top of the scene until
+// the next tick clears them. non dev (NDEBUG) builds compile all of it out, the DEBUG_DRAW_*
+// macros then expand to nothing and their arguments are never evaluated
+#ifndef SEAFIGHT_DEBUG_DRAW
+#ifdef NDEBUG
+#define SEAFIGHT_DEBUG_DRAW 0
+#else
+#define SEAFIGHT_DEBUG_DRAW 1
+#endif
+#endif
+
+#if SEAFIGHT_DEBUG_DRAW
+
+#include "buffer.h"
+#include "device.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#define DEBUG_DRAW_LINE(...) DebugDraw::line(__VA_ARGS__)
+#define DEBUG_DRAW_ARROW(...) DebugDraw::arrow(__VA_ARGS__)
+#define DEBUG_DRAW_CIRCLE(...) DebugDraw::circle(__VA_ARGS__)
+#define DEBUG_DRAW_SOLID_CIRCLE(...) DebugDraw::solidCircle(__VA_ARGS__)
+#define DEBUG_DRAW_AABB(...) DebugDraw::aabb(__VA_ARGS__)
+#define DEBUG_DRAW_SOLID_AABB(...) DebugDraw::solidAabb(__VA_ARGS__)
+#define DEBUG_DRAW_CLEAR() DebugDraw::clear()
+
+// shape queue, positions are in world space
+class DebugDraw {
+public:
+	struct Vertex {
+		glm::vec2 position;
+		uint32_t color;		// rgba8
+
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	static void line(glm::vec2 from, glm::vec2 to, glm::vec4 color);
+	// line with a filled head at to, headSize is the head length in world units
+	static void arrow(glm::vec2 from, glm::vec2 to, glm::vec4 color, float headSize = 0.02f);
+	static void circle(glm::vec2 center, float radius, glm::vec4 color);
+	static void solidCircle(glm::vec2 center, float radius, glm::vec4 color);
+	static void aabb(glm::vec2 min, glm::vec2 max, glm::vec4 color);
+	static void solidAabb(glm::vec2 min, glm::vec2 max, glm::vec4 color);
+
+	// drops everything queued, called at the start of every simulation tick
+	static void clear();
+
+	static const std::vector<Vertex>& getLineVertices() { return lineVertices; }
+	static const std::vector<Vertex>& getTriangleVertices() { return triangleVertices; }
+
+private:
+	static constexpr int CIRCLE_SEGMENTS = 24;
+
+	static std::vector<Vertex> lineVertices;
+	static std::vector<Vertex> triangleVertices;
+};
+
+// streams the queued shapes into a per frame mapped buffer and draws them with one line
+// list and one triangle list draw
+class DebugRenderer {
+public:
+	// pipelines are created against renderPass
+	DebugRenderer(Device& device, VkRenderPass renderPass, uint32_t initialCapacity = 4096);
+	~DebugRenderer();
+
+	DebugRenderer(const DebugRenderer&) = delete;
+	DebugRenderer& operator=(const DebugRenderer&) = delete;
+
+	// copies the queued shapes into this frame's buffer
+	void upload(int frameIndex);
+	void draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProj);
+
+private:
+	Device& device;
+
+	VkPipelineLayout pipelineLayout;
+	std::unique_ptr<Pipeline> linePipeline;
+	std::unique_ptr<Pipeline> trianglePipeline;
+
+	std::array<std::unique_ptr<Buffer>, Swapchain::MAX_FRAMES_IN_FLIGHT> vertexBuffers;
+	int frameIndex = 0;
+	uint32_t lineCount = 0;
+	uint32_t triangleCount = 0;
+
+	void createVertexBuffer(int index, uint32_t capacity);
+	void createPipelineLayout();
+	void createPipelines(VkRenderPass renderPass);
+};
+
+#else
+
+#define DEBUG_DRAW_LINE(...) ((void)0)
+#define DEBUG_DRAW_ARROW(...) ((void)0)
+#define DEBUG_DRAW_CIRCLE(...) ((void)0)
+#define DEBUG_DRAW_SOLID_CIRCLE(...) ((void)0)
+#define DEBUG_DRAW_AABB(...) ((void)0)
+#define DEBUG_DRAW_SOLID_AABB(...) ((void)0)
+#define DEBUG_DRAW_CLEAR() ((void)0)
+
+#endif
@@ -0,0 +1,26 @@
+#include "deletionQueue.h"
+
+void DeletionQueue::push(std::function<void()> deleter) {
+	entries.push_back({ submittedFrames, std::move(deleter) });
+}
+
+void DeletionQueue::pushAfterCurrentFrame(std::function<void()> deleter) {
+	entries.push_back({ submittedFrames + 1, std::move(deleter) });
+}
+
+void DeletionQueue::collect(uint64_t completedFrames) {
+	//entries are pushed in frame order, so the ready ones are all at the front. one waiting on
+	//the current frame can sit in front of plain pushes from the same frame, which only holds
+	//those back a frame
+	while (!entries.empty() && entries.front().frame <= completedFrames) {
+		entries.front().deleter();
+		entries.pop_front();
+	}
+}
+
+void DeletionQueue::flushAll() {
+	while (!entries.empty()) {
+		entries.front().deleter();
+		entries.pop_front();
+	}
+}
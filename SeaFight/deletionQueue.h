@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// defers destroying gpu objects until no frame in flight can still be using them
+// deleters are tagged with the number of frames submitted when they were pushed and run once
+// that many frames are known to have completed, so nothing has to wait for the device to idle
+class DeletionQueue {
+public:
+	DeletionQueue() = default;
+	~DeletionQueue() { flushAll(); }
+
+	DeletionQueue(const DeletionQueue&) = delete;
+	DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+	// for objects only frames already submitted can be using
+	void push(std::function<void()> deleter);
+	// for objects the frame being recorded uses as well, they also wait for that frame
+	void pushAfterCurrentFrame(std::function<void()> deleter);
+
+	void frameSubmitted() { submittedFrames++; }
+	uint64_t getSubmittedFrames() const { return submittedFrames; }
+
+	// runs every deleter whose frames have all completed
+	void collect(uint64_t completedFrames);
+	// runs everything, only safe once the device is idle
+	void flushAll();
+
+private:
+	struct Entry {
+		uint64_t frame;
+		std::function<void()> deleter;
+	};
+
+	std::deque<Entry> entries;
+	uint64_t submittedFrames = 0;
+};
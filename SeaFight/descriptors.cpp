@@ -131,6 +131,10 @@ void DescriptorPool::resetPool() {
 DescriptorWriter::DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool)
     : setLayout{setLayout}, pool{pool} {}
 
+DescriptorWriter::DescriptorWriter(
+    DescriptorSetLayout &setLayout, DescriptorPool &pool, FrameArena &arena)
+    : setLayout{setLayout}, pool{pool}, writes{arena} {}
+
 DescriptorWriter &DescriptorWriter::writeBuffer(
     uint32_t binding, VkDescriptorBufferInfo *bufferInfo) {
   assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device.h"
+#include "frameArena.h"
 
 #include <memory>
 #include <unordered_map>
@@ -84,6 +85,8 @@ class DescriptorPool {
 class DescriptorWriter {
  public:
   DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool);
+  // writes are gathered in arena instead of on the heap, for writers made while recording a frame
+  DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool, FrameArena &arena);
 
   DescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
   DescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
@@ -94,6 +97,6 @@ class DescriptorWriter {
  private:
   DescriptorSetLayout &setLayout;
   DescriptorPool &pool;
-  std::vector<VkWriteDescriptorSet> writes;
+  ArenaVector<VkWriteDescriptorSet> writes;
 };
 
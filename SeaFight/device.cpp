@@ -1,5 +1,7 @@
 #include "device.h"
 
+#include "log.h"
+
 #include <cstring>
 #include <set>
 #include <unordered_set>
@@ -13,13 +15,13 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
     void *pUserData) {
 	if (messageSeverity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
-		spdlog::warn("Validation layer: {}", pCallbackData->pMessage);
+		LOG_WARN("Validation layer: {}", pCallbackData->pMessage);
     }
 	else if (messageSeverity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
-		spdlog::critical("Validation layer: {}", pCallbackData->pMessage);
+		LOG_ERROR("Validation layer: {}", pCallbackData->pMessage);
 	}
 	else {
-		spdlog::info("Validation layer: {}", pCallbackData->pMessage);
+		LOG_INFO("Validation layer: {}", pCallbackData->pMessage);
 	}
 
   return VK_FALSE;
@@ -76,7 +78,7 @@ Device::~Device() {
 
 void Device::createInstance() {
 	if (enableValidationLayers && !checkValidationLayerSupport()) {
-		spdlog::critical("Validation alyers requested but not found");
+		LOG_CRITICAL("Validation alyers requested but not found");
 		throw std::runtime_error("validation layers requested, but not available!");
 	}
 
@@ -109,7 +111,7 @@ void Device::createInstance() {
 	}
 
 	if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
-		spdlog::critical("Failed to create instance");
+		LOG_CRITICAL("Failed to create instance");
 		throw std::runtime_error("createInstance");
 	}
 
@@ -120,10 +122,10 @@ void Device::pickPhysicalDevice() {
 	uint32_t deviceCount = 0;
 	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
 	if (deviceCount == 0) {
-		spdlog::critical("Failed to find GPU with vulkan support");
+		LOG_CRITICAL("Failed to find GPU with vulkan support");
 		throw std::runtime_error("pickPhysicalDevice");
 	}
-	spdlog::debug("Device Count: {}", deviceCount);
+	LOG_DEBUG("Device Count: {}", deviceCount);
 	std::vector<VkPhysicalDevice> devices(deviceCount);
 	vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
@@ -135,12 +137,12 @@ void Device::pickPhysicalDevice() {
 	}
 
 	if (physicalDevice == VK_NULL_HANDLE) {
-		spdlog::critical("Failed to find suitable GPU");
+		LOG_CRITICAL("Failed to find suitable GPU");
 		throw std::runtime_error("pickPhysicalDevice");
 	}
 
 	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-	spdlog::debug("Physical Device: {}", properties.deviceName);
+	LOG_DEBUG("Physical Device: {}", properties.deviceName);
 }
 
 void Device::createLogicalDevice() {
@@ -159,9 +161,15 @@ void Device::createLogicalDevice() {
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.tessellationShader = VK_TRUE;
+	//only used for profiling, so it is fine to run without it
+	deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+	enabledFeatures = deviceFeatures;
 
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -169,9 +177,17 @@ void Device::createLogicalDevice() {
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+	//optional extensions are only used for pacing, so it is fine to run without them
+	std::vector<const char*> extensions = deviceExtensions;
+	displayTimingEnabled = isDeviceExtensionAvailable(physicalDevice, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+	if (displayTimingEnabled) {
+		extensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+	}
+	LOG_DEBUG("Display timing: {}", displayTimingEnabled ? "supported" : "unsupported");
+
 	createInfo.pEnabledFeatures = &deviceFeatures;
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
 	if (enableValidationLayers) {
 		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -181,7 +197,7 @@ void Device::createLogicalDevice() {
 	}
 
 	if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device_) != VK_SUCCESS) {
-		spdlog::critical("Failed to create logical device");
+		LOG_CRITICAL("Failed to create logical device");
 		throw std::runtime_error("createLogicalDevice");
 	}
 
@@ -199,7 +215,7 @@ void Device::createCommandPool() {
 	  VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 	if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-		spdlog::critical("Failed to create command pool");
+		LOG_CRITICAL("Failed to create command pool");
 		throw std::runtime_error("createCommandPool");
 	}
 }
@@ -243,7 +259,7 @@ void Device::setupDebugMessenger() {
 		VkDebugUtilsMessengerCreateInfoEXT createInfo;
 		populateDebugMessengerCreateInfo(createInfo);
 		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
-			spdlog::critical("Failed to setup debug messenger");
+			LOG_CRITICAL("Failed to setup debug messenger");
 			throw std::runtime_error("setupDebugMessenger");
 		}
 	}
@@ -293,19 +309,19 @@ void Device::hasGflwRequiredInstanceExtensions() {
 	std::vector<VkExtensionProperties> extensions(extensionCount);
 	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
 
-	spdlog::debug("Available extensions: ");
+	LOG_DEBUG("Available extensions: ");
 	std::unordered_set<std::string> available;
 	for (const auto &extension : extensions) {
-		spdlog::debug("\t {}", extension.extensionName);
+		LOG_DEBUG("\t {}", extension.extensionName);
 		available.insert(extension.extensionName);
 	}
 
-	spdlog::debug("Required extensions:");
+	LOG_DEBUG("Required extensions:");
 	auto requiredExtensions = getRequiredExtensions();
 	for (const auto &required : requiredExtensions) {
-		spdlog::debug("\t {}", required);
+		LOG_DEBUG("\t {}", required);
 		if (available.find(required) == available.end()) {
-			spdlog::critical("Missing required glfw extension");
+			LOG_CRITICAL("Missing required glfw extension");
 			throw std::runtime_error("hasGlfwRequiredInstanceExtensions");
 		}
 	}
@@ -331,6 +347,21 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
 	return requiredExtensions.empty();
 }
 
+bool Device::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension) {
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+	for (const auto& available : availableExtensions) {
+		if (strcmp(available.extensionName, extension) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
 	QueueFamilyIndices indices;
 
@@ -402,7 +433,7 @@ VkFormat Device::findSupportedFormat(
 			return format;
 		}
 	}
-	spdlog::critical("Failed to find supported format");
+	LOG_CRITICAL("Failed to find supported format");
 	throw std::runtime_error("findSupportedFormat");
 }
 
@@ -416,7 +447,7 @@ uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
 		}
 	}
 
-	spdlog::critical("Failed to find suitable memory type");
+	LOG_CRITICAL("Failed to find suitable memory type");
 	throw std::runtime_error("findMemoryType");
 }
 
@@ -427,7 +458,7 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-		spdlog::critical("Failed to create vertex buffer");
+		LOG_CRITICAL("Failed to create vertex buffer");
 		throw std::runtime_error("createBuffer");
 	}
 
@@ -440,7 +471,7 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
 	if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-		spdlog::critical("Failed to allocate vertex buffer memory");
+		LOG_CRITICAL("Failed to allocate vertex buffer memory");
 		throw std::runtime_error("createBuffer");
 	}
 
@@ -520,7 +551,7 @@ void Device::copyBufferToImage(
 
 void Device::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory) {
 	if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
-		spdlog::critical("Failed to create image");
+		LOG_CRITICAL("Failed to create image");
 		throw std::runtime_error("createImageWithInfo");
 	}
 
@@ -533,12 +564,12 @@ void Device::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPro
 	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
 	if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		spdlog::critical("Failed to allocate image memory");
+		LOG_CRITICAL("Failed to allocate image memory");
 		throw std::runtime_error("createImageWithInfo");
 	}
 
 	if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-		spdlog::critical("Failed to bind image memory");
+		LOG_CRITICAL("Failed to bind image memory");
 		throw std::runtime_error("createImageWithInfo");
 	}
 }
@@ -549,9 +580,20 @@ bool Device::supportsBlit(VkPhysicalDevice device) {
 
 	vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_R8G8B8A8_UNORM, &formatProps);
 	if (!(formatProps.linearTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
-		spdlog::warn("Device doesn't support blitting");
+		LOG_WARN("Device doesn't support blitting");
 		supportsBlit = false;
 	}
 
 	return supportsBlit;
 }
+
+bool Device::getOptimalBlitSupport(VkFormat format, bool linearFilter) {
+	VkFormatProperties formatProps;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProps);
+
+	VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+	if (linearFilter) {
+		required |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	}
+	return (formatProps.optimalTilingFeatures & required) == required;
+}
@@ -44,6 +44,8 @@ public:
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 	QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
 	bool getBlitSupport() { return supportsBlit(physicalDevice); }
+	// whether optimal tiling images of format can be both blit source and destination
+	bool getOptimalBlitSupport(VkFormat format, bool linearFilter);
 	VkFormat findSupportedFormat(
 	  const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -67,6 +69,10 @@ public:
 	  VkDeviceMemory &imageMemory);
 
 	VkPhysicalDeviceProperties properties;
+	// optional features are only set here when the device supports them
+	VkPhysicalDeviceFeatures enabledFeatures{};
+	// VK_GOOGLE_display_timing, enabled when available for present scheduling and feedback
+	bool displayTimingEnabled = false;
 
 private:
 	VkInstance instance;
@@ -98,6 +104,7 @@ private:
 	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
 	void hasGflwRequiredInstanceExtensions();
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+	bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension);
 	SwapChainSupportDetails querySwapchainSupport(VkPhysicalDevice device);
 	bool supportsBlit(VkPhysicalDevice device);
 };
@@ -0,0 +1,53 @@
+#include "dynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "log.h"
+
+//timings read back in the first frames after a change can still be from the old scale
+static constexpr int SETTLE_FRAMES = 3;
+//frames to wait after a change before shrinking or growing again, so the new scale gets
+//measured first. shrinking reacts sooner, a frame over budget is worse than one under it
+static constexpr int SHRINK_DELAY = SETTLE_FRAMES + 10;
+static constexpr int GROW_DELAY = 30;
+//grow only with this much headroom left, to avoid bouncing around the budget
+static constexpr double GROW_THRESHOLD = 0.8;
+static constexpr float GROW_STEP = 0.05f;
+
+DynamicResolution::DynamicResolution() : scale{ maxScale } {}
+
+void DynamicResolution::update(double gpuMilliseconds) {
+	if (!enabled) return;
+
+	framesSinceChange++;
+	if (framesSinceChange <= SETTLE_FRAMES) return;
+	//plain mean over the first samples of a scale, so one spike right after a change does not
+	//count for more than the rest, then a moving average with the same 0.1 weight
+	int samples = std::min(framesSinceChange - SETTLE_FRAMES, 10);
+	smoothedMs += (gpuMilliseconds - smoothedMs) / samples;
+
+	float newScale = scale;
+	if (smoothedMs > budgetMs && framesSinceChange > SHRINK_DELAY) {
+		//fill cost scales with area, so shrink each axis by the root of the overshoot
+		float factor = static_cast<float>(std::sqrt(budgetMs / smoothedMs));
+		newScale = std::max(minScale, scale * std::max(factor, 0.85f));
+	} else if (smoothedMs < budgetMs * GROW_THRESHOLD && framesSinceChange > GROW_DELAY) {
+		newScale = std::min(maxScale, scale + GROW_STEP);
+	}
+
+	if (newScale != scale) {
+		LOG_DEBUG("Render scale {:.2f} -> {:.2f} (gpu {:.2f}ms, budget {:.2f}ms)", scale, newScale, smoothedMs, budgetMs);
+		scale = newScale;
+		framesSinceChange = 0;
+		//the average so far is of the old scale, start over on the new one
+		smoothedMs = 0.0;
+	}
+}
+
+VkExtent2D DynamicResolution::getRenderExtent(VkExtent2D outputExtent) const {
+	VkExtent2D extent;
+	extent.width = std::max(1u, static_cast<uint32_t>(outputExtent.width * scale));
+	extent.height = std::max(1u, static_cast<uint32_t>(outputExtent.height * scale));
+	return extent;
+}
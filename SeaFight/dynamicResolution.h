@@ -0,0 +1,30 @@
+#pragma once
+
+#include "utils.h"
+
+#include <vulkan/vulkan.h>
+
+// picks the internal render resolution that keeps the measured gpu frame time inside a budget
+// the scene target is allocated once at the maximum scale and only the scaled region of it
+// is rendered and upscaled, so changing the scale never reallocates anything
+class DynamicResolution {
+public:
+	DynamicResolution();
+
+	// feeds one gpu frame time sample
+	void update(double gpuMilliseconds);
+
+	float getScale() const { return scale; }
+	float getMaxScale() const { return maxScale; }
+	VkExtent2D getRenderExtent(VkExtent2D outputExtent) const;
+
+private:
+	const bool enabled = Settings::settings.value("dynamic_resolution", true);
+	const double budgetMs = Settings::settings.value("gpu_frame_budget_ms", 7.5);
+	const float minScale = Settings::settings.value("resolution_scale_min", 0.5f);
+	const float maxScale = Settings::settings.value("resolution_scale_max", 1.0f);
+
+	float scale;
+	double smoothedMs = 0.0;
+	int framesSinceChange = 0;
+};
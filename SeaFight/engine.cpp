@@ -1,11 +1,13 @@
 #include "engine.h"
 
+#include "log.h"
+
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <limits>
 
 #include <json.hpp> 
-#include <spdlog/spdlog.h>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -19,9 +21,19 @@
 struct SpriteUBO {
 	glm::mat4 proj;
 	glm::mat4 view;
+	// animation clock, the same one AnimationComponent::startTime uses
+	float time;
 };
 
+static const char* SPRITE_TEXTURE_PATH = "res/sprites/syl.png";
+
 Engine::Engine() {
+	spriteTexture = assets.loadTexture(SPRITE_TEXTURE_PATH);
+
+	//storage buffers have to exist before the descriptor sets pointing at them
+	loadAnimations();
+	animations.upload();
+
 	uboBuffers.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
 	for (int i = 0; i < uboBuffers.size(); i++) {
 		uboBuffers[i] = std::make_unique<Buffer>(
@@ -38,11 +50,14 @@ Engine::Engine() {
 		.setMaxSets(Swapchain::MAX_FRAMES_IN_FLIGHT)
 		.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT)
 		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * Swapchain::MAX_FRAMES_IN_FLIGHT)
 		.build();
 
-	auto setLayout = DescriptorSetLayout::Builder(device)
+	spriteSetLayout = DescriptorSetLayout::Builder(device)
 		.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
 		.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+		.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
 		.build();
 
 	VkSamplerCreateInfo samplerInfo{};
@@ -64,31 +79,60 @@ Engine::Engine() {
 	samplerInfo.minLod = 0.0f;
 	samplerInfo.maxLod = 0.0f;
 	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
-		spdlog::critical("Failed to create texture sampler!");
+		LOG_CRITICAL("Failed to create texture sampler!");
 		throw std::runtime_error("Failed to create texture sampler!");
 	}
 
 	descriptorSets.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
+	boundSpriteTextures.resize(Swapchain::MAX_FRAMES_IN_FLIGHT, spriteTexture);
 	VkDescriptorImageInfo imageInfo{};
 	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imageInfo.imageView = texture.getImageView();
+	imageInfo.imageView = assets.get(spriteTexture)->getImageView();
 	imageInfo.sampler = textureSampler;
+	auto clipInfo = animations.getClipBufferInfo();
+	auto frameInfo = animations.getFrameBufferInfo();
 	for (int i = 0; i < descriptorSets.size(); i++) {
 		auto bufferInfo = uboBuffers[i]->descriptorInfo();
-		DescriptorWriter(*setLayout, *spritePool)
+		DescriptorWriter(*spriteSetLayout, *spritePool)
 			.writeBuffer(0, &bufferInfo)
 			.writeImage(1, &imageInfo)
+			.writeBuffer(2, &clipInfo)
+			.writeBuffer(3, &frameInfo)
 			.build(descriptorSets[i]);
 	}
 
 
-	std::vector<VkDescriptorSetLayout> setLayouts = { setLayout->getDescriptorSetLayout() };
+	std::vector<VkDescriptorSetLayout> setLayouts = { spriteSetLayout->getDescriptorSetLayout() };
 	renderManager = std::make_unique<RenderManager>(device, renderer.getSwapChainRenderPass(), setLayouts);
+	text = std::make_unique<TextRenderer>(device, renderer.getSwapChainRenderPass());
+	skinnedRenderer = std::make_unique<SkinnedRenderer>(device, renderer.getSwapChainRenderPass(), jobs, assets.get(spriteTexture)->getImageView(), textureSampler);
+#if SEAFIGHT_DEBUG_DRAW
+	debugRenderer = std::make_unique<DebugRenderer>(device, renderer.getSwapChainRenderPass());
+#endif
 
 	loadGameObjects();
+	if (uint32_t agents = Settings::settings.value("swarm_agents", 0u)) {
+		startSwarm(agents);
+	}
+	if (uint32_t bodies = Settings::settings.value("physics_bodies", 0u)) {
+		startPhysics(bodies);
+	}
+	if (Settings::settings.value("loopback_netplay", false)) {
+		startNetplay();
+	}
+	if (Settings::settings.value("replication_test", false)) {
+		startReplication();
+	}
+	if (Settings::settings.value("audio", true)) {
+		startAudio();
+	}
+	buildFrameGraph();
 }
 
 Engine::~Engine() {
+	if (recording) {
+		recording->save(Settings::settings.value("replay_path", "last.replay"));
+	}
 	vkDestroySampler(device.device(), textureSampler, nullptr);
 }
 
@@ -96,9 +140,12 @@ void Engine::start() {
 	double lastTime = glfwGetTime(), timer = lastTime;
 	double deltaTime = 0, nowTime = 0;
 	int frames = 0, updates = 0;
-	const double delta = 1.0 / 120.0;
+	const double delta = UPDATE_DELTA;
 
 	while (!window.shouldClose()) {
+		//wait before sampling time so the frame's input is as fresh as possible
+		pacer.waitForNextFrame();
+
 		//get time
 		nowTime = glfwGetTime();
 		deltaTime += (nowTime - lastTime) / delta;
@@ -118,6 +165,7 @@ void Engine::start() {
 		if (glfwGetTime() - timer > 1.0) {
 			timer++;
 			//std::cout << "FPS: " << frames << " Updates:" << updates << std::endl;
+			framesPerSecond = frames;
 			updates = 0, frames = 0;
 		}
 	}
@@ -125,17 +173,147 @@ void Engine::start() {
 	vkDeviceWaitIdle(device.device());
 }
 
+#if SEAFIGHT_DEBUG_DRAW
+void Engine::drawDebugShapes() {
+	for (auto& obj : gameObjects) {
+		if (!obj.sprite) continue;
+
+		glm::vec2 center = obj.transform2d.translation;
+		glm::vec2 halfExtent = glm::abs(obj.transform2d.scale) * 0.5f;
+		DEBUG_DRAW_AABB(center - halfExtent, center + halfExtent, { 0.2f, 1.0f, 0.2f, 0.8f });
+
+		float radians = glm::radians(obj.transform2d.rotation);
+		glm::vec2 facing{ glm::cos(radians), glm::sin(radians) };
+		DEBUG_DRAW_ARROW(center, center + facing * halfExtent.x, { 1.0f, 0.3f, 0.2f, 1.0f });
+	}
+}
+#endif
+
+void Engine::prepareText(int frameIndex) {
+	text->begin(frameIndex);
+	floatingNumbers.draw(*text);
+
+	if (Settings::settings["dev_mode"]) {
+		TextRenderer::TextStyle style{};
+		style.size = 14.0f;
+		const auto& label = text->getLayout("FPS");
+		text->addText(label, { 8.0f, 8.0f }, style);
+		text->addNumber(framesPerSecond, { 8.0f + (label.extent.x + 1.0f) * style.size, 8.0f }, style);
+	}
+	text->upload();
+}
+
+void Engine::buildFrameGraph() {
+	VkFormat colorFormat = renderer.getSwapChainImageFormat();
+	backbuffer = frameGraph.importImage("backbuffer", colorFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+	//the scene renders into an internal target sized for the largest render scale and gets
+	//blitted onto the swapchain image, which needs transfer usage and blit support
+	scaledRendering = (renderer.getSwapChainUsage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+		device.getOptimalBlitSupport(colorFormat, false);
+	linearUpscale = device.getOptimalBlitSupport(colorFormat, true);
+	if (!scaledRendering) {
+		LOG_WARN("Swapchain images can't be blitted to, dynamic resolution is disabled");
+	}
+
+	float targetScale = scaledRendering ? resolution.getMaxScale() : 1.0f;
+	RenderGraph::ResourceId target = backbuffer;
+	if (scaledRendering) {
+		sceneColor = frameGraph.createTransient("scene color", { colorFormat, targetScale });
+		target = sceneColor;
+	}
+	auto depth = frameGraph.createTransient("depth", { renderer.getSwapChainDepthFormat(), targetScale });
+
+	//color then depth in the same formats as the swapchain render pass, so the pipelines
+	//created against that render pass stay compatible with this one
+	frameGraph.addPass("scene", [this](VkCommandBuffer commandBuffer) {
+		//only the scaled corner of the target is rendered
+		VkViewport viewport{};
+		viewport.width = static_cast<float>(frameContext.renderExtent.width);
+		viewport.height = static_cast<float>(frameContext.renderExtent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ { 0, 0 }, frameContext.renderExtent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkDescriptorSet descriptorSet = descriptorSets[frameContext.frameIndex];
+		overdraw.begin(commandBuffer, frameContext.frameIndex);
+		renderManager->renderOpaque(commandBuffer, descriptorSet);
+		skinnedRenderer->draw(commandBuffer, frameContext.viewProj);
+		renderManager->renderTilemap(commandBuffer, descriptorSet, *ocean, frameContext.viewMin, frameContext.viewMax);
+		renderManager->renderTransparent(commandBuffer, descriptorSet);
+#if SEAFIGHT_DEBUG_DRAW
+		debugRenderer->draw(commandBuffer, frameContext.viewProj);
+#endif
+		//hud is laid out in output pixels, the viewport maps them onto the scaled target
+		text->draw(commandBuffer, frameContext.viewProj, frameContext.outputExtent);
+		overdraw.end(commandBuffer, frameContext.frameIndex);
+	})
+		.writeColor(target, { 0.01f, 0.01f, 0.01f, 1.0f })
+		.writeDepth(depth, { 1.0f, 0 });
+
+	if (!scaledRendering) return;
+
+	frameGraph.addPass("upscale", [this](VkCommandBuffer commandBuffer) {
+		VkExtent2D renderExtent = frameContext.renderExtent;
+		VkExtent2D outputExtent = frameGraph.getExtent(backbuffer);
+
+		VkImageBlit blit{};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1] = { static_cast<int32_t>(outputExtent.width), static_cast<int32_t>(outputExtent.height), 1 };
+
+		//at full scale this is a straight copy, nearest keeps it pixel exact
+		bool sameSize = renderExtent.width == outputExtent.width && renderExtent.height == outputExtent.height;
+		VkFilter filter = sameSize || !linearUpscale ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+		vkCmdBlitImage(
+			commandBuffer,
+			frameGraph.getImage(sceneColor),
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			frameGraph.getImage(backbuffer),
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&blit,
+			filter);
+	})
+		.readTransfer(sceneColor)
+		.writeTransfer(backbuffer);
+}
+
+void Engine::reloadSpriteTexture() {
+	//released first, a load of a path that is still loaded would just hand back the same texture
+	//frames in flight keep sampling the old one until the deletion queue destroys it, and each
+	//frame's sets are pointed at the new one before that frame records
+	assets.release(spriteTexture);
+	spriteTexture = assets.loadTexture(SPRITE_TEXTURE_PATH);
+	LOG_INFO("Reloaded {}, {} unloads so far", SPRITE_TEXTURE_PATH, assets.getUnloads());
+}
+
+void Engine::bindSpriteTexture(int frameIndex) {
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = assets.get(spriteTexture)->getImageView();
+	imageInfo.sampler = textureSampler;
+	DescriptorWriter(*spriteSetLayout, *spritePool, renderer.getFrameArena())
+		.writeImage(1, &imageInfo)
+		.overwrite(descriptorSets[frameIndex]);
+	skinnedRenderer->setTexture(frameIndex, imageInfo.imageView, renderer.getFrameArena());
+	boundSpriteTextures[frameIndex] = spriteTexture;
+}
+
+void Engine::loadAnimations() {
+	//temp clip stepping through the quarters of the test sprite
+	krillClip = animations.addClip(
+		AnimationLibrary::gridFrames({ 0.0f, 0.0f, 0.5f, 0.5f }, 2, 4, 0.15f),
+		AnimationLibrary::LoopMode::Loop);
+}
+
 void Engine::loadGameObjects() {
-	const std::vector<Sprite::Vertex> vertices = {
-		{{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-		{{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-		{{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
-		{{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}
-};
-	const std::vector<uint32_t> indices = {
-		0, 1, 2, 2, 3, 0
-	};
-	auto sprite = std::make_shared<Sprite>(device, vertices, indices);
+	SpriteHandle sprite = assets.loadSprite("blank");
 
 	auto triangle = GameObject::createGameObject();
 	triangle.sprite = sprite;
@@ -144,48 +322,617 @@ void Engine::loadGameObjects() {
 	triangle.transform2d.scale = { 1.f, 1.f };
 	triangle.transform2d.rotation = 1;
 
-	gameObjects.push_back(std::move(triangle));
+	triangleObject = gameObjects.spawn(std::move(triangle));
+
+	//animated school, the offsets and speeds keep them out of step without any cpu work
+	for (int i = 0; i < 64; i++) {
+		auto krill = GameObject::createGameObject();
+		krill.sprite = sprite;
+		krill.transform2d.translation = { -0.8f + (i % 8) * 0.2f, -0.8f + (i / 8) * 0.2f };
+		krill.transform2d.scale = { 0.08f, 0.08f };
+		krill.depth = 0.6f;
+		krill.animation.clip = krillClip;
+		krill.animation.startTime = i * 0.037f;
+		krill.animation.speed = 0.75f + (i % 5) * 0.125f;
+		gameObjects.spawn(std::move(krill));
+	}
+
+	//glocktopus crowd, all sharing one rig and clip at different points in it
+	glocktopus = std::make_unique<Glocktopus>(device);
+	for (int i = 0; i < 24; i++) {
+		SkinnedRenderer::Instance instance{};
+		instance.skeleton = &glocktopus->getSkeleton();
+		instance.clip = &glocktopus->getIdleClip();
+		instance.mesh = &glocktopus->getMesh();
+		instance.translation = { -0.75f + (i % 6) * 0.3f, -0.45f + (i / 6) * 0.3f, 0.5f };
+		instance.scale = 0.12f;
+		skinnedInstances.push_back(instance);
+	}
+
+	//ocean background, checkered so the chunk culling is visible when moving the camera
+	ocean = std::make_unique<Tilemap>(device, renderer.getDeletionQueue(), 256, 256, 0.25f, glm::vec2{ -32.0f, -32.0f }, 1, 1);
+	for (int y = 0; y < ocean->getHeight(); y++) {
+		for (int x = 0; x < ocean->getWidth(); x++) {
+			if ((x + y) % 2 == 0) {
+				ocean->setTile(x, y, 1);
+			}
+		}
+	}
+}
+
+void Engine::startAudio() {
+	if (Settings::settings.value("measure_audio", false)) {
+		Mixer::benchmark();
+	}
+
+	//there is no sound device backend yet, the mix is discarded or captured to a file
+	std::unique_ptr<AudioSink> sink;
+	if (Settings::settings.value("audio_output", "null") == "wav") {
+		sink = std::make_unique<WavFileSink>(Settings::settings.value("audio_capture_path", "capture.wav"), Mixer::SAMPLE_RATE);
+	}
+	else {
+		sink = std::make_unique<NullSink>();
+	}
+	Mixer::Params params{};
+	params.maxVoices = Settings::settings.value("audio_voices", 32u);
+	mixer = std::make_unique<Mixer>(std::move(sink), params);
+
+	//temp sounds synthesized until there are audio assets
+	uint32_t random = 22695477u;
+	auto noise = [&]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) / 8388608.0f - 1.0f;
+	};
+	std::vector<float> gunshot(Mixer::SAMPLE_RATE / 8);
+	for (size_t i = 0; i < gunshot.size(); i++) {
+		float t = static_cast<float>(i) / Mixer::SAMPLE_RATE;
+		gunshot[i] = (noise() * 0.7f + std::sin(t * 2.0f * 3.14159265f * 140.0f) * 0.5f) * std::exp(-t * 40.0f);
+	}
+	std::vector<float> explosion(Mixer::SAMPLE_RATE);
+	float rumble = 0.0f;
+	for (size_t i = 0; i < explosion.size(); i++) {
+		float t = static_cast<float>(i) / Mixer::SAMPLE_RATE;
+		//low passed noise for the rumble
+		rumble += (noise() - rumble) * 0.05f;
+		explosion[i] = (rumble * 3.0f + noise() * 0.3f * std::exp(-t * 30.0f)) * std::exp(-t * 4.0f);
+	}
+	gunshotSound = mixer->addClip(gunshot);
+	explosionSound = mixer->addClip(explosion);
+
+	std::string musicPath = Settings::settings.value("music_path", "");
+	if (!musicPath.empty()) {
+		mixer->playMusic(std::make_unique<MusicStream>(musicPath, Mixer::SAMPLE_RATE, true), Settings::settings.value("music_volume", 0.5f));
+	}
+	mixer->start();
+}
+
+void Engine::updateAudio() {
+	if (session) {
+		const Simulation::Ship& ship = simulation.getShip(0);
+		mixer->setListener({ Simulation::toFloat(ship.x), -Simulation::toFloat(ship.y) });
+
+		//ids only grow, anything past the last one heard was fired since
+		auto& projectiles = heardProjectiles;
+		projectiles.clear();
+		for (uint32_t i = 0; i < simulation.getProjectileCount(); i++) {
+			const Simulation::Projectile& projectile = simulation.getProjectile(i);
+			glm::vec2 position{ Simulation::toFloat(projectile.x), -Simulation::toFloat(projectile.y) };
+			if (projectile.id >= nextProjectileSound) {
+				mixer->play(gunshotSound, position, 0.6f, 1);
+				nextProjectileSound = projectile.id + 1;
+			}
+			projectiles.push_back({ projectile.id, position });
+		}
+		std::sort(projectiles.begin(), projectiles.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		for (const auto& [id, position] : audibleProjectiles) {
+			auto found = std::lower_bound(projectiles.begin(), projectiles.end(), id, [](const auto& entry, uint32_t id) { return entry.first < id; });
+			if (found == projectiles.end() || found->first != id) {
+				mixer->play(explosionSound, position, 0.8f);
+			}
+		}
+		audibleProjectiles.swap(projectiles);
+	}
+	mixer->update();
+}
+
+void Engine::startSwarm(uint32_t agents) {
+	if (Settings::settings.value("measure_swarm", false)) {
+		Swarm::benchmark(jobs);
+	}
+
+	Swarm::Params params{};
+	swarm = std::make_unique<Swarm>(params);
+	//the glocktopi are in the way
+	std::vector<Swarm::Obstacle> obstacles;
+	for (const auto& instance : skinnedInstances) {
+		obstacles.push_back({ glm::vec2(instance.translation), instance.scale });
+	}
+	swarm->setObstacles(obstacles);
+
+	if (Settings::settings.value("flow_fields", true)) {
+		if (Settings::settings.value("measure_flowfields", false)) {
+			FlowFieldCache::benchmark();
+		}
+		//the same obstacles rasterized into the navigation grid over the swarm's arena
+		int cells = std::max(Settings::settings.value("flow_grid_cells", 64), 2);
+		float cellSize = 2.0f * params.extent / cells;
+		NavigationGrid grid{ cells, cells, cellSize, glm::vec2(-params.extent) };
+		for (uint32_t cell = 0; cell < static_cast<uint32_t>(cells * cells); cell++) {
+			for (const auto& obstacle : obstacles) {
+				if (glm::distance(grid.cellCenter(cell), obstacle.center) < obstacle.radius) {
+					grid.setCost(cell, NavigationGrid::BLOCKED);
+				}
+			}
+		}
+		flowFields = std::make_unique<FlowFieldCache>(grid, Settings::settings.value("flow_field_cache", 8u));
+	}
+
+	SpriteHandle sprite = assets.loadSprite("blank");
+	for (uint32_t i = 0; i < agents; i++) {
+		//golden angle spiral, evenly spread without any randomness
+		float angle = i * 2.39996f;
+		float radius = 0.9f * std::sqrt((i + 0.5f) / agents);
+		glm::vec2 direction{ std::cos(angle), std::sin(angle) };
+		swarm->add(direction * radius, glm::vec2(-direction.y, direction.x) * params.maxSpeed * 0.5f);
+
+		auto krill = GameObject::createGameObject();
+		krill.sprite = sprite;
+		krill.transform2d.scale = { 0.03f, 0.03f };
+		krill.depth = 0.55f;
+		krill.animation.clip = krillClip;
+		krill.animation.startTime = i * 0.037f;
+		krill.animation.speed = 0.75f + (i % 5) * 0.125f;
+		swarmObjects.push_back(gameObjects.spawn(std::move(krill)));
+	}
+}
+
+void Engine::updateSwarm() {
+	if (flowFields) {
+		if (InputManager::wasKeyPressed(GLFW_KEY_G)) {
+			//a wall across the middle of the arena with a gap at the top
+			wallUp = !wallUp;
+			const NavigationGrid& grid = flowFields->getGrid();
+			for (int y = 0; y < grid.getHeight() * 3 / 4; y++) {
+				flowFields->setCost(grid.cellIndex(grid.getWidth() / 2, y), wallUp ? NavigationGrid::BLOCKED : 1);
+			}
+		}
+		//the previous field keeps steering until the one for a new goal is built
+		glm::vec2 goal = session ? gameObjects[shipObjects[0]].transform2d.translation : glm::vec2(0.0f);
+		if (auto field = flowFields->request(goal)) {
+			swarm->setFlowField(std::move(field));
+		}
+	}
+	swarm->update(jobs, static_cast<float>(UPDATE_DELTA));
+	for (uint32_t i = 0; i < swarm->size(); i++) {
+		GameObject& obj = gameObjects[swarmObjects[swarm->getId(i)]];
+		glm::vec2 velocity = swarm->getVelocity(i);
+		obj.transform2d.translation = swarm->getPosition(i);
+		obj.transform2d.rotation = glm::degrees(std::atan2(velocity.y, velocity.x));
+	}
+}
+
+//physics runs in meters with y up, the bin spans most of the screen
+static constexpr float PHYSICS_RENDER_SCALE = 0.1f;
+
+static glm::vec2 physicsToScreen(glm::vec2 position) {
+	return { position.x * PHYSICS_RENDER_SCALE, 0.9f - position.y * PHYSICS_RENDER_SCALE };
+}
+
+void Engine::startPhysics(uint32_t bodies) {
+	if (Settings::settings.value("measure_physics", false)) {
+		PhysicsWorld::benchmark(jobs);
+	}
+
+	physics = std::make_unique<PhysicsWorld>(PhysicsWorld::Params{});
+	physics->createBody(PhysicsWorld::BodyType::Static, Shape::box({ 8.5f, 0.5f }), { 0.0f, -0.5f });
+	physics->createBody(PhysicsWorld::BodyType::Static, Shape::box({ 0.5f, 8.0f }), { -8.5f, 8.0f });
+	physics->createBody(PhysicsWorld::BodyType::Static, Shape::box({ 0.5f, 8.0f }), { 8.5f, 8.0f });
+
+	glm::vec2 triangle[3] = { { 0.0f, 0.3f }, { -0.26f, -0.15f }, { 0.26f, -0.15f } };
+	const Shape debris[4] = { Shape::circle(0.2f), Shape::capsule(0.15f, 0.12f), Shape::box({ 0.2f, 0.15f }), Shape::polygon(triangle, 3) };
+	const uint32_t columns = 24;
+	for (uint32_t i = 0; i < bodies; i++) {
+		uint32_t row = i / columns;
+		glm::vec2 position{ -7.5f + (i % columns) * 0.65f + (row % 2) * 0.2f, 0.5f + row * 0.65f };
+		physics->createBody(PhysicsWorld::BodyType::Dynamic, debris[i % 4], position, i * 0.37f);
+	}
+
+	//every body gets a game object, the walls included
+	SpriteHandle sprite = assets.loadSprite("blank");
+	for (uint32_t body = 0; body < physics->size(); body++) {
+		AABB bounds = physics->getShape(body).computeAABB({});
+		auto object = GameObject::createGameObject();
+		object.sprite = sprite;
+		object.color = body < 3 ? glm::vec3{ 0.3f, 0.3f, 0.35f } : glm::vec3{ 0.55f, 0.45f, 0.3f };
+		object.transform2d.scale = (bounds.max - bounds.min) * PHYSICS_RENDER_SCALE;
+		object.depth = 0.5f;
+		physicsObjects.push_back(gameObjects.spawn(std::move(object)));
+	}
+	updatePhysics();
+}
+
+void Engine::updatePhysics() {
+	if (InputManager::wasKeyPressed(GLFW_KEY_H)) {
+		//every third body thrown up, which wakes whatever has gone to sleep
+		for (uint32_t body = 3; body < physics->size(); body += 3) {
+			physics->setVelocity(body, { ((body * 7919) % 11) - 5.0f, 8.0f }, ((body * 104729) % 9) - 4.0f);
+		}
+	}
+	if (InputManager::wasKeyPressed(GLFW_KEY_J)) {
+		//600m/s, five meters a tick, far more than anything in the bin is wide
+		for (int i = 0; i < 32; i++) {
+			rounds.push_back({ { -7.9f, 0.2f + i * 0.1f }, { 600.0f, -20.0f + i * 1.5f } });
+		}
+	}
+	if (!rounds.empty()) {
+		const float dt = static_cast<float>(UPDATE_DELTA);
+		roundSweeps.clear();
+		for (const auto& [position, velocity] : rounds) {
+			roundSweeps.push_back({ position, position + velocity * dt, 0.02f });
+		}
+		roundImpacts.resize(rounds.size());
+		physics->castSweeps(jobs, roundSweeps.data(), static_cast<uint32_t>(roundSweeps.size()), roundImpacts.data());
+
+		//a hit stops the round and hands the body its momentum, the rest fly on until they leave the bin
+		for (size_t i = rounds.size(); i-- > 0;) {
+			const PhysicsWorld::Impact& impact = roundImpacts[i];
+			if (impact.body != PhysicsWorld::NO_BODY) {
+				physics->applyImpulse(impact.body, rounds[i].second * 0.0005f, impact.point);
+			}
+			rounds[i].first = roundSweeps[i].end;
+			if (impact.body != PhysicsWorld::NO_BODY || std::abs(rounds[i].first.x) > 10.0f || std::abs(rounds[i].first.y - 8.0f) > 10.0f) {
+				rounds[i] = rounds.back();
+				rounds.pop_back();
+			}
+		}
+	}
+	physics->step(jobs, static_cast<float>(UPDATE_DELTA));
+	for (uint32_t body = 0; body < physics->size(); body++) {
+		GameObject& obj = gameObjects[physicsObjects[body]];
+		obj.transform2d.translation = physicsToScreen(physics->getPosition(body));
+		//y is flipped on the way to the screen, which turns the rotation around too
+		obj.transform2d.rotation = -glm::degrees(physics->getAngle(body));
+	}
+}
+
+void Engine::startNetplay() {
+	LinkConditions conditions{};
+	conditions.latency = Settings::settings.value("netplay_latency_ms", 50.0) / 1000.0;
+	conditions.jitter = Settings::settings.value("netplay_jitter_ms", 10.0) / 1000.0;
+	conditions.loss = Settings::settings.value("netplay_loss", 0.05f);
+	LoopbackTransport::createPair(conditions, 7, localLink, remoteLink);
+
+	uint32_t inputDelay = Settings::settings.value("input_delay_ticks", 3u);
+	uint32_t maxRollback = Settings::settings.value("max_rollback_ticks", 12u);
+	session = std::make_unique<RollbackSession>(simulation, *localLink, 0, inputDelay, maxRollback);
+	remoteSession = std::make_unique<RollbackSession>(remoteSimulation, *remoteLink, 1, inputDelay, maxRollback);
+	if (Settings::settings.value("measure_rollback", false)) {
+		RollbackSession::benchmark(simulation, maxRollback);
+	}
+	if (Settings::settings.value("record_replay", false)) {
+		recording = std::make_unique<Replay>(simulation.getPlayerCount(), SIMULATION_SEED, Settings::settings.value("replay_keyframe_interval", 600u));
+	}
+
+	//projectiles get their objects as they are fired, see updateNetplay
+	SpriteHandle sprite = assets.loadSprite("blank");
+	for (uint32_t player = 0; player < simulation.getPlayerCount(); player++) {
+		auto ship = GameObject::createGameObject();
+		ship.sprite = sprite;
+		ship.color = player == 0 ? glm::vec3{ 0.2f, 0.8f, 0.3f } : glm::vec3{ 0.9f, 0.3f, 0.2f };
+		ship.transform2d.scale = { 0.1f, 0.1f };
+		ship.depth = 0.4f;
+		shipObjects.push_back(gameObjects.spawn(std::move(ship)));
+	}
+}
+
+void Engine::startReplication() {
+	//the same conditions as the loopback netplay link, applied to real sockets
+	LinkConditions conditions{};
+	conditions.latency = Settings::settings.value("netplay_latency_ms", 50.0) / 1000.0;
+	conditions.jitter = Settings::settings.value("netplay_jitter_ms", 10.0) / 1000.0;
+	conditions.loss = Settings::settings.value("netplay_loss", 0.05f);
+
+	uint16_t port = Settings::settings.value("replication_port", 27015);
+	serverSocket = std::make_unique<UdpTransport>(port, "127.0.0.1", static_cast<uint16_t>(port + 1));
+	clientSocket = std::make_unique<UdpTransport>(static_cast<uint16_t>(port + 1), "127.0.0.1", port);
+	serverLink = std::make_unique<ImpairedTransport>(*serverSocket, conditions, 11);
+	clientLink = std::make_unique<ImpairedTransport>(*clientSocket, conditions, 13);
+
+	uint32_t snapshotBytes = Settings::settings.value("snapshot_bytes", 1200u);
+	float interestRadius = Settings::settings.value("interest_radius", 0.75f);
+	uint32_t maxEntities = Settings::settings.value("max_replicated_entities", 96u);
+	snapshotInterval = std::max(Settings::settings.value("snapshot_interval_ticks", 4u), 1u);
+	replicationServer = std::make_unique<ReplicationServer>(snapshotBytes, interestRadius, maxEntities);
+	replicationClient = std::make_unique<ReplicationClient>(*clientLink);
+	replicationServer->addClient(*serverLink);
+	if (measureReplication) {
+		ReplicationServer::benchmark(snapshotBytes, interestRadius, maxEntities);
+	}
+}
+
+void Engine::updateReplication() {
+	if (simulation.getTick() % snapshotInterval == 0) {
+		NetEntity::gather(simulation, netEntities);
+		replicationServer->update(simulation.getTick(), netEntities);
+	}
+
+	//the client cares about the area around the local ship
+	const Simulation::Ship& ship = simulation.getShip(0);
+	replicationClient->update({ Simulation::toFloat(ship.x), Simulation::toFloat(ship.y) });
+
+	//server and client share this process, so the rebuilt state can be checked exactly
+	if (measureReplication && replicationClient->hasSnapshot()) {
+		auto sent = replicationServer->findSent(0, replicationClient->getLatestSequence());
+		if (sent && *sent != replicationClient->getEntities()) {
+			LOG_ERROR("Replicated snapshot {} decoded differently than it was sent", replicationClient->getLatestSequence());
+		}
+	}
+}
+
+PlayerInput Engine::readLocalInput() {
+	PlayerInput input{};
+	if (InputManager::isKeyDown(GLFW_KEY_UP)) input.buttons |= PlayerInput::Up;
+	if (InputManager::isKeyDown(GLFW_KEY_DOWN)) input.buttons |= PlayerInput::Down;
+	if (InputManager::isKeyDown(GLFW_KEY_LEFT)) input.buttons |= PlayerInput::Left;
+	if (InputManager::isKeyDown(GLFW_KEY_RIGHT)) input.buttons |= PlayerInput::Right;
+	if (InputManager::isKeyDown(GLFW_KEY_ENTER)) input.buttons |= PlayerInput::Fire;
+	return input;
+}
+
+PlayerInput Engine::botInput(uint32_t tick) {
+	//holds a direction for a while and fires in every other stretch
+	uint32_t stretch = tick / 45;
+	PlayerInput input{};
+	input.buttons = static_cast<uint8_t>(1 << ((stretch * 2654435761u) >> 30));
+	if (stretch % 2 == 1) input.buttons |= PlayerInput::Fire;
+	return input;
+}
+
+void Engine::updateNetplay() {
+	session->advance(readLocalInput());
+	remoteSession->advance(botInput(remoteSession->getTick()));
+
+	//both peers live in this process, so their confirmed states can be compared directly
+	uint32_t tick = std::min(session->getConfirmedTick(), remoteSession->getConfirmedTick());
+	uint64_t localChecksum, remoteChecksum;
+	if (!desyncReported
+		&& session->getChecksum(tick, localChecksum)
+		&& remoteSession->getChecksum(tick, remoteChecksum)
+		&& localChecksum != remoteChecksum) {
+		LOG_ERROR("Netplay desync at tick {}", tick);
+		desyncReported = true;
+	}
+
+	//only ticks that can't be rolled back anymore go into the replay
+	if (recording) {
+		PlayerInput inputs[Simulation::MAX_PLAYERS];
+		while (recording->getTickCount() < session->getConfirmedTick() && recording->getTickCount() < session->getTick()) {
+			uint32_t tick = recording->getTickCount();
+			const uint8_t* snapshot;
+			size_t size;
+			if (recording->wantsKeyframe(tick) && session->getSnapshot(tick, snapshot, size)) {
+				recording->addKeyframe(tick, snapshot, size);
+			}
+			session->getInputs(tick, inputs);
+			recording->record(inputs);
+		}
+	}
+
+	//simulation y points up, the screen's points down
+	for (uint32_t player = 0; player < simulation.getPlayerCount(); player++) {
+		const Simulation::Ship& ship = simulation.getShip(player);
+		GameObject& obj = gameObjects[shipObjects[player]];
+		obj.transform2d.translation = { Simulation::toFloat(ship.x), -Simulation::toFloat(ship.y) };
+		obj.transform2d.rotation = glm::degrees(std::atan2(static_cast<float>(-ship.facingY), static_cast<float>(ship.facingX)));
+	}
+
+	//a projectile's object is spawned the first tick it shows up and despawned the first tick
+	//it is gone, rollbacks included. both lists are sorted by id so they are matched in one pass
+	liveProjectiles.clear();
+	for (uint32_t i = 0; i < simulation.getProjectileCount(); i++) {
+		liveProjectiles.push_back({ simulation.getProjectile(i).id, i });
+	}
+	std::sort(liveProjectiles.begin(), liveProjectiles.end());
+	nextProjectileObjects.clear();
+	size_t previous = 0;
+	for (const auto& [id, index] : liveProjectiles) {
+		while (previous < projectileObjects.size() && projectileObjects[previous].first < id) {
+			gameObjects.despawn(projectileObjects[previous++].second);
+		}
+		Entity entity;
+		if (previous < projectileObjects.size() && projectileObjects[previous].first == id) {
+			entity = projectileObjects[previous++].second;
+		}
+		else {
+			auto object = GameObject::createGameObject();
+			object.sprite = gameObjects[shipObjects[0]].sprite;
+			object.color = { 1.0f, 0.9f, 0.4f };
+			object.transform2d.scale = { 0.03f, 0.03f };
+			object.depth = 0.45f;
+			entity = gameObjects.spawn(std::move(object));
+		}
+		const Simulation::Projectile& projectile = simulation.getProjectile(index);
+		gameObjects[entity].transform2d.translation = { Simulation::toFloat(projectile.x), -Simulation::toFloat(projectile.y) };
+		nextProjectileObjects.push_back({ id, entity });
+	}
+	while (previous < projectileObjects.size()) {
+		gameObjects.despawn(projectileObjects[previous++].second);
+	}
+	projectileObjects.swap(nextProjectileObjects);
+}
+
+void Engine::getViewBounds(const glm::mat4& viewProj, glm::vec2& min, glm::vec2& max) {
+	//unproject the corners of clip space to get the visible world rect
+	glm::mat4 inverse = glm::inverse(viewProj);
+	min = glm::vec2{ std::numeric_limits<float>::max() };
+	max = glm::vec2{ std::numeric_limits<float>::lowest() };
+	const glm::vec2 corners[] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	for (const auto& corner : corners) {
+		glm::vec4 world = inverse * glm::vec4(corner, 0.0f, 1.0f);
+		glm::vec2 point = glm::vec2(world) / world.w;
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
 }
 
 
 void Engine::update() {
 	glfwPollEvents();
 
+	//drain queued input in order
+	InputManager::beginTick();
+	InputEvent event;
+	while (InputManager::pollEvent(event)) {
+		latency.inputApplied(event.time);
+	}
+	if (uint32_t dropped = InputManager::takeDroppedCount()) {
+		LOG_WARN("Input queue full, dropped {} events", dropped);
+	}
+
+	floatingNumbers.update(static_cast<float>(UPDATE_DELTA));
+	if (swarm) {
+		updateSwarm();
+	}
+	if (physics) {
+		updatePhysics();
+	}
+	if (session) {
+		updateNetplay();
+	}
+	if (replicationServer) {
+		updateReplication();
+	}
+	if (mixer) {
+		updateAudio();
+	}
+
+	//debug shapes describe the latest tick only
+	DEBUG_DRAW_CLEAR();
+#if SEAFIGHT_DEBUG_DRAW
+	if (InputManager::wasKeyPressed(GLFW_KEY_F3)) {
+		showDebugShapes = !showDebugShapes;
+	}
+	if (showDebugShapes) {
+		drawDebugShapes();
+	}
+#endif
+	if (Settings::settings["dev_mode"] && InputManager::wasKeyPressed(GLFW_KEY_F5)) {
+		reloadSpriteTexture();
+	}
 
 	//temp translations
-	gameObjects[0].transform2d.rotation = 90 * sin(glfwGetTime());
-	if (InputManager::keys[GLFW_KEY_W]) {
+	gameObjects[triangleObject].transform2d.rotation = 90 * sin(glfwGetTime());
+	if (InputManager::wasKeyPressed(GLFW_KEY_SPACE)) {
+		//stand in for hits until there is combat
+		for (int i = 0; i < 100; i++) {
+			floatingNumbers.spawn(gameObjects[triangleObject].transform2d.translation, 10 + (i * 7919) % 990, { 1.0f, 0.85f, 0.2f, 1.0f });
+			if (mixer) {
+				mixer->play(explosionSound, gameObjects[triangleObject].transform2d.translation, 0.3f + (i % 7) * 0.1f);
+			}
+		}
+	}
+	if (InputManager::isKeyDown(GLFW_KEY_W)) {
 		view = glm::translate(view, glm::vec3(0, 0.1f, 0));
 	}
-	if (InputManager::keys[GLFW_KEY_S]) {
+	if (InputManager::isKeyDown(GLFW_KEY_S)) {
 		view = glm::translate(view, glm::vec3(0, -0.1f, 0));
 	}
-	if (InputManager::keys[GLFW_KEY_A]) {
+	if (InputManager::isKeyDown(GLFW_KEY_A)) {
 		view = glm::translate(view, glm::vec3(0.1f, 0, 0));
 	}
-	if (InputManager::keys[GLFW_KEY_D]) {
+	if (InputManager::isKeyDown(GLFW_KEY_D)) {
 		view = glm::translate(view, glm::vec3(-0.1f, 0, 0));
 	}
 }
 
 void Engine::render() {
 	if (auto commandBuffer = renderer.beginFrame()) {
+		int frameIndex = renderer.getFrameIndex();
+		//beginFrame waited on this slot's fence, so the frame that used it last is done
+		latency.frameCompleted(frameIndex, glfwGetTime());
+		overdraw.collect(frameIndex);
+		//the fence for this slot has been waited on too, so its sets are free to rewrite
+		if (boundSpriteTextures[frameIndex] != spriteTexture) {
+			bindSpriteTexture(frameIndex);
+		}
+		double gpuMilliseconds;
+		if (gpuTimer.collect(frameIndex, gpuMilliseconds)) {
+			resolution.update(gpuMilliseconds);
+		}
+
 		//update ubos
 		SpriteUBO ubo{};
 		//ubo.proj = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
 		ubo.proj = glm::mat4(1.0f);
 		ubo.view = view;
+		ubo.time = static_cast<float>(glfwGetTime());
 		//ubo.view = glm::mat4(1.0f);
-		int frameIndex = renderer.getFrameIndex();
 		uboBuffers[frameIndex]->writeToBuffer(&ubo);
 		uboBuffers[frameIndex]->flush();
 
+		frameContext.frameIndex = frameIndex;
+		frameContext.viewProj = ubo.proj * ubo.view;
+		getViewBounds(frameContext.viewProj, frameContext.viewMin, frameContext.viewMax);
+
+		VkExtent2D outputExtent = renderer.getSwapChainExtent();
+		frameContext.outputExtent = outputExtent;
+		frameContext.renderExtent = scaledRendering ? resolution.getRenderExtent(outputExtent) : outputExtent;
+
+		renderManager->prepareGameObjects(frameIndex, gameObjects, assets);
+		for (size_t i = 0; i < skinnedInstances.size(); i++) {
+			skinnedInstances[i].clipTime = ubo.time + i * 0.37f;
+		}
+		skinnedRenderer->prepare(frameIndex, skinnedInstances, renderer.getFrameArena());
+		prepareText(frameIndex);
+#if SEAFIGHT_DEBUG_DRAW
+		debugRenderer->upload(frameIndex);
+#endif
+		gpuTimer.begin(commandBuffer, frameIndex);
+		overdraw.reset(commandBuffer, frameIndex, frameContext.renderExtent);
+		//chunk uploads go in ahead of the graph's render passes
+		ocean->update(commandBuffer);
+
+		//the graph retires its old targets, so recompiling doesn't stall frames in flight
+		if (frameGraphVersion != renderer.getSwapChainVersion()) {
+			frameGraph.compile(outputExtent);
+			frameGraphVersion = renderer.getSwapChainVersion();
+		}
+
 		//render frame
-      renderer.beginSwapchainRenderPass(commandBuffer);
-      renderManager->renderGameObjects(commandBuffer, descriptorSets[frameIndex], gameObjects);
-      renderer.endSwapchainRenderPass(commandBuffer);
-      renderer.endFrame();
-    }}
+		frameGraph.setImportedImage(backbuffer, renderer.getCurrentSwapChainImage(), renderer.getCurrentSwapChainImageView());
+		frameGraph.execute(commandBuffer, renderer.getFrameArena());
+		gpuTimer.end(commandBuffer, frameIndex);
+		renderer.endFrame(pacer.schedulePresent(renderer));
+
+		double now = glfwGetTime();
+		latency.framePresented(frameIndex, now);
+		pacer.framePresented(renderer, now);
+		latency.report(now);
+		overdraw.report(now);
+		pacer.report(now);
+		renderer.report(now);
+		renderManager->report(now);
+		skinnedRenderer->report(now);
+		if (swarm) {
+			swarm->report(now);
+		}
+		if (flowFields) {
+			flowFields->report(now);
+		}
+		if (physics) {
+			physics->report(now);
+		}
+		if (mixer) {
+			mixer->report(now);
+		}
+		if (session) {
+			session->report(now);
+		}
+		if (replicationServer) {
+			replicationServer->report(now, measureReplication);
+		}
+	}
+}
 
 void Engine::stop() {
 	window.setWindowShouldClose();
@@ -7,12 +7,34 @@
 #include "utils.h"
 #include "window.h"
 #include "device.h"
+#include "entityRegistry.h"
 #include "gameobject.h"
 #include "renderer.h"
 #include "renderManager.h"
 #include "buffer.h"
 #include "descriptors.h"
 #include "texture.h"
+#include "assetRegistry.h"
+#include "latencyTracker.h"
+#include "overdrawQuery.h"
+#include "renderGraph.h"
+#include "gpuTimer.h"
+#include "dynamicResolution.h"
+#include "framePacer.h"
+#include "tilemap.h"
+#include "textRenderer.h"
+#include "debugDraw.h"
+#include "animation.h"
+#include "jobSystem.h"
+#include "skinnedRenderer.h"
+#include "glocktopus.h"
+#include "rollback.h"
+#include "replication.h"
+#include "udpTransport.h"
+#include "replay.h"
+#include "swarm.h"
+#include "mixer.h"
+#include "physicsWorld.h"
 
 //temp
 #define GLM_FORCE_RADIANS
@@ -28,6 +50,11 @@ public:
 	int width;
 	int height;
 
+	// fixed simulation step
+	static constexpr double UPDATE_DELTA = 1.0 / 120.0;
+	// every peer has to start the simulation from the same seed
+	static constexpr uint32_t SIMULATION_SEED = 1;
+
 	Engine();
 	~Engine();
 
@@ -40,21 +67,142 @@ public:
 
 private:
 	Settings settings{};
+	LatencyTracker latency{ Settings::settings.value("measure_input_latency", false) };
 	Window window{Settings::settings["window_width"], Settings::settings["window_height"], "Sea Fight"};
 	Device device{ window };
-	std::vector<GameObject> gameObjects;
+	JobSystem jobs{ Settings::settings.value("job_workers", 0u) };
+	OverdrawQuery overdraw{ device, Settings::settings.value("measure_overdraw", false) };
+	GpuTimer gpuTimer{ device };
+	DynamicResolution resolution;
+	AnimationLibrary animations{ device };
+	uint32_t krillClip = Sprite::NO_CLIP;
+	EntityRegistry<GameObject> gameObjects;
+	Entity triangleObject;
 	Renderer renderer{ window, device };
+	// unloads wait on the renderer's deletion queue, so it has to outlive the registry
+	AssetRegistry assets{ device, renderer.getDeletionQueue() };
+	FramePacer pacer;
 	std::unique_ptr<RenderManager> renderManager;
+	std::unique_ptr<TextRenderer> text;
+	FloatingNumbers floatingNumbers;
+	std::unique_ptr<SkinnedRenderer> skinnedRenderer;
+	std::unique_ptr<Glocktopus> glocktopus;
+	std::vector<SkinnedRenderer::Instance> skinnedInstances;
+	// krill school steered as boids, by agent id
+	std::unique_ptr<Swarm> swarm;
+	std::vector<Entity> swarmObjects;
+	// the swarm paths around the glocktopi towards the local ship, G toggles a wall
+	std::unique_ptr<FlowFieldCache> flowFields;
+	bool wallUp = false;
+	// sounds are queued to the mixer thread, projectiles fire and explode as they come and go
+	std::unique_ptr<Mixer> mixer;
+	Mixer::ClipId gunshotSound = 0;
+	Mixer::ClipId explosionSound = 0;
+	uint32_t nextProjectileSound = 0;
+	std::vector<std::pair<uint32_t, glm::vec2>> audibleProjectiles;
+	// swapped with audibleProjectiles every tick, both keep their capacity
+	std::vector<std::pair<uint32_t, glm::vec2>> heardProjectiles;
+	// debris pile in a bin, by body id, H heaves it
+	std::unique_ptr<PhysicsWorld> physics;
+	std::vector<Entity> physicsObjects;
+	// J fires a volley of rounds into the pile, position and velocity, swept against it each tick
+	std::vector<std::pair<glm::vec2, glm::vec2>> rounds;
+	std::vector<PhysicsWorld::Sweep> roundSweeps;
+	std::vector<PhysicsWorld::Impact> roundImpacts;
+	// loopback netplay, a bot plays the remote peer over a simulated link in this process
+	Simulation simulation{ 2, SIMULATION_SEED };
+	Simulation remoteSimulation{ 2, SIMULATION_SEED };
+	std::unique_ptr<LoopbackTransport> localLink;
+	std::unique_ptr<LoopbackTransport> remoteLink;
+	std::unique_ptr<RollbackSession> session;
+	std::unique_ptr<RollbackSession> remoteSession;
+	// game objects mirroring the simulation, ships by player and projectiles by projectile id
+	std::vector<Entity> shipObjects;
+	std::vector<std::pair<uint32_t, Entity>> projectileObjects;
+	// per tick, kept around for their capacity
+	std::vector<std::pair<uint32_t, Entity>> nextProjectileObjects;
+	std::vector<std::pair<uint32_t, uint32_t>> liveProjectiles;
+	bool desyncReported = false;
+	// confirmed inputs of the netplay session, saved when the engine shuts down
+	std::unique_ptr<Replay> recording;
+	// client/server replication of the simulation over a pair of impaired localhost sockets
+	std::unique_ptr<UdpTransport> serverSocket;
+	std::unique_ptr<UdpTransport> clientSocket;
+	std::unique_ptr<ImpairedTransport> serverLink;
+	std::unique_ptr<ImpairedTransport> clientLink;
+	std::unique_ptr<ReplicationServer> replicationServer;
+	std::unique_ptr<ReplicationClient> replicationClient;
+	std::vector<NetEntity> netEntities;
+	uint32_t snapshotInterval = 4;
+	const bool measureReplication = Settings::settings.value("measure_replication", false);
+#if SEAFIGHT_DEBUG_DRAW
+	std::unique_ptr<DebugRenderer> debugRenderer;
+	// toggled with F3
+	bool showDebugShapes = Settings::settings.value("debug_draw", false);
+#endif
+	int framesPerSecond = 0;
+
+	// per frame state the frame graph passes record with
+	struct FrameContext {
+		int frameIndex = 0;
+		glm::vec2 viewMin{};
+		glm::vec2 viewMax{};
+		glm::mat4 viewProj{ 1.0f };
+		VkExtent2D renderExtent{};
+		VkExtent2D outputExtent{};
+	};
+	RenderGraph frameGraph{ device, renderer.getDeletionQueue() };
+	RenderGraph::ResourceId backbuffer;
+	RenderGraph::ResourceId sceneColor;
+	// false when the swapchain can't be blitted to, the scene then renders to it directly
+	bool scaledRendering = false;
+	bool linearUpscale = false;
+	uint32_t frameGraphVersion = 0;
+	FrameContext frameContext{};
 
 	std::vector<std::unique_ptr<Buffer>> uboBuffers;
 	std::unique_ptr<DescriptorPool> spritePool;
+	std::unique_ptr<DescriptorSetLayout> spriteSetLayout;
 	std::vector<VkDescriptorSet> descriptorSets;
+	// sprite texture each frame's descriptor sets were last written with
+	std::vector<TextureHandle> boundSpriteTextures;
 	VkSampler textureSampler;
 
 	//temp
 	glm::mat4 view = glm::mat4(1.0f);
-	Texture texture{ device, "res/sprites/syl.png" };
+	TextureHandle spriteTexture;
+	std::unique_ptr<Tilemap> ocean;
 
+	// unloads the sprite texture and loads it again from disk, F5 in dev mode
+	void reloadSpriteTexture();
+	// points this frame's descriptor sets at the current sprite texture
+	void bindSpriteTexture(int frameIndex);
+	void loadAnimations();
 	void loadGameObjects();
+	void buildFrameGraph();
+	void startAudio();
+	// queues the tick's sounds and moves the listener with the local ship
+	void updateAudio();
+	void startSwarm(uint32_t agents);
+	// steps the swarm and points its game objects along their velocity
+	void updateSwarm();
+	void startPhysics(uint32_t bodies);
+	// steps the physics world and copies the bodies into their game objects
+	void updatePhysics();
+	void startNetplay();
+	// ticks both peers and mirrors the local simulation into its game objects
+	void updateNetplay();
+	void startReplication();
+	// sends snapshots of the local simulation and checks what the client rebuilt from them
+	void updateReplication();
+	static PlayerInput readLocalInput();
+	static PlayerInput botInput(uint32_t tick);
+	// fills the frame's text batch, hud and floating numbers
+	void prepareText(int frameIndex);
+#if SEAFIGHT_DEBUG_DRAW
+	// queues hitboxes and facing arrows for the game objects
+	void drawDebugShapes();
+#endif
+	static void getViewBounds(const glm::mat4& viewProj, glm::vec2& min, glm::vec2& max);
 };
 
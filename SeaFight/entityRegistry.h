@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// handle to an entity, the generation tells a reused index apart from the entity that had it
+// before, so a handle kept past its entity's despawn stops resolving instead of aliasing
+struct Entity {
+	uint32_t index = ~0u;
+	uint32_t generation = 0;
+
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// entities stored as a sparse set
+// values are packed densely in spawn order, give or take despawns, so iterating them is a
+// plain walk over an array. each index maps to its slot in the dense array and each slot back
+// to its index, despawning moves the last value into the hole and patches both. spawn, despawn
+// and lookup are all O(1), freed indices are reused with their generation bumped
+// not thread safe, the owner spawns and despawns from one thread
+template <typename T>
+class EntityRegistry {
+public:
+	EntityRegistry() = default;
+
+	EntityRegistry(const EntityRegistry&) = delete;
+	EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+	Entity spawn(T&& value) {
+		uint32_t index;
+		if (!freeIndices.empty()) {
+			index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else {
+			index = static_cast<uint32_t>(sparse.size());
+			sparse.push_back(0);
+			//generations start at one, so a default constructed handle is never alive
+			generations.push_back(1);
+		}
+		sparse[index] = static_cast<uint32_t>(dense.size());
+		dense.push_back(std::move(value));
+		denseIndices.push_back(index);
+		return { index, generations[index] };
+	}
+
+	// false when the entity was already gone
+	bool despawn(Entity entity) {
+		if (!isAlive(entity)) return false;
+
+		uint32_t slot = sparse[entity.index];
+		uint32_t last = static_cast<uint32_t>(dense.size()) - 1;
+		if (slot != last) {
+			dense[slot] = std::move(dense[last]);
+			denseIndices[slot] = denseIndices[last];
+			sparse[denseIndices[slot]] = slot;
+		}
+		dense.pop_back();
+		denseIndices.pop_back();
+
+		generations[entity.index]++;
+		freeIndices.push_back(entity.index);
+		return true;
+	}
+
+	bool isAlive(Entity entity) const {
+		return entity.index < generations.size() && generations[entity.index] == entity.generation;
+	}
+
+	// nullptr for handles whose entity has been despawned
+	T* get(Entity entity) { return isAlive(entity) ? &dense[sparse[entity.index]] : nullptr; }
+	const T* get(Entity entity) const { return isAlive(entity) ? &dense[sparse[entity.index]] : nullptr; }
+
+	// for handles known to be alive
+	T& operator[](Entity entity) {
+		assert(isAlive(entity) && "Entity has been despawned");
+		return dense[sparse[entity.index]];
+	}
+
+	void clear() {
+		for (uint32_t index : denseIndices) {
+			generations[index]++;
+			freeIndices.push_back(index);
+		}
+		dense.clear();
+		denseIndices.clear();
+	}
+
+	// dense iteration, slots move around whenever something despawns
+	uint32_t size() const { return static_cast<uint32_t>(dense.size()); }
+	T& getDense(uint32_t slot) { return dense[slot]; }
+	Entity getEntity(uint32_t slot) const { return { denseIndices[slot], generations[denseIndices[slot]] }; }
+	typename std::vector<T>::iterator begin() { return dense.begin(); }
+	typename std::vector<T>::iterator end() { return dense.end(); }
+
+private:
+	std::vector<T> dense;
+	// entity index of each dense slot
+	std::vector<uint32_t> denseIndices;
+	// dense slot of each entity index, only meaningful while the index is alive
+	std::vector<uint32_t> sparse;
+	std::vector<uint32_t> generations;
+	std::vector<uint32_t> freeIndices;
+};
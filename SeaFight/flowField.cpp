@@ -0,0 +1,374 @@
+#include "flowField.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+
+//east, north east, north, north west, west, south west, south, south east
+static constexpr int OFFSET_X[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static constexpr int OFFSET_Y[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+//roughly 1 and sqrt 2, integer so the costs compare exactly
+static constexpr uint32_t STEP_WEIGHT[8] = { 10, 14, 10, 14, 10, 14, 10, 14 };
+static const glm::vec2 DIRECTIONS[9] = {
+	{ 1.0f, 0.0f }, { 0.70710678f, 0.70710678f }, { 0.0f, 1.0f }, { -0.70710678f, 0.70710678f },
+	{ -1.0f, 0.0f }, { -0.70710678f, -0.70710678f }, { 0.0f, -1.0f }, { 0.70710678f, -0.70710678f },
+	{ 0.0f, 0.0f } };
+
+using HeapEntry = std::pair<uint32_t, uint32_t>;
+
+static int opposite(int direction) {
+	return (direction + 4) % 8;
+}
+
+NavigationGrid::NavigationGrid(int width, int height, float cellSize, glm::vec2 origin)
+	: width{ width }, height{ height }, cellSize{ cellSize }, origin{ origin } {
+	assert(width > 0 && height > 0 && "Navigation grid has no cells");
+	costs.resize(static_cast<size_t>(width) * height, 1);
+}
+
+uint32_t NavigationGrid::cellAt(glm::vec2 position) const {
+	int x = std::clamp(static_cast<int>((position.x - origin.x) / cellSize), 0, width - 1);
+	int y = std::clamp(static_cast<int>((position.y - origin.y) / cellSize), 0, height - 1);
+	return cellIndex(x, y);
+}
+
+glm::vec2 NavigationGrid::cellCenter(uint32_t cell) const {
+	return origin + (glm::vec2(cell % width, cell / width) + 0.5f) * cellSize;
+}
+
+FlowField::FlowField(const NavigationGrid& grid, uint32_t goal)
+	: width{ grid.getWidth() }, height{ grid.getHeight() }, cellSize{ grid.getCellSize() }, origin{ grid.getOrigin() }, goal{ goal } {
+	integration.resize(static_cast<size_t>(width) * height, UNREACHABLE);
+	directions.resize(integration.size(), NO_DIRECTION);
+
+	std::vector<HeapEntry> heap;
+	if (grid.getCost(goal) != NavigationGrid::BLOCKED) {
+		integration[goal] = 0;
+		heap.push_back({ 0, goal });
+	}
+	propagate(grid, heap);
+}
+
+bool FlowField::step(const NavigationGrid& grid, uint32_t cell, int direction, uint32_t& neighbour) const {
+	int x = static_cast<int>(cell % width);
+	int y = static_cast<int>(cell / width);
+	int nx = x + OFFSET_X[direction];
+	int ny = y + OFFSET_Y[direction];
+	if (nx < 0 || ny < 0 || nx >= width || ny >= height) return false;
+
+	//no squeezing diagonally between two blocked cells or around the corner of one
+	if (direction % 2 == 1) {
+		if (grid.getCost(grid.cellIndex(nx, y)) == NavigationGrid::BLOCKED ||
+			grid.getCost(grid.cellIndex(x, ny)) == NavigationGrid::BLOCKED) {
+			return false;
+		}
+	}
+	neighbour = grid.cellIndex(nx, ny);
+	return true;
+}
+
+void FlowField::propagate(const NavigationGrid& grid, std::vector<HeapEntry>& heap) {
+	auto later = std::greater<HeapEntry>();
+	std::make_heap(heap.begin(), heap.end(), later);
+
+	expandedCells = 0;
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), later);
+		auto [cost, cell] = heap.back();
+		heap.pop_back();
+		//stale, the cell was queued again with a lower cost
+		if (cost != integration[cell]) continue;
+		expandedCells++;
+
+		for (int direction = 0; direction < 8; direction++) {
+			uint32_t neighbour;
+			if (!step(grid, cell, direction, neighbour)) continue;
+			uint8_t neighbourCost = grid.getCost(neighbour);
+			if (neighbourCost == NavigationGrid::BLOCKED) continue;
+
+			//units in the neighbour pay its cost to step over into this cell
+			uint32_t candidate = cost + neighbourCost * STEP_WEIGHT[direction];
+			if (candidate < integration[neighbour]) {
+				integration[neighbour] = candidate;
+				directions[neighbour] = static_cast<uint8_t>(opposite(direction));
+				heap.push_back({ candidate, neighbour });
+				std::push_heap(heap.begin(), heap.end(), later);
+			}
+		}
+	}
+}
+
+void FlowField::repair(const NavigationGrid& grid, const std::vector<uint32_t>& changedCells) {
+	assert(grid.getWidth() == width && grid.getHeight() == height && "Flow field repaired with a different grid");
+
+	//a changed cell's cost feeds into every cell downstream of it, and diagonals that
+	//cut its corner may have opened or closed, so all of those start over
+	std::vector<uint8_t> invalid(integration.size(), 0);
+	std::vector<uint32_t> invalidCells;
+	auto invalidate = [&](uint32_t cell) {
+		if (invalid[cell]) return;
+		invalid[cell] = 1;
+		invalidCells.push_back(cell);
+	};
+	for (uint32_t cell : changedCells) {
+		invalidate(cell);
+		for (int direction = 0; direction < 8; direction++) {
+			uint32_t neighbour;
+			if (step(grid, cell, direction, neighbour) && directions[neighbour] % 2 == 1) {
+				invalidate(neighbour);
+			}
+		}
+	}
+	//the list doubles as the queue of cells whose children still need visiting
+	for (size_t visited = 0; visited < invalidCells.size(); visited++) {
+		uint32_t cell = invalidCells[visited];
+		int x = static_cast<int>(cell % width);
+		int y = static_cast<int>(cell / width);
+		for (int direction = 0; direction < 8; direction++) {
+			int nx = x + OFFSET_X[direction];
+			int ny = y + OFFSET_Y[direction];
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+			uint32_t neighbour = grid.cellIndex(nx, ny);
+			//children are the cells that step into this one
+			if (directions[neighbour] == opposite(direction)) {
+				invalidate(neighbour);
+			}
+		}
+	}
+
+	std::vector<HeapEntry> heap;
+	for (uint32_t cell : invalidCells) {
+		integration[cell] = UNREACHABLE;
+		directions[cell] = NO_DIRECTION;
+	}
+
+	//reseed the invalidated region from the valid cells around it
+	for (uint32_t cell : invalidCells) {
+		uint8_t cost = grid.getCost(cell);
+		if (cost == NavigationGrid::BLOCKED) continue;
+		if (cell == goal) {
+			integration[cell] = 0;
+			heap.push_back({ 0, cell });
+			continue;
+		}
+		for (int direction = 0; direction < 8; direction++) {
+			uint32_t neighbour;
+			if (!step(grid, cell, direction, neighbour) || invalid[neighbour] || integration[neighbour] == UNREACHABLE) continue;
+			uint32_t candidate = integration[neighbour] + cost * STEP_WEIGHT[direction];
+			if (candidate < integration[cell]) {
+				integration[cell] = candidate;
+				directions[cell] = static_cast<uint8_t>(direction);
+			}
+		}
+		if (integration[cell] != UNREACHABLE) {
+			heap.push_back({ integration[cell], cell });
+		}
+	}
+	//cheaper or newly open cells can shorten paths around them, expanding their valid
+	//neighbours again lets the lower costs flow outwards
+	for (uint32_t cell : changedCells) {
+		for (int direction = 0; direction < 8; direction++) {
+			uint32_t neighbour;
+			if (step(grid, cell, direction, neighbour) && !invalid[neighbour] && integration[neighbour] != UNREACHABLE) {
+				heap.push_back({ integration[neighbour], neighbour });
+			}
+		}
+	}
+
+	propagate(grid, heap);
+}
+
+uint32_t FlowField::cellAt(glm::vec2 position) const {
+	int x = std::clamp(static_cast<int>((position.x - origin.x) / cellSize), 0, width - 1);
+	int y = std::clamp(static_cast<int>((position.y - origin.y) / cellSize), 0, height - 1);
+	return static_cast<uint32_t>(y * width + x);
+}
+
+glm::vec2 FlowField::getDirection(glm::vec2 position) const {
+	return DIRECTIONS[directions[cellAt(position)]];
+}
+
+FlowFieldCache::FlowFieldCache(const NavigationGrid& grid, uint32_t maxFields)
+	: grid{ grid }, workerGrid{ grid }, maxFields{ std::max(maxFields, 1u) } {
+	worker = std::thread(&FlowFieldCache::workerLoop, this);
+}
+
+FlowFieldCache::~FlowFieldCache() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+std::shared_ptr<const FlowField> FlowFieldCache::request(glm::vec2 goal) {
+	uint32_t cell = grid.cellAt(goal);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = fields.find(cell);
+	if (found != fields.end()) {
+		recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, found->second.use);
+		return found->second.field;
+	}
+	if (std::find(pendingGoals.begin(), pendingGoals.end(), cell) == pendingGoals.end()) {
+		pendingGoals.push_back(cell);
+		wake.notify_one();
+	}
+	return nullptr;
+}
+
+void FlowFieldCache::setCost(uint32_t cell, uint8_t cost) {
+	if (grid.getCost(cell) == cost) return;
+	grid.setCost(cell, cost);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pendingEdits.push_back({ cell, cost });
+	wake.notify_one();
+}
+
+void FlowFieldCache::evict() {
+	while (fields.size() > maxFields) {
+		fields.erase(recentlyUsed.back());
+		recentlyUsed.pop_back();
+	}
+}
+
+void FlowFieldCache::workerLoop() {
+	using Clock = std::chrono::high_resolution_clock;
+
+	while (true) {
+		std::vector<std::pair<uint32_t, uint8_t>> edits;
+		std::vector<uint32_t> goals;
+		std::vector<std::shared_ptr<const FlowField>> cached;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || !pendingGoals.empty() || !pendingEdits.empty(); });
+			if (stopping) return;
+			edits.swap(pendingEdits);
+			goals.swap(pendingGoals);
+			if (!edits.empty()) {
+				for (auto& [goal, entry] : fields) {
+					cached.push_back(entry.field);
+				}
+			}
+		}
+
+		//edits go first so new fields are built over the latest costs
+		std::vector<uint32_t> changed;
+		for (auto [cell, cost] : edits) {
+			if (workerGrid.getCost(cell) == cost) continue;
+			workerGrid.setCost(cell, cost);
+			changed.push_back(cell);
+		}
+		if (!changed.empty()) {
+			for (auto& field : cached) {
+				auto start = Clock::now();
+				//repaired as a copy, units may still be reading the old one
+				auto repaired = std::make_shared<FlowField>(*field);
+				repaired->repair(workerGrid, changed);
+				double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+				std::lock_guard<std::mutex> lock(mutex);
+				auto found = fields.find(field->getGoal());
+				if (found != fields.end() && found->second.field == field) {
+					found->second.field = repaired;
+				}
+				repairs++;
+				repairMilliseconds += milliseconds;
+			}
+		}
+
+		for (uint32_t goal : goals) {
+			auto start = Clock::now();
+			auto field = std::make_shared<FlowField>(workerGrid, goal);
+			double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			recentlyUsed.push_front(goal);
+			fields[goal] = { field, recentlyUsed.begin() };
+			evict();
+			builds++;
+			buildMilliseconds += milliseconds;
+		}
+	}
+}
+
+void FlowFieldCache::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (builds > 0 || repairs > 0) {
+		LOG_INFO("Flow fields {} cached: {} builds avg {:.3f}ms, {} repairs avg {:.3f}ms",
+			fields.size(), builds, builds > 0 ? buildMilliseconds / builds : 0.0,
+			repairs, repairs > 0 ? repairMilliseconds / repairs : 0.0);
+	}
+	builds = repairs = 0;
+	buildMilliseconds = repairMilliseconds = 0.0;
+}
+
+void FlowFieldCache::benchmark() {
+	using Clock = std::chrono::high_resolution_clock;
+	const int size = 256;
+	const uint32_t units = 10000;
+	NavigationGrid grid{ size, size, 1.0f, glm::vec2(0.0f) };
+
+	uint32_t random = 2463534242u;
+	auto next = [&]() {
+		random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+		return random;
+	};
+	//scattered walls with some rough ground between them
+	for (uint32_t cell = 0; cell < size * size; cell++) {
+		uint32_t roll = next() % 100;
+		grid.setCost(cell, roll < 15 ? NavigationGrid::BLOCKED : roll < 30 ? 4 : 1);
+	}
+	uint32_t goal = grid.cellIndex(size / 2, size / 2);
+	grid.setCost(goal, 1);
+
+	auto start = Clock::now();
+	FlowField field{ grid, goal };
+	double buildMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	//toggle single cells and check every repair against a fresh build
+	const int edits = 100;
+	double repairMilliseconds = 0.0;
+	uint64_t expanded = 0;
+	uint32_t mismatches = 0;
+	for (int i = 0; i < edits; i++) {
+		uint32_t cell = next() % (size * size);
+		if (cell == goal) continue;
+		grid.setCost(cell, grid.getCost(cell) == NavigationGrid::BLOCKED ? 1 : NavigationGrid::BLOCKED);
+
+		start = Clock::now();
+		field.repair(grid, { cell });
+		repairMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		expanded += field.getExpandedCells();
+
+		FlowField reference{ grid, goal };
+		for (uint32_t check = 0; check < size * size; check++) {
+			if (field.getCost(check) != reference.getCost(check)) {
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	std::vector<glm::vec2> positions(units);
+	for (auto& position : positions) {
+		position = { (next() % (size * 1000)) / 1000.0f, (next() % (size * 1000)) / 1000.0f };
+	}
+	start = Clock::now();
+	glm::vec2 sum{ 0.0f };
+	for (const auto& position : positions) {
+		sum += field.getDirection(position);
+	}
+	double lookupMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	LOG_INFO("Flow field benchmark {}x{}: build {:.3f}ms, repair avg {:.3f}ms expanding {} cells, {} mismatched repairs, {} unit lookups {:.3f}ms ({})",
+		size, size, buildMilliseconds, repairMilliseconds / edits, expanded / edits, mismatches, units, lookupMilliseconds, sum.x + sum.y);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "utils.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// uniform grid of traversal costs the flow fields are integrated over
+// a cost is how expensive it is to move through a cell, BLOCKED cells can't be entered
+class NavigationGrid {
+public:
+	static constexpr uint8_t BLOCKED = 255;
+
+	NavigationGrid(int width, int height, float cellSize, glm::vec2 origin);
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	float getCellSize() const { return cellSize; }
+	glm::vec2 getOrigin() const { return origin; }
+
+	uint8_t getCost(uint32_t cell) const { return costs[cell]; }
+	void setCost(uint32_t cell, uint8_t cost) { costs[cell] = cost; }
+	uint32_t cellIndex(int x, int y) const { return static_cast<uint32_t>(y * width + x); }
+	// positions outside the grid are clamped to its border cells
+	uint32_t cellAt(glm::vec2 position) const;
+	glm::vec2 cellCenter(uint32_t cell) const;
+
+private:
+	int width;
+	int height;
+	float cellSize;
+	glm::vec2 origin;
+	std::vector<uint8_t> costs;
+};
+
+// shortest path costs from every cell to one goal cell, and the direction each cell steps in
+// to follow them. built once per goal with dijkstra over 8 connected cells, after that any
+// number of units find their way with one lookup each
+class FlowField {
+public:
+	static constexpr uint32_t UNREACHABLE = ~0u;
+	static constexpr uint8_t NO_DIRECTION = 8;
+
+	FlowField(const NavigationGrid& grid, uint32_t goal);
+
+	// recomputes only the cells whose paths went through changed cells, and lets cells that
+	// changed for the better pull their neighbours' costs down
+	// grid has to be the one the field was built over, with the new costs already applied
+	void repair(const NavigationGrid& grid, const std::vector<uint32_t>& changedCells);
+
+	uint32_t getGoal() const { return goal; }
+	uint32_t getCost(uint32_t cell) const { return integration[cell]; }
+	// unit vector to move along, zero at the goal and in cells the goal can't be reached from
+	glm::vec2 getDirection(glm::vec2 position) const;
+	// cells the last build or repair had to expand
+	uint32_t getExpandedCells() const { return expandedCells; }
+
+private:
+	int width;
+	int height;
+	float cellSize;
+	glm::vec2 origin;
+	uint32_t goal;
+
+	std::vector<uint32_t> integration;
+	// index into the neighbour offsets of the next cell towards the goal
+	std::vector<uint8_t> directions;
+	uint32_t expandedCells = 0;
+
+	uint32_t cellAt(glm::vec2 position) const;
+	// neighbour of cell in direction, false when that is off the grid or cuts a blocked corner
+	bool step(const NavigationGrid& grid, uint32_t cell, int direction, uint32_t& neighbour) const;
+	// relaxes outwards from the queued cells until every reachable cost is final
+	void propagate(const NavigationGrid& grid, std::vector<std::pair<uint32_t, uint32_t>>& heap);
+};
+
+// flow fields cached per goal cell and built on a background thread
+// request hands out the field for a goal if it is ready and queues a build otherwise, so a
+// new goal costs its units a few ticks of standing still instead of a frame spike. cost edits
+// are applied by the same thread, which repairs every cached field and swaps in the repaired
+// copies. fields are immutable once handed out, units can read them from any thread
+class FlowFieldCache {
+public:
+	FlowFieldCache(const NavigationGrid& grid, uint32_t maxFields);
+	~FlowFieldCache();
+
+	FlowFieldCache(const FlowFieldCache&) = delete;
+	FlowFieldCache& operator=(const FlowFieldCache&) = delete;
+
+	// null until the field for the goal's cell has been built
+	std::shared_ptr<const FlowField> request(glm::vec2 goal);
+	// the main thread's view of the grid, edits show up here immediately
+	const NavigationGrid& getGrid() const { return grid; }
+	void setCost(uint32_t cell, uint8_t cost);
+
+	// logs build and repair timings once a second when measure_flowfields is set
+	void report(double now);
+
+	// full builds against incremental repairs and per unit lookups on a large grid
+	static void benchmark();
+
+private:
+	struct Entry {
+		std::shared_ptr<const FlowField> field;
+		// position in the least recently used list
+		std::list<uint32_t>::iterator use;
+	};
+
+	NavigationGrid grid;
+	// the worker's copy, edits reach it in the order they were made
+	NavigationGrid workerGrid;
+	uint32_t maxFields;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	// everything below is shared with the worker and guarded by mutex
+	std::unordered_map<uint32_t, Entry> fields;
+	std::list<uint32_t> recentlyUsed;
+	std::vector<uint32_t> pendingGoals;
+	std::vector<std::pair<uint32_t, uint8_t>> pendingEdits;
+
+	const bool measure = Settings::settings.value("measure_flowfields", false);
+	uint32_t builds = 0;
+	uint32_t repairs = 0;
+	double buildMilliseconds = 0.0;
+	double repairMilliseconds = 0.0;
+	double lastReport = 0.0;
+
+	void workerLoop();
+	void evict();
+};
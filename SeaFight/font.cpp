@@ -0,0 +1,156 @@
+#include "font.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+//one byte per row, bit 4 is the leftmost pixel. covers ' ' through '_'
+static const uint8_t FONT_ROWS[Font::GLYPH_COUNT][Font::GLYPH_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// space
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },	// !
+	{ 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00 },	// double quote
+	{ 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },	// #
+	{ 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },	// $
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },	// %
+	{ 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },	// &
+	{ 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 },	// quote
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },	// (
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },	// )
+	{ 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },	// *
+	{ 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },	// +
+	{ 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },	// ,
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },	// -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },	// .
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },	// /
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },	// 0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },	// 2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },	// 3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },	// 4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },	// 5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },	// 6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },	// 7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },	// 8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },	// 9
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },	// :
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },	// ;
+	{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },	// <
+	{ 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },	// =
+	{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },	// >
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },	// ?
+	{ 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },	// @
+	{ 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// A
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },	// B
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },	// C
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },	// D
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },	// E
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },	// F
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },	// G
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// H
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },	// J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },	// K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },	// L
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },	// M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },	// N
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// O
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },	// P
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },	// Q
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },	// R
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },	// S
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },	// W
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },	// X
+	{ 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 },	// Y
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },	// Z
+	{ 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },	// [
+	{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },	// backslash
+	{ 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },	// ]
+	{ 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },	// ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },	// _
+};
+
+Font::Font(Device& device) {
+	auto start = std::chrono::high_resolution_clock::now();
+	createGlyphQuads();
+
+	uint32_t atlasWidth = ATLAS_COLUMNS * CELL_WIDTH;
+	uint32_t atlasHeight = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * CELL_HEIGHT;
+	std::vector<uint8_t> pixels(atlasWidth * atlasHeight, 0);
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		uint32_t x = (i % ATLAS_COLUMNS) * CELL_WIDTH;
+		uint32_t y = (i / ATLAS_COLUMNS) * CELL_HEIGHT;
+		renderDistanceField(FONT_ROWS[i], &pixels[y * atlasWidth + x], atlasWidth);
+	}
+	atlas = std::make_unique<Texture>(device, pixels, atlasWidth, atlasHeight, VK_FORMAT_R8_UNORM);
+
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+	LOG_DEBUG("Font atlas {}x{} generated in {:.2f}ms", atlasWidth, atlasHeight, elapsed.count());
+}
+
+void Font::createGlyphQuads() {
+	float atlasWidth = static_cast<float>(ATLAS_COLUMNS * CELL_WIDTH);
+	float atlasHeight = static_cast<float>((GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * CELL_HEIGHT);
+
+	//every quad covers its whole cell, the padding holds the outside of the distance field
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		GlyphQuad& glyph = glyphs[i];
+		glyph.offset = glm::vec2(-PADDING) / static_cast<float>(GLYPH_HEIGHT);
+		glyph.size = glm::vec2(GLYPH_WIDTH + 2 * PADDING, GLYPH_HEIGHT + 2 * PADDING) / static_cast<float>(GLYPH_HEIGHT);
+		glyph.uvRect = {
+			(i % ATLAS_COLUMNS) * CELL_WIDTH / atlasWidth,
+			(i / ATLAS_COLUMNS) * CELL_HEIGHT / atlasHeight,
+			CELL_WIDTH / atlasWidth,
+			CELL_HEIGHT / atlasHeight };
+	}
+}
+
+void Font::renderDistanceField(const uint8_t* rows, uint8_t* cell, uint32_t stride) {
+	auto filled = [rows](int x, int y) {
+		if (x < 0 || y < 0 || x >= GLYPH_WIDTH || y >= GLYPH_HEIGHT) return false;
+		return (rows[y] >> (GLYPH_WIDTH - 1 - x) & 1) != 0;
+	};
+
+	//exact distance to the font pixels as squares rather than to their centers,
+	//so the upscaled edges come out straight instead of rippled
+	for (int py = 0; py < CELL_HEIGHT; py++) {
+		for (int px = 0; px < CELL_WIDTH; px++) {
+			glm::vec2 point = glm::vec2(px + 0.5f, py + 0.5f) / static_cast<float>(SCALE) - glm::vec2(PADDING);
+
+			float inside = std::numeric_limits<float>::max();
+			float outside = std::numeric_limits<float>::max();
+			//one ring of empty pixels around the glyph is enough for a padding of one
+			for (int y = -PADDING; y < GLYPH_HEIGHT + PADDING; y++) {
+				for (int x = -PADDING; x < GLYPH_WIDTH + PADDING; x++) {
+					float dx = std::max({ x - point.x, 0.0f, point.x - (x + 1) });
+					float dy = std::max({ y - point.y, 0.0f, point.y - (y + 1) });
+					float distance = std::sqrt(dx * dx + dy * dy);
+					if (filled(x, y)) {
+						outside = std::min(outside, distance);
+					} else {
+						inside = std::min(inside, distance);
+					}
+				}
+			}
+
+			//0.5 is the edge and the field spans the padding on either side
+			float signedDistance = outside > 0.0f ? -outside : inside;
+			float value = 0.5f + 0.5f * std::clamp(signedDistance / PADDING, -1.0f, 1.0f);
+			cell[py * stride + px] = static_cast<uint8_t>(std::lround(value * 255.0f));
+		}
+	}
+}
+
+const Font::GlyphQuad& Font::getGlyph(char c) const {
+	int index = std::toupper(static_cast<unsigned char>(c)) - FIRST_CHAR;
+	if (index < 0 || index >= GLYPH_COUNT) {
+		index = '?' - FIRST_CHAR;
+	}
+	return glyphs[index];
+}
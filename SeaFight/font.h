@@ -0,0 +1,55 @@
+#pragma once
+
+#include "device.h"
+#include "texture.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// built in 5x7 pixel font turned into a signed distance field atlas at load time
+// the distance field keeps the edges crisp at any size and lets the shader draw outlines
+// lowercase letters map to uppercase and anything unsupported renders as '?'
+class Font {
+public:
+	// one glyph relative to the pen position, in units of the cap height and y down
+	struct GlyphQuad {
+		glm::vec2 offset;
+		glm::vec2 size;
+		glm::vec4 uvRect;
+	};
+
+	static constexpr int GLYPH_WIDTH = 5;
+	static constexpr int GLYPH_HEIGHT = 7;
+	static constexpr char FIRST_CHAR = ' ';
+	static constexpr int GLYPH_COUNT = 64;
+
+	Font(Device& device);
+
+	Font(const Font&) = delete;
+	Font& operator=(const Font&) = delete;
+
+	VkImageView getAtlasView() { return atlas->getImageView(); }
+	const GlyphQuad& getGlyph(char c) const;
+
+	// horizontal distance between pen positions and vertical distance between lines
+	float getAdvance() const { return static_cast<float>(GLYPH_WIDTH + 1) / GLYPH_HEIGHT; }
+	float getLineHeight() const { return static_cast<float>(GLYPH_HEIGHT + 2) / GLYPH_HEIGHT; }
+
+private:
+	// atlas pixels per font pixel, and the font pixels of distance kept around each glyph
+	static constexpr int SCALE = 4;
+	static constexpr int PADDING = 1;
+	static constexpr int CELL_WIDTH = (GLYPH_WIDTH + 2 * PADDING) * SCALE;
+	static constexpr int CELL_HEIGHT = (GLYPH_HEIGHT + 2 * PADDING) * SCALE;
+	static constexpr int ATLAS_COLUMNS = 8;
+
+	std::array<GlyphQuad, GLYPH_COUNT> glyphs;
+	std::unique_ptr<Texture> atlas;
+
+	void createGlyphQuads();
+	static void renderDistanceField(const uint8_t* rows, uint8_t* cell, uint32_t stride);
+};
@@ -0,0 +1,76 @@
+#include "frameArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#if SEAFIGHT_COUNT_ALLOCATIONS
+//per thread, so worker, audio and logging threads don't show up in the frame's count
+static thread_local uint64_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+	heapAllocations++;
+	if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+uint64_t FrameArena::threadHeapAllocations() {
+	return heapAllocations;
+}
+#else
+uint64_t FrameArena::threadHeapAllocations() {
+	return 0;
+}
+#endif
+
+FrameArena::FrameArena(size_t capacity) : memory{ new std::byte[capacity] }, capacity{ capacity } {}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+	assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	//new[] hands back memory aligned for any fundamental type, offsets are aligned from there
+	size_t offset = (used + alignment - 1) & ~(alignment - 1);
+	if (offset + size <= capacity) {
+		used = offset + size;
+		return memory.get() + offset;
+	}
+
+	//one block per allocation that didn't fit, the next reset makes room for them
+	overflow.emplace_back(new std::byte[size + alignment]);
+	overflowBytes += size + alignment;
+	uintptr_t address = reinterpret_cast<uintptr_t>(overflow.back().get());
+	return reinterpret_cast<void*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
+
+void FrameArena::reset() {
+	highWater = std::max(highWater, used + overflowBytes);
+	if (!overflow.empty()) {
+		overflow.clear();
+		overflowBytes = 0;
+		//grows to the most any frame has needed, with room to spare
+		capacity = highWater + highWater / 2;
+		memory.reset(new std::byte[capacity]);
+	}
+	used = 0;
+}
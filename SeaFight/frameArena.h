@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// counts every heap allocation made through operator new so frames can be checked for them.
+// non dev (NDEBUG) builds leave operator new alone and the count stays at zero
+#ifndef SEAFIGHT_COUNT_ALLOCATIONS
+#ifdef NDEBUG
+#define SEAFIGHT_COUNT_ALLOCATIONS 0
+#else
+#define SEAFIGHT_COUNT_ALLOCATIONS 1
+#endif
+#endif
+
+// bump allocator for memory that only lives for one frame
+// the renderer keeps one per frame in flight and resets it once that frame's fence has
+// signalled, so anything allocated while recording a frame stays valid until the gpu is done
+// with it. nothing is freed on its own, deallocating is a no op. running out chains a heap
+// block, and the next reset grows the arena to fit so later frames stop touching the heap
+class FrameArena {
+public:
+	explicit FrameArena(size_t capacity);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+	// forgets everything allocated since the last reset
+	void reset();
+
+	size_t getCapacity() const { return capacity; }
+	size_t getUsed() const { return used + overflowBytes; }
+	// most bytes a frame has used since the arena was made
+	size_t getHighWater() const { return highWater; }
+
+	// heap allocations made on the calling thread so far, always zero when not counted
+	static uint64_t threadHeapAllocations();
+
+private:
+	std::unique_ptr<std::byte[]> memory;
+	size_t capacity;
+	size_t used = 0;
+	// blocks for what didn't fit, freed on reset
+	std::vector<std::unique_ptr<std::byte[]>> overflow;
+	size_t overflowBytes = 0;
+	size_t highWater = 0;
+};
+
+// stl allocator on top of a FrameArena, one made without an arena goes to the heap instead
+template <typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator() = default;
+	ArenaAllocator(FrameArena& arena) : arena{ &arena } {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena{ other.arena } {}
+
+	T* allocate(size_t count) {
+		if (arena) return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+		return std::allocator<T>{}.allocate(count);
+	}
+	void deallocate(T* pointer, size_t count) {
+		if (!arena) std::allocator<T>{}.deallocate(pointer, count);
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+	template <typename U>
+	friend class ArenaAllocator;
+
+	FrameArena* arena = nullptr;
+};
+
+// scratch vector that lives until the arena it came from is reset
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,181 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include "framePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "log.h"
+
+FramePacer::FramePacer() {
+	double rate = targetRate;
+	if (rate <= 0.0) {
+		const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		rate = mode != nullptr ? mode->refreshRate : 0.0;
+	}
+	frameInterval = enabled && rate > 0.0 ? 1.0 / rate : 0.0;
+	//display timing is only known once there is a swapchain, until then assume the limiter runs
+	setFineTimer(frameInterval > 0.0);
+
+	LOG_DEBUG("Frame pacing: {}, target {:.1f}fps", enabled ? "on" : "off", frameInterval > 0.0 ? 1.0 / frameInterval : 0.0);
+}
+
+FramePacer::~FramePacer() {
+	setFineTimer(false);
+}
+
+void FramePacer::setFineTimer(bool fine) {
+	if (fineTimer == fine) return;
+	fineTimer = fine;
+#ifdef _WIN32
+	//default timer resolution is ~15.6ms, far too coarse to sleep inside a frame, but a
+	//finer one costs power system wide so it is only held while the limiter sleeps
+	if (fine) {
+		timeBeginPeriod(1);
+	} else {
+		timeEndPeriod(1);
+	}
+#endif
+}
+
+void FramePacer::waitForNextFrame() {
+	//scheduled presents hold their images, which already blocks acquire at the right rate
+	if (frameInterval <= 0.0 || useDisplayTiming) return;
+
+	double now = glfwGetTime();
+	if (now < nextFrameTime) {
+		sleepUntil(nextFrameTime);
+		nextFrameTime += frameInterval;
+	} else if (now - nextFrameTime < frameInterval) {
+		//slightly late, keep the cadence instead of shifting every following frame
+		nextFrameTime += frameInterval;
+	} else {
+		//too far behind to catch up without a burst of frames
+		nextFrameTime = now + frameInterval;
+	}
+}
+
+void FramePacer::sleepUntil(double time) {
+	//sleep in short steps while clearly ahead, the os can overshoot by an unpredictable
+	//amount so the estimate keeps a standard deviation of margin
+	double now = glfwGetTime();
+	while (time - now > sleepEstimate) {
+		double start = now;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = glfwGetTime();
+		updateSleepEstimate(now - start);
+	}
+
+	//spin the rest, it is too short to trust the scheduler with
+	while (glfwGetTime() < time) {
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::updateSleepEstimate(double observed) {
+	//capped so the estimate keeps following changes in system load
+	sleepSamples = std::min(sleepSamples + 1, 1000u);
+	double delta = observed - sleepMean;
+	sleepMean += delta / sleepSamples;
+	sleepM2 += delta * (observed - sleepMean);
+	if (sleepSamples > 1) {
+		sleepEstimate = sleepMean + std::sqrt(std::max(sleepM2 / (sleepSamples - 1), 0.0));
+	}
+}
+
+void FramePacer::refreshDisplayTiming(Renderer& renderer) {
+	if (timingSwapchainVersion == renderer.getSwapChainVersion()) return;
+	timingSwapchainVersion = renderer.getSwapChainVersion();
+
+	//present ids and timings belong to the old swapchain
+	lastFeedbackId = 0;
+	lastActualPresent = 0;
+	useDisplayTiming = enabled && renderer.getRefreshDuration(refreshDuration);
+	setFineTimer(frameInterval > 0.0 && !useDisplayTiming);
+	if (!useDisplayTiming) return;
+
+	//presents land on whole refresh cycles, so the target rate is rounded to one
+	double intervalNs = frameInterval > 0.0 ? frameInterval * 1e9 : static_cast<double>(refreshDuration);
+	refreshesPerFrame = std::max(1u, static_cast<uint32_t>(std::lround(intervalNs / refreshDuration)));
+	LOG_DEBUG("Display timing: refresh {:.3f}ms, presenting every {} refreshes",
+		refreshDuration / 1e6, refreshesPerFrame);
+}
+
+const VkPresentTimeGOOGLE* FramePacer::schedulePresent(Renderer& renderer) {
+	refreshDisplayTiming(renderer);
+	if (!useDisplayTiming) return nullptr;
+
+	presentTime.presentID = nextPresentId++;
+	presentTime.desiredPresentTime = 0;
+	if (lastActualPresent != 0) {
+		//extrapolate from the last present we know landed, half a refresh early so the
+		//image is ready for the intended vblank rather than the one after it
+		uint64_t cycles = static_cast<uint64_t>(presentTime.presentID - lastFeedbackId) * refreshesPerFrame;
+		presentTime.desiredPresentTime = lastActualPresent + cycles * refreshDuration - refreshDuration / 2;
+	}
+	return &presentTime;
+}
+
+void FramePacer::framePresented(Renderer& renderer, double now) {
+	if (!useDisplayTiming) {
+		if (lastCpuPresent > 0.0) {
+			addDelta((now - lastCpuPresent) * 1000.0, false);
+		}
+		lastCpuPresent = now;
+		return;
+	}
+
+	pastTimings.clear();
+	renderer.getPastPresentationTimings(pastTimings);
+	for (const auto& timing : pastTimings) {
+		if (timing.presentID <= lastFeedbackId) continue;
+
+		if (lastActualPresent != 0) {
+			//a present scheduled for a vblank that landed on a later one
+			bool missed = timing.desiredPresentTime != 0 &&
+				timing.actualPresentTime > timing.desiredPresentTime + refreshDuration;
+			addDelta((timing.actualPresentTime - lastActualPresent) / 1e6, missed);
+		}
+		lastFeedbackId = timing.presentID;
+		lastActualPresent = timing.actualPresentTime;
+	}
+}
+
+void FramePacer::addDelta(double milliseconds, bool missed) {
+	if (!logTiming) return;
+
+	if (samples == 0) {
+		minDelta = maxDelta = milliseconds;
+	}
+	samples++;
+	sumDelta += milliseconds;
+	sumDeltaSquared += milliseconds * milliseconds;
+	minDelta = std::min(minDelta, milliseconds);
+	maxDelta = std::max(maxDelta, milliseconds);
+	if (missed) missedPresents++;
+
+	LOG_TRACE("Present delta {:.3f}ms{}", milliseconds, missed ? " (missed)" : "");
+}
+
+void FramePacer::report(double now) {
+	if (!logTiming || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		double mean = sumDelta / samples;
+		double jitter = std::sqrt(std::max(sumDeltaSquared / samples - mean * mean, 0.0));
+		LOG_INFO("Present deltas over {} frames ({}): avg {:.2f}ms min {:.2f}ms max {:.2f}ms jitter {:.2f}ms, {} missed",
+			samples, useDisplayTiming ? "display" : "cpu", mean, minDelta, maxDelta, jitter, missedPresents);
+	}
+	samples = 0;
+	sumDelta = sumDeltaSquared = 0.0;
+	missedPresents = 0;
+}
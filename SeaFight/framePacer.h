@@ -0,0 +1,79 @@
+#pragma once
+
+#include "renderer.h"
+#include "utils.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// keeps frames evenly spaced and caps how fast they are produced
+// with VK_GOOGLE_display_timing every present is scheduled onto a refresh cycle and the
+// actual present times are read back, the held images then throttle acquire on their own
+// without it a sleep plus spin limiter holds the target rate on the cpu
+// present to present deltas are logged either way so microstutter shows up in the log
+class FramePacer {
+public:
+	// queries the monitor refresh rate, so glfw has to be initialized
+	FramePacer();
+	~FramePacer();
+
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// blocks until the next frame is due, call before input is sampled for the frame
+	void waitForNextFrame();
+	// the present time to hand to Renderer::endFrame, nullptr when presents aren't scheduled
+	const VkPresentTimeGOOGLE* schedulePresent(Renderer& renderer);
+	// the frame was just queued for present, now is the cpu time after vkQueuePresentKHR
+	void framePresented(Renderer& renderer, double now);
+	// logs the present stats about once per second
+	void report(double now);
+
+private:
+	const bool enabled = Settings::settings.value("frame_pacing", true);
+	// frames per second, 0 follows the monitor refresh rate
+	const double targetRate = Settings::settings.value("target_frame_rate", 0.0);
+	const bool logTiming = Settings::settings.value("log_present_timing", false);
+
+	// seconds between frames, 0 when uncapped
+	double frameInterval = 0.0;
+	double nextFrameTime = 0.0;
+
+	// running mean and variance of how long a 1ms sleep really takes
+	double sleepMean = 0.0;
+	double sleepM2 = 0.0;
+	uint32_t sleepSamples = 0;
+	double sleepEstimate = 0.002;
+	// whether the 1ms system timer resolution is held for the sleep plus spin limiter
+	bool fineTimer = false;
+
+	// display timing, refreshed whenever the swapchain is recreated
+	bool useDisplayTiming = false;
+	uint32_t timingSwapchainVersion = ~0u;
+	uint64_t refreshDuration = 0;
+	uint32_t refreshesPerFrame = 1;
+	uint32_t nextPresentId = 1;
+	uint32_t lastFeedbackId = 0;
+	uint64_t lastActualPresent = 0;
+	VkPresentTimeGOOGLE presentTime{};
+	std::vector<VkPastPresentationTimingGOOGLE> pastTimings;
+
+	// cpu side deltas when there is no display feedback
+	double lastCpuPresent = 0.0;
+
+	uint32_t samples = 0;
+	double sumDelta = 0.0;
+	double sumDeltaSquared = 0.0;
+	double minDelta = 0.0;
+	double maxDelta = 0.0;
+	uint32_t missedPresents = 0;
+	double lastReport = 0.0;
+
+	void setFineTimer(bool fine);
+	void sleepUntil(double time);
+	void updateSleepEstimate(double observed);
+	void refreshDisplayTiming(Renderer& renderer);
+	void addDelta(double milliseconds, bool missed);
+};
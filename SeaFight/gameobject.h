@@ -1,5 +1,6 @@
 #pragma once
 
+#include "assetRegistry.h"
 #include "sprite.h"
 
 #include <glm/glm.hpp>
@@ -26,28 +27,35 @@ struct Transform2dComponent {
   }
 };
 
+// sprite sheet animation evaluated on the gpu, see AnimationLibrary
+struct AnimationComponent {
+  uint32_t clip = Sprite::NO_CLIP;
+  // seconds in the frame time clock
+  float startTime = 0.0f;
+  // negative plays backwards
+  float speed = 1.0f;
+};
+
+// identified by the Entity handle it was spawned with, see EntityRegistry
 class GameObject {
  public:
-  using id_t = unsigned int;
-
-  static GameObject createGameObject() {
-    static id_t currentId = 0;
-    return GameObject{currentId++};
-  }
+  static GameObject createGameObject() { return GameObject{}; }
 
   GameObject(const GameObject &) = delete;
   GameObject &operator=(const GameObject &) = delete;
   GameObject(GameObject &&) = default;
   GameObject &operator=(GameObject &&) = default;
 
-  id_t getId() { return id; }
-
-  std::shared_ptr<Sprite> sprite{};
+  // objects without a sprite aren't drawn
+  SpriteHandle sprite{};
   glm::vec3 color{};
   Transform2dComponent transform2d{};
+  // draw depth in [0, 1), 0 is nearest
+  float depth = 0.5f;
+  // transparent sprites are blended back to front after everything opaque
+  bool transparent = false;
+  AnimationComponent animation{};
 
  private:
-  GameObject(id_t objId) : id{objId} {}
-
-  id_t id;
+  GameObject() = default;
 };
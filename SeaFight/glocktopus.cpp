@@ -0,0 +1,112 @@
+#include "glocktopus.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+Glocktopus::Glocktopus(Device& device) {
+	buildSkeleton();
+	buildMesh(device);
+	buildIdleClip();
+}
+
+void Glocktopus::buildSkeleton() {
+	body = skeleton.addBone(-1, {});
+
+	//tentacles start on the rim pointing outwards, each segment continues straight on
+	for (uint32_t tentacle = 0; tentacle < TENTACLES; tentacle++) {
+		float angle = glm::two_pi<float>() * tentacle / TENTACLES;
+		int parent = static_cast<int>(body);
+		for (uint32_t segment = 0; segment < SEGMENTS; segment++) {
+			BoneTransform bind{};
+			if (segment == 0) {
+				bind.translation = glm::vec2(std::cos(angle), std::sin(angle)) * BODY_RADIUS;
+				bind.rotation = angle;
+			}
+			else {
+				bind.translation = { SEGMENT_LENGTH, 0.0f };
+			}
+			parent = static_cast<int>(skeleton.addBone(parent, bind));
+			tentacleBones.push_back(static_cast<uint32_t>(parent));
+		}
+	}
+}
+
+void Glocktopus::buildMesh(Device& device) {
+	std::vector<SkinnedMesh::Vertex> vertices;
+	std::vector<uint16_t> indices;
+
+	//body is a fan around its center, rigid on the body bone
+	const uint32_t rim = 16;
+	vertices.push_back(SkinnedMesh::Vertex::pack({ 0.0f, 0.0f }, { 0.5f, 0.5f }, { body, 0, 0, 0 }, { 1.0f, 0.0f, 0.0f, 0.0f }));
+	for (uint32_t i = 0; i < rim; i++) {
+		float angle = glm::two_pi<float>() * i / rim;
+		glm::vec2 direction{ std::cos(angle), std::sin(angle) };
+		vertices.push_back(SkinnedMesh::Vertex::pack(direction * BODY_RADIUS * 1.15f, glm::vec2(0.5f) + direction * 0.5f, { body, 0, 0, 0 }, { 1.0f, 0.0f, 0.0f, 0.0f }));
+		indices.push_back(0);
+		indices.push_back(static_cast<uint16_t>(1 + i));
+		indices.push_back(static_cast<uint16_t>(1 + (i + 1) % rim));
+	}
+
+	//tentacles are tapering strips with a pair of vertices at every joint and mid segment
+	//joints blend the two bones meeting there, so the strip bends smoothly instead of creasing
+	const uint32_t rows = SEGMENTS * 2 + 1;
+	const float length = SEGMENT_LENGTH * SEGMENTS;
+	for (uint32_t tentacle = 0; tentacle < TENTACLES; tentacle++) {
+		const Affine2D& base = skeleton.getBindWorld(tentacleBones[tentacle * SEGMENTS]);
+		uint16_t first = static_cast<uint16_t>(vertices.size());
+
+		for (uint32_t row = 0; row < rows; row++) {
+			uint32_t segment = std::min(row / 2, SEGMENTS - 1);
+			uint32_t bone = tentacleBones[tentacle * SEGMENTS + segment];
+			glm::uvec4 joints{ bone, 0, 0, 0 };
+			glm::vec4 weights{ 1.0f, 0.0f, 0.0f, 0.0f };
+			if (row % 2 == 0 && row < rows - 1) {
+				//joint row, shared with the bone before it
+				joints.y = segment == 0 ? body : tentacleBones[tentacle * SEGMENTS + segment - 1];
+				weights = { 0.5f, 0.5f, 0.0f, 0.0f };
+			}
+
+			float along = row * length / (rows - 1);
+			float halfWidth = 0.08f * (1.0f - 0.8f * along / length);
+			for (int side = -1; side <= 1; side += 2) {
+				glm::vec2 position = base.apply({ along, side * halfWidth });
+				glm::vec2 texCoord{ side < 0 ? 0.0f : 1.0f, along / length };
+				vertices.push_back(SkinnedMesh::Vertex::pack(position, texCoord, joints, weights));
+			}
+		}
+
+		for (uint32_t row = 0; row + 1 < rows; row++) {
+			uint16_t a = static_cast<uint16_t>(first + row * 2);
+			indices.insert(indices.end(), { a, static_cast<uint16_t>(a + 1), static_cast<uint16_t>(a + 2) });
+			indices.insert(indices.end(), { static_cast<uint16_t>(a + 1), static_cast<uint16_t>(a + 3), static_cast<uint16_t>(a + 2) });
+		}
+	}
+
+	mesh = std::make_unique<SkinnedMesh>(device, vertices, indices);
+}
+
+void Glocktopus::buildIdleClip() {
+	const float duration = 2.0f;
+	idle = SkeletalClip::bake(skeleton, duration, 30.0f, true, [&](uint32_t bone, float time) {
+		BoneTransform transform = skeleton.getBindTransform(bone);
+		float phase = glm::two_pi<float>() * time / duration;
+
+		//body breathes
+		if (bone == body) {
+			float pulse = 1.0f + 0.05f * std::sin(phase);
+			transform.scale = { pulse, pulse };
+			return transform;
+		}
+
+		//tentacle bones follow the body in order, a wave travels down each one with
+		//neighbours out of step, growing towards the tip
+		uint32_t index = bone - 1;
+		uint32_t tentacle = index / SEGMENTS;
+		uint32_t segment = index % SEGMENTS;
+		float wave = std::sin(phase - segment * 0.9f + tentacle * glm::two_pi<float>() * 3.0f / TENTACLES);
+		transform.rotation += wave * (0.12f + 0.08f * segment);
+		return transform;
+	});
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "device.h"
+#include "skeleton.h"
+#include "skinnedRenderer.h"
+
+#include <memory>
+#include <vector>
+
+// procedurally rigged glocktopus, a round body with tentacles of chained bones
+// built in code until rigs can be authored and loaded
+class Glocktopus {
+public:
+	static constexpr uint32_t TENTACLES = 8;
+	static constexpr uint32_t SEGMENTS = 4;
+
+	Glocktopus(Device& device);
+
+	Glocktopus(const Glocktopus&) = delete;
+	Glocktopus& operator=(const Glocktopus&) = delete;
+
+	const Skeleton& getSkeleton() const { return skeleton; }
+	const SkinnedMesh& getMesh() const { return *mesh; }
+	const SkeletalClip& getIdleClip() const { return idle; }
+
+private:
+	static constexpr float BODY_RADIUS = 0.3f;
+	static constexpr float SEGMENT_LENGTH = 0.22f;
+
+	Skeleton skeleton;
+	uint32_t body = 0;
+	// bones[tentacle * SEGMENTS + segment]
+	std::vector<uint32_t> tentacleBones;
+	std::unique_ptr<SkinnedMesh> mesh;
+	SkeletalClip idle;
+
+	void buildSkeleton();
+	void buildMesh(Device& device);
+	void buildIdleClip();
+};
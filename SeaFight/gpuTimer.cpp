@@ -0,0 +1,64 @@
+#include "gpuTimer.h"
+
+#include <stdexcept>
+
+#include "log.h"
+
+GpuTimer::GpuTimer(Device& device) : device{ device } {
+	//guarantees every graphics queue supports timestamps
+	if (!device.properties.limits.timestampComputeAndGraphics) {
+		LOG_WARN("Timestamp queries are not supported, gpu frame time will not be measured");
+		return;
+	}
+	nanosecondsPerTick = device.properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = 2 * Swapchain::MAX_FRAMES_IN_FLIGHT;
+	if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create timestamp query pool!");
+		throw std::runtime_error("Failed to create timestamp query pool!");
+	}
+}
+
+GpuTimer::~GpuTimer() {
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device.device(), queryPool, nullptr);
+	}
+}
+
+bool GpuTimer::collect(int frameIndex, double& milliseconds) {
+	if (!isSupported() || !pending[frameIndex]) return false;
+	pending[frameIndex] = false;
+
+	uint64_t timestamps[2];
+	VkResult result = vkGetQueryPoolResults(
+		device.device(),
+		queryPool,
+		static_cast<uint32_t>(frameIndex * 2),
+		2,
+		sizeof(timestamps),
+		timestamps,
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS || timestamps[1] < timestamps[0]) return false;
+
+	milliseconds = static_cast<double>(timestamps[1] - timestamps[0]) * nanosecondsPerTick / 1000000.0;
+	return true;
+}
+
+void GpuTimer::begin(VkCommandBuffer commandBuffer, int frameIndex) {
+	if (!isSupported()) return;
+
+	uint32_t first = static_cast<uint32_t>(frameIndex * 2);
+	vkCmdResetQueryPool(commandBuffer, queryPool, first, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, first);
+}
+
+void GpuTimer::end(VkCommandBuffer commandBuffer, int frameIndex) {
+	if (!isSupported()) return;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, static_cast<uint32_t>(frameIndex * 2 + 1));
+	pending[frameIndex] = true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "device.h"
+#include "swapchain.h"
+
+// measures how long the gpu spends on each frame with a pair of timestamp queries
+// results are read back once the frame's fence has signaled, so they lag a couple of frames
+class GpuTimer {
+public:
+	GpuTimer(Device& device);
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+	// gpu time of the frame that last used this slot, false if there is none
+	// the slot's fence must have been waited on
+	bool collect(int frameIndex, double& milliseconds);
+	// both must be recorded outside of a render pass
+	void begin(VkCommandBuffer commandBuffer, int frameIndex);
+	void end(VkCommandBuffer commandBuffer, int frameIndex);
+
+private:
+	Device& device;
+
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	double nanosecondsPerTick = 1.0;
+	std::array<bool, Swapchain::MAX_FRAMES_IN_FLIGHT> pending{};
+};
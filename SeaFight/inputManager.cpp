@@ -1,10 +1,105 @@
 #include "inputManager.h"
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
-bool InputManager::keys[350];
+bool InputManager::firstMouse = true;
+RingBuffer<InputEvent, 256> InputManager::events;
+uint32_t InputManager::dropped = 0;
+
+bool InputManager::keys[KEY_COUNT];
+bool InputManager::pressed[KEY_COUNT];
+
+double InputManager::lastX = 0.0, InputManager::lastY = 0.0;
+double InputManager::xoffset = 0.0, InputManager::yoffset = 0.0;
+
+bool InputManager::pushEvent(const InputEvent& event) {
+	if (!events.push(event)) {
+		dropped++;
+		return false;
+	}
+	return true;
+}
 
 void InputManager::key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	keys[key] = action;
+	//GLFW_KEY_UNKNOWN is -1, media keys etc. have no slot in the state table
+	if (key < 0 || key >= KEY_COUNT) {
+		return;
+	}
+	//key repeats carry no new state
+	if (action == GLFW_REPEAT) {
+		return;
+	}
+
+	InputEvent event{};
+	event.type = InputEvent::Type::Key;
+	event.key = key;
+	event.action = action;
+	event.mods = mods;
+	event.time = glfwGetTime();
+	pushEvent(event);
+}
+
+void InputManager::mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+	InputEvent event{};
+	event.type = InputEvent::Type::MouseMove;
+	event.x = xpos;
+	event.y = ypos;
+	event.time = glfwGetTime();
+	pushEvent(event);
+}
+
+bool InputManager::pollEvent(InputEvent& event) {
+	if (!events.pop(event)) {
+		return false;
+	}
+
+	switch (event.type) {
+	case InputEvent::Type::Key:
+		keys[event.key] = event.action != GLFW_RELEASE;
+		if (event.action == GLFW_PRESS) {
+			pressed[event.key] = true;
+		}
+		break;
+	case InputEvent::Type::MouseMove:
+		if (firstMouse) {
+			lastX = event.x;
+			lastY = event.y;
+			firstMouse = false;
+		}
+		xoffset += event.x - lastX;
+		yoffset += lastY - event.y;
+		lastX = event.x;
+		lastY = event.y;
+		break;
+	}
+	return true;
+}
+
+void InputManager::beginTick() {
+	std::memset(pressed, 0, sizeof(pressed));
+	xoffset = 0.0;
+	yoffset = 0.0;
+}
+
+bool InputManager::isKeyDown(int key) {
+	if (key < 0 || key >= KEY_COUNT) {
+		return false;
+	}
+	//a press released within the same tick still counts as held for that tick
+	return keys[key] || pressed[key];
+}
+
+bool InputManager::wasKeyPressed(int key) {
+	if (key < 0 || key >= KEY_COUNT) {
+		return false;
+	}
+	return pressed[key];
+}
+
+uint32_t InputManager::takeDroppedCount() {
+	uint32_t count = dropped;
+	dropped = 0;
+	return count;
 }
@@ -1,16 +1,57 @@
 #pragma once
 
+#include <cstdint>
+
 #include <GLFW/glfw3.h>
 
+#include "ringBuffer.h"
+
+// a single input event as seen by the glfw callbacks
+// time is glfwGetTime() at the moment the callback fired
+struct InputEvent {
+	enum class Type : uint8_t { Key, MouseMove };
+
+	Type type;
+	int key;
+	int action;
+	int mods;
+	double x;
+	double y;
+	double time;
+};
+
+// collects glfw input into an ordered, timestamped event queue
+// the simulation tick drains the queue so presses shorter than a tick are never lost
 class InputManager {
 private:
 	static bool firstMouse;
+	static RingBuffer<InputEvent, 256> events;
+	static uint32_t dropped;
+
+	static bool pushEvent(const InputEvent& event);
 public:
-	static bool keys[350];
+	static constexpr int KEY_COUNT = GLFW_KEY_LAST + 1;
+
+	// current held state, updated as events are drained
+	static bool keys[KEY_COUNT];
+	// set when a key went down during the last drained tick, even if it was released again
+	static bool pressed[KEY_COUNT];
+
 	static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 	static double lastX, lastY;
 	static double xoffset, yoffset;
-	
+
 	static void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-};
\ No newline at end of file
+
+	// pops the oldest queued event, applying it to the key state
+	static bool pollEvent(InputEvent& event);
+	// clears the per tick pressed flags, call once at the start of every simulation tick
+	static void beginTick();
+
+	static bool isKeyDown(int key);
+	static bool wasKeyPressed(int key);
+
+	// events lost because the queue was full, reset on read
+	static uint32_t takeDroppedCount();
+};
@@ -0,0 +1,97 @@
+#include "jobSystem.h"
+
+#include "log.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t workerCount) {
+	if (workerCount == 0) {
+		uint32_t hardware = std::thread::hardware_concurrency();
+		workerCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++) {
+		workers.emplace_back(&JobSystem::workerLoop, this);
+	}
+	LOG_DEBUG("Job system started {} workers", workerCount);
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t batchSize, const RangeFn& fn) {
+	if (count == 0) return;
+	batchSize = std::max(batchSize, 1u);
+
+	//not worth waking anyone for a single batch
+	if (count <= batchSize || workers.empty()) {
+		fn(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &fn;
+		jobCount = count;
+		jobBatchSize = batchSize;
+		nextIndex.store(0, std::memory_order_relaxed);
+		completed.store(0, std::memory_order_relaxed);
+		generation++;
+	}
+	wake.notify_all();
+
+	//the caller works too instead of sleeping
+	runBatches();
+
+	//batches are short, spinning beats a round trip through the scheduler
+	while (completed.load(std::memory_order_acquire) < count) {
+		std::this_thread::yield();
+	}
+
+	//no worker can join once the job is cleared, the ones still inside only find the
+	//range exhausted, but they read its bounds so the next job has to wait for them
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = nullptr;
+	}
+	while (active.load(std::memory_order_acquire) > 0) {
+		std::this_thread::yield();
+	}
+}
+
+void JobSystem::runBatches() {
+	while (true) {
+		uint32_t begin = nextIndex.fetch_add(jobBatchSize, std::memory_order_relaxed);
+		if (begin >= jobCount) return;
+
+		uint32_t end = std::min(begin + jobBatchSize, jobCount);
+		(*job)(begin, end);
+		completed.fetch_add(end - begin, std::memory_order_release);
+	}
+}
+
+void JobSystem::workerLoop() {
+	uint64_t seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || (generation != seenGeneration && job != nullptr); });
+			if (stopping) return;
+			seenGeneration = generation;
+			//registered under the lock, so it can only happen while the job is still set
+			active.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		runBatches();
+		active.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed pool of worker threads for data parallel work inside a frame
+// parallelFor splits a range into batches that the workers and the calling thread pull
+// from a shared counter, and returns once every batch has run. only one thread may
+// issue work at a time, the main loop is expected to be that thread
+class JobSystem {
+public:
+	using RangeFn = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// 0 workers picks one less than the hardware thread count, the caller makes up the rest
+	JobSystem(uint32_t workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// runs fn over [0, count) in batches of up to batchSize and blocks until all are done
+	void parallelFor(uint32_t count, uint32_t batchSize, const RangeFn& fn);
+
+	uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	uint64_t generation = 0;
+
+	// the range currently being worked on
+	const RangeFn* job = nullptr;
+	uint32_t jobCount = 0;
+	uint32_t jobBatchSize = 1;
+	std::atomic<uint32_t> nextIndex{ 0 };
+	std::atomic<uint32_t> completed{ 0 };
+	// workers still inside the current job, it can't be replaced until this is zero
+	std::atomic<uint32_t> active{ 0 };
+
+	void workerLoop();
+	void runBatches();
+};
@@ -0,0 +1,58 @@
+#include "latencyTracker.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+void LatencyTracker::inputApplied(double inputTime) {
+	if (!enabled) return;
+
+	//only the oldest input matters, later ones in the same frame have less latency
+	if (pendingInput < 0.0 || inputTime < pendingInput) {
+		pendingInput = inputTime;
+	}
+}
+
+void LatencyTracker::framePresented(int frameIndex, double now) {
+	if (!enabled) return;
+
+	frameCounter++;
+	FrameSample& sample = frames[frameIndex];
+	sample.valid = pendingInput >= 0.0;
+	sample.frameNumber = frameCounter;
+	sample.inputTime = pendingInput;
+	sample.presentTime = now;
+	pendingInput = -1.0;
+}
+
+void LatencyTracker::frameCompleted(int frameIndex, double now) {
+	if (!enabled) return;
+
+	FrameSample& sample = frames[frameIndex];
+	if (!sample.valid) return;
+
+	double toPresent = (sample.presentTime - sample.inputTime) * 1000.0;
+	double toComplete = (now - sample.inputTime) * 1000.0;
+	samples++;
+	sumPresent += toPresent;
+	sumComplete += toComplete;
+	maxPresent = std::max(maxPresent, toPresent);
+	maxComplete = std::max(maxComplete, toComplete);
+
+	LOG_TRACE("Input latency frame {}: present {:.2f}ms, gpu done {:.2f}ms",
+		sample.frameNumber, toPresent, toComplete);
+	sample.valid = false;
+}
+
+void LatencyTracker::report(double now) {
+	if (!enabled || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		LOG_INFO("Input latency over {} frames: present avg {:.2f}ms max {:.2f}ms, gpu done avg {:.2f}ms max {:.2f}ms",
+			samples, sumPresent / samples, maxPresent, sumComplete / samples, maxComplete);
+	}
+	samples = 0;
+	sumPresent = maxPresent = 0.0;
+	sumComplete = maxComplete = 0.0;
+}
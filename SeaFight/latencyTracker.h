@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "swapchain.h"
+
+// instrumentation for end to end input latency
+// input applied by a simulation tick is tagged onto the next frame that gets submitted,
+// that frame is then timed when it is queued for present and when its fence signals
+class LatencyTracker {
+public:
+	LatencyTracker(bool enabled) : enabled{ enabled } {}
+
+	bool isEnabled() const { return enabled; }
+
+	// an input event with the given timestamp changed the simulation state
+	void inputApplied(double inputTime);
+	// the frame recorded in frameIndex was just handed to vkQueuePresentKHR
+	void framePresented(int frameIndex, double now);
+	// the fence guarding frameIndex was waited on, so the frame previously in that slot is done
+	void frameCompleted(int frameIndex, double now);
+	// logs the collected stats about once per second
+	void report(double now);
+
+private:
+	struct FrameSample {
+		bool valid = false;
+		uint64_t frameNumber = 0;
+		double inputTime = 0.0;
+		double presentTime = 0.0;
+	};
+
+	bool enabled;
+
+	std::array<FrameSample, Swapchain::MAX_FRAMES_IN_FLIGHT> frames{};
+	double pendingInput = -1.0;
+	uint64_t frameCounter = 0;
+
+	uint32_t samples = 0;
+	double sumPresent = 0.0;
+	double maxPresent = 0.0;
+	double sumComplete = 0.0;
+	double maxComplete = 0.0;
+	double lastReport = 0.0;
+};
@@ -0,0 +1,119 @@
+#include "layoutTransition.h"
+
+#include <stdexcept>
+
+#include "log.h"
+
+bool getLayoutAccess(VkImageLayout layout, LayoutAccess& layoutAccess) {
+	switch (layout) {
+	case VK_IMAGE_LAYOUT_UNDEFINED:
+		//nothing to wait on, contents are discarded
+		layoutAccess = { 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_GENERAL:
+		layoutAccess = { VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+		layoutAccess = { VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+		layoutAccess = { VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+		layoutAccess = { VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		layoutAccess = { VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+		layoutAccess = { VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+		layoutAccess = { VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+		return true;
+	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+		//presentation waits on a semaphore, so no access has to be made visible
+		layoutAccess = { 0, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT };
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool isDepthFormat(VkFormat format) {
+	switch (format) {
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_S8_UINT:
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+VkImageAspectFlags getFormatAspect(VkFormat format) {
+	switch (format) {
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+void recordLayoutTransition(VkCommandBuffer commandBuffer,
+	VkImage image,
+	VkFormat format,
+	uint32_t arrayLayers,
+	VkImageLayout oldLayout,
+	VkImageLayout newLayout) {
+	LayoutAccess src;
+	LayoutAccess dst;
+	if (!getLayoutAccess(oldLayout, src) || !getLayoutAccess(newLayout, dst)) {
+		LOG_CRITICAL("Unsupported layout transition {} -> {}", static_cast<int>(oldLayout), static_cast<int>(newLayout));
+		throw std::runtime_error("Unsupported layout transition");
+	}
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = getFormatAspect(format);
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = arrayLayers;
+	//only writes have to be made available, read to read needs no memory dependency
+	barrier.srcAccessMask = src.access & (VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT);
+	barrier.dstAccessMask = dst.access;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		src.stages, dst.stages,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier
+	);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// the memory access and pipeline stages that use an image while it is in a given layout
+struct LayoutAccess {
+	VkAccessFlags access;
+	VkPipelineStageFlags stages;
+};
+
+// returns false for layouts the engine never uses
+bool getLayoutAccess(VkImageLayout layout, LayoutAccess& layoutAccess);
+
+// true when the format carries depth and/or stencil
+bool isDepthFormat(VkFormat format);
+VkImageAspectFlags getFormatAspect(VkFormat format);
+
+// records a barrier moving the whole image from oldLayout to newLayout, throws on layouts without a mapping
+void recordLayoutTransition(VkCommandBuffer commandBuffer,
+	VkImage image,
+	VkFormat format,
+	uint32_t arrayLayers,
+	VkImageLayout oldLayout,
+	VkImageLayout newLayout);
@@ -0,0 +1,106 @@
+#include "log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static_assert((Log::CAPACITY & (Log::CAPACITY - 1)) == 0, "Log capacity must be a power of two so positions wrap with a mask");
+
+Log::Entry Log::entries[Log::CAPACITY];
+
+//the draining side, producers never touch any of it
+static std::mutex drainMutex;
+static std::mutex threadMutex;
+static std::condition_variable wake;
+static std::thread flushThread;
+static bool running = false;
+
+Log::Entry* Log::claim(uint64_t& position) {
+	position = head.load(std::memory_order_relaxed);
+	while (true) {
+		Entry& entry = entries[position & (CAPACITY - 1)];
+		uint64_t lap = position / CAPACITY;
+		uint64_t sequence = entry.sequence.load(std::memory_order_acquire);
+		if (sequence == lap * 2) {
+			if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				return &entry;
+			}
+		}
+		else if (sequence < lap * 2) {
+			//still holds a message from the last lap, the ring is full
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		else {
+			//another thread took this position first
+			position = head.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void Log::publish(Entry* entry, uint64_t position) {
+	entry->sequence.store(position / CAPACITY * 2 + 1, std::memory_order_release);
+}
+
+void Log::drain() {
+	auto& logger = *spdlog::default_logger_raw();
+	while (true) {
+		Entry& entry = entries[tail & (CAPACITY - 1)];
+		uint64_t lap = tail / CAPACITY;
+		//a claimed entry still being formatted holds up the ones after it until it is published
+		if (entry.sequence.load(std::memory_order_acquire) != lap * 2 + 1) break;
+
+		spdlog::string_view_t message = entry.overflow ? spdlog::string_view_t(*entry.overflow) : spdlog::string_view_t(entry.text, entry.length);
+		logger.log(entry.time, spdlog::source_loc{}, entry.level, message);
+		delete entry.overflow;
+		entry.overflow = nullptr;
+
+		entry.sequence.store((lap + 1) * 2, std::memory_order_release);
+		tail++;
+	}
+
+	if (uint32_t count = takeDroppedCount()) {
+		logger.warn("Log ring full, dropped {} messages", count);
+	}
+}
+
+void Log::flushLoop() {
+	std::unique_lock<std::mutex> lock(threadMutex);
+	while (running) {
+		//producers never signal, so the queue is polled a few hundred times a second
+		wake.wait_for(lock, std::chrono::milliseconds(2));
+		std::lock_guard<std::mutex> drainLock(drainMutex);
+		drain();
+	}
+}
+
+void Log::start() {
+	std::lock_guard<std::mutex> lock(threadMutex);
+	if (running) return;
+	running = true;
+	flushThread = std::thread(&Log::flushLoop);
+}
+
+void Log::stop() {
+	{
+		std::lock_guard<std::mutex> lock(threadMutex);
+		if (!running) return;
+		running = false;
+	}
+	wake.notify_all();
+	flushThread.join();
+	flush();
+}
+
+void Log::flush() {
+	//whoever gets here drains on its own thread instead of waiting for the flush thread
+	std::lock_guard<std::mutex> lock(drainMutex);
+	drain();
+	spdlog::default_logger_raw()->flush();
+}
+
+void Log::setLevel(spdlog::level::level_enum level) {
+	minimumLevel.store(level, std::memory_order_relaxed);
+	spdlog::set_level(level);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// lowest level that is compiled in, sites below it expand to nothing and their arguments are
+// never evaluated. dev builds keep everything, release (NDEBUG) builds drop debug and trace
+#ifndef SEAFIGHT_LOG_LEVEL
+#ifdef NDEBUG
+#define SEAFIGHT_LOG_LEVEL SPDLOG_LEVEL_INFO
+#else
+#define SEAFIGHT_LOG_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+#endif
+
+#if SEAFIGHT_LOG_LEVEL <= SPDLOG_LEVEL_TRACE
+#define LOG_TRACE(...) Log::write(spdlog::level::trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+#if SEAFIGHT_LOG_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::write(spdlog::level::debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if SEAFIGHT_LOG_LEVEL <= SPDLOG_LEVEL_INFO
+#define LOG_INFO(...) Log::write(spdlog::level::info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#define LOG_WARN(...) Log::write(spdlog::level::warn, __VA_ARGS__)
+#define LOG_ERROR(...) Log::write(spdlog::level::err, __VA_ARGS__)
+// criticals come right before a throw or an exit, so they wait until they are written out
+#define LOG_CRITICAL(...) (Log::write(spdlog::level::critical, __VA_ARGS__), Log::flush())
+
+// logging front end that never blocks the thread logging
+// messages are formatted straight into a slot of a fixed ring that any thread can claim with
+// one compare and swap, and a background thread hands them to the spdlog logger, so console
+// and file output happen off the frame. a full ring drops the message and counts it instead
+// of waiting
+class Log {
+public:
+	static constexpr size_t CAPACITY = 4096;
+	// longer messages are formatted again into a string of their own
+	static constexpr size_t MESSAGE_SIZE = 480;
+
+	// starts the thread writing messages out, the ones queued before it go out first
+	static void start();
+	// writes out everything queued and stops the thread. messages logged after this stay queued
+	// until the next start, nothing writes them out on its own
+	static void stop();
+	// blocks until everything queued so far has been written out
+	static void flush();
+
+	// runtime level on top of the compiled one
+	static void setLevel(spdlog::level::level_enum level);
+
+	template <typename... Args>
+	static void write(spdlog::level::level_enum level, fmt::format_string<Args...> format, Args&&... args) {
+		if (level < minimumLevel.load(std::memory_order_relaxed)) return;
+
+		uint64_t position;
+		Entry* entry = claim(position);
+		if (!entry) return;
+		auto result = fmt::format_to_n(entry->text, MESSAGE_SIZE, format, args...);
+		entry->length = static_cast<uint32_t>(std::min(result.size, MESSAGE_SIZE));
+		entry->overflow = result.size > MESSAGE_SIZE ? new std::string(fmt::format(format, args...)) : nullptr;
+		entry->level = level;
+		entry->time = spdlog::log_clock::now();
+		publish(entry, position);
+	}
+
+	// messages dropped because the ring was full, since the last call
+	static uint32_t takeDroppedCount() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+	struct Entry {
+		// twice the lap while free for that lap's producer, plus one once written. zero, free
+		// for the first lap, is what static storage starts out as
+		std::atomic<uint64_t> sequence;
+		spdlog::level::level_enum level;
+		spdlog::log_clock::time_point time;
+		uint32_t length;
+		std::string* overflow;
+		char text[MESSAGE_SIZE];
+	};
+
+	static Entry entries[CAPACITY];
+	alignas(64) inline static std::atomic<uint64_t> head{ 0 };
+	// only the thread draining moves it
+	alignas(64) inline static uint64_t tail = 0;
+	inline static std::atomic<int> minimumLevel{ spdlog::level::trace };
+	inline static std::atomic<uint32_t> dropped{ 0 };
+
+	static Entry* claim(uint64_t& position);
+	static void publish(Entry* entry, uint64_t position);
+	// writes out what is queued, only ever on one thread at a time
+	static void drain();
+	static void flushLoop();
+};
+
+// stops the log when it goes out of scope
+// held at the top of main, so the queue is written out while spdlog's logger still exists. a
+// static destructor would run after spdlog's registry is gone and write through a dead logger
+struct LogSession {
+	LogSession() = default;
+	~LogSession() { Log::stop(); }
+
+	LogSession(const LogSession&) = delete;
+	LogSession& operator=(const LogSession&) = delete;
+};
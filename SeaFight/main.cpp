@@ -2,22 +2,57 @@
 #include <GLFW/glfw3.h>
 
 #include "engine.h"
-#include <spdlog/spdlog.h>
+#include "replay.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// SeaFight --replay <file> [--seek <tick>] [--runs <count>]
+// plays a replay headless as fast as possible instead of starting the game
+static int playReplay(int argc, char** argv) {
+    std::string path;
+    uint32_t seek = 0;
+    uint32_t runs = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--replay") == 0) path = argv[i + 1];
+        else if (std::strcmp(argv[i], "--seek") == 0) seek = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (std::strcmp(argv[i], "--runs") == 0) runs = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+    }
+
+    try {
+        Settings settings{};
+        return ReplayPlayer::runHeadless(path, seek, runs) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e) {
+        LOG_CRITICAL("{}", e.what());
+        return EXIT_FAILURE;
+    }
+}
+
 // entry for program start
 // probably should put some sort of legal nonsense here
-int main() {
+int main(int argc, char** argv) {
+    //outlives the engine, so everything logged while shutting down is still written out
+    LogSession logSession{};
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--replay") == 0) {
+            return playReplay(argc, argv);
+        }
+    }
 
     Engine engine{};
     try {
         engine.start();
     }
     catch (const std::exception& e) {
-        spdlog::critical("{}", e.what());
+        LOG_CRITICAL("{}", e.what());
         return EXIT_FAILURE;
     }
     
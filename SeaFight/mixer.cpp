@@ -0,0 +1,282 @@
+#include "mixer.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIXER_SSE 1
+#endif
+
+static_assert(Mixer::BLOCK_FRAMES % 4 == 0, "Mixer blocks are mixed four frames at a time");
+
+Mixer::Mixer(std::unique_ptr<AudioSink> sink, const Params& params) : sink{ std::move(sink) }, params{ params } {
+	this->params.maxVoices = std::max(params.maxVoices, 1u);
+	voices.reserve(this->params.maxVoices);
+}
+
+Mixer::~Mixer() {
+	if (running.exchange(false)) {
+		thread.join();
+	}
+}
+
+Mixer::ClipId Mixer::addClip(const std::vector<float>& samples) {
+	assert(!running && "Clips have to be added before the mixer starts");
+	Clip clip{};
+	clip.length = static_cast<uint32_t>(samples.size());
+	clip.samples = samples;
+	clip.samples.resize((samples.size() + 3) / 4 * 4, 0.0f);
+	clips.push_back(std::move(clip));
+	return static_cast<ClipId>(clips.size() - 1);
+}
+
+void Mixer::start() {
+	if (running.exchange(true)) return;
+	thread = std::thread(&Mixer::mixLoop, this);
+}
+
+void Mixer::push(const Command& command) {
+	//a full queue means the mixer is hundreds of sounds behind, losing one beats waiting
+	if (!commands.push(command)) {
+		droppedCommands++;
+	}
+}
+
+void Mixer::play(ClipId clip, glm::vec2 position, float volume, uint8_t priority) {
+	assert(clip < clips.size() && "Invalid clip id");
+	Command command{};
+	command.type = Command::Type::Play;
+	command.clip = clip;
+	command.position = position;
+	command.volume = volume;
+	command.priority = priority;
+	push(command);
+}
+
+void Mixer::setListener(glm::vec2 position) {
+	Command command{};
+	command.type = Command::Type::Listener;
+	command.position = position;
+	push(command);
+}
+
+void Mixer::playMusic(std::unique_ptr<MusicStream> stream, float volume) {
+	Command command{};
+	command.type = Command::Type::Music;
+	command.music = stream.get();
+	command.volume = volume;
+	command.musicSerial = nextMusicSerial++;
+	//kept alive here until the mixer confirms it has moved past it
+	musicStreams.emplace_back(command.musicSerial, std::move(stream));
+	push(command);
+}
+
+void Mixer::update() {
+	uint32_t applied = appliedMusicSerial.load(std::memory_order_acquire);
+	musicStreams.erase(std::remove_if(musicStreams.begin(), musicStreams.end(),
+		[&](const auto& entry) { return entry.first < applied; }), musicStreams.end());
+}
+
+void Mixer::applyCommands() {
+	Command command;
+	while (commands.pop(command)) {
+		switch (command.type) {
+		case Command::Type::Play:
+			startVoice(command);
+			break;
+		case Command::Type::Listener:
+			listener = command.position;
+			break;
+		case Command::Type::Music:
+			music = command.music;
+			musicVolume = command.volume;
+			appliedMusicSerial.store(command.musicSerial, std::memory_order_release);
+			break;
+		}
+	}
+}
+
+void Mixer::startVoice(const Command& command) {
+	glm::vec2 offset = command.position - listener;
+	float audibility = command.volume * std::max(1.0f - glm::length(offset) / params.maxDistance, 0.0f);
+	if (audibility < params.cullThreshold) {
+		voicesCulled.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	//equal power pan from how far off to the side the sound is
+	float pan = std::clamp(offset.x / params.maxDistance, -1.0f, 1.0f);
+	float angle = (pan + 1.0f) * 0.25f * 3.14159265f;
+	Voice voice{ command.clip, 0, std::cos(angle) * audibility, std::sin(angle) * audibility, audibility, command.priority };
+
+	if (voices.size() < params.maxVoices) {
+		voices.push_back(voice);
+	}
+	else {
+		//the least important voice makes way, if the new one is more important
+		auto weakest = std::min_element(voices.begin(), voices.end(), [](const Voice& a, const Voice& b) {
+			return a.priority != b.priority ? a.priority < b.priority : a.audibility < b.audibility;
+		});
+		if (weakest->priority > voice.priority || (weakest->priority == voice.priority && weakest->audibility >= voice.audibility)) {
+			voicesCulled.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		*weakest = voice;
+		voicesStolen.fetch_add(1, std::memory_order_relaxed);
+	}
+	voicesStarted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Mixer::mixVoice(Voice& voice, float* out) {
+	const Clip& clip = clips[voice.clip];
+	//positions stay multiples of four, the padding covers the clip's last group
+	uint32_t frames = std::min(BLOCK_FRAMES, static_cast<uint32_t>(clip.samples.size()) - voice.position);
+	const float* samples = clip.samples.data() + voice.position;
+
+#ifdef MIXER_SSE
+	const __m128 gains = _mm_setr_ps(voice.gainLeft, voice.gainRight, voice.gainLeft, voice.gainRight);
+	for (uint32_t i = 0; i < frames; i += 4) {
+		__m128 mono = _mm_loadu_ps(samples + i);
+		//s0 s0 s1 s1 and s2 s2 s3 s3, one left and right pair per sample
+		__m128 low = _mm_unpacklo_ps(mono, mono);
+		__m128 high = _mm_unpackhi_ps(mono, mono);
+		float* target = out + i * 2;
+		_mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), _mm_mul_ps(low, gains)));
+		_mm_storeu_ps(target + 4, _mm_add_ps(_mm_loadu_ps(target + 4), _mm_mul_ps(high, gains)));
+	}
+#else
+	for (uint32_t i = 0; i < frames; i++) {
+		out[i * 2] += samples[i] * voice.gainLeft;
+		out[i * 2 + 1] += samples[i] * voice.gainRight;
+	}
+#endif
+	voice.position += frames;
+}
+
+void Mixer::mixBlock(float* out) {
+	auto start = std::chrono::high_resolution_clock::now();
+	applyCommands();
+
+	std::fill(out, out + BLOCK_FRAMES * 2, 0.0f);
+	for (auto& voice : voices) {
+		mixVoice(voice, out);
+	}
+	//finished voices are swapped out, order doesn't matter
+	for (size_t i = 0; i < voices.size();) {
+		if (voices[i].position >= clips[voices[i].clip].length) {
+			voices[i] = voices.back();
+			voices.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+	if (music) {
+		music->mixInto(out, BLOCK_FRAMES, musicVolume);
+		if (music->isFinished()) {
+			music = nullptr;
+		}
+	}
+
+#ifdef MIXER_SSE
+	const __m128 volume = _mm_set1_ps(params.masterVolume);
+	const __m128 low = _mm_set1_ps(-1.0f);
+	const __m128 high = _mm_set1_ps(1.0f);
+	for (uint32_t i = 0; i < BLOCK_FRAMES * 2; i += 4) {
+		__m128 sample = _mm_mul_ps(_mm_loadu_ps(out + i), volume);
+		_mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(sample, low), high));
+	}
+#else
+	for (uint32_t i = 0; i < BLOCK_FRAMES * 2; i++) {
+		out[i] = std::clamp(out[i] * params.masterVolume, -1.0f, 1.0f);
+	}
+#endif
+
+	if (measure) {
+		uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		mixNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+		if (nanoseconds > maxMixNanoseconds.load(std::memory_order_relaxed)) {
+			maxMixNanoseconds.store(nanoseconds, std::memory_order_relaxed);
+		}
+		if (voices.size() > peakVoices.load(std::memory_order_relaxed)) {
+			peakVoices.store(static_cast<uint32_t>(voices.size()), std::memory_order_relaxed);
+		}
+	}
+	blocksMixed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Mixer::mixLoop() {
+	using Clock = std::chrono::steady_clock;
+	const auto blockDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(static_cast<double>(BLOCK_FRAMES) / SAMPLE_RATE));
+
+	std::vector<float> block(BLOCK_FRAMES * 2);
+	auto deadline = Clock::now();
+	while (running.load(std::memory_order_acquire)) {
+		mixBlock(block.data());
+		sink->write(block.data(), BLOCK_FRAMES);
+
+		//paced by the clock like a device would pace it, a stall isn't made up for with a burst
+		deadline += blockDuration;
+		auto now = Clock::now();
+		if (now > deadline + blockDuration * 4) {
+			deadline = now;
+		}
+		std::this_thread::sleep_until(deadline);
+	}
+}
+
+void Mixer::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	uint32_t blocks = blocksMixed.exchange(0, std::memory_order_relaxed);
+	uint64_t nanoseconds = mixNanoseconds.exchange(0, std::memory_order_relaxed);
+	uint32_t underruns = 0;
+	for (const auto& [serial, stream] : musicStreams) {
+		underruns += stream->getUnderruns();
+	}
+	LOG_INFO("Audio {} blocks avg {:.1f}us max {:.1f}us of {:.0f}us, voices started {} culled {} stolen {} peak {}, {} dropped commands, {} music underruns",
+		blocks, blocks > 0 ? nanoseconds / 1000.0 / blocks : 0.0, maxMixNanoseconds.exchange(0, std::memory_order_relaxed) / 1000.0,
+		BLOCK_FRAMES * 1000000.0 / SAMPLE_RATE,
+		voicesStarted.exchange(0, std::memory_order_relaxed), voicesCulled.exchange(0, std::memory_order_relaxed),
+		voicesStolen.exchange(0, std::memory_order_relaxed), peakVoices.exchange(0, std::memory_order_relaxed),
+		droppedCommands, underruns >= underrunsReported ? underruns - underrunsReported : underruns);
+	droppedCommands = 0;
+	underrunsReported = underruns;
+}
+
+void Mixer::benchmark() {
+	using Clock = std::chrono::high_resolution_clock;
+	//a second of noise so no voice ends during the measurement
+	std::vector<float> noise(SAMPLE_RATE);
+	uint32_t random = 2463534242u;
+	for (float& sample : noise) {
+		random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+		sample = (random >> 8) / 8388608.0f - 1.0f;
+	}
+
+	for (uint32_t voiceCount : { 16u, 64u, 256u }) {
+		Params params{};
+		params.maxVoices = voiceCount;
+		Mixer mixer{ std::make_unique<NullSink>(), params };
+		ClipId clip = mixer.addClip(noise);
+		for (uint32_t i = 0; i < voiceCount; i++) {
+			mixer.play(clip, { (i % 16) * 0.1f - 0.8f, 0.0f }, 0.05f);
+		}
+
+		const int blocks = 150;
+		std::vector<float> out(BLOCK_FRAMES * 2);
+		auto start = Clock::now();
+		for (int i = 0; i < blocks; i++) {
+			mixer.mixBlock(out.data());
+		}
+		double microseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / blocks;
+		LOG_INFO("Mixer benchmark: {} voices {:.2f}us per {} frame block ({:.2f}% of its {:.0f}us)",
+			voiceCount, microseconds, BLOCK_FRAMES, microseconds / (BLOCK_FRAMES * 1000000.0 / SAMPLE_RATE) * 100.0, BLOCK_FRAMES * 1000000.0 / SAMPLE_RATE);
+	}
+}
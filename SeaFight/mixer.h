@@ -0,0 +1,133 @@
+#pragma once
+
+#include "audioSink.h"
+#include "musicStream.h"
+#include "ringBuffer.h"
+#include "utils.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// software mixer running on its own thread
+// the game thread only ever pushes commands into a lock free queue, so a burst of sounds costs
+// it a few stores and never waits on the mixer. the mixer drains the queue at the start of
+// every block, starts voices with distance attenuation and panning from the listener, keeps
+// at most maxVoices playing by dropping or stealing the least important ones, and mixes the
+// mono clips into interleaved stereo four samples at a time with sse
+class Mixer {
+public:
+	using ClipId = uint32_t;
+
+	static constexpr uint32_t SAMPLE_RATE = 48000;
+	// 256 frames is about 5.3ms of latency between a command and the sink
+	static constexpr uint32_t BLOCK_FRAMES = 256;
+
+	struct Params {
+		uint32_t maxVoices = 32;
+		// sounds further than this from the listener are silent
+		float maxDistance = 2.0f;
+		// voices quieter than this after attenuation aren't worth starting
+		float cullThreshold = 0.02f;
+		float masterVolume = 0.8f;
+	};
+
+	Mixer(std::unique_ptr<AudioSink> sink, const Params& params);
+	~Mixer();
+
+	Mixer(const Mixer&) = delete;
+	Mixer& operator=(const Mixer&) = delete;
+
+	// mono samples at SAMPLE_RATE, clips have to be added before start
+	ClipId addClip(const std::vector<float>& samples);
+	// starts the mixing thread, without it blocks are only mixed by calling mixBlock
+	void start();
+
+	// game thread only, higher priorities win when there are more sounds than voices
+	void play(ClipId clip, glm::vec2 position, float volume = 1.0f, uint8_t priority = 0);
+	void setListener(glm::vec2 position);
+	// replaces the current music, null stops it
+	void playMusic(std::unique_ptr<MusicStream> music, float volume = 0.5f);
+	// frees music streams the mixer has let go of, call once per tick
+	void update();
+
+	// mixes the next BLOCK_FRAMES interleaved stereo frames into out, the mixer thread's job
+	// it is the command queue's consumer, so only one thread may ever call it
+	void mixBlock(float* out);
+
+	// logs voice and timing stats once a second when measure_audio is set
+	void report(double now);
+
+	// block mixing cost for growing voice counts, against the time a block lasts
+	static void benchmark();
+
+private:
+	struct Clip {
+		// zero padded to a multiple of four samples
+		std::vector<float> samples;
+		uint32_t length;
+	};
+
+	struct Voice {
+		ClipId clip;
+		uint32_t position;
+		float gainLeft;
+		float gainRight;
+		float audibility;
+		uint8_t priority;
+	};
+
+	struct Command {
+		enum class Type : uint8_t { Play, Listener, Music };
+		Type type;
+		uint8_t priority;
+		ClipId clip;
+		glm::vec2 position;
+		float volume;
+		MusicStream* music;
+		uint32_t musicSerial;
+	};
+
+	std::unique_ptr<AudioSink> sink;
+	Params params;
+	std::vector<Clip> clips;
+	RingBuffer<Command, 1024> commands;
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+
+	// mixer side
+	std::vector<Voice> voices;
+	glm::vec2 listener{ 0.0f };
+	MusicStream* music = nullptr;
+	float musicVolume = 0.0f;
+	// the newest music command the mixer has applied, older streams are free to go
+	std::atomic<uint32_t> appliedMusicSerial{ 0 };
+
+	// game side
+	std::vector<std::pair<uint32_t, std::unique_ptr<MusicStream>>> musicStreams;
+	uint32_t nextMusicSerial = 1;
+	uint32_t droppedCommands = 0;
+
+	const bool measure = Settings::settings.value("measure_audio", false);
+	std::atomic<uint32_t> blocksMixed{ 0 };
+	std::atomic<uint32_t> voicesStarted{ 0 };
+	std::atomic<uint32_t> voicesCulled{ 0 };
+	std::atomic<uint32_t> voicesStolen{ 0 };
+	std::atomic<uint32_t> peakVoices{ 0 };
+	std::atomic<uint64_t> mixNanoseconds{ 0 };
+	std::atomic<uint64_t> maxMixNanoseconds{ 0 };
+	uint32_t underrunsReported = 0;
+	double lastReport = 0.0;
+
+	void push(const Command& command);
+	void applyCommands();
+	void startVoice(const Command& command);
+	void mixVoice(Voice& voice, float* out);
+	void mixLoop();
+};
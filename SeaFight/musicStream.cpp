@@ -0,0 +1,146 @@
+#include "musicStream.h"
+
+#include "log.h"
+
+#include <chrono>
+#include <stdexcept>
+
+static uint32_t readLittleEndian(const uint8_t* bytes, int count) {
+	uint32_t value = 0;
+	for (int i = 0; i < count; i++) {
+		value |= static_cast<uint32_t>(bytes[i]) << (i * 8);
+	}
+	return value;
+}
+
+MusicStream::MusicStream(const std::string& path, uint32_t sampleRate, bool loop) : loop{ loop } {
+	readHeader(path, sampleRate);
+	decoder = std::thread(&MusicStream::decodeLoop, this);
+}
+
+MusicStream::~MusicStream() {
+	stopping.store(true, std::memory_order_release);
+	decoder.join();
+}
+
+void MusicStream::readHeader(const std::string& path, uint32_t sampleRate) {
+	file.open(path, std::ios::binary);
+	uint8_t riff[12];
+	if (!file || !file.read(reinterpret_cast<char*>(riff), sizeof(riff))
+		|| std::string(reinterpret_cast<char*>(riff), 4) != "RIFF" || std::string(reinterpret_cast<char*>(riff + 8), 4) != "WAVE") {
+		LOG_CRITICAL("Failed to open music {}, not a wav file", path);
+		throw std::runtime_error("Failed to open music!");
+	}
+
+	//walk the chunks for the format and the samples, anything else is skipped
+	bool haveFormat = false;
+	uint8_t chunkHeader[8];
+	while (file.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader))) {
+		std::string id(reinterpret_cast<char*>(chunkHeader), 4);
+		uint32_t size = readLittleEndian(chunkHeader + 4, 4);
+
+		if (id == "fmt " && size >= 16) {
+			uint8_t format[16];
+			file.read(reinterpret_cast<char*>(format), sizeof(format));
+			uint32_t encoding = readLittleEndian(format, 2);
+			channels = readLittleEndian(format + 2, 2);
+			uint32_t rate = readLittleEndian(format + 4, 4);
+			uint32_t bits = readLittleEndian(format + 14, 2);
+			if (encoding != 1 || bits != 16 || (channels != 1 && channels != 2) || rate != sampleRate) {
+				LOG_CRITICAL("Music {} is {} channel {} bit at {}Hz, needs mono or stereo 16 bit pcm at {}Hz", path, channels, bits, rate, sampleRate);
+				throw std::runtime_error("Unsupported music format!");
+			}
+			haveFormat = true;
+			file.seekg(size - sizeof(format) + (size & 1), std::ios::cur);
+		}
+		else if (id == "data" && haveFormat) {
+			dataStart = file.tellg();
+			dataFrames = size / (channels * 2);
+			return;
+		}
+		else {
+			//chunks are padded to an even size
+			file.seekg(size + (size & 1), std::ios::cur);
+		}
+	}
+
+	LOG_CRITICAL("Music {} has no samples", path);
+	throw std::runtime_error("Failed to open music!");
+}
+
+bool MusicStream::decode(Chunk& chunk) {
+	int16_t pcm[CHUNK_FRAMES * 2];
+	chunk.frames = 0;
+
+	while (chunk.frames < CHUNK_FRAMES) {
+		if (framesDecoded == dataFrames) {
+			if (!loop || dataFrames == 0) break;
+			file.clear();
+			file.seekg(dataStart);
+			framesDecoded = 0;
+		}
+
+		uint32_t frames = std::min(CHUNK_FRAMES - chunk.frames, dataFrames - framesDecoded);
+		if (!file.read(reinterpret_cast<char*>(pcm), static_cast<std::streamsize>(frames) * channels * sizeof(int16_t))) {
+			//truncated file, treat what's missing as the end
+			dataFrames = framesDecoded;
+			continue;
+		}
+		float* out = chunk.samples.data() + chunk.frames * 2;
+		for (uint32_t i = 0; i < frames; i++) {
+			float left = pcm[i * channels] / 32768.0f;
+			out[i * 2] = left;
+			out[i * 2 + 1] = channels == 2 ? pcm[i * 2 + 1] / 32768.0f : left;
+		}
+		chunk.frames += frames;
+		framesDecoded += frames;
+	}
+	return chunk.frames > 0;
+}
+
+void MusicStream::decodeLoop() {
+	Chunk chunk;
+	bool pending = false;
+	while (!stopping.load(std::memory_order_acquire)) {
+		if (!pending) {
+			if (!decode(chunk)) {
+				endOfTrack.store(true, std::memory_order_release);
+				return;
+			}
+			pending = true;
+		}
+		if (chunks.push(chunk)) {
+			pending = false;
+			continue;
+		}
+		//a full ring is several blocks of audio ahead, no hurry
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+uint32_t MusicStream::mixInto(float* out, uint32_t frames, float volume) {
+	uint32_t mixed = 0;
+	while (mixed < frames) {
+		if (current == nullptr || offset == current->frames) {
+			if (!chunks.pop(playing)) {
+				current = nullptr;
+				if (!endOfTrack.load(std::memory_order_acquire)) {
+					underruns.fetch_add(1, std::memory_order_relaxed);
+				}
+				break;
+			}
+			current = &playing;
+			offset = 0;
+		}
+
+		uint32_t count = std::min(frames - mixed, current->frames - offset);
+		const float* in = current->samples.data() + offset * 2;
+		float* target = out + mixed * 2;
+		for (uint32_t i = 0; i < count * 2; i++) {
+			target[i] += in[i] * volume;
+		}
+		offset += count;
+		mixed += count;
+	}
+	return mixed;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ringBuffer.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// music decoded from a 16 bit pcm wav file on its own thread and handed to the mixer in chunks
+// only a few chunks are ever decoded ahead, so memory stays flat however long the track is.
+// the decoding thread is the ring's producer and the mixer thread its only consumer
+class MusicStream {
+public:
+	static constexpr uint32_t CHUNK_FRAMES = 2048;
+
+	// throws if the file can't be read or isn't mono or stereo 16 bit pcm at sampleRate
+	MusicStream(const std::string& path, uint32_t sampleRate, bool loop);
+	~MusicStream();
+
+	MusicStream(const MusicStream&) = delete;
+	MusicStream& operator=(const MusicStream&) = delete;
+
+	// mixer thread, adds up to frames interleaved stereo frames scaled by volume into out
+	// returns fewer when the decoder fell behind or the track ended
+	uint32_t mixInto(float* out, uint32_t frames, float volume);
+
+	// mixer thread, the track ended and every decoded chunk has been played
+	bool isFinished() const {
+		return endOfTrack.load(std::memory_order_acquire) && chunks.empty() && (current == nullptr || offset == current->frames);
+	}
+	// blocks where the decoder hadn't caught up, any at all means it is starved
+	uint32_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+	struct Chunk {
+		std::array<float, CHUNK_FRAMES * 2> samples;
+		uint32_t frames;
+	};
+
+	std::ifstream file;
+	uint32_t channels = 2;
+	std::streampos dataStart = 0;
+	uint32_t dataFrames = 0;
+	uint32_t framesDecoded = 0;
+	bool loop;
+
+	RingBuffer<Chunk, 8> chunks;
+	// mixer side, the chunk being played and how far into it
+	Chunk playing{};
+	const Chunk* current = nullptr;
+	uint32_t offset = 0;
+
+	std::thread decoder;
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> endOfTrack{ false };
+	std::atomic<uint32_t> underruns{ 0 };
+
+	void readHeader(const std::string& path, uint32_t sampleRate);
+	void decodeLoop();
+	// fills chunk from the file, false at the end of a track that doesn't loop
+	bool decode(Chunk& chunk);
+};
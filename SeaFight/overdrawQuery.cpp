@@ -0,0 +1,86 @@
+#include "overdrawQuery.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "log.h"
+
+OverdrawQuery::OverdrawQuery(Device& device, bool enabled) : device{ device }, enabled{ enabled } {
+	if (!enabled) return;
+
+	if (!device.enabledFeatures.pipelineStatisticsQuery) {
+		LOG_WARN("Pipeline statistics queries are not supported, overdraw will not be measured");
+		this->enabled = false;
+		return;
+	}
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	poolInfo.queryCount = Swapchain::MAX_FRAMES_IN_FLIGHT;
+	poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+	if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create overdraw query pool!");
+		throw std::runtime_error("Failed to create overdraw query pool!");
+	}
+}
+
+OverdrawQuery::~OverdrawQuery() {
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device.device(), queryPool, nullptr);
+	}
+}
+
+void OverdrawQuery::collect(int frameIndex) {
+	if (!enabled || !pending[frameIndex]) return;
+	pending[frameIndex] = false;
+
+	uint64_t invocations = 0;
+	VkResult result = vkGetQueryPoolResults(
+		device.device(),
+		queryPool,
+		static_cast<uint32_t>(frameIndex),
+		1,
+		sizeof(invocations),
+		&invocations,
+		sizeof(invocations),
+		VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS || pixels[frameIndex] == 0) return;
+
+	double overdraw = static_cast<double>(invocations) / static_cast<double>(pixels[frameIndex]);
+	samples++;
+	sumOverdraw += overdraw;
+	maxOverdraw = std::max(maxOverdraw, overdraw);
+}
+
+void OverdrawQuery::reset(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent) {
+	if (!enabled) return;
+
+	vkCmdResetQueryPool(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex), 1);
+	pixels[frameIndex] = static_cast<uint64_t>(extent.width) * extent.height;
+}
+
+void OverdrawQuery::begin(VkCommandBuffer commandBuffer, int frameIndex) {
+	if (!enabled) return;
+
+	vkCmdBeginQuery(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex), 0);
+}
+
+void OverdrawQuery::end(VkCommandBuffer commandBuffer, int frameIndex) {
+	if (!enabled) return;
+
+	vkCmdEndQuery(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex));
+	pending[frameIndex] = true;
+}
+
+void OverdrawQuery::report(double now) {
+	if (!enabled || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		LOG_INFO("Overdraw over {} frames: avg {:.2f} max {:.2f} fragments per pixel",
+			samples, sumOverdraw / samples, maxOverdraw);
+	}
+	samples = 0;
+	sumOverdraw = maxOverdraw = 0.0;
+}
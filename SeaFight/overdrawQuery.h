@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "device.h"
+#include "swapchain.h"
+
+// instrumentation for fill rate
+// counts fragment shader invocations inside the scene with a pipeline statistics query and
+// reports them per pixel, so 1.0 means every pixel was shaded exactly once.
+// needs the pipelineStatisticsQuery device feature, without it the query stays disabled
+class OverdrawQuery {
+public:
+	OverdrawQuery(Device& device, bool enabled);
+	~OverdrawQuery();
+
+	OverdrawQuery(const OverdrawQuery&) = delete;
+	OverdrawQuery& operator=(const OverdrawQuery&) = delete;
+
+	bool isEnabled() const { return enabled; }
+
+	// reads back the query the frame previously in this slot wrote, the slot's fence must have been waited on
+	void collect(int frameIndex);
+	// must be recorded outside of a render pass
+	void reset(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent);
+	// begin and end must be recorded in the same subpass
+	void begin(VkCommandBuffer commandBuffer, int frameIndex);
+	void end(VkCommandBuffer commandBuffer, int frameIndex);
+	// logs the collected stats about once per second
+	void report(double now);
+
+private:
+	Device& device;
+	bool enabled;
+
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	std::array<bool, Swapchain::MAX_FRAMES_IN_FLIGHT> pending{};
+	std::array<uint64_t, Swapchain::MAX_FRAMES_IN_FLIGHT> pixels{};
+
+	uint32_t samples = 0;
+	double sumOverdraw = 0.0;
+	double maxOverdraw = 0.0;
+	double lastReport = 0.0;
+};
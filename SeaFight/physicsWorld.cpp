@@ -0,0 +1,871 @@
+#include "physicsWorld.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PHYSICS_SSE 1
+#endif
+
+//overlap allowed to persist so resting contacts don't jitter, matches collision.cpp
+static constexpr float LINEAR_SLOP = 0.005f;
+
+static float cross(glm::vec2 a, glm::vec2 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+static uint64_t pairKey(uint32_t a, uint32_t b) {
+	return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+PhysicsWorld::PhysicsWorld(const Params& params) : params{ params } {}
+
+PhysicsWorld::BodyId PhysicsWorld::createBody(BodyType type, const Shape& shape, glm::vec2 position, float angle, float density) {
+	BodyId body = size();
+	shapes.push_back(shape);
+	posX.push_back(position.x);
+	posY.push_back(position.y);
+	angles.push_back(angle);
+	velX.push_back(0.0f);
+	velY.push_back(0.0f);
+	angularVelocity.push_back(0.0f);
+	sleepTimers.push_back(0.0f);
+	sleepIsland.push_back(NO_ISLAND);
+	float extent = 0.0f;
+	for (int i = 0; i < shape.count; i++) {
+		extent = std::max(extent, glm::length(shape.vertices[i]));
+	}
+	extents.push_back(extent + shape.radius);
+
+	if (type == BodyType::Dynamic) {
+		float mass, inertia;
+		shape.massProperties(density, mass, inertia);
+		invMass.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+		invInertia.push_back(inertia > 0.0f ? 1.0f / inertia : 0.0f);
+		awake.push_back(1);
+	}
+	else {
+		//static bodies are never awake, so pairs of them are skipped without a type check
+		invMass.push_back(0.0f);
+		invInertia.push_back(0.0f);
+		awake.push_back(0);
+	}
+
+	Transform2D transform{ position, { std::cos(angle), std::sin(angle) } };
+	AABB box = shape.computeAABB(transform);
+	bounds.push_back({ box.min - params.speculativeDistance, box.max + params.speculativeDistance });
+	sweepOrder.push_back(body);
+	sweepUnsorted = true;
+	sweepGridStale = true;
+	return body;
+}
+
+void PhysicsWorld::setVelocity(BodyId body, glm::vec2 linear, float angular) {
+	if (invMass[body] == 0.0f) return;
+	wakeBody(body);
+	velX[body] = linear.x;
+	velY[body] = linear.y;
+	angularVelocity[body] = angular;
+}
+
+void PhysicsWorld::applyImpulse(BodyId body, glm::vec2 impulse, glm::vec2 point) {
+	if (invMass[body] == 0.0f) return;
+	wakeBody(body);
+	velX[body] += invMass[body] * impulse.x;
+	velY[body] += invMass[body] * impulse.y;
+	angularVelocity[body] += invInertia[body] * cross(point - getPosition(body), impulse);
+}
+
+uint32_t PhysicsWorld::getAwakeCount() const {
+	return static_cast<uint32_t>(std::count(awake.begin(), awake.end(), 1));
+}
+
+void PhysicsWorld::step(JobSystem& jobs, float dt) {
+	if (dt <= 0.0f || shapes.empty()) return;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	jobs.parallelFor(size(), 1024, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (!awake[i]) continue;
+			velX[i] += params.gravity.x * dt;
+			velY[i] += params.gravity.y * dt;
+		}
+	});
+
+	updateBounds(jobs);
+	findPairs();
+	collidePairs(jobs);
+	wakeTouched();
+	buildGroups(dt);
+	solve(jobs, true);
+	//positions move with the push, the velocity it added is then taken back out
+	integratePositions(jobs, dt);
+	solve(jobs, false);
+	storeImpulses();
+	updateSleep(dt);
+	sweepGridStale = true;
+
+	if (measure) {
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		sumMilliseconds += milliseconds;
+		maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+		samples++;
+	}
+}
+
+void PhysicsWorld::updateBounds(JobSystem& jobs) {
+	jobs.parallelFor(size(), 512, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (!awake[i]) continue;
+			Transform2D transform{ { posX[i], posY[i] }, { std::cos(angles[i]), std::sin(angles[i]) } };
+			AABB box = shapes[i].computeAABB(transform);
+			bounds[i] = { box.min - params.speculativeDistance, box.max + params.speculativeDistance };
+		}
+	});
+}
+
+void PhysicsWorld::findPairs() {
+	if (sweepUnsorted) {
+		std::sort(sweepOrder.begin(), sweepOrder.end(), [&](BodyId a, BodyId b) { return bounds[a].min.x < bounds[b].min.x; });
+		sweepUnsorted = false;
+	}
+	//bodies barely move between steps, so insertion sort is close to linear
+	for (size_t i = 1; i < sweepOrder.size(); i++) {
+		BodyId body = sweepOrder[i];
+		float minX = bounds[body].min.x;
+		size_t j = i;
+		while (j > 0 && bounds[sweepOrder[j - 1]].min.x > minX) {
+			sweepOrder[j] = sweepOrder[j - 1];
+			j--;
+		}
+		sweepOrder[j] = body;
+	}
+
+	pairs.clear();
+	for (size_t i = 0; i < sweepOrder.size(); i++) {
+		BodyId a = sweepOrder[i];
+		const AABB& boxA = bounds[a];
+		for (size_t j = i + 1; j < sweepOrder.size(); j++) {
+			BodyId b = sweepOrder[j];
+			const AABB& boxB = bounds[b];
+			if (boxB.min.x > boxA.max.x) break;
+			//static and sleeping bodies don't move, at least one side has to
+			if (!awake[a] && !awake[b]) continue;
+			if (boxB.min.y > boxA.max.y || boxA.min.y > boxB.max.y) continue;
+			pairs.push_back({ std::min(a, b), std::max(a, b) });
+		}
+	}
+}
+
+void PhysicsWorld::collidePairs(JobSystem& jobs) {
+	candidates.resize(pairs.size());
+	jobs.parallelFor(static_cast<uint32_t>(pairs.size()), 64, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			auto [a, b] = pairs[i];
+			Transform2D transformA{ { posX[a], posY[a] }, { std::cos(angles[a]), std::sin(angles[a]) } };
+			Transform2D transformB{ { posX[b], posY[b] }, { std::cos(angles[b]), std::sin(angles[b]) } };
+
+			Constraint& constraint = candidates[i];
+			constraint.a = a;
+			constraint.b = b;
+			constraint.manifold = collide(shapes[a], transformA, shapes[b], transformB, params.speculativeDistance);
+			for (int p = 0; p < 2; p++) {
+				constraint.normalImpulse[p] = 0.0f;
+				constraint.tangentImpulse[p] = 0.0f;
+			}
+
+			//points made by the same features as last step start from last step's impulses
+			uint64_t key = pairKey(a, b);
+			auto cached = std::lower_bound(cache.begin(), cache.end(), key, [](const CachedContact& contact, uint64_t key) { return contact.key < key; });
+			if (cached == cache.end() || cached->key != key) continue;
+			for (int p = 0; p < constraint.manifold.pointCount; p++) {
+				for (int q = 0; q < cached->pointCount; q++) {
+					if (cached->ids[q] == constraint.manifold.points[p].id) {
+						constraint.normalImpulse[p] = cached->normalImpulse[q];
+						constraint.tangentImpulse[p] = cached->tangentImpulse[q];
+					}
+				}
+			}
+		}
+	});
+
+	constraints.clear();
+	for (const Constraint& candidate : candidates) {
+		if (candidate.manifold.pointCount > 0) {
+			constraints.push_back(candidate);
+		}
+	}
+}
+
+void PhysicsWorld::wakeBody(BodyId body) {
+	uint32_t island = sleepIsland[body];
+	if (island == NO_ISLAND) {
+		if (invMass[body] > 0.0f) {
+			awake[body] = 1;
+			sleepTimers[body] = 0.0f;
+		}
+		return;
+	}
+
+	for (BodyId member : sleepingIslands[island]) {
+		awake[member] = 1;
+		sleepTimers[member] = 0.0f;
+		sleepIsland[member] = NO_ISLAND;
+	}
+	sleepingIslands[island].clear();
+	freeIslands.push_back(island);
+}
+
+void PhysicsWorld::wakeTouched() {
+	//a moving body touching a sleeping one wakes its whole island
+	for (const Constraint& constraint : constraints) {
+		if (!awake[constraint.a] && invMass[constraint.a] > 0.0f) {
+			wakeBody(constraint.a);
+		}
+		if (!awake[constraint.b] && invMass[constraint.b] > 0.0f) {
+			wakeBody(constraint.b);
+		}
+	}
+}
+
+void PhysicsWorld::fillLane(ContactGroup& group, uint32_t lane, uint32_t index, float dt) {
+	const Constraint& constraint = constraints[index];
+	const Manifold& manifold = constraint.manifold;
+	uint32_t a = constraint.a;
+	uint32_t b = constraint.b;
+
+	group.bodyA[lane] = a;
+	group.bodyB[lane] = b;
+	group.constraint[lane] = index;
+	group.invMassA[lane] = invMass[a];
+	group.invInertiaA[lane] = invInertia[a];
+	group.invMassB[lane] = invMass[b];
+	group.invInertiaB[lane] = invInertia[b];
+	group.normalX[lane] = manifold.normal.x;
+	group.normalY[lane] = manifold.normal.y;
+	group.friction[lane] = params.friction;
+
+	glm::vec2 normal = manifold.normal;
+	glm::vec2 tangent{ normal.y, -normal.x };
+	float invDt = 1.0f / dt;
+	for (int p = 0; p < 2; p++) {
+		ContactGroup::Point& point = group.points[p];
+		if (p >= manifold.pointCount) {
+			//a one point manifold's second point gets no mass, so it never applies anything
+			point.anchorAX[lane] = point.anchorAY[lane] = point.anchorBX[lane] = point.anchorBY[lane] = 0.0f;
+			point.normalMass[lane] = point.tangentMass[lane] = 0.0f;
+			point.pushBias[lane] = point.restBias[lane] = 0.0f;
+			point.normalImpulse[lane] = point.tangentImpulse[lane] = 0.0f;
+			continue;
+		}
+
+		glm::vec2 anchorA = manifold.points[p].anchorA;
+		glm::vec2 anchorB = manifold.points[p].anchorB;
+		point.anchorAX[lane] = anchorA.x;
+		point.anchorAY[lane] = anchorA.y;
+		point.anchorBX[lane] = anchorB.x;
+		point.anchorBY[lane] = anchorB.y;
+
+		float rnA = cross(anchorA, normal);
+		float rnB = cross(anchorB, normal);
+		float normalK = invMass[a] + invMass[b] + invInertia[a] * rnA * rnA + invInertia[b] * rnB * rnB;
+		point.normalMass[lane] = normalK > 0.0f ? 1.0f / normalK : 0.0f;
+		float rtA = cross(anchorA, tangent);
+		float rtB = cross(anchorB, tangent);
+		float tangentK = invMass[a] + invMass[b] + invInertia[a] * rtA * rtA + invInertia[b] * rtB * rtB;
+		point.tangentMass[lane] = tangentK > 0.0f ? 1.0f / tangentK : 0.0f;
+
+		//speculative points may close their gap in one step but not more, overlapping
+		//ones are pushed apart a fraction at a time
+		float separation = manifold.points[p].separation;
+		point.restBias[lane] = separation > 0.0f ? -separation * invDt : 0.0f;
+		point.pushBias[lane] = separation > 0.0f
+			? point.restBias[lane]
+			: std::min(params.baumgarte * invDt * std::max(-(separation + LINEAR_SLOP), 0.0f), params.maxPushVelocity);
+
+		point.normalImpulse[lane] = constraint.normalImpulse[p];
+		point.tangentImpulse[lane] = constraint.tangentImpulse[p];
+	}
+}
+
+void PhysicsWorld::buildGroups(float dt) {
+	colorMasks.assign(size(), 0);
+	for (int color = 0; color < MAX_COLORS; color++) {
+		colorMembers[color].clear();
+		colors[color].clear();
+	}
+	overflow.clear();
+
+	//greedy colouring, static bodies are only read so any number of contacts may share one
+	std::vector<uint32_t> uncolored;
+	for (uint32_t i = 0; i < constraints.size(); i++) {
+		uint32_t a = constraints[i].a;
+		uint32_t b = constraints[i].b;
+		bool movingA = invMass[a] > 0.0f;
+		bool movingB = invMass[b] > 0.0f;
+		int color = 0;
+		for (; color < MAX_COLORS; color++) {
+			uint32_t bit = 1u << color;
+			if ((movingA && (colorMasks[a] & bit)) || (movingB && (colorMasks[b] & bit))) continue;
+			if (movingA) colorMasks[a] |= bit;
+			if (movingB) colorMasks[b] |= bit;
+			colorMembers[color].push_back(i);
+			break;
+		}
+		if (color == MAX_COLORS) {
+			uncolored.push_back(i);
+		}
+	}
+
+	for (int color = 0; color < MAX_COLORS; color++) {
+		const auto& members = colorMembers[color];
+		colors[color].resize((members.size() + 3) / 4);
+		for (size_t g = 0; g < colors[color].size(); g++) {
+			ContactGroup& group = colors[color][g];
+			group = {};
+			group.lanes = static_cast<uint32_t>(std::min<size_t>(4, members.size() - g * 4));
+			for (uint32_t lane = 0; lane < group.lanes; lane++) {
+				fillLane(group, lane, members[g * 4 + lane], dt);
+			}
+		}
+	}
+	overflow.resize(uncolored.size());
+	for (size_t i = 0; i < uncolored.size(); i++) {
+		overflow[i] = {};
+		overflow[i].lanes = 1;
+		fillLane(overflow[i], 0, uncolored[i], dt);
+	}
+}
+
+void PhysicsWorld::warmStart(ContactGroup& group, float* velX, float* velY, float* angularVelocity) {
+	for (uint32_t lane = 0; lane < group.lanes; lane++) {
+		uint32_t a = group.bodyA[lane];
+		uint32_t b = group.bodyB[lane];
+		glm::vec2 normal{ group.normalX[lane], group.normalY[lane] };
+		glm::vec2 tangent{ normal.y, -normal.x };
+		for (const auto& point : group.points) {
+			glm::vec2 impulse = normal * point.normalImpulse[lane] + tangent * point.tangentImpulse[lane];
+			glm::vec2 anchorA{ point.anchorAX[lane], point.anchorAY[lane] };
+			glm::vec2 anchorB{ point.anchorBX[lane], point.anchorBY[lane] };
+			if (group.invMassA[lane] > 0.0f) {
+				velX[a] -= group.invMassA[lane] * impulse.x;
+				velY[a] -= group.invMassA[lane] * impulse.y;
+				angularVelocity[a] -= group.invInertiaA[lane] * cross(anchorA, impulse);
+			}
+			if (group.invMassB[lane] > 0.0f) {
+				velX[b] += group.invMassB[lane] * impulse.x;
+				velY[b] += group.invMassB[lane] * impulse.y;
+				angularVelocity[b] += group.invInertiaB[lane] * cross(anchorB, impulse);
+			}
+		}
+	}
+}
+
+#ifdef PHYSICS_SSE
+void PhysicsWorld::solveGroup(ContactGroup& group, float* velX, float* velY, float* angularVelocity, bool push) {
+	//unused lanes gather body 0 but have no mass, so they solve to zero and are never written
+	const uint32_t* a = group.bodyA;
+	const uint32_t* b = group.bodyB;
+	__m128 vAX = _mm_setr_ps(velX[a[0]], velX[a[1]], velX[a[2]], velX[a[3]]);
+	__m128 vAY = _mm_setr_ps(velY[a[0]], velY[a[1]], velY[a[2]], velY[a[3]]);
+	__m128 wA = _mm_setr_ps(angularVelocity[a[0]], angularVelocity[a[1]], angularVelocity[a[2]], angularVelocity[a[3]]);
+	__m128 vBX = _mm_setr_ps(velX[b[0]], velX[b[1]], velX[b[2]], velX[b[3]]);
+	__m128 vBY = _mm_setr_ps(velY[b[0]], velY[b[1]], velY[b[2]], velY[b[3]]);
+	__m128 wB = _mm_setr_ps(angularVelocity[b[0]], angularVelocity[b[1]], angularVelocity[b[2]], angularVelocity[b[3]]);
+
+	const __m128 mA = _mm_load_ps(group.invMassA);
+	const __m128 iA = _mm_load_ps(group.invInertiaA);
+	const __m128 mB = _mm_load_ps(group.invMassB);
+	const __m128 iB = _mm_load_ps(group.invInertiaB);
+	const __m128 nX = _mm_load_ps(group.normalX);
+	const __m128 nY = _mm_load_ps(group.normalY);
+	const __m128 tX = nY;
+	const __m128 tY = _mm_sub_ps(_mm_setzero_ps(), nX);
+	const __m128 friction = _mm_load_ps(group.friction);
+
+	auto applyImpulse = [&](__m128 rAX, __m128 rAY, __m128 rBX, __m128 rBY, __m128 pX, __m128 pY) {
+		vAX = _mm_sub_ps(vAX, _mm_mul_ps(mA, pX));
+		vAY = _mm_sub_ps(vAY, _mm_mul_ps(mA, pY));
+		wA = _mm_sub_ps(wA, _mm_mul_ps(iA, _mm_sub_ps(_mm_mul_ps(rAX, pY), _mm_mul_ps(rAY, pX))));
+		vBX = _mm_add_ps(vBX, _mm_mul_ps(mB, pX));
+		vBY = _mm_add_ps(vBY, _mm_mul_ps(mB, pY));
+		wB = _mm_add_ps(wB, _mm_mul_ps(iB, _mm_sub_ps(_mm_mul_ps(rBX, pY), _mm_mul_ps(rBY, pX))));
+	};
+	//velocity of b's contact point relative to a's
+	auto relativeVelocity = [&](__m128 rAX, __m128 rAY, __m128 rBX, __m128 rBY, __m128& dX, __m128& dY) {
+		dX = _mm_sub_ps(_mm_sub_ps(vBX, _mm_mul_ps(wB, rBY)), _mm_sub_ps(vAX, _mm_mul_ps(wA, rAY)));
+		dY = _mm_sub_ps(_mm_add_ps(vBY, _mm_mul_ps(wB, rBX)), _mm_add_ps(vAY, _mm_mul_ps(wA, rAX)));
+	};
+
+	//friction first, so the normal impulses get the last word on penetration
+	for (auto& point : group.points) {
+		__m128 rAX = _mm_load_ps(point.anchorAX), rAY = _mm_load_ps(point.anchorAY);
+		__m128 rBX = _mm_load_ps(point.anchorBX), rBY = _mm_load_ps(point.anchorBY);
+		__m128 dX, dY;
+		relativeVelocity(rAX, rAY, rBX, rBY, dX, dY);
+		__m128 vt = _mm_add_ps(_mm_mul_ps(dX, tX), _mm_mul_ps(dY, tY));
+		__m128 lambda = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_load_ps(point.tangentMass), vt));
+
+		__m128 maxFriction = _mm_mul_ps(friction, _mm_load_ps(point.normalImpulse));
+		__m128 old = _mm_load_ps(point.tangentImpulse);
+		__m128 total = _mm_min_ps(_mm_max_ps(_mm_add_ps(old, lambda), _mm_sub_ps(_mm_setzero_ps(), maxFriction)), maxFriction);
+		_mm_store_ps(point.tangentImpulse, total);
+		lambda = _mm_sub_ps(total, old);
+		applyImpulse(rAX, rAY, rBX, rBY, _mm_mul_ps(lambda, tX), _mm_mul_ps(lambda, tY));
+	}
+	for (auto& point : group.points) {
+		__m128 rAX = _mm_load_ps(point.anchorAX), rAY = _mm_load_ps(point.anchorAY);
+		__m128 rBX = _mm_load_ps(point.anchorBX), rBY = _mm_load_ps(point.anchorBY);
+		__m128 dX, dY;
+		relativeVelocity(rAX, rAY, rBX, rBY, dX, dY);
+		__m128 vn = _mm_add_ps(_mm_mul_ps(dX, nX), _mm_mul_ps(dY, nY));
+		__m128 lambda = _mm_mul_ps(_mm_load_ps(point.normalMass), _mm_sub_ps(_mm_load_ps(push ? point.pushBias : point.restBias), vn));
+
+		__m128 old = _mm_load_ps(point.normalImpulse);
+		__m128 total = _mm_max_ps(_mm_add_ps(old, lambda), _mm_setzero_ps());
+		_mm_store_ps(point.normalImpulse, total);
+		lambda = _mm_sub_ps(total, old);
+		applyImpulse(rAX, rAY, rBX, rBY, _mm_mul_ps(lambda, nX), _mm_mul_ps(lambda, nY));
+	}
+
+	alignas(16) float lanes[6][4];
+	_mm_store_ps(lanes[0], vAX);
+	_mm_store_ps(lanes[1], vAY);
+	_mm_store_ps(lanes[2], wA);
+	_mm_store_ps(lanes[3], vBX);
+	_mm_store_ps(lanes[4], vBY);
+	_mm_store_ps(lanes[5], wB);
+	for (uint32_t lane = 0; lane < group.lanes; lane++) {
+		if (group.invMassA[lane] > 0.0f) {
+			velX[a[lane]] = lanes[0][lane];
+			velY[a[lane]] = lanes[1][lane];
+			angularVelocity[a[lane]] = lanes[2][lane];
+		}
+		if (group.invMassB[lane] > 0.0f) {
+			velX[b[lane]] = lanes[3][lane];
+			velY[b[lane]] = lanes[4][lane];
+			angularVelocity[b[lane]] = lanes[5][lane];
+		}
+	}
+}
+#else
+void PhysicsWorld::solveGroup(ContactGroup& group, float* velX, float* velY, float* angularVelocity, bool push) {
+	for (uint32_t lane = 0; lane < group.lanes; lane++) {
+		uint32_t a = group.bodyA[lane];
+		uint32_t b = group.bodyB[lane];
+		glm::vec2 vA{ velX[a], velY[a] }, vB{ velX[b], velY[b] };
+		float wA = angularVelocity[a], wB = angularVelocity[b];
+		float mA = group.invMassA[lane], iA = group.invInertiaA[lane];
+		float mB = group.invMassB[lane], iB = group.invInertiaB[lane];
+		glm::vec2 normal{ group.normalX[lane], group.normalY[lane] };
+		glm::vec2 tangent{ normal.y, -normal.x };
+
+		auto solvePoint = [&](ContactGroup::Point& point, bool isNormal) {
+			glm::vec2 rA{ point.anchorAX[lane], point.anchorAY[lane] };
+			glm::vec2 rB{ point.anchorBX[lane], point.anchorBY[lane] };
+			glm::vec2 dv = vB + glm::vec2(-wB * rB.y, wB * rB.x) - vA - glm::vec2(-wA * rA.y, wA * rA.x);
+			glm::vec2 direction = isNormal ? normal : tangent;
+			float lambda;
+			if (isNormal) {
+				lambda = point.normalMass[lane] * ((push ? point.pushBias[lane] : point.restBias[lane]) - glm::dot(dv, normal));
+				float total = std::max(point.normalImpulse[lane] + lambda, 0.0f);
+				lambda = total - point.normalImpulse[lane];
+				point.normalImpulse[lane] = total;
+			}
+			else {
+				lambda = -point.tangentMass[lane] * glm::dot(dv, tangent);
+				float maxFriction = group.friction[lane] * point.normalImpulse[lane];
+				float total = std::clamp(point.tangentImpulse[lane] + lambda, -maxFriction, maxFriction);
+				lambda = total - point.tangentImpulse[lane];
+				point.tangentImpulse[lane] = total;
+			}
+			glm::vec2 impulse = direction * lambda;
+			vA -= mA * impulse;
+			wA -= iA * cross(rA, impulse);
+			vB += mB * impulse;
+			wB += iB * cross(rB, impulse);
+		};
+		for (auto& point : group.points) solvePoint(point, false);
+		for (auto& point : group.points) solvePoint(point, true);
+
+		if (mA > 0.0f) {
+			velX[a] = vA.x;
+			velY[a] = vA.y;
+			angularVelocity[a] = wA;
+		}
+		if (mB > 0.0f) {
+			velX[b] = vB.x;
+			velY[b] = vB.y;
+			angularVelocity[b] = wB;
+		}
+	}
+}
+#endif
+
+void PhysicsWorld::solve(JobSystem& jobs, bool push) {
+	float* vx = velX.data();
+	float* vy = velY.data();
+	float* w = angularVelocity.data();
+
+	//iteration -1 warm starts, colours run one after the other, the groups of a colour
+	//share no moving bodies so they run in parallel
+	const int first = push ? -1 : 0;
+	const int iterations = push ? params.velocityIterations : params.relaxIterations;
+	for (int iteration = first; iteration < iterations; iteration++) {
+		for (int color = 0; color < MAX_COLORS; color++) {
+			auto& groups = colors[color];
+			if (groups.empty()) break;
+			jobs.parallelFor(static_cast<uint32_t>(groups.size()), 32, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t g = begin; g < end; g++) {
+					if (iteration < 0) warmStart(groups[g], vx, vy, w);
+					else solveGroup(groups[g], vx, vy, w, push);
+				}
+			});
+		}
+		for (auto& group : overflow) {
+			if (iteration < 0) warmStart(group, vx, vy, w);
+			else solveGroup(group, vx, vy, w, push);
+		}
+	}
+}
+
+void PhysicsWorld::storeImpulses() {
+	auto store = [&](const ContactGroup& group) {
+		for (uint32_t lane = 0; lane < group.lanes; lane++) {
+			Constraint& constraint = constraints[group.constraint[lane]];
+			for (int p = 0; p < 2; p++) {
+				constraint.normalImpulse[p] = group.points[p].normalImpulse[lane];
+				constraint.tangentImpulse[p] = group.points[p].tangentImpulse[lane];
+			}
+		}
+	};
+	for (const auto& groups : colors) {
+		for (const auto& group : groups) store(group);
+	}
+	for (const auto& group : overflow) store(group);
+
+	cache.clear();
+	for (const Constraint& constraint : constraints) {
+		CachedContact contact{};
+		contact.key = pairKey(constraint.a, constraint.b);
+		contact.pointCount = constraint.manifold.pointCount;
+		for (int p = 0; p < contact.pointCount; p++) {
+			contact.ids[p] = constraint.manifold.points[p].id;
+			contact.normalImpulse[p] = constraint.normalImpulse[p];
+			contact.tangentImpulse[p] = constraint.tangentImpulse[p];
+		}
+		cache.push_back(contact);
+	}
+	std::sort(cache.begin(), cache.end(), [](const CachedContact& a, const CachedContact& b) { return a.key < b.key; });
+}
+
+void PhysicsWorld::integratePositions(JobSystem& jobs, float dt) {
+	jobs.parallelFor(size(), 1024, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (!awake[i]) continue;
+			posX[i] += velX[i] * dt;
+			posY[i] += velY[i] * dt;
+			angles[i] += angularVelocity[i] * dt;
+		}
+	});
+}
+
+uint32_t PhysicsWorld::findIsland(uint32_t body) {
+	while (islandParent[body] != body) {
+		//path halving keeps the trees flat
+		islandParent[body] = islandParent[islandParent[body]];
+		body = islandParent[body];
+	}
+	return body;
+}
+
+void PhysicsWorld::updateSleep(float dt) {
+	const float tolerance = params.sleepVelocity * params.sleepVelocity;
+	for (uint32_t i = 0; i < size(); i++) {
+		if (!awake[i]) continue;
+		float speed = velX[i] * velX[i] + velY[i] * velY[i];
+		float rim = angularVelocity[i] * extents[i];
+		if (speed > tolerance || rim * rim > tolerance) {
+			sleepTimers[i] = 0.0f;
+		}
+		else {
+			sleepTimers[i] += dt;
+		}
+	}
+
+	//touching moving bodies form an island, static ones don't join them
+	islandParent.resize(size());
+	for (uint32_t i = 0; i < size(); i++) {
+		islandParent[i] = i;
+	}
+	for (const Constraint& constraint : constraints) {
+		if (invMass[constraint.a] == 0.0f || invMass[constraint.b] == 0.0f) continue;
+		uint32_t rootA = findIsland(constraint.a);
+		uint32_t rootB = findIsland(constraint.b);
+		if (rootA != rootB) {
+			islandParent[rootA] = rootB;
+		}
+	}
+
+	//an island sleeps once its most restless body has been still long enough
+	islandTimers.assign(size(), FLT_MAX);
+	for (uint32_t i = 0; i < size(); i++) {
+		if (!awake[i]) continue;
+		uint32_t root = findIsland(i);
+		islandTimers[root] = std::min(islandTimers[root], sleepTimers[i]);
+	}
+	islandSlots.assign(size(), NO_ISLAND);
+	for (uint32_t i = 0; i < size(); i++) {
+		if (!awake[i]) continue;
+		uint32_t root = findIsland(i);
+		if (islandTimers[root] < params.timeToSleep) continue;
+
+		if (islandSlots[root] == NO_ISLAND) {
+			if (freeIslands.empty()) {
+				islandSlots[root] = static_cast<uint32_t>(sleepingIslands.size());
+				sleepingIslands.emplace_back();
+			}
+			else {
+				islandSlots[root] = freeIslands.back();
+				freeIslands.pop_back();
+			}
+		}
+		uint32_t island = islandSlots[root];
+		sleepingIslands[island].push_back(i);
+		sleepIsland[i] = island;
+		awake[i] = 0;
+		velX[i] = velY[i] = angularVelocity[i] = 0.0f;
+	}
+}
+
+void PhysicsWorld::buildSweepGrid() {
+	sweepGridStale = false;
+	const float margin = params.maxSweepRadius;
+	sweepGridBounds = { glm::vec2(FLT_MAX), glm::vec2(-FLT_MAX) };
+	for (const AABB& box : bounds) {
+		sweepGridBounds.min = glm::min(sweepGridBounds.min, box.min - margin);
+		sweepGridBounds.max = glm::max(sweepGridBounds.max, box.max + margin);
+	}
+
+	//cells grow when the world is too big for the grid to stay small
+	const int MAX_CELLS = 512;
+	glm::vec2 extent = sweepGridBounds.max - sweepGridBounds.min;
+	sweepCellSize = std::max({ params.sweepCellSize, extent.x / MAX_CELLS, extent.y / MAX_CELLS });
+	sweepGridWidth = std::max(static_cast<int>(std::ceil(extent.x / sweepCellSize)), 1);
+	sweepGridHeight = std::max(static_cast<int>(std::ceil(extent.y / sweepCellSize)), 1);
+
+	auto cellRange = [&](BodyId body, int& minX, int& minY, int& maxX, int& maxY) {
+		glm::vec2 low = (bounds[body].min - margin - sweepGridBounds.min) / sweepCellSize;
+		glm::vec2 high = (bounds[body].max + margin - sweepGridBounds.min) / sweepCellSize;
+		minX = std::clamp(static_cast<int>(low.x), 0, sweepGridWidth - 1);
+		minY = std::clamp(static_cast<int>(low.y), 0, sweepGridHeight - 1);
+		maxX = std::clamp(static_cast<int>(high.x), 0, sweepGridWidth - 1);
+		maxY = std::clamp(static_cast<int>(high.y), 0, sweepGridHeight - 1);
+	};
+
+	//counting sort, bodies spanning several cells are in each of them
+	sweepCellStart.assign(static_cast<size_t>(sweepGridWidth) * sweepGridHeight + 1, 0);
+	for (BodyId body = 0; body < size(); body++) {
+		int minX, minY, maxX, maxY;
+		cellRange(body, minX, minY, maxX, maxY);
+		for (int y = minY; y <= maxY; y++) {
+			for (int x = minX; x <= maxX; x++) {
+				sweepCellStart[y * sweepGridWidth + x + 1]++;
+			}
+		}
+	}
+	for (size_t cell = 1; cell < sweepCellStart.size(); cell++) {
+		sweepCellStart[cell] += sweepCellStart[cell - 1];
+	}
+	sweepCellBodies.resize(sweepCellStart.back());
+	std::vector<uint32_t> fill(sweepCellStart.begin(), sweepCellStart.end() - 1);
+	for (BodyId body = 0; body < size(); body++) {
+		int minX, minY, maxX, maxY;
+		cellRange(body, minX, minY, maxX, maxY);
+		for (int y = minY; y <= maxY; y++) {
+			for (int x = minX; x <= maxX; x++) {
+				sweepCellBodies[fill[y * sweepGridWidth + x]++] = body;
+			}
+		}
+	}
+}
+
+PhysicsWorld::Impact PhysicsWorld::castSweepAgainst(const Sweep& sweep, BodyId body, float best) const {
+	Impact impact{ NO_BODY, best };
+	glm::vec2 translation = sweep.end - sweep.start;
+	AABB grown{ bounds[body].min - sweep.radius, bounds[body].max + sweep.radius };
+	float enter;
+	if (!rayCastAABB(grown, sweep.start, translation, enter) || enter >= best) return impact;
+
+	Transform2D transform{ getPosition(body), { std::cos(angles[body]), std::sin(angles[body]) } };
+	CastHit hit;
+	if (castShape(shapes[body], transform, sweep.start, translation, sweep.radius, hit) && hit.fraction < best) {
+		impact = { body, hit.fraction, hit.point, hit.normal };
+	}
+	return impact;
+}
+
+PhysicsWorld::Impact PhysicsWorld::castSweep(const Sweep& sweep) const {
+	Impact best{ NO_BODY, FLT_MAX };
+	glm::vec2 translation = sweep.end - sweep.start;
+	float cellEnter;
+	if (!rayCastAABB(sweepGridBounds, sweep.start, translation, cellEnter)) return best;
+
+	//walks the cells the line crosses in order. bodies are bucketed grown by the largest
+	//radius, so the cell holding the sweep's center at its time of impact holds what it hit,
+	//and once a hit comes before the next cell is entered nothing later can beat it
+	glm::vec2 entry = (sweep.start + translation * cellEnter - sweepGridBounds.min) / sweepCellSize;
+	int x = std::clamp(static_cast<int>(entry.x), 0, sweepGridWidth - 1);
+	int y = std::clamp(static_cast<int>(entry.y), 0, sweepGridHeight - 1);
+	int stepX = translation.x > 0.0f ? 1 : translation.x < 0.0f ? -1 : 0;
+	int stepY = translation.y > 0.0f ? 1 : translation.y < 0.0f ? -1 : 0;
+	float deltaX = stepX != 0 ? sweepCellSize / std::abs(translation.x) : FLT_MAX;
+	float deltaY = stepY != 0 ? sweepCellSize / std::abs(translation.y) : FLT_MAX;
+	float nextX = stepX != 0 ? (sweepGridBounds.min.x + (x + (stepX > 0 ? 1 : 0)) * sweepCellSize - sweep.start.x) / translation.x : FLT_MAX;
+	float nextY = stepY != 0 ? (sweepGridBounds.min.y + (y + (stepY > 0 ? 1 : 0)) * sweepCellSize - sweep.start.y) / translation.y : FLT_MAX;
+
+	//bodies spanning cells come up again in the next ones, the last few tested are skipped
+	BodyId recent[8];
+	uint32_t recentCount = 0;
+	while (best.fraction >= cellEnter) {
+		uint32_t cell = y * sweepGridWidth + x;
+		for (uint32_t i = sweepCellStart[cell]; i < sweepCellStart[cell + 1]; i++) {
+			BodyId body = sweepCellBodies[i];
+			if (std::find(recent, recent + std::min(recentCount, 8u), body) != recent + std::min(recentCount, 8u)) continue;
+			recent[recentCount++ % 8] = body;
+
+			Impact impact = castSweepAgainst(sweep, body, best.fraction);
+			if (impact.body != NO_BODY) {
+				best = impact;
+			}
+		}
+
+		if (nextX < nextY) {
+			cellEnter = nextX;
+			nextX += deltaX;
+			x += stepX;
+		}
+		else {
+			cellEnter = nextY;
+			nextY += deltaY;
+			y += stepY;
+		}
+		if (cellEnter > 1.0f || x < 0 || y < 0 || x >= sweepGridWidth || y >= sweepGridHeight) break;
+	}
+	return best;
+}
+
+void PhysicsWorld::castSweeps(JobSystem& jobs, const Sweep* sweeps, uint32_t count, Impact* impacts) {
+	if (count == 0) return;
+	auto start = std::chrono::high_resolution_clock::now();
+	if (sweepGridStale) {
+		buildSweepGrid();
+	}
+	jobs.parallelFor(count, 64, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			impacts[i] = castSweep(sweeps[i]);
+		}
+	});
+
+	if (measure) {
+		sweepMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		sweepsCast += count;
+	}
+}
+
+void PhysicsWorld::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		LOG_INFO("Physics {} bodies, {} awake, {} contacts: avg {:.3f}ms max {:.3f}ms per step, {} sweeps in {:.3f}ms",
+			size(), getAwakeCount(), constraints.size(), sumMilliseconds / samples, maxMilliseconds, sweepsCast, sweepMilliseconds);
+	}
+	samples = 0;
+	sumMilliseconds = maxMilliseconds = 0.0;
+	sweepsCast = 0;
+	sweepMilliseconds = 0.0;
+}
+
+void PhysicsWorld::benchmark(JobSystem& jobs) {
+	using Clock = std::chrono::high_resolution_clock;
+	const float dt = 1.0f / 120.0f;
+
+	for (uint32_t bodies : { 1000u, 2000u, 4000u }) {
+		PhysicsWorld world{ Params{} };
+		//a wide bin so the pile stays a few dozen bodies deep whatever the count
+		const uint32_t columns = 100;
+		float width = columns * 0.6f;
+		world.createBody(BodyType::Static, Shape::box({ width * 0.5f + 1.0f, 0.5f }), { 0.0f, -0.5f });
+		world.createBody(BodyType::Static, Shape::box({ 0.5f, 40.0f }), { -width * 0.5f - 1.0f, 40.0f });
+		world.createBody(BodyType::Static, Shape::box({ 0.5f, 40.0f }), { width * 0.5f + 1.0f, 40.0f });
+
+		glm::vec2 hexagon[6];
+		for (int i = 0; i < 6; i++) {
+			hexagon[i] = glm::vec2(std::cos(i * 1.0471976f), std::sin(i * 1.0471976f)) * 0.25f;
+		}
+		const Shape debris[4] = { Shape::circle(0.22f), Shape::capsule(0.15f, 0.12f), Shape::box({ 0.22f, 0.18f }), Shape::polygon(hexagon, 6) };
+		for (uint32_t i = 0; i < bodies; i++) {
+			uint32_t column = i % columns;
+			uint32_t row = i / columns;
+			glm::vec2 position{ -width * 0.5f + 0.3f + column * 0.6f + (row % 2) * 0.1f, 0.5f + row * 0.6f };
+			world.createBody(BodyType::Dynamic, debris[(i * 7 + row) % 4], position, i * 0.37f);
+		}
+
+		//the first second is the pile falling in, the rest is it settling under its own weight
+		const int steps = 600;
+		double sumMilliseconds = 0.0, maxMilliseconds = 0.0;
+		uint32_t awakeAfterFall = 0;
+		for (int i = 0; i < steps; i++) {
+			auto start = Clock::now();
+			world.step(jobs, dt);
+			double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			sumMilliseconds += milliseconds;
+			maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+			if (i == 119) awakeAfterFall = world.getAwakeCount();
+		}
+
+		LOG_INFO("Physics benchmark: {} bodies on {} threads, avg {:.3f}ms max {:.3f}ms per step against 2ms, {} contacts, {} awake after 1s {} after {:.0f}s",
+			bodies, jobs.getWorkerCount() + 1, sumMilliseconds / steps, maxMilliseconds, world.getContactCount(),
+			awakeAfterFall, world.getAwakeCount(), steps * dt);
+
+		//rounds at 600m/s cover 5m a tick, fired into the pile from all over the bin
+		const uint32_t sweepCount = 20000;
+		std::vector<Sweep> sweeps(sweepCount);
+		uint32_t random = 2463534242u;
+		auto nextFloat = [&]() {
+			random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+			return (random >> 8) / 16777216.0f;
+		};
+		for (uint32_t i = 0; i < sweepCount; i++) {
+			glm::vec2 start{ (nextFloat() - 0.5f) * width, nextFloat() * 12.0f };
+			float angle = nextFloat() * 6.2831853f;
+			sweeps[i] = { start, start + glm::vec2(std::cos(angle), std::sin(angle)) * 5.0f, i % 2 == 0 ? 0.0f : 0.05f };
+		}
+		std::vector<Impact> impacts(sweepCount);
+		auto start = Clock::now();
+		world.castSweeps(jobs, sweeps.data(), sweepCount, impacts.data());
+		double gridMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		//every body against every sweep for comparison
+		uint32_t hits = 0, mismatches = 0;
+		start = Clock::now();
+		for (uint32_t i = 0; i < sweepCount; i++) {
+			Impact best{ NO_BODY, FLT_MAX };
+			for (BodyId body = 0; body < world.size(); body++) {
+				Impact impact = world.castSweepAgainst(sweeps[i], body, best.fraction);
+				if (impact.body != NO_BODY) best = impact;
+			}
+			hits += best.body != NO_BODY;
+			if (best.body != impacts[i].body && std::abs(best.fraction - impacts[i].fraction) > 1e-5f) mismatches++;
+		}
+		double bruteMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		LOG_INFO("Physics benchmark: {} sweeps through {} bodies {:.3f}ms, {:.3f}ms testing every body, {} hits, {} mismatches",
+			sweepCount, world.size(), gridMilliseconds, bruteMilliseconds, hits, mismatches);
+	}
+}
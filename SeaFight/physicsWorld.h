@@ -0,0 +1,203 @@
+#pragma once
+
+#include "collision.h"
+#include "jobSystem.h"
+#include "utils.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// 2d rigid bodies with contacts solved by sequential impulses
+// bodies are kept as structure of arrays. every step runs:
+//  - a sort and sweep broadphase over the bodies' bounds, kept nearly sorted between steps
+//  - narrowphase manifolds for the overlapping pairs, across the job system, warm started
+//    from the previous step's impulses
+//  - graph colouring so no two contacts of a colour share a moving body, then packing each
+//    colour four contacts at a time into sse lanes that are solved side by side, and the
+//    colour's groups split across the job system
+//  - union find islands over the touching contacts, islands that stayed still long enough
+//    go to sleep and cost nothing until something touches them
+// fast movers like projectiles don't step as bodies, they are swept against the world in
+// batches through a uniform grid, so each one costs the cells it crosses
+class PhysicsWorld {
+public:
+	using BodyId = uint32_t;
+	static constexpr BodyId NO_BODY = ~0u;
+
+	enum class BodyType : uint8_t { Static, Dynamic };
+
+	struct Params {
+		glm::vec2 gravity{ 0.0f, -10.0f };
+		int velocityIterations = 8;
+		// iterations after positions moved, taking back the velocity the overlap push added
+		int relaxIterations = 2;
+		float friction = 0.6f;
+		// fraction of the overlap pushed out per step
+		float baumgarte = 0.2f;
+		float maxPushVelocity = 2.0f;
+		// contacts this far apart are kept, so fast bodies slow down before they touch
+		float speculativeDistance = 0.02f;
+		float timeToSleep = 0.5f;
+		// a body counts as still while no point of it moves faster than this
+		float sleepVelocity = 0.05f;
+		// sweeps with a larger radius can miss bodies at the edge of the cells they cross
+		float maxSweepRadius = 0.25f;
+		float sweepCellSize = 1.0f;
+	};
+
+	// a point, or a circle with a radius, moving from start to end over one tick
+	struct Sweep {
+		glm::vec2 start;
+		glm::vec2 end;
+		float radius;
+	};
+
+	// first body a sweep touched, NO_BODY when it touched nothing
+	struct Impact {
+		BodyId body;
+		// time of impact as a fraction of the tick
+		float fraction;
+		glm::vec2 point{ 0.0f };
+		glm::vec2 normal{ 0.0f };
+	};
+
+	PhysicsWorld(const Params& params);
+
+	BodyId createBody(BodyType type, const Shape& shape, glm::vec2 position, float angle = 0.0f, float density = 1.0f);
+	void setVelocity(BodyId body, glm::vec2 linear, float angular);
+	void applyImpulse(BodyId body, glm::vec2 impulse, glm::vec2 point);
+
+	void step(JobSystem& jobs, float dt);
+	// fills impacts with the first hit of each sweep, the sweeps split across the job system
+	void castSweeps(JobSystem& jobs, const Sweep* sweeps, uint32_t count, Impact* impacts);
+
+	uint32_t size() const { return static_cast<uint32_t>(shapes.size()); }
+	glm::vec2 getPosition(BodyId body) const { return { posX[body], posY[body] }; }
+	float getAngle(BodyId body) const { return angles[body]; }
+	const Shape& getShape(BodyId body) const { return shapes[body]; }
+	bool isAwake(BodyId body) const { return awake[body] != 0; }
+	uint32_t getAwakeCount() const;
+	uint32_t getContactCount() const { return static_cast<uint32_t>(constraints.size()); }
+
+	// logs step timings once a second when measure_physics is set
+	void report(double now);
+
+	// a large pile of mixed shapes settling into sleep, step times against the 2ms target
+	static void benchmark(JobSystem& jobs);
+
+private:
+	static constexpr int MAX_COLORS = 16;
+	static constexpr uint32_t NO_ISLAND = ~0u;
+
+	// four contacts solved together, one per sse lane
+	struct alignas(16) ContactGroup {
+		float invMassA[4], invInertiaA[4], invMassB[4], invInertiaB[4];
+		float normalX[4], normalY[4], friction[4];
+		struct Point {
+			float anchorAX[4], anchorAY[4], anchorBX[4], anchorBY[4];
+			float normalMass[4], tangentMass[4];
+			// pushBias also pushes out overlap, restBias only stops speculative points short
+			float pushBias[4], restBias[4];
+			float normalImpulse[4], tangentImpulse[4];
+		} points[2];
+		uint32_t bodyA[4], bodyB[4];
+		// index into constraints, impulses are copied back when solving is done
+		uint32_t constraint[4];
+		uint32_t lanes;
+	};
+
+	struct Pair {
+		uint32_t a;
+		uint32_t b;
+	};
+
+	// impulses carried over to the next step, by body pair and feature id
+	struct CachedContact {
+		uint64_t key;
+		uint16_t ids[2];
+		float normalImpulse[2];
+		float tangentImpulse[2];
+		int pointCount;
+	};
+
+	struct Constraint {
+		uint32_t a;
+		uint32_t b;
+		Manifold manifold;
+		float normalImpulse[2];
+		float tangentImpulse[2];
+	};
+
+	Params params;
+
+	// bodies
+	std::vector<Shape> shapes;
+	std::vector<float> posX, posY, angles;
+	std::vector<float> velX, velY, angularVelocity;
+	std::vector<float> invMass, invInertia;
+	// furthest any point of the shape is from the body origin
+	std::vector<float> extents;
+	std::vector<float> sleepTimers;
+	std::vector<uint8_t> awake;
+	std::vector<AABB> bounds;
+	// bodies put to sleep together wake together
+	std::vector<uint32_t> sleepIsland;
+	std::vector<std::vector<BodyId>> sleepingIslands;
+	std::vector<uint32_t> freeIslands;
+
+	// per step, kept around for their capacity
+	std::vector<BodyId> sweepOrder;
+	// new bodies are appended unsorted, a full sort beats insertion sort for a batch of them
+	bool sweepUnsorted = false;
+	std::vector<Pair> pairs;
+	std::vector<Constraint> candidates;
+	std::vector<Constraint> constraints;
+	std::vector<CachedContact> cache;
+	std::vector<uint32_t> colorMasks;
+	std::vector<uint32_t> colorMembers[MAX_COLORS];
+	std::vector<ContactGroup> colors[MAX_COLORS];
+	// contacts no colour had room for, solved one at a time
+	std::vector<ContactGroup> overflow;
+	std::vector<uint32_t> islandParent;
+	std::vector<float> islandTimers;
+	std::vector<uint32_t> islandSlots;
+
+	// bodies bucketed by their bounds grown by maxSweepRadius, rebuilt when a sweep follows a step
+	std::vector<uint32_t> sweepCellStart;
+	std::vector<BodyId> sweepCellBodies;
+	AABB sweepGridBounds{};
+	float sweepCellSize = 1.0f;
+	int sweepGridWidth = 0;
+	int sweepGridHeight = 0;
+	bool sweepGridStale = true;
+
+	const bool measure = Settings::settings.value("measure_physics", false);
+	uint32_t samples = 0;
+	double sumMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	double lastReport = 0.0;
+	uint32_t sweepsCast = 0;
+	double sweepMilliseconds = 0.0;
+
+	void updateBounds(JobSystem& jobs);
+	void findPairs();
+	void collidePairs(JobSystem& jobs);
+	void wakeTouched();
+	void wakeBody(BodyId body);
+	void buildGroups(float dt);
+	void fillLane(ContactGroup& group, uint32_t lane, uint32_t constraint, float dt);
+	// push solves with the overlap push and warm starts, otherwise it relaxes
+	void solve(JobSystem& jobs, bool push);
+	void storeImpulses();
+	void integratePositions(JobSystem& jobs, float dt);
+	void updateSleep(float dt);
+	void buildSweepGrid();
+	Impact castSweep(const Sweep& sweep) const;
+	Impact castSweepAgainst(const Sweep& sweep, BodyId body, float best) const;
+
+	uint32_t findIsland(uint32_t body);
+	static void warmStart(ContactGroup& group, float* velX, float* velY, float* angularVelocity);
+	static void solveGroup(ContactGroup& group, float* velX, float* velY, float* angularVelocity, bool push);
+};
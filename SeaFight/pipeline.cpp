@@ -1,5 +1,7 @@
 #include "pipeline.h"
 
+#include "log.h"
+
 #include <cassert>
 #include <fstream>
 #include <iostream>
@@ -27,7 +29,7 @@ std::vector<char> Pipeline::readFile(const std::string& filepath) {
 	std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
 
 	if (!file.is_open()) {
-		spdlog::critical("Failed to open file: {}", filepath);
+		LOG_CRITICAL("Failed to open file: {}", filepath);
 		throw std::runtime_error("Failed to open file: " + filepath);
 	}
 
@@ -74,8 +76,8 @@ void Pipeline::createGraphicsPipeline(
 	shaderStages[1].pNext = nullptr;
 	shaderStages[1].pSpecializationInfo = nullptr;
 
-	auto bindingDescriptions = Sprite::Vertex::getBindingDescriptions();
-	auto attributeDescriptions = Sprite::Vertex::getAttributeDescriptions();
+	auto& bindingDescriptions = configInfo.bindingDescriptions;
+	auto& attributeDescriptions = configInfo.attributeDescriptions;
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexAttributeDescriptionCount =
@@ -111,7 +113,7 @@ void Pipeline::createGraphicsPipeline(
 		&pipelineInfo,
 		nullptr,
 		&graphicsPipeline) != VK_SUCCESS) {
-		spdlog::critical("Failed to create graphics pipeline!");
+		LOG_CRITICAL("Failed to create graphics pipeline!");
 		throw std::runtime_error("Failed to create graphics pipeline!");
 	}
 
@@ -128,7 +130,7 @@ void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule*
 	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
 	if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
-		spdlog::critical("Failed to create shader module");
+		LOG_CRITICAL("Failed to create shader module");
 		throw std::runtime_error("Failed to create shader module");
 	}
 }
@@ -206,4 +208,7 @@ void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) {
 	configInfo.dynamicStateInfo.dynamicStateCount =
 	  static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 	configInfo.dynamicStateInfo.flags = 0;
+
+	configInfo.bindingDescriptions = Sprite::Vertex::getBindingDescriptions();
+	configInfo.attributeDescriptions = Sprite::Vertex::getAttributeDescriptions();
 }
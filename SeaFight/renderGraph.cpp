@@ -0,0 +1,650 @@
+#include "renderGraph.h"
+
+#include "layoutTransition.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "log.h"
+
+//access bits that leave data behind which later accesses have to see
+static constexpr VkAccessFlags WRITE_ACCESS =
+	VK_ACCESS_SHADER_WRITE_BIT |
+	VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_TRANSFER_WRITE_BIT;
+
+static bool isAttachmentLayout(VkImageLayout layout) {
+	return layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+		layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+}
+
+static VkImageUsageFlags usageForLayout(VkImageLayout layout) {
+	switch (layout) {
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return VK_IMAGE_USAGE_SAMPLED_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	default: return 0;
+	}
+}
+
+static LayoutAccess layoutAccess(VkImageLayout layout) {
+	LayoutAccess access;
+	if (!getLayoutAccess(layout, access)) {
+		LOG_CRITICAL("Render graph has no access mapping for layout {}", static_cast<int>(layout));
+		throw std::runtime_error("Render graph has no access mapping for layout");
+	}
+	return access;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(ResourceId resource) {
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, false, {});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(ResourceId resource, VkClearColorValue clear) {
+	VkClearValue clearValue{};
+	clearValue.color = clear;
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, true, clearValue);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(ResourceId resource) {
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, false, {});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(ResourceId resource, VkClearDepthStencilValue clear) {
+	VkClearValue clearValue{};
+	clearValue.depthStencil = clear;
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, true, clearValue);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::readTexture(ResourceId resource) {
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, false, {});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::readTransfer(ResourceId resource) {
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, false, {});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeTransfer(ResourceId resource) {
+	graph.addUse(pass, resource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, false, {});
+	return *this;
+}
+
+RenderGraph::RenderGraph(Device& device, DeletionQueue& deletionQueue)
+	: device{ device }, deletionQueue{ deletionQueue } {}
+
+RenderGraph::~RenderGraph() {
+	releaseResources();
+}
+
+RenderGraph::ResourceId RenderGraph::importImage(const std::string& name, VkFormat format, VkImageLayout finalLayout) {
+	Resource resource{};
+	resource.name = name;
+	resource.imported = true;
+	resource.format = format;
+	resource.finalLayout = finalLayout;
+	resources.push_back(resource);
+	compiled = false;
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::createTransient(const std::string& name, const TransientDesc& desc) {
+	Resource resource{};
+	resource.name = name;
+	resource.imported = false;
+	resource.format = desc.format;
+	resource.desc = desc;
+	resources.push_back(resource);
+	compiled = false;
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, RecordFn record) {
+	Pass pass{};
+	pass.name = name;
+	pass.record = std::move(record);
+	passes.push_back(std::move(pass));
+	compiled = false;
+	return PassBuilder{ *this, static_cast<PassId>(passes.size() - 1) };
+}
+
+void RenderGraph::addUse(PassId pass, ResourceId resource, VkImageLayout layout, bool write, bool clear, VkClearValue clearValue) {
+	assert(pass < passes.size() && resource < resources.size() && "Invalid render graph handle");
+#ifndef NDEBUG
+	for (const Use& use : passes[pass].uses) {
+		assert(use.resource != resource && "A pass can only use a resource once");
+	}
+#endif
+	passes[pass].uses.push_back({ resource, layout, write, clear, clearValue });
+	compiled = false;
+}
+
+void RenderGraph::setImportedImage(ResourceId resource, VkImage image, VkImageView view) {
+	assert(resources[resource].imported && "Only imported images can be replaced");
+	resources[resource].image = image;
+	resources[resource].view = view;
+}
+
+RenderGraph::SyncState& RenderGraph::syncState(Resource& resource) {
+	return resource.block >= 0 ? blocks[resource.block].sync : resource.sync;
+}
+
+void RenderGraph::compile(VkExtent2D extent) {
+	releaseResources();
+
+	cullPasses();
+	computeLifetimes();
+	createTransients(extent);
+	aliasTransients();
+	createRenderPasses();
+	compiled = true;
+}
+
+void RenderGraph::cullPasses() {
+	//imported images are what the frame hands out, everything else only matters if it feeds one
+	std::vector<bool> needed(resources.size(), false);
+	for (size_t i = 0; i < resources.size(); i++) {
+		needed[i] = resources[i].imported;
+	}
+
+	//walk backwards so every consumer is decided before its producers
+	for (size_t p = passes.size(); p-- > 0;) {
+		Pass& pass = passes[p];
+		pass.culled = true;
+		for (const Use& use : pass.uses) {
+			if (use.write && needed[use.resource]) {
+				pass.culled = false;
+				break;
+			}
+		}
+		if (pass.culled) continue;
+
+		//attachments that are loaded instead of cleared read what earlier passes wrote
+		for (const Use& use : pass.uses) {
+			if (!use.write || (isAttachmentLayout(use.layout) && !use.clear)) {
+				needed[use.resource] = true;
+			}
+		}
+	}
+
+	executionOrder.clear();
+	for (PassId p = 0; p < passes.size(); p++) {
+		if (passes[p].culled) {
+			LOG_DEBUG("Render graph culled pass {}", passes[p].name);
+		} else {
+			executionOrder.push_back(p);
+		}
+	}
+}
+
+void RenderGraph::computeLifetimes() {
+	for (Resource& resource : resources) {
+		resource.firstUse = -1;
+		resource.lastUse = -1;
+		resource.usage = resource.desc.usage;
+	}
+
+	for (int order = 0; order < static_cast<int>(executionOrder.size()); order++) {
+		for (const Use& use : passes[executionOrder[order]].uses) {
+			Resource& resource = resources[use.resource];
+			if (resource.firstUse < 0) resource.firstUse = order;
+			resource.lastUse = order;
+			resource.usage |= usageForLayout(use.layout);
+		}
+	}
+}
+
+void RenderGraph::createTransients(VkExtent2D extent) {
+	for (Resource& resource : resources) {
+		if (resource.imported) {
+			resource.extent = extent;
+			continue;
+		}
+		if (resource.firstUse < 0) continue;
+
+		resource.extent.width = std::max(1u, static_cast<uint32_t>(extent.width * resource.desc.scale));
+		resource.extent.height = std::max(1u, static_cast<uint32_t>(extent.height * resource.desc.scale));
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = resource.extent.width;
+		imageInfo.extent.height = resource.extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = resource.format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = resource.usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateImage(device.device(), &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+			LOG_CRITICAL("Failed to create render graph image {}!", resource.name);
+			throw std::runtime_error("Failed to create render graph image!");
+		}
+		vkGetImageMemoryRequirements(device.device(), resource.image, &resource.memoryRequirements);
+	}
+}
+
+void RenderGraph::aliasTransients() {
+	blocks.clear();
+
+	std::vector<ResourceId> transients;
+	for (ResourceId i = 0; i < resources.size(); i++) {
+		resources[i].block = -1;
+		if (!resources[i].imported && resources[i].image != VK_NULL_HANDLE) {
+			transients.push_back(i);
+		}
+	}
+
+	//largest first so smaller images fill in behind them
+	std::sort(transients.begin(), transients.end(), [&](ResourceId a, ResourceId b) {
+		return resources[a].memoryRequirements.size > resources[b].memoryRequirements.size;
+	});
+
+	VkDeviceSize requested = 0;
+	for (ResourceId id : transients) {
+		Resource& resource = resources[id];
+		const VkMemoryRequirements& requirements = resource.memoryRequirements;
+		requested += requirements.size;
+
+		int chosen = -1;
+		for (int b = 0; b < static_cast<int>(blocks.size()) && chosen < 0; b++) {
+			MemoryBlock& block = blocks[b];
+			if ((block.memoryTypeBits & requirements.memoryTypeBits) == 0) continue;
+
+			bool overlaps = false;
+			for (ResourceId other : block.resources) {
+				const Resource& o = resources[other];
+				if (resource.firstUse <= o.lastUse && o.firstUse <= resource.lastUse) {
+					overlaps = true;
+					break;
+				}
+			}
+			if (!overlaps) chosen = b;
+		}
+		if (chosen < 0) {
+			blocks.emplace_back();
+			chosen = static_cast<int>(blocks.size() - 1);
+		}
+
+		MemoryBlock& block = blocks[chosen];
+		block.resources.push_back(id);
+		block.size = std::max(block.size, requirements.size);
+		block.alignment = std::max(block.alignment, requirements.alignment);
+		block.memoryTypeBits &= requirements.memoryTypeBits;
+		resource.block = chosen;
+	}
+
+	//pack the blocks into as few allocations as their memory types allow
+	struct Allocation {
+		uint32_t memoryTypeBits = ~0u;
+		VkDeviceSize size = 0;
+	};
+	std::vector<Allocation> pending;
+	for (MemoryBlock& block : blocks) {
+		int chosen = -1;
+		for (int a = 0; a < static_cast<int>(pending.size()) && chosen < 0; a++) {
+			if (pending[a].memoryTypeBits & block.memoryTypeBits) chosen = a;
+		}
+		if (chosen < 0) {
+			pending.emplace_back();
+			chosen = static_cast<int>(pending.size() - 1);
+		}
+
+		Allocation& allocation = pending[chosen];
+		allocation.memoryTypeBits &= block.memoryTypeBits;
+		block.allocation = chosen;
+		block.offset = (allocation.size + block.alignment - 1) / block.alignment * block.alignment;
+		allocation.size = block.offset + block.size;
+	}
+
+	VkDeviceSize allocated = 0;
+	for (const Allocation& allocation : pending) {
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = allocation.size;
+		allocInfo.memoryTypeIndex = device.findMemoryType(allocation.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			LOG_CRITICAL("Failed to allocate render graph memory!");
+			throw std::runtime_error("Failed to allocate render graph memory!");
+		}
+		allocations.push_back(memory);
+		allocated += allocation.size;
+	}
+
+	for (ResourceId id : transients) {
+		Resource& resource = resources[id];
+		const MemoryBlock& block = blocks[resource.block];
+		vkBindImageMemory(device.device(), resource.image, allocations[block.allocation], block.offset);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = resource.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = resource.format;
+		viewInfo.subresourceRange.aspectMask = getFormatAspect(resource.format);
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+			LOG_CRITICAL("Failed to create render graph image view {}!", resource.name);
+			throw std::runtime_error("Failed to create render graph image view!");
+		}
+	}
+
+	LOG_DEBUG("Render graph: {} of {} passes, {} transients in {} blocks, {} KiB allocated for {} KiB requested",
+		executionOrder.size(), passes.size(), transients.size(), blocks.size(), allocated / 1024, requested / 1024);
+}
+
+void RenderGraph::createRenderPasses() {
+	for (int order = 0; order < static_cast<int>(executionOrder.size()); order++) {
+		Pass& pass = passes[executionOrder[order]];
+		pass.attachments.clear();
+		pass.clearValues.clear();
+
+		//colors first and depth last, matching the layout the pipelines are created against
+		for (size_t u = 0; u < pass.uses.size(); u++) {
+			if (pass.uses[u].layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) pass.attachments.push_back(u);
+		}
+		int depthUse = -1;
+		for (size_t u = 0; u < pass.uses.size(); u++) {
+			if (pass.uses[u].layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+				assert(depthUse < 0 && "A pass can only have one depth attachment");
+				depthUse = static_cast<int>(u);
+				pass.attachments.push_back(u);
+			}
+		}
+		if (pass.attachments.empty()) continue;
+
+		std::vector<VkAttachmentDescription> descriptions;
+		std::vector<VkAttachmentReference> colorRefs;
+		VkAttachmentReference depthRef{};
+		for (size_t a = 0; a < pass.attachments.size(); a++) {
+			const Use& use = pass.uses[pass.attachments[a]];
+			const Resource& resource = resources[use.resource];
+
+			//barriers move the image into the attachment layout before the pass begins,
+			//so the render pass itself never transitions anything
+			VkAttachmentDescription description{};
+			description.format = resource.format;
+			description.samples = VK_SAMPLE_COUNT_1_BIT;
+			if (use.clear) {
+				description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			} else if (resource.firstUse == order) {
+				description.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			} else {
+				description.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			}
+			bool readLater = resource.imported || resource.lastUse > order;
+			description.storeOp = readLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = use.layout;
+			description.finalLayout = use.layout;
+			descriptions.push_back(description);
+
+			VkAttachmentReference ref{};
+			ref.attachment = static_cast<uint32_t>(a);
+			ref.layout = use.layout;
+			if (use.layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
+				colorRefs.push_back(ref);
+			} else {
+				depthRef = ref;
+			}
+
+			pass.clearValues.push_back(use.clearValue);
+			if (a == 0) pass.extent = resource.extent;
+		}
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+		subpass.pColorAttachments = colorRefs.data();
+		subpass.pDepthStencilAttachment = depthUse >= 0 ? &depthRef : nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS) {
+			LOG_CRITICAL("Failed to create render pass for {}!", pass.name);
+			throw std::runtime_error("Failed to create render graph render pass!");
+		}
+	}
+}
+
+VkFramebuffer RenderGraph::getFramebuffer(Pass& pass) {
+	std::vector<VkImageView> views;
+	for (size_t use : pass.attachments) {
+		views.push_back(resources[pass.uses[use].resource].view);
+	}
+
+	auto it = pass.framebuffers.find(views);
+	if (it != pass.framebuffers.end()) return it->second;
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = pass.renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = pass.extent.width;
+	framebufferInfo.height = pass.extent.height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create framebuffer for {}!", pass.name);
+		throw std::runtime_error("Failed to create render graph framebuffer!");
+	}
+	pass.framebuffers[views] = framebuffer;
+	return framebuffer;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer, FrameArena& arena) {
+	assert(compiled && "Render graph must be compiled before it is executed");
+
+	//nothing is kept between frames, but the last frame's accesses still have to finish
+	for (Resource& resource : resources) {
+		resource.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (resource.imported) {
+			assert((resource.firstUse < 0 || resource.image != VK_NULL_HANDLE) && "Imported image was never set");
+			//chains with the swapchain acquire semaphore, which is waited on at this stage
+			resource.sync.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			resource.sync.access = 0;
+		}
+	}
+
+	//a pass never needs more barriers than there are resources
+	ArenaVector<VkImageMemoryBarrier> barriers{ arena };
+	barriers.reserve(resources.size());
+	for (PassId p : executionOrder) {
+		Pass& pass = passes[p];
+
+		barriers.clear();
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		for (const Use& use : pass.uses) {
+			Resource& resource = resources[use.resource];
+			SyncState& sync = syncState(resource);
+			LayoutAccess dst = layoutAccess(use.layout);
+
+			//read after read in the same layout is the only case that needs no barrier
+			bool layoutChange = resource.layout != use.layout;
+			bool hazard = use.write || (sync.access & WRITE_ACCESS) != 0;
+			if (!layoutChange && !hazard) {
+				sync.stages |= dst.stages;
+				sync.access |= dst.access;
+				continue;
+			}
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			//cleared attachments don't care about what was there before
+			barrier.oldLayout = use.clear ? VK_IMAGE_LAYOUT_UNDEFINED : resource.layout;
+			barrier.newLayout = use.layout;
+			barrier.srcAccessMask = sync.access & WRITE_ACCESS;
+			barrier.dstAccessMask = dst.access;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = resource.image;
+			barrier.subresourceRange.aspectMask = getFormatAspect(resource.format);
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			barriers.push_back(barrier);
+
+			srcStages |= sync.stages;
+			dstStages |= dst.stages;
+			resource.layout = use.layout;
+			sync.stages = dst.stages;
+			sync.access = dst.access;
+		}
+
+		if (!barriers.empty()) {
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				srcStages, dstStages,
+				0,
+				0, nullptr,
+				0, nullptr,
+				static_cast<uint32_t>(barriers.size()), barriers.data()
+			);
+		}
+
+		if (pass.renderPass == VK_NULL_HANDLE) {
+			pass.record(commandBuffer);
+			continue;
+		}
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = pass.renderPass;
+		renderPassInfo.framebuffer = getFramebuffer(pass);
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = pass.extent;
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+		renderPassInfo.pClearValues = pass.clearValues.data();
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(pass.extent.width);
+		viewport.height = static_cast<float>(pass.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ { 0, 0 }, pass.extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		pass.record(commandBuffer);
+
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	//hand imported images back in the layout their owner expects, all in one barrier
+	barriers.clear();
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	for (Resource& resource : resources) {
+		if (!resource.imported || resource.firstUse < 0 || resource.layout == resource.finalLayout) continue;
+
+		LayoutAccess dst = layoutAccess(resource.finalLayout);
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = resource.layout;
+		barrier.newLayout = resource.finalLayout;
+		barrier.srcAccessMask = resource.sync.access & WRITE_ACCESS;
+		barrier.dstAccessMask = dst.access;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resource.image;
+		barrier.subresourceRange.aspectMask = getFormatAspect(resource.format);
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barriers.push_back(barrier);
+
+		srcStages |= resource.sync.stages;
+		dstStages |= dst.stages;
+		resource.layout = resource.finalLayout;
+	}
+	if (!barriers.empty()) {
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			srcStages, dstStages,
+			0,
+			0, nullptr,
+			0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data()
+		);
+	}
+}
+
+void RenderGraph::releaseResources() {
+	std::vector<VkFramebuffer> framebuffers;
+	std::vector<VkRenderPass> renderPasses;
+	std::vector<VkImageView> views;
+	std::vector<VkImage> images;
+
+	for (Pass& pass : passes) {
+		for (auto& entry : pass.framebuffers) {
+			framebuffers.push_back(entry.second);
+		}
+		pass.framebuffers.clear();
+		if (pass.renderPass != VK_NULL_HANDLE) {
+			renderPasses.push_back(pass.renderPass);
+			pass.renderPass = VK_NULL_HANDLE;
+		}
+	}
+
+	for (Resource& resource : resources) {
+		if (resource.imported) continue;
+		if (resource.view != VK_NULL_HANDLE) {
+			views.push_back(resource.view);
+			resource.view = VK_NULL_HANDLE;
+		}
+		if (resource.image != VK_NULL_HANDLE) {
+			images.push_back(resource.image);
+			resource.image = VK_NULL_HANDLE;
+		}
+	}
+
+	std::vector<VkDeviceMemory> memory = std::move(allocations);
+	allocations.clear();
+	blocks.clear();
+	compiled = false;
+
+	if (framebuffers.empty() && renderPasses.empty() && images.empty() && memory.empty()) return;
+
+	//frames still in flight may be using these
+	VkDevice vkDevice = device.device();
+	deletionQueue.push([=]() {
+		for (VkFramebuffer framebuffer : framebuffers) vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+		for (VkRenderPass renderPass : renderPasses) vkDestroyRenderPass(vkDevice, renderPass, nullptr);
+		for (VkImageView view : views) vkDestroyImageView(vkDevice, view, nullptr);
+		for (VkImage image : images) vkDestroyImage(vkDevice, image, nullptr);
+		for (VkDeviceMemory allocation : memory) vkFreeMemory(vkDevice, allocation, nullptr);
+	});
+}
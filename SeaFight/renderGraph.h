@@ -0,0 +1,169 @@
+#pragma once
+
+#include "deletionQueue.h"
+#include "device.h"
+#include "frameArena.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// declarative description of the passes that make up a frame
+// passes declare the images they read and write and the graph works out the rest:
+//  - passes whose output nothing consumes are culled
+//  - layout transitions and hazards are resolved with one batched barrier per pass
+//  - transient images with non overlapping lifetimes are aliased into the same memory
+// passes with attachments get a render pass and framebuffer built for them, their record
+// callback runs inside that render pass with the viewport and scissor already set
+class RenderGraph {
+public:
+	using ResourceId = uint32_t;
+	using PassId = uint32_t;
+	using RecordFn = std::function<void(VkCommandBuffer commandBuffer)>;
+
+	// an image created and owned by the graph, its contents only live between the passes using it
+	struct TransientDesc {
+		VkFormat format;
+		// size relative to the extent the graph is compiled with
+		float scale = 1.0f;
+		// usage on top of what the declaring passes imply
+		VkImageUsageFlags usage = 0;
+	};
+
+	// chained declaration of how one pass uses resources
+	class PassBuilder {
+	public:
+		PassBuilder(RenderGraph& graph, PassId pass) : graph{ graph }, pass{ pass } {}
+
+		// color and depth attachments keep their previous contents unless a clear value is given
+		PassBuilder& writeColor(ResourceId resource);
+		PassBuilder& writeColor(ResourceId resource, VkClearColorValue clear);
+		PassBuilder& writeDepth(ResourceId resource);
+		PassBuilder& writeDepth(ResourceId resource, VkClearDepthStencilValue clear);
+		// sampled from fragment shaders
+		PassBuilder& readTexture(ResourceId resource);
+		PassBuilder& readTransfer(ResourceId resource);
+		PassBuilder& writeTransfer(ResourceId resource);
+
+		PassId id() const { return pass; }
+
+	private:
+		RenderGraph& graph;
+		PassId pass;
+	};
+
+	// replaced vulkan objects are retired through deletionQueue
+	RenderGraph(Device& device, DeletionQueue& deletionQueue);
+	~RenderGraph();
+
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// an image owned outside the graph, eg the swapchain image. it is handed over in finalLayout
+	// at the end of every frame and its contents are not kept between frames
+	ResourceId importImage(const std::string& name, VkFormat format, VkImageLayout finalLayout);
+	ResourceId createTransient(const std::string& name, const TransientDesc& desc);
+	PassBuilder addPass(const std::string& name, RecordFn record);
+
+	// culls passes and (re)creates transient images, render passes and framebuffers
+	// the previous ones are retired, so this is safe with frames still in flight
+	void compile(VkExtent2D extent);
+	bool isCompiled() const { return compiled; }
+
+	// imported images can change every frame, eg with the acquired swapchain image
+	void setImportedImage(ResourceId resource, VkImage image, VkImageView view);
+
+	// records every pass that survived culling, barriers are gathered in the frame arena
+	void execute(VkCommandBuffer commandBuffer, FrameArena& arena);
+
+	VkImage getImage(ResourceId resource) const { return resources[resource].image; }
+	VkImageView getImageView(ResourceId resource) const { return resources[resource].view; }
+	VkExtent2D getExtent(ResourceId resource) const { return resources[resource].extent; }
+	VkRenderPass getRenderPass(PassId pass) const { return passes[pass].renderPass; }
+
+private:
+	struct SyncState {
+		VkPipelineStageFlags stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags access = 0;
+	};
+
+	struct Use {
+		ResourceId resource;
+		VkImageLayout layout;
+		bool write;
+		bool clear;
+		VkClearValue clearValue;
+	};
+
+	struct Pass {
+		std::string name;
+		RecordFn record;
+		std::vector<Use> uses;
+		bool culled = false;
+
+		// passes with attachments only
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+		std::vector<size_t> attachments;		// indices into uses, in attachment order
+		std::vector<VkClearValue> clearValues;
+		std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+	};
+
+	struct Resource {
+		std::string name;
+		bool imported;
+		VkFormat format;
+		VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		TransientDesc desc{};
+
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+		VkImageUsageFlags usage = 0;
+		VkMemoryRequirements memoryRequirements{};
+
+		// range of surviving passes using the resource, in execution order
+		int firstUse = -1;
+		int lastUse = -1;
+		// aliasing block, transients only
+		int block = -1;
+
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		SyncState sync{};
+	};
+
+	// memory shared by transients whose lifetimes never overlap
+	struct MemoryBlock {
+		std::vector<ResourceId> resources;
+		VkDeviceSize size = 0;
+		VkDeviceSize alignment = 1;
+		uint32_t memoryTypeBits = ~0u;
+		int allocation = -1;
+		VkDeviceSize offset = 0;
+		// accesses by any aliased image have to finish before the next one takes over
+		SyncState sync{};
+	};
+
+	Device& device;
+	DeletionQueue& deletionQueue;
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<PassId> executionOrder;
+	std::vector<MemoryBlock> blocks;
+	std::vector<VkDeviceMemory> allocations;
+	bool compiled = false;
+
+	void addUse(PassId pass, ResourceId resource, VkImageLayout layout, bool write, bool clear, VkClearValue clearValue);
+
+	void cullPasses();
+	void computeLifetimes();
+	void createTransients(VkExtent2D extent);
+	void aliasTransients();
+	void createRenderPasses();
+	VkFramebuffer getFramebuffer(Pass& pass);
+	void releaseResources();
+
+	SyncState& syncState(Resource& resource);
+};
@@ -1,11 +1,15 @@
 #include "renderManager.h"
 
+#include "log.h"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
@@ -18,9 +22,10 @@ struct PushConstantData {
 RenderManager::RenderManager(Device& device, 
 	VkRenderPass renderPass,
 	std::vector<VkDescriptorSetLayout> setLayouts)
-	: device{ device } {
+	: device{ device }, spriteBatch{ device } {
 	createPipelineLayout(setLayouts);
 	createPipeline(renderPass);
+	Sprite::logFormatSizes();
 }
 
 RenderManager::~RenderManager() {
@@ -44,7 +49,7 @@ void RenderManager::createPipelineLayout(std::vector<VkDescriptorSetLayout> setL
 	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
 		VK_SUCCESS) {
-		spdlog::critical("Failed to create pipeline layout!");
+		LOG_CRITICAL("Failed to create pipeline layout!");
 		throw std::runtime_error("Failed to create pipeline layout!");
 	}
 }
@@ -52,23 +57,54 @@ void RenderManager::createPipelineLayout(std::vector<VkDescriptorSetLayout> setL
 void RenderManager::createPipeline(VkRenderPass renderPass) {
 	assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
+	//sprites build their quad in the vertex shader and only stream instance data.
+	//opaque sprites write depth so anything drawn behind them later is rejected
 	PipelineConfigInfo pipelineConfig{};
 	Pipeline::defaultPipelineConfigInfo(pipelineConfig);
 	pipelineConfig.renderPass = renderPass;
 	pipelineConfig.pipelineLayout = pipelineLayout;
+	pipelineConfig.bindingDescriptions = Sprite::Instance::getBindingDescriptions();
+	pipelineConfig.attributeDescriptions = Sprite::Instance::getAttributeDescriptions();
 	pipeline = std::make_unique<Pipeline>(
 		device,
 		"res/shaders/sprite.vert.spv",
 		"res/shaders/sprite.frag.spv",
 		pipelineConfig);
-}
 
-void RenderManager::renderGameObjects(
-	VkCommandBuffer commandBuffer, 
-	VkDescriptorSet descriptorSet,
-	std::vector<GameObject>& gameObjects) {
-	pipeline->bind(commandBuffer);
+	//transparent sprites are tested against the opaque depth but never write it
+	PipelineConfigInfo transparentConfig{};
+	Pipeline::defaultPipelineConfigInfo(transparentConfig);
+	transparentConfig.renderPass = renderPass;
+	transparentConfig.pipelineLayout = pipelineLayout;
+	transparentConfig.bindingDescriptions = Sprite::Instance::getBindingDescriptions();
+	transparentConfig.attributeDescriptions = Sprite::Instance::getAttributeDescriptions();
+	transparentConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	transparentConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+	transparentConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	transparentConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	transparentConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	transparentConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	transparentPipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/sprite.vert.spv",
+		"res/shaders/sprite.frag.spv",
+		transparentConfig);
+
+	//background layers sit behind everything and never occlude, so they skip depth writes.
+	//they are drawn after the opaque sprites so covered tiles fail the depth test early
+	PipelineConfigInfo backgroundConfig{};
+	Pipeline::defaultPipelineConfigInfo(backgroundConfig);
+	backgroundConfig.renderPass = renderPass;
+	backgroundConfig.pipelineLayout = pipelineLayout;
+	backgroundConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	backgroundPipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/tile.vert.spv",
+		"res/shaders/sprite.frag.spv",
+		backgroundConfig);
+}
 
+void RenderManager::bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) {
 	vkCmdBindDescriptorSets(
 		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -79,12 +115,22 @@ void RenderManager::renderGameObjects(
 		0,
 		nullptr
 	);
+}
 
-	for (auto& obj : gameObjects) {
+void RenderManager::renderTilemap(
+	VkCommandBuffer commandBuffer,
+	VkDescriptorSet descriptorSet,
+	Tilemap& tilemap,
+	glm::vec2 viewMin,
+	glm::vec2 viewMax) {
+	backgroundPipeline->bind(commandBuffer);
+	bindDescriptorSet(commandBuffer, descriptorSet);
+
+	//chunks are baked relative to their own origin to keep the half float positions precise
+	tilemap.draw(commandBuffer, viewMin, viewMax, [&](glm::vec2 chunkOrigin) {
 		PushConstantData push{};
-		push.color = obj.color;
-		push.transform = obj.transform2d.mat4();
-
+		push.transform = glm::translate(glm::mat4(1.0f), glm::vec3(chunkOrigin, BACKGROUND_DEPTH));
+		push.color = { 1.0f, 1.0f, 1.0f };
 		vkCmdPushConstants(
 			commandBuffer,
 			pipelineLayout,
@@ -92,8 +138,70 @@ void RenderManager::renderGameObjects(
 			0,
 			sizeof(PushConstantData),
 			&push);
-		obj.sprite->bind(commandBuffer);
-		obj.sprite->draw(commandBuffer);
+	});
+}
+
+void RenderManager::prepareGameObjects(int frameIndex, EntityRegistry<GameObject>& gameObjects, const AssetRegistry& assets) {
+	opaqueKeys.clear();
+	transparentKeys.clear();
+	for (uint32_t i = 0; i < gameObjects.size(); i++) {
+		GameObject& obj = gameObjects.getDense(i);
+		//unloaded sprites resolve to nothing and aren't drawn either
+		if (assets.get(obj.sprite) == nullptr) continue;
+
+		//anything at or behind the background would be hidden by it
+		float depth = glm::clamp(obj.depth, 0.0f, BACKGROUND_DEPTH - 0.001f);
+		if (obj.transparent) {
+			transparentKeys.push_back({ depth, i });
+		} else {
+			opaqueKeys.push_back({ depth, i });
+		}
+	}
+
+	if (sortSprites) {
+		//opaque front to back so the depth test rejects hidden fragments before shading,
+		//transparent back to front so blending composes in the right order
+		std::stable_sort(opaqueKeys.begin(), opaqueKeys.end(),
+			[](const DrawKey& a, const DrawKey& b) { return a.depth < b.depth; });
+		std::stable_sort(transparentKeys.begin(), transparentKeys.end(),
+			[](const DrawKey& a, const DrawKey& b) { return a.depth > b.depth; });
 	}
+
+	spriteBatch.begin(frameIndex);
+	auto addSprites = [&](const std::vector<DrawKey>& keys) {
+		for (const DrawKey& key : keys) {
+			GameObject& obj = gameObjects.getDense(key.index);
+			spriteBatch.add(Sprite::Instance::pack(
+				glm::vec3(obj.transform2d.translation, key.depth),
+				obj.transform2d.scale,
+				glm::radians(obj.transform2d.rotation),
+				assets.get(obj.sprite)->getUVRect(),
+				glm::vec4(obj.color, 1.0f),
+				obj.animation.clip,
+				obj.animation.startTime,
+				obj.animation.speed));
+		}
+	};
+	addSprites(opaqueKeys);
+	addSprites(transparentKeys);
+	spriteBatch.upload();
+}
+
+void RenderManager::renderOpaque(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) {
+	if (opaqueKeys.empty()) return;
+
+	pipeline->bind(commandBuffer);
+	bindDescriptorSet(commandBuffer, descriptorSet);
+	spriteBatch.draw(commandBuffer, 0, static_cast<uint32_t>(opaqueKeys.size()));
 }
 
+void RenderManager::renderTransparent(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) {
+	if (transparentKeys.empty()) return;
+
+	transparentPipeline->bind(commandBuffer);
+	bindDescriptorSet(commandBuffer, descriptorSet);
+	spriteBatch.draw(
+		commandBuffer,
+		static_cast<uint32_t>(opaqueKeys.size()),
+		static_cast<uint32_t>(transparentKeys.size()));
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "assetRegistry.h"
 #include "device.h"
+#include "entityRegistry.h"
 #include "gameobject.h"
 #include "pipeline.h"
+#include "spriteBatch.h"
+#include "tilemap.h"
 #include "utils.h"
 
 #include <memory>
@@ -16,14 +20,40 @@ public:
 	RenderManager(const RenderManager&) = delete;
 	RenderManager& operator=(const RenderManager&) = delete;
 
-	void renderGameObjects(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, std::vector<GameObject>& gameObjects);
+	// depth the background layer is drawn at, sprite depths are kept in front of it
+	static constexpr float BACKGROUND_DEPTH = 0.999f;
+
+	// sorts and uploads the frame's sprites, call before the render pass begins
+	void prepareGameObjects(int frameIndex, EntityRegistry<GameObject>& gameObjects, const AssetRegistry& assets);
+
+	// draw order within the pass is opaque, background, transparent
+	void renderOpaque(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet);
+	void renderTilemap(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, Tilemap& tilemap, glm::vec2 viewMin, glm::vec2 viewMax);
+	void renderTransparent(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet);
+
+	// logs the sprite upload measurement, see SpriteBatch::report
+	void report(double now) { spriteBatch.report(now); }
 
 private:
+	struct DrawKey {
+		float depth;
+		uint32_t index;
+	};
+
 	Device& device;
 
 	std::unique_ptr<Pipeline> pipeline;
+	std::unique_ptr<Pipeline> transparentPipeline;
+	std::unique_ptr<Pipeline> backgroundPipeline;
 	VkPipelineLayout pipelineLayout;
+	SpriteBatch spriteBatch;
+
+	// turning this off keeps submission order, for comparing overdraw
+	const bool sortSprites = Settings::settings.value("sort_sprites", true);
+	std::vector<DrawKey> opaqueKeys;
+	std::vector<DrawKey> transparentKeys;
 
+	void bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet);
 	void createPipelineLayout(std::vector<VkDescriptorSetLayout> setLayouts);
 	void createPipeline(VkRenderPass renderPass);
 };
\ No newline at end of file
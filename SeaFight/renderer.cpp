@@ -1,5 +1,8 @@
 #include "renderer.h"
 
+#include "log.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
@@ -7,19 +10,31 @@
 
 Renderer::Renderer(Window& window, Device& device)
     : window{window}, device{device} {
+  //the first swapchain has nothing to fall back on, so wait until the window has an area
+  auto extent = window.getExtent();
+  while (extent.width == 0 || extent.height == 0) {
+    extent = window.getExtent();
+    glfwWaitEvents();
+  }
   recreateSwapchain();
   createCommandBuffers();
+
+  size_t arenaBytes = Settings::settings.value("frame_arena_kb", 256u) * size_t(1024);
+  for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+    frameArenas.push_back(std::make_unique<FrameArena>(arenaBytes));
+  }
 }
 
 Renderer::~Renderer() { freeCommandBuffers(); }
 
 void Renderer::recreateSwapchain() {
   auto extent = window.getExtent();
-  while (extent.width == 0 || extent.height == 0) {
-    extent = window.getExtent();
-    glfwWaitEvents();
+  if (extent.width == 0 || extent.height == 0) {
+    //minimized, beginFrame retries once the window has an area again
+    swapchainDirty = true;
+    return;
   }
-  vkDeviceWaitIdle(device.device());
+  swapchainDirty = false;
 
   if (swapchain == nullptr) {
     swapchain = std::make_unique<Swapchain>(device, extent);
@@ -28,10 +43,15 @@ void Renderer::recreateSwapchain() {
     swapchain = std::make_unique<Swapchain>(device, extent, oldSwapchain);
 
     if (!oldSwapchain->compareSwapFormats(*swapchain.get())) {
-      spdlog::critical("Swap chain image(or depth) format has changed!");
+      LOG_CRITICAL("Swap chain image(or depth) format has changed!");
       throw std::runtime_error("Swap chain image(or depth) format has changed!");
     }
+
+    //frames in flight may still render to or present from the old swapchain, so it is
+    //retired instead of waiting for the device to idle
+    deletionQueue.push([oldSwapchain]() mutable { oldSwapchain.reset(); });
   }
+  swapchainVersion++;
 }
 
 void Renderer::createCommandBuffers() {
@@ -45,7 +65,7 @@ void Renderer::createCommandBuffers() {
 
   if (vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data()) !=
       VK_SUCCESS) {
-    spdlog::critical("Failed to allocate command buffers!");
+    LOG_CRITICAL("Failed to allocate command buffers!");
     throw std::runtime_error("Failed to allocate command buffers!");
   }
 }
@@ -62,14 +82,43 @@ void Renderer::freeCommandBuffers() {
 VkCommandBuffer Renderer::beginFrame() {
   assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
+  if (swapchainDirty) {
+    recreateSwapchain();
+    if (swapchainDirty) {
+      //nothing to draw to while minimized, block briefly so the loop doesn't spin
+      glfwWaitEventsTimeout(0.01);
+      return nullptr;
+    }
+  }
+
   auto result = swapchain->acquireNextImage(&currentImageIndex);
+
+  //acquire waited on this slot's fence, so every frame submitted MAX_FRAMES_IN_FLIGHT
+  //or more frames ago has finished and anything they retired can go
+  uint64_t submitted = deletionQueue.getSubmittedFrames();
+  if (submitted >= Swapchain::MAX_FRAMES_IN_FLIGHT - 1) {
+    deletionQueue.collect(submitted - (Swapchain::MAX_FRAMES_IN_FLIGHT - 1));
+  }
+  //and so is everything that frame recorded out of this slot's arena
+  frameArenas[currentFrameIndex]->reset();
+
+  //a whole loop, update ticks included, lies between two frame starts
+  uint64_t allocations = FrameArena::threadHeapAllocations();
+  if (measure && allocationsAtFrameStart != 0) {
+    uint64_t frameAllocations = allocations - allocationsAtFrameStart;
+    samples++;
+    sumAllocations += frameAllocations;
+    maxAllocations = std::max(maxAllocations, frameAllocations);
+  }
+  allocationsAtFrameStart = allocations;
+
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     recreateSwapchain();
     return nullptr;
   }
 
   if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-    spdlog::critical("Failed to acquire swap chain image!");
+    LOG_CRITICAL("Failed to acquire swap chain image!");
     throw std::runtime_error("Failed to acquire swap chain image!");
   }
 
@@ -80,27 +129,28 @@ VkCommandBuffer Renderer::beginFrame() {
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
   if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-    spdlog::critical("Failed to begin recording command buffer!");
+    LOG_CRITICAL("Failed to begin recording command buffer!");
     throw std::runtime_error("Failed to begin recording command buffer!");
   }
   return commandBuffer;
 }
 
-void Renderer::endFrame() {
+void Renderer::endFrame(const VkPresentTimeGOOGLE* presentTime) {
   assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
   auto commandBuffer = getCurrentCommandBuffer();
   if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-    spdlog::critical("Failed to record command buffer!");
+    LOG_CRITICAL("Failed to record command buffer!");
     throw std::runtime_error("Failed to record command buffer!");
   }
 
-  auto result = swapchain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+  auto result = swapchain->submitCommandBuffers(&commandBuffer, &currentImageIndex, presentTime);
+  deletionQueue.frameSubmitted();
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
       window.windowResized()) {
     window.resetWindowResizedFlag();
     recreateSwapchain();
   } else if (result != VK_SUCCESS) {
-    spdlog::critical("Failed to present swap chain image!");
+    LOG_CRITICAL("Failed to present swap chain image!");
     throw std::runtime_error("Failed to present swap chain image!");
   }
 
@@ -108,45 +158,18 @@ void Renderer::endFrame() {
   currentFrameIndex = (currentFrameIndex + 1) % Swapchain::MAX_FRAMES_IN_FLIGHT;
 }
 
-void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer) {
-  assert(isFrameStarted && "Can't call beginSwapchainRenderPass if frame is not in progress");
-  assert(
-      commandBuffer == getCurrentCommandBuffer() &&
-      "Can't begin render pass on command buffer from a different frame");
-
-  VkRenderPassBeginInfo renderPassInfo{};
-  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassInfo.renderPass = swapchain->getRenderPass();
-  renderPassInfo.framebuffer = swapchain->getFrameBuffer(currentImageIndex);
-
-  renderPassInfo.renderArea.offset = {0, 0};
-  renderPassInfo.renderArea.extent = swapchain->getSwapChainExtent();
-
-  std::array<VkClearValue, 2> clearValues{};
-  clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
-  clearValues[1].depthStencil = {1.0f, 0};
-  renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-  renderPassInfo.pClearValues = clearValues.data();
-
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-  VkViewport viewport{};
-  viewport.x = 0.0f;
-  viewport.y = 0.0f;
-  viewport.width = static_cast<float>(swapchain->getSwapChainExtent().width);
-  viewport.height = static_cast<float>(swapchain->getSwapChainExtent().height);
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
-  VkRect2D scissor{{0, 0}, swapchain->getSwapChainExtent()};
-  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-}
+void Renderer::report(double now) {
+  if (!measure || now - lastReport < 1.0) return;
+  lastReport = now;
+  if (samples == 0) return;
 
-void Renderer::endSwapchainRenderPass(VkCommandBuffer commandBuffer) {
-  assert(isFrameStarted && "Can't call endSwapchainRenderPass if frame is not in progress");
-  assert(
-      commandBuffer == getCurrentCommandBuffer() &&
-      "Can't end render pass on command buffer from a different frame");
-  vkCmdEndRenderPass(commandBuffer);
+  size_t arenaHighWater = 0;
+  for (const auto& arena : frameArenas) {
+    arenaHighWater = std::max(arenaHighWater, arena->getHighWater());
+  }
+  LOG_INFO("Heap allocations per frame avg: {:.1f} max: {}, frame arena high water: {} KB",
+    static_cast<double>(sumAllocations) / samples, maxAllocations, arenaHighWater / 1024);
+  samples = 0;
+  sumAllocations = 0;
+  maxAllocations = 0;
 }
-
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "deletionQueue.h"
 #include "device.h"
+#include "frameArena.h"
 #include "swapchain.h"
+#include "utils.h"
 #include "window.h"
 
 #include <cassert>
@@ -17,6 +20,22 @@ public:
     Renderer& operator=(const Renderer&) = delete;
 
     VkRenderPass getSwapChainRenderPass() const { return swapchain->getRenderPass(); }
+    VkExtent2D getSwapChainExtent() const { return swapchain->getSwapChainExtent(); }
+    VkFormat getSwapChainImageFormat() const { return swapchain->getSwapChainImageFormat(); }
+    VkImageUsageFlags getSwapChainUsage() const { return swapchain->getSwapChainUsage(); }
+    VkFormat getSwapChainDepthFormat() const { return swapchain->findDepthFormat(); }
+    // bumped every time the swapchain is recreated, anything holding its images must be rebuilt
+    uint32_t getSwapChainVersion() const { return swapchainVersion; }
+
+    VkImage getCurrentSwapChainImage() const {
+        assert(isFrameStarted && "Cannot get swapchain image when frame not in progress");
+        return swapchain->getImage(currentImageIndex);
+    }
+
+    VkImageView getCurrentSwapChainImageView() const {
+        assert(isFrameStarted && "Cannot get swapchain image view when frame not in progress");
+        return swapchain->getImageView(currentImageIndex);
+    }
     bool isFrameInProgress() const { return isFrameStarted; }
 
     VkCommandBuffer getCurrentCommandBuffer() const {
@@ -29,20 +48,51 @@ public:
         return currentFrameIndex;
     }
 
+    // gpu objects pushed here are destroyed once the frames that could use them have finished
+    DeletionQueue& getDeletionQueue() { return deletionQueue; }
+
+    // scratch memory for the frame being recorded, valid until this slot comes around again
+    FrameArena& getFrameArena() const {
+        assert(isFrameStarted && "Cannot get frame arena when frame not in progress");
+        return *frameArenas[currentFrameIndex];
+    }
+
+    // logs heap allocations per frame once a second when measure_allocations is set
+    void report(double now);
+
+    // present timing feedback, only available with VK_GOOGLE_display_timing
+    bool supportsDisplayTiming() const { return swapchain->supportsDisplayTiming(); }
+    bool getRefreshDuration(uint64_t& nanoseconds) { return swapchain->getRefreshDuration(nanoseconds); }
+    bool getPastPresentationTimings(std::vector<VkPastPresentationTimingGOOGLE>& timings) {
+        return swapchain->getPastPresentationTimings(timings);
+    }
+
+    // returns nullptr when no frame can be rendered, eg while minimized or after a resize
     VkCommandBuffer beginFrame();
-    void endFrame();
-    void beginSwapchainRenderPass(VkCommandBuffer commandBuffer);
-    void endSwapchainRenderPass(VkCommandBuffer commandBuffer);
+    // presentTime optionally schedules when the frame should reach the display
+    void endFrame(const VkPresentTimeGOOGLE* presentTime = nullptr);
 
 private:
     Window& window;
     Device& device;
+    DeletionQueue deletionQueue;
     std::unique_ptr<Swapchain> swapchain;
     std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<std::unique_ptr<FrameArena>> frameArenas;
+
+    uint32_t currentImageIndex = 0;
+    int currentFrameIndex = 0;
+    bool isFrameStarted = false;
+    uint32_t swapchainVersion = 0;
+    // set when the swapchain has to be recreated but the window has no area yet
+    bool swapchainDirty = false;
 
-    uint32_t currentImageIndex;
-    int currentFrameIndex;
-    bool isFrameStarted;
+    const bool measure = Settings::settings.value("measure_allocations", false);
+    uint64_t allocationsAtFrameStart = 0;
+    uint32_t samples = 0;
+    uint64_t sumAllocations = 0;
+    uint64_t maxAllocations = 0;
+    double lastReport = 0.0;
 
     void createCommandBuffers();
     void freeCommandBuffers();
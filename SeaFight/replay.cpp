@@ -0,0 +1,275 @@
+#include "replay.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+static constexpr uint32_t REPLAY_MAGIC = 0x50524653;	// "SFRP"
+//2: projectiles hit along their whole path, older replays play out differently
+static constexpr uint32_t REPLAY_VERSION = 2;
+
+//little helpers over a byte vector, the file is read whole and written whole
+static void writeU32(std::vector<uint8_t>& out, uint32_t value) {
+	for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+static void writeU64(std::vector<uint8_t>& out, uint64_t value) {
+	for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+// run lengths are mostly small, 7 bits per byte with a continuation bit
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+class ReplayReader {
+public:
+	ReplayReader(const std::vector<uint8_t>& bytes) : bytes{ bytes } {}
+
+	uint32_t u32() { return static_cast<uint32_t>(read(4)); }
+	uint64_t u64() { return read(8); }
+	uint32_t varint() {
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			uint8_t byte = static_cast<uint8_t>(read(1));
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) return value;
+		}
+		fail("Replay varint is too long");
+		return 0;
+	}
+	const uint8_t* take(size_t size) {
+		if (size > bytes.size() - position) fail("Replay ends early");
+		const uint8_t* data = bytes.data() + position;
+		position += size;
+		return data;
+	}
+
+	[[noreturn]] static void fail(const char* message) {
+		LOG_CRITICAL("{}!", message);
+		throw std::runtime_error(std::string(message) + "!");
+	}
+
+private:
+	const std::vector<uint8_t>& bytes;
+	size_t position = 0;
+
+	uint64_t read(int size) {
+		const uint8_t* data = take(size);
+		uint64_t value = 0;
+		for (int i = 0; i < size; i++) value |= static_cast<uint64_t>(data[i]) << (i * 8);
+		return value;
+	}
+};
+
+Replay::Replay(uint32_t playerCount, uint32_t seed, uint32_t keyframeInterval)
+	: playerCount{ playerCount }, seed{ seed }, keyframeInterval{ keyframeInterval } {
+	assert(playerCount > 0 && playerCount <= Simulation::MAX_PLAYERS && "Unsupported player count");
+}
+
+void Replay::record(const PlayerInput* inputs) {
+	//consecutive ticks with the same inputs extend the last run
+	if (!runs.empty() && std::equal(inputs, inputs + playerCount, runs.back().inputs.begin())) {
+		runs.back().length++;
+	}
+	else {
+		Run run{};
+		run.firstTick = tickCount;
+		run.length = 1;
+		std::copy(inputs, inputs + playerCount, run.inputs.begin());
+		runs.push_back(run);
+	}
+	tickCount++;
+}
+
+void Replay::addKeyframe(uint32_t tick, const uint8_t* snapshot, size_t size) {
+	assert((keyframes.empty() || keyframes.back().tick < tick) && "Keyframes have to be added in order");
+	Keyframe keyframe{};
+	keyframe.tick = tick;
+	keyframe.checksum = Simulation::checksum(snapshot, size);
+	keyframe.snapshot.assign(snapshot, snapshot + size);
+	keyframes.push_back(std::move(keyframe));
+}
+
+void Replay::getInputs(uint32_t tick, PlayerInput* inputs) const {
+	assert(tick < tickCount && "Tick is past the end of the replay");
+	auto it = std::upper_bound(runs.begin(), runs.end(), tick, [](uint32_t t, const Run& run) { return t < run.firstTick; });
+	std::copy(std::prev(it)->inputs.begin(), std::prev(it)->inputs.begin() + playerCount, inputs);
+}
+
+bool Replay::save(const std::string& path) const {
+	std::vector<uint8_t> bytes;
+	writeU32(bytes, REPLAY_MAGIC);
+	writeU32(bytes, REPLAY_VERSION);
+	writeU32(bytes, playerCount);
+	writeU32(bytes, seed);
+	writeU32(bytes, keyframeInterval);
+	writeU32(bytes, tickCount);
+	writeU32(bytes, static_cast<uint32_t>(runs.size()));
+	writeU32(bytes, static_cast<uint32_t>(keyframes.size()));
+	for (const Run& run : runs) {
+		writeVarint(bytes, run.length);
+		for (uint32_t player = 0; player < playerCount; player++) {
+			bytes.push_back(run.inputs[player].buttons);
+		}
+	}
+	for (const Keyframe& keyframe : keyframes) {
+		writeU32(bytes, keyframe.tick);
+		writeU64(bytes, keyframe.checksum);
+		writeU32(bytes, static_cast<uint32_t>(keyframe.snapshot.size()));
+		bytes.insert(bytes.end(), keyframe.snapshot.begin(), keyframe.snapshot.end());
+	}
+
+	std::ofstream out(path, std::ios::binary);
+	out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	if (!out) {
+		LOG_ERROR("Failed to write replay {}", path);
+		return false;
+	}
+	LOG_INFO("Saved replay {}: {} ticks in {} runs, {} keyframes, {} bytes", path, tickCount, runs.size(), keyframes.size(), bytes.size());
+	return true;
+}
+
+Replay Replay::load(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		LOG_CRITICAL("Failed to open replay {}!", path);
+		throw std::runtime_error("Failed to open replay!");
+	}
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	ReplayReader reader{ bytes };
+	if (reader.u32() != REPLAY_MAGIC) ReplayReader::fail("Not a replay file");
+	if (reader.u32() != REPLAY_VERSION) ReplayReader::fail("Unsupported replay version");
+
+	Replay replay{};
+	replay.playerCount = reader.u32();
+	replay.seed = reader.u32();
+	replay.keyframeInterval = reader.u32();
+	uint32_t tickCount = reader.u32();
+	uint32_t runCount = reader.u32();
+	uint32_t keyframeCount = reader.u32();
+	if (replay.playerCount == 0 || replay.playerCount > Simulation::MAX_PLAYERS) ReplayReader::fail("Replay has an unsupported player count");
+
+	for (uint32_t i = 0; i < runCount; i++) {
+		Run run{};
+		run.firstTick = replay.tickCount;
+		run.length = reader.varint();
+		const uint8_t* buttons = reader.take(replay.playerCount);
+		for (uint32_t player = 0; player < replay.playerCount; player++) {
+			run.inputs[player].buttons = buttons[player];
+		}
+		if (run.length == 0 || run.length > tickCount - replay.tickCount) ReplayReader::fail("Replay input runs are corrupt");
+		replay.tickCount += run.length;
+		replay.runs.push_back(run);
+	}
+	if (replay.tickCount != tickCount) ReplayReader::fail("Replay input runs are corrupt");
+
+	for (uint32_t i = 0; i < keyframeCount; i++) {
+		Keyframe keyframe{};
+		keyframe.tick = reader.u32();
+		keyframe.checksum = reader.u64();
+		uint32_t size = reader.u32();
+		const uint8_t* snapshot = reader.take(size);
+		bool ordered = replay.keyframes.empty() || replay.keyframes.back().tick < keyframe.tick;
+		if (!ordered || !Simulation::isValidSnapshot(snapshot, size)) ReplayReader::fail("Replay keyframes are corrupt");
+		keyframe.snapshot.assign(snapshot, snapshot + size);
+		replay.keyframes.push_back(std::move(keyframe));
+	}
+	return replay;
+}
+
+ReplayPlayer::ReplayPlayer(const Replay& replay) : replay{ replay } {
+	scratch.resize(Simulation::MAX_SNAPSHOT_SIZE);
+}
+
+void ReplayPlayer::seek(uint32_t tick, Simulation& simulation) {
+	tick = std::min(tick, replay.tickCount);
+
+	//latest keyframe at or before tick, or the very start
+	auto keyframe = std::upper_bound(replay.keyframes.begin(), replay.keyframes.end(), tick,
+		[](uint32_t t, const Replay::Keyframe& k) { return t < k.tick; });
+	if (keyframe != replay.keyframes.begin()) {
+		--keyframe;
+		simulation.restore(keyframe->snapshot.data());
+		nextKeyframe = static_cast<size_t>(keyframe - replay.keyframes.begin()) + 1;
+	}
+	else {
+		simulation = Simulation(replay.playerCount, replay.seed);
+		nextKeyframe = 0;
+	}
+
+	run = 0;
+	while (simulation.getTick() < tick) {
+		step(simulation);
+	}
+}
+
+void ReplayPlayer::checkKeyframe(const Simulation& simulation) {
+	uint32_t tick = simulation.getTick();
+	while (nextKeyframe < replay.keyframes.size() && replay.keyframes[nextKeyframe].tick < tick) {
+		nextKeyframe++;
+	}
+	if (nextKeyframe == replay.keyframes.size() || replay.keyframes[nextKeyframe].tick != tick) return;
+
+	const Replay::Keyframe& keyframe = replay.keyframes[nextKeyframe++];
+	size_t size = simulation.save(scratch.data());
+	if (Simulation::checksum(scratch.data(), size) != keyframe.checksum && firstDivergence == UINT32_MAX) {
+		firstDivergence = tick;
+		LOG_ERROR("Replay diverged from the recording by tick {}", tick);
+	}
+}
+
+bool ReplayPlayer::step(Simulation& simulation) {
+	uint32_t tick = simulation.getTick();
+	if (tick >= replay.tickCount) return false;
+
+	checkKeyframe(simulation);
+
+	//runs are visited in order, seeking resets to the first one
+	while (replay.runs[run].firstTick + replay.runs[run].length <= tick) {
+		run++;
+	}
+	simulation.tick(replay.runs[run].inputs.data());
+	return true;
+}
+
+bool ReplayPlayer::runHeadless(const std::string& path, uint32_t startTick, uint32_t runs) {
+	using Clock = std::chrono::high_resolution_clock;
+
+	Replay replay = Replay::load(path);
+	LOG_INFO("Replay {}: {} players, {} ticks, {} keyframes", path, replay.getPlayerCount(), replay.getTickCount(), replay.getKeyframeCount());
+
+	bool diverged = false;
+	for (uint32_t i = 0; i < std::max(runs, 1u); i++) {
+		ReplayPlayer player{ replay };
+		Simulation simulation{ replay.getPlayerCount(), replay.getSeed() };
+
+		auto start = Clock::now();
+		player.seek(startTick, simulation);
+		double seekMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		uint32_t ticks = 0;
+		while (player.step(simulation)) {
+			ticks++;
+		}
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		LOG_INFO("Run {}: seek to {} in {:.3f}ms, {} ticks in {:.3f}s ({:.0f} ticks/s, {:.0f}x real time at 120Hz), {} projectiles at the end",
+			i, startTick, seekMilliseconds, ticks, seconds, ticks / std::max(seconds, 1e-9), ticks / std::max(seconds, 1e-9) / 120.0,
+			simulation.getProjectileCount());
+		diverged |= player.getFirstDivergence() != UINT32_MAX;
+	}
+	return !diverged;
+}
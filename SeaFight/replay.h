@@ -0,0 +1,87 @@
+#pragma once
+
+#include "simulation.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// recording of a simulation as its seed and every tick's inputs
+// runs of ticks with the same inputs are stored once, and full snapshots taken every
+// keyframeInterval ticks let playback seek without simulating from the start. keyframes
+// carry their checksum, so a replay recorded on one machine shows where another diverges
+class Replay {
+public:
+	Replay() = default;
+	Replay(uint32_t playerCount, uint32_t seed, uint32_t keyframeInterval);
+
+	// throws if the file can't be read or isn't a replay
+	static Replay load(const std::string& path);
+	// returns false and logs when the file can't be written
+	bool save(const std::string& path) const;
+
+	// appends the inputs of the next tick, the first one recorded is tick 0
+	void record(const PlayerInput* inputs);
+	bool wantsKeyframe(uint32_t tick) const { return keyframeInterval > 0 && tick % keyframeInterval == 0; }
+	// snapshot of the state at the start of tick, as written by Simulation::save
+	void addKeyframe(uint32_t tick, const uint8_t* snapshot, size_t size);
+
+	uint32_t getPlayerCount() const { return playerCount; }
+	uint32_t getSeed() const { return seed; }
+	uint32_t getTickCount() const { return tickCount; }
+	size_t getKeyframeCount() const { return keyframes.size(); }
+	// the inputs of one recorded tick
+	void getInputs(uint32_t tick, PlayerInput* inputs) const;
+
+private:
+	friend class ReplayPlayer;
+
+	struct Run {
+		uint32_t firstTick;
+		uint32_t length;
+		// playerCount inputs
+		std::array<PlayerInput, Simulation::MAX_PLAYERS> inputs;
+	};
+
+	struct Keyframe {
+		uint32_t tick;
+		uint64_t checksum;
+		std::vector<uint8_t> snapshot;
+	};
+
+	uint32_t playerCount = 0;
+	uint32_t seed = 0;
+	uint32_t keyframeInterval = 0;
+	uint32_t tickCount = 0;
+	std::vector<Run> runs;
+	std::vector<Keyframe> keyframes;
+};
+
+// drives a simulation from a replay, as fast as it will go
+class ReplayPlayer {
+public:
+	ReplayPlayer(const Replay& replay);
+
+	// puts simulation at the start of tick, from the closest keyframe before it
+	void seek(uint32_t tick, Simulation& simulation);
+	// simulates one recorded tick, returns false at the end of the replay
+	// keyframes passed on the way are checked against the recorded checksums
+	bool step(Simulation& simulation);
+
+	// first tick whose state differed from the recording, or UINT32_MAX
+	uint32_t getFirstDivergence() const { return firstDivergence; }
+
+	// plays a replay file without a window or renderer, seeking to startTick and then running
+	// to the end runs times. returns false if the simulation diverged from the recording
+	static bool runHeadless(const std::string& path, uint32_t startTick, uint32_t runs);
+
+private:
+	const Replay& replay;
+	size_t run = 0;
+	size_t nextKeyframe = 0;
+	uint32_t firstDivergence = UINT32_MAX;
+	std::vector<uint8_t> scratch;
+
+	void checkKeyframe(const Simulation& simulation);
+};
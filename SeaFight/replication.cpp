@@ -0,0 +1,484 @@
+#include "replication.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+
+enum MessageType : uint32_t {
+	MESSAGE_SNAPSHOT = 1,
+	MESSAGE_ACK = 2,
+};
+
+static constexpr uint32_t MESSAGE_BITS = 2;
+static constexpr uint32_t SEQUENCE_BITS = 16;
+static constexpr uint32_t COUNT_BITS = 10;
+static constexpr uint32_t POSITION_BITS = 14;
+static constexpr uint32_t VELOCITY_BITS = 10;
+static constexpr uint32_t HEALTH_BITS = 3;
+static constexpr uint32_t SCORE_BITS = 16;
+// ids close to the previous one are sent as a short gap
+static constexpr uint32_t GAP_BITS = 4;
+// positions that moved this little since the baseline are sent as a short delta
+static constexpr uint32_t POSITION_DELTA_BITS = 6;
+
+//fixed point to quantized shifts, positions cover the arena, velocities +-2048
+static constexpr int POSITION_SHIFT = Simulation::FIXED_SHIFT + 1 - POSITION_BITS;
+static constexpr int VELOCITY_SHIFT = 2;
+
+static constexpr uint32_t SNAPSHOT_HEADER_BITS = MESSAGE_BITS + SEQUENCE_BITS + 1 + SEQUENCE_BITS + 32 + COUNT_BITS;
+// the most one entity can take, whether delta coded or new
+static constexpr uint32_t ENTITY_MAX_BITS = 1 + 16 + 1 + 1
+	+ 2 + 2 * POSITION_BITS
+	+ 1 + 2 * VELOCITY_BITS
+	+ 1 + HEALTH_BITS + SCORE_BITS;
+
+//true when a comes after b, allowing for wrap around
+static bool sequenceNewer(uint16_t a, uint16_t b) {
+	return static_cast<int16_t>(a - b) > 0;
+}
+
+static uint16_t quantize(int32_t value, int shift, uint32_t bits, int32_t offset) {
+	int32_t quantized = (value >> shift) + offset;
+	return static_cast<uint16_t>(std::clamp(quantized, 0, static_cast<int32_t>((1u << bits) - 1)));
+}
+
+bool NetEntity::operator==(const NetEntity& other) const {
+	return id == other.id && type == other.type && health == other.health && score == other.score
+		&& x == other.x && y == other.y && vx == other.vx && vy == other.vy;
+}
+
+glm::vec2 NetEntity::getPosition() const {
+	float scale = static_cast<float>(1 << POSITION_SHIFT) / Simulation::FIXED_ONE;
+	return glm::vec2(x, y) * scale - glm::vec2(1.0f);
+}
+
+void NetEntity::gather(const Simulation& simulation, std::vector<NetEntity>& out) {
+	out.clear();
+	const int32_t positionOffset = 1 << (POSITION_BITS - 1);
+	const int32_t velocityOffset = 1 << (VELOCITY_BITS - 1);
+
+	//ships take the lowest ids, so they are always first
+	for (uint32_t player = 0; player < simulation.getPlayerCount(); player++) {
+		const Simulation::Ship& ship = simulation.getShip(player);
+		NetEntity entity{};
+		entity.id = static_cast<uint16_t>(player);
+		entity.type = Type::Ship;
+		entity.health = static_cast<uint8_t>(std::min<uint32_t>(ship.health, (1u << HEALTH_BITS) - 1));
+		entity.score = static_cast<uint16_t>(std::min<uint32_t>(ship.score, 0xFFFF));
+		entity.x = quantize(ship.x, POSITION_SHIFT, POSITION_BITS, positionOffset);
+		entity.y = quantize(ship.y, POSITION_SHIFT, POSITION_BITS, positionOffset);
+		entity.vx = quantize(ship.vx, VELOCITY_SHIFT, VELOCITY_BITS, velocityOffset);
+		entity.vy = quantize(ship.vy, VELOCITY_SHIFT, VELOCITY_BITS, velocityOffset);
+		out.push_back(entity);
+	}
+
+	size_t firstProjectile = out.size();
+	for (uint32_t i = 0; i < simulation.getProjectileCount(); i++) {
+		const Simulation::Projectile& projectile = simulation.getProjectile(i);
+		NetEntity entity{};
+		entity.id = static_cast<uint16_t>(Simulation::MAX_PLAYERS + projectile.id % (0x10000 - Simulation::MAX_PLAYERS));
+		entity.type = Type::Projectile;
+		entity.x = quantize(projectile.x, POSITION_SHIFT, POSITION_BITS, positionOffset);
+		entity.y = quantize(projectile.y, POSITION_SHIFT, POSITION_BITS, positionOffset);
+		entity.vx = quantize(projectile.vx, VELOCITY_SHIFT, VELOCITY_BITS, velocityOffset);
+		entity.vy = quantize(projectile.vy, VELOCITY_SHIFT, VELOCITY_BITS, velocityOffset);
+		out.push_back(entity);
+	}
+
+	//the pool gets reordered by swap removes
+	std::sort(out.begin() + firstProjectile, out.end(), [](const NetEntity& a, const NetEntity& b) { return a.id < b.id; });
+}
+
+//baseline moved along its velocity to the snapshot's tick, projectiles fly straight so this
+//usually leaves nothing to send. integer maths so both ends round the same
+static NetEntity extrapolate(const NetEntity& baseline, uint32_t ticks) {
+	const int32_t velocityOffset = 1 << (VELOCITY_BITS - 1);
+	const int32_t maxPosition = (1 << POSITION_BITS) - 1;
+	int64_t scale = static_cast<int64_t>(ticks) << VELOCITY_SHIFT;
+	int64_t dx = ((static_cast<int32_t>(baseline.vx) - velocityOffset) * scale) >> POSITION_SHIFT;
+	int64_t dy = ((static_cast<int32_t>(baseline.vy) - velocityOffset) * scale) >> POSITION_SHIFT;
+
+	NetEntity expected = baseline;
+	expected.x = static_cast<uint16_t>(std::clamp<int64_t>(baseline.x + dx, 0, maxPosition));
+	expected.y = static_cast<uint16_t>(std::clamp<int64_t>(baseline.y + dy, 0, maxPosition));
+	return expected;
+}
+
+static void writeEntity(BitWriter& writer, const NetEntity& entity, const NetEntity* baseline, int previousId) {
+	//ids are strictly increasing, so the gap is at least one
+	int gap = entity.id - previousId;
+	if (gap >= 1 && gap <= (1 << GAP_BITS)) {
+		writer.writeBool(true);
+		writer.writeBits(gap - 1, GAP_BITS);
+	}
+	else {
+		writer.writeBool(false);
+		writer.writeBits(entity.id, 16);
+	}
+
+	if (baseline) {
+		if (*baseline == entity) {
+			writer.writeBool(false);
+			return;
+		}
+		writer.writeBool(true);
+	}
+	else {
+		writer.writeBool(entity.type == NetEntity::Type::Projectile);
+	}
+
+	bool moved = !baseline || baseline->x != entity.x || baseline->y != entity.y;
+	writer.writeBool(moved);
+	if (moved) {
+		const int limit = 1 << (POSITION_DELTA_BITS - 1);
+		int dx = baseline ? entity.x - baseline->x : limit;
+		int dy = baseline ? entity.y - baseline->y : limit;
+		bool small = dx >= -limit && dx < limit && dy >= -limit && dy < limit;
+		writer.writeBool(small);
+		if (small) {
+			writer.writeSigned(dx, POSITION_DELTA_BITS);
+			writer.writeSigned(dy, POSITION_DELTA_BITS);
+		}
+		else {
+			writer.writeBits(entity.x, POSITION_BITS);
+			writer.writeBits(entity.y, POSITION_BITS);
+		}
+	}
+
+	bool accelerated = !baseline || baseline->vx != entity.vx || baseline->vy != entity.vy;
+	writer.writeBool(accelerated);
+	if (accelerated) {
+		writer.writeBits(entity.vx, VELOCITY_BITS);
+		writer.writeBits(entity.vy, VELOCITY_BITS);
+	}
+
+	if (entity.type == NetEntity::Type::Ship) {
+		bool changed = !baseline || baseline->health != entity.health || baseline->score != entity.score;
+		writer.writeBool(changed);
+		if (changed) {
+			writer.writeBits(entity.health, HEALTH_BITS);
+			writer.writeBits(entity.score, SCORE_BITS);
+		}
+	}
+}
+
+ReplicationServer::ReplicationServer(uint32_t maxPacketBytes, float interestRadius, uint32_t maxEntities)
+	: maxPacketBytes{ maxPacketBytes },
+	interestRadius{ interestRadius },
+	writer{ maxPacketBytes } {
+	//cap the entity count so even a snapshot of nothing but new entities fits
+	uint32_t fitting = (maxPacketBytes * 8 - SNAPSHOT_HEADER_BITS) / ENTITY_MAX_BITS;
+	this->maxEntities = std::min({ maxEntities, fitting, (1u << COUNT_BITS) - 1 });
+	if (this->maxEntities < maxEntities) {
+		LOG_DEBUG("Replication limited to {} entities to fit {} byte snapshots", this->maxEntities, maxPacketBytes);
+	}
+}
+
+uint32_t ReplicationServer::addClient(Transport& transport) {
+	clients.emplace_back();
+	clients.back().transport = &transport;
+	return static_cast<uint32_t>(clients.size() - 1);
+}
+
+void ReplicationServer::receiveAcks(Client& client) {
+	while (client.transport->receive(packet)) {
+		BitReader reader{ packet.data(), packet.size() };
+		if (reader.readBits(MESSAGE_BITS) != MESSAGE_ACK) continue;
+
+		uint16_t sequence = static_cast<uint16_t>(reader.readBits(SEQUENCE_BITS));
+		uint32_t focusX = reader.readBits(POSITION_BITS);
+		uint32_t focusY = reader.readBits(POSITION_BITS);
+		if (reader.hasOverflowed()) continue;
+
+		//acks can arrive out of order, only ever move forwards
+		if (!client.hasAck || sequenceNewer(sequence, client.ackedSequence)) {
+			client.hasAck = true;
+			client.ackedSequence = sequence;
+			NetEntity focus{};
+			focus.x = static_cast<uint16_t>(focusX);
+			focus.y = static_cast<uint16_t>(focusY);
+			client.focus = focus.getPosition();
+		}
+	}
+}
+
+void ReplicationServer::selectEntities(const Client& client, const std::vector<NetEntity>& entities, std::vector<NetEntity>& out) {
+	//ships always make it in, then the closest entities inside the radius
+	candidates.clear();
+	float radiusSquared = interestRadius * interestRadius;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++) {
+		const NetEntity& entity = entities[i];
+		glm::vec2 offset = entity.getPosition() - client.focus;
+		float distanceSquared = glm::dot(offset, offset);
+		if (entity.type == NetEntity::Type::Ship) {
+			candidates.push_back({ -1.0f, i });
+		}
+		else if (distanceSquared <= radiusSquared) {
+			candidates.push_back({ distanceSquared, i });
+		}
+	}
+
+	if (candidates.size() > maxEntities) {
+		std::nth_element(candidates.begin(), candidates.begin() + maxEntities, candidates.end());
+		candidates.resize(maxEntities);
+	}
+	//back in id order for the gap coding
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+
+	out.clear();
+	for (const auto& candidate : candidates) {
+		out.push_back(entities[candidate.second]);
+	}
+}
+
+void ReplicationServer::update(uint32_t tick, const std::vector<NetEntity>& entities) {
+	for (Client& client : clients) {
+		receiveAcks(client);
+
+		uint16_t sequence = client.nextSequence++;
+		SentSnapshot& snapshot = client.sent[sequence % HISTORY];
+		selectEntities(client, entities, snapshot.entities);
+		snapshot.sequence = sequence;
+		snapshot.tick = tick;
+		snapshot.valid = true;
+
+		//the client only keeps HISTORY snapshots, older baselines are gone on its side too
+		const SentSnapshot* baseline = nullptr;
+		if (client.hasAck && static_cast<uint16_t>(sequence - client.ackedSequence) < HISTORY) {
+			const SentSnapshot& acked = client.sent[client.ackedSequence % HISTORY];
+			if (acked.valid && acked.sequence == client.ackedSequence) {
+				baseline = &acked;
+			}
+		}
+
+		writer.reset();
+		writer.writeBits(MESSAGE_SNAPSHOT, MESSAGE_BITS);
+		writer.writeBits(sequence, SEQUENCE_BITS);
+		writer.writeBool(baseline != nullptr);
+		writer.writeBits(baseline ? baseline->sequence : 0, SEQUENCE_BITS);
+		writer.writeBits(tick, 32);
+		writer.writeBits(static_cast<uint32_t>(snapshot.entities.size()), COUNT_BITS);
+
+		//both lists are sorted by id, walk them together to pair entities with their baselines
+		size_t b = 0;
+		int previousId = -1;
+		for (const NetEntity& entity : snapshot.entities) {
+			const NetEntity* base = nullptr;
+			NetEntity expected;
+			if (baseline) {
+				while (b < baseline->entities.size() && baseline->entities[b].id < entity.id) b++;
+				if (b < baseline->entities.size() && baseline->entities[b].id == entity.id) {
+					expected = extrapolate(baseline->entities[b], tick - baseline->tick);
+					base = &expected;
+				}
+			}
+			writeEntity(writer, entity, base, previousId);
+			previousId = entity.id;
+		}
+		assert(!writer.hasOverflowed() && "Snapshot entity cap doesn't fit the packet size");
+
+		client.transport->send(writer.data(), writer.getByteCount());
+		client.snapshots++;
+		client.fullSnapshots += baseline ? 0 : 1;
+		client.bytes += writer.getByteCount();
+		client.maxBytes = std::max(client.maxBytes, writer.getByteCount());
+		client.entitiesSent += snapshot.entities.size();
+	}
+}
+
+const std::vector<NetEntity>* ReplicationServer::findSent(uint32_t client, uint16_t sequence) const {
+	const SentSnapshot& snapshot = clients[client].sent[sequence % HISTORY];
+	return snapshot.valid && snapshot.sequence == sequence ? &snapshot.entities : nullptr;
+}
+
+void ReplicationServer::report(double now, bool enabled) {
+	if (!enabled || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	for (size_t i = 0; i < clients.size(); i++) {
+		Client& client = clients[i];
+		if (client.snapshots > 0) {
+			LOG_INFO("Replication client {}: {} snapshots ({} full), {} bytes/s, avg {} max {} bytes, {:.1f} entities, {:.1f} bits per entity",
+				i, client.snapshots, client.fullSnapshots, client.bytes, client.bytes / client.snapshots, client.maxBytes,
+				static_cast<double>(client.entitiesSent) / client.snapshots,
+				client.entitiesSent > 0 ? client.bytes * 8.0 / client.entitiesSent : 0.0);
+		}
+		client.snapshots = client.fullSnapshots = 0;
+		client.bytes = client.entitiesSent = 0;
+		client.maxBytes = 0;
+	}
+}
+
+void ReplicationServer::benchmark(uint32_t maxPacketBytes, float interestRadius, uint32_t maxEntities) {
+	std::unique_ptr<LoopbackTransport> serverLink, clientLink;
+	LinkConditions lossless{};
+	lossless.latency = 0.0;
+	lossless.jitter = 0.0;
+	lossless.loss = 0.0f;
+	LoopbackTransport::createPair(lossless, 3, serverLink, clientLink);
+
+	ReplicationServer server{ maxPacketBytes, interestRadius, maxEntities };
+	ReplicationClient client{ *clientLink };
+	server.addClient(*serverLink);
+
+	//two ships and a few hundred projectiles, snapshots every fourth tick
+	std::vector<NetEntity> entities;
+	uint32_t random = 12345;
+	auto next = [&]() { random ^= random << 13; random ^= random >> 17; random ^= random << 5; return random; };
+	for (uint16_t id = 0; id < 500; id++) {
+		NetEntity entity{};
+		entity.id = id;
+		entity.type = id < 2 ? NetEntity::Type::Ship : NetEntity::Type::Projectile;
+		entity.health = 5;
+		entity.x = static_cast<uint16_t>(next() % (1u << POSITION_BITS));
+		entity.y = static_cast<uint16_t>(next() % (1u << POSITION_BITS));
+		entity.vx = static_cast<uint16_t>(next() % (1u << VELOCITY_BITS));
+		entity.vy = static_cast<uint16_t>(next() % (1u << VELOCITY_BITS));
+		entities.push_back(entity);
+	}
+
+	size_t fullBytes = 0, deltaBytes = 0, maxBytes = 0;
+	uint32_t deltas = 0;
+	for (uint32_t tick = 0; tick < 240; tick++) {
+		//projectiles fly straight and bounce off the arena edge, ships wander
+		for (NetEntity& entity : entities) {
+			const uint16_t maxPosition = (1u << POSITION_BITS) - 1;
+			const uint16_t maxVelocity = (1u << VELOCITY_BITS) - 1;
+			if (entity.type == NetEntity::Type::Ship) {
+				entity.vx = static_cast<uint16_t>(std::clamp<int>(entity.vx + static_cast<int>(next() % 33) - 16, 0, maxVelocity));
+				entity.vy = static_cast<uint16_t>(std::clamp<int>(entity.vy + static_cast<int>(next() % 33) - 16, 0, maxVelocity));
+			}
+			NetEntity moved = extrapolate(entity, 1);
+			if (moved.x == 0 || moved.x == maxPosition) moved.vx = static_cast<uint16_t>(maxVelocity - moved.vx);
+			if (moved.y == 0 || moved.y == maxPosition) moved.vy = static_cast<uint16_t>(maxVelocity - moved.vy);
+			entity = moved;
+		}
+		if (tick % 4 != 0) continue;
+		server.update(tick, entities);
+		client.update({ 0.0f, 0.0f });
+
+		const Client& state = server.clients[0];
+		size_t bytes = static_cast<size_t>(state.bytes);
+		if (tick == 0) {
+			fullBytes = bytes;
+		}
+		else {
+			deltaBytes += bytes;
+			deltas++;
+		}
+		maxBytes = std::max(maxBytes, state.maxBytes);
+		server.clients[0].bytes = 0;
+	}
+
+	LOG_INFO("Replication benchmark: {} entities, {} replicated, full snapshot {} bytes, delta avg {} bytes, max {} of {} bytes",
+		entities.size(), client.getEntities().size(), fullBytes, deltas > 0 ? deltaBytes / deltas : 0, maxBytes, maxPacketBytes);
+}
+
+ReplicationClient::ReplicationClient(Transport& transport) : transport{ transport }, writer{ 16 } {}
+
+bool ReplicationClient::decode(BitReader& reader) {
+	uint16_t sequence = static_cast<uint16_t>(reader.readBits(SEQUENCE_BITS));
+	bool hasBaseline = reader.readBool();
+	uint16_t baselineSequence = static_cast<uint16_t>(reader.readBits(SEQUENCE_BITS));
+	uint32_t tick = reader.readBits(32);
+	uint32_t count = reader.readBits(COUNT_BITS);
+	if (reader.hasOverflowed()) return false;
+
+	//anything older than what we have is of no use
+	if (hasLatest && !sequenceNewer(sequence, latestSequence)) return false;
+
+	const ReceivedSnapshot* baseline = nullptr;
+	if (hasBaseline) {
+		const ReceivedSnapshot& candidate = received[baselineSequence % HISTORY];
+		if (!candidate.valid || candidate.sequence != baselineSequence) {
+			dropped++;
+			return false;
+		}
+		baseline = &candidate;
+	}
+
+	//decoded to the side so a truncated packet leaves the history alone
+	std::vector<NetEntity>& entities = decoded;
+	entities.clear();
+
+	size_t b = 0;
+	int previousId = -1;
+	for (uint32_t i = 0; i < count; i++) {
+		NetEntity entity{};
+		if (reader.readBool()) {
+			entity.id = static_cast<uint16_t>(previousId + 1 + static_cast<int>(reader.readBits(GAP_BITS)));
+		}
+		else {
+			entity.id = static_cast<uint16_t>(reader.readBits(16));
+		}
+		previousId = entity.id;
+
+		bool inBaseline = false;
+		if (baseline) {
+			while (b < baseline->entities.size() && baseline->entities[b].id < entity.id) b++;
+			inBaseline = b < baseline->entities.size() && baseline->entities[b].id == entity.id;
+		}
+
+		if (inBaseline) {
+			entity = extrapolate(baseline->entities[b], tick - baseline->tick);
+			if (!reader.readBool()) {
+				entities.push_back(entity);
+				continue;
+			}
+		}
+		else {
+			entity.type = reader.readBool() ? NetEntity::Type::Projectile : NetEntity::Type::Ship;
+		}
+
+		if (reader.readBool()) {
+			if (reader.readBool()) {
+				entity.x = static_cast<uint16_t>(entity.x + reader.readSigned(POSITION_DELTA_BITS));
+				entity.y = static_cast<uint16_t>(entity.y + reader.readSigned(POSITION_DELTA_BITS));
+			}
+			else {
+				entity.x = static_cast<uint16_t>(reader.readBits(POSITION_BITS));
+				entity.y = static_cast<uint16_t>(reader.readBits(POSITION_BITS));
+			}
+		}
+		if (reader.readBool()) {
+			entity.vx = static_cast<uint16_t>(reader.readBits(VELOCITY_BITS));
+			entity.vy = static_cast<uint16_t>(reader.readBits(VELOCITY_BITS));
+		}
+		if (entity.type == NetEntity::Type::Ship && reader.readBool()) {
+			entity.health = static_cast<uint8_t>(reader.readBits(HEALTH_BITS));
+			entity.score = static_cast<uint16_t>(reader.readBits(SCORE_BITS));
+		}
+		entities.push_back(entity);
+	}
+	if (reader.hasOverflowed()) return false;
+
+	ReceivedSnapshot& snapshot = received[sequence % HISTORY];
+	snapshot.sequence = sequence;
+	snapshot.tick = tick;
+	snapshot.valid = true;
+	std::swap(snapshot.entities, entities);
+	hasLatest = true;
+	latestSequence = sequence;
+	serverTick = tick;
+	return true;
+}
+
+void ReplicationClient::update(glm::vec2 focus) {
+	bool decoded = false;
+	while (transport.receive(packet)) {
+		BitReader reader{ packet.data(), packet.size() };
+		if (reader.readBits(MESSAGE_BITS) != MESSAGE_SNAPSHOT) continue;
+		decoded |= decode(reader);
+	}
+	if (!decoded) return;
+
+	//one ack per update is enough, the newest one covers everything before it
+	const int32_t offset = 1 << (POSITION_BITS - 1);
+	writer.reset();
+	writer.writeBits(MESSAGE_ACK, MESSAGE_BITS);
+	writer.writeBits(latestSequence, SEQUENCE_BITS);
+	writer.writeBits(quantize(static_cast<int32_t>(focus.x * Simulation::FIXED_ONE), POSITION_SHIFT, POSITION_BITS, offset), POSITION_BITS);
+	writer.writeBits(quantize(static_cast<int32_t>(focus.y * Simulation::FIXED_ONE), POSITION_SHIFT, POSITION_BITS, offset), POSITION_BITS);
+	transport.send(writer.data(), writer.getByteCount());
+}
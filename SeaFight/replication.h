@@ -0,0 +1,142 @@
+#pragma once
+
+#include "bitStream.h"
+#include "simulation.h"
+#include "transport.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// replicated state of one entity, quantized to exactly what goes over the wire
+struct NetEntity {
+	enum class Type : uint8_t { Ship, Projectile };
+
+	uint16_t id;
+	Type type;
+	// ships only
+	uint8_t health;
+	uint16_t score;
+	// POSITION_BITS over the arena
+	uint16_t x, y;
+	// VELOCITY_BITS
+	uint16_t vx, vy;
+
+	bool operator==(const NetEntity& other) const;
+	bool operator!=(const NetEntity& other) const { return !(*this == other); }
+
+	glm::vec2 getPosition() const;
+
+	// quantizes the simulation's ships and projectiles, sorted by id
+	static void gather(const Simulation& simulation, std::vector<NetEntity>& out);
+};
+
+// sends each client bit packed snapshots of the entities near it
+// snapshots are delta compressed against the last one the client acknowledged, extrapolated
+// along each entity's velocity, or sent whole when there is none. every snapshot lists the entities the client should have, ones
+// missing have left its area of interest. the area is capped by both radius and count so
+// a snapshot always fits maxPacketBytes, however many projectiles are flying
+class ReplicationServer {
+public:
+	static constexpr uint32_t HISTORY = 32;
+
+	ReplicationServer(uint32_t maxPacketBytes, float interestRadius, uint32_t maxEntities);
+
+	ReplicationServer(const ReplicationServer&) = delete;
+	ReplicationServer& operator=(const ReplicationServer&) = delete;
+
+	// returns the client's index
+	uint32_t addClient(Transport& transport);
+	// reads acknowledgements, then sends every client a snapshot of entities sorted by id
+	void update(uint32_t tick, const std::vector<NetEntity>& entities);
+
+	// what was sent to a client under sequence, if it is still in the history
+	const std::vector<NetEntity>* findSent(uint32_t client, uint16_t sequence) const;
+
+	// logs per client bandwidth about once per second
+	void report(double now, bool enabled);
+	// snapshot sizes for hundreds of live projectiles over a lossless link
+	static void benchmark(uint32_t maxPacketBytes, float interestRadius, uint32_t maxEntities);
+
+private:
+	struct SentSnapshot {
+		uint16_t sequence = 0;
+		uint32_t tick = 0;
+		bool valid = false;
+		std::vector<NetEntity> entities;
+	};
+
+	struct Client {
+		Transport* transport;
+		std::array<SentSnapshot, HISTORY> sent;
+		uint16_t nextSequence = 0;
+		bool hasAck = false;
+		uint16_t ackedSequence = 0;
+		// where the client wants detail, reported with its acks
+		glm::vec2 focus{ 0.0f };
+
+		uint32_t snapshots = 0;
+		uint32_t fullSnapshots = 0;
+		uint64_t bytes = 0;
+		size_t maxBytes = 0;
+		uint64_t entitiesSent = 0;
+	};
+
+	uint32_t maxPacketBytes;
+	float interestRadius;
+	uint32_t maxEntities;
+	std::vector<Client> clients;
+
+	BitWriter writer;
+	std::vector<uint8_t> packet;
+	std::vector<std::pair<float, uint32_t>> candidates;
+	double lastReport = 0.0;
+
+	void receiveAcks(Client& client);
+	void selectEntities(const Client& client, const std::vector<NetEntity>& entities, std::vector<NetEntity>& out);
+};
+
+// rebuilds the server's view of the world from its snapshots
+class ReplicationClient {
+public:
+	ReplicationClient(Transport& transport);
+
+	ReplicationClient(const ReplicationClient&) = delete;
+	ReplicationClient& operator=(const ReplicationClient&) = delete;
+
+	// decodes arrived snapshots and acknowledges the newest, focus is where detail is wanted
+	void update(glm::vec2 focus);
+
+	// newest snapshot, sorted by id
+	const std::vector<NetEntity>& getEntities() const { return received[latestSequence % HISTORY].entities; }
+	bool hasSnapshot() const { return hasLatest; }
+	uint16_t getLatestSequence() const { return latestSequence; }
+	uint32_t getServerTick() const { return serverTick; }
+	// snapshots thrown away because their baseline was no longer around
+	uint32_t getDroppedCount() const { return dropped; }
+
+private:
+	static constexpr uint32_t HISTORY = ReplicationServer::HISTORY;
+
+	struct ReceivedSnapshot {
+		uint16_t sequence = 0;
+		uint32_t tick = 0;
+		bool valid = false;
+		std::vector<NetEntity> entities;
+	};
+
+	Transport& transport;
+	std::array<ReceivedSnapshot, HISTORY> received;
+	bool hasLatest = false;
+	uint16_t latestSequence = 0;
+	uint32_t serverTick = 0;
+	uint32_t dropped = 0;
+
+	std::vector<uint8_t> packet;
+	std::vector<NetEntity> decoded;
+	BitWriter writer;
+
+	bool decode(BitReader& reader);
+};
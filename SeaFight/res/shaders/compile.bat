@@ -1,3 +1,10 @@
 C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe sprite.vert -o sprite.vert.spv
 C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe sprite.frag -o sprite.frag.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe tile.vert -o tile.vert.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe text.vert -o text.vert.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe text.frag -o text.frag.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe debug.vert -o debug.vert.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe debug.frag -o debug.frag.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe skinned.vert -o skinned.vert.spv
+C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe skinned.frag -o skinned.frag.spv
 pause
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(push_constant) uniform Push {
+	mat4 viewProj;
+} push;
+
+void main() {
+	gl_Position = push.viewProj * vec4(position, 0.0, 1.0);
+	fragColor = color;
+}
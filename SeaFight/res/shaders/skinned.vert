@@ -0,0 +1,34 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in uvec4 joints;
+layout(location = 3) in vec4 weights;
+
+layout(location = 0) out vec2 fragTexCoord;
+
+struct BoneMatrix {
+	vec4 linear;		// x column then y column
+	vec4 translation;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Bones {
+	BoneMatrix bones[];
+};
+
+layout(push_constant) uniform Push {
+	mat4 transform;
+	uint boneOffset;
+} push;
+
+void main() {
+	//linear blend of up to four bones, unused slots carry zero weight
+	vec2 skinned = vec2(0.0);
+	for (int i = 0; i < 4; i++) {
+		BoneMatrix bone = bones[push.boneOffset + joints[i]];
+		skinned += weights[i] * (mat2(bone.linear.xy, bone.linear.zw) * position + bone.translation.xy);
+	}
+
+	gl_Position = push.transform * vec4(skinned, 0.0, 1.0);
+	fragTexCoord = texCoord;
+}
@@ -1,22 +1,96 @@
 #version 450
 
-layout(location = 0) in vec2 pos;
-layout (location = 1) in vec3 color;
-layout(location = 2) in vec2 texCoord;
+layout(location = 0) in vec2 translation;
+layout(location = 1) in uint depthRotation;	// unorm16 depth, 15 bit fraction of a turn, top bit set when animated
+layout(location = 2) in vec2 scale;
+layout(location = 3) in vec4 color;
+layout(location = 4) in uvec2 image;	// unorm16x2 uv offset and size, or clip id | half speed << 16 and the start time bits
 
-layout (location = 0) out vec2 fragTexCoord;
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
 
 layout(set = 0, binding = 0) uniform UBO {
 	mat4 proj;
 	mat4 view;
+	float time;
 } ubo;
 
-layout(push_constant) uniform Push {
-	mat4 transform;
-	vec3 color;
-} push;
+struct Clip {
+	uint firstFrame;
+	uint frameCount;
+	uint loopMode;	// 0 once, 1 loop, 2 ping pong
+	float duration;
+};
+
+struct Frame {
+	uint uvOffset;	// unorm16x2
+	uint uvSize;	// unorm16x2
+	float endTime;
+	uint padding;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Clips {
+	Clip clips[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer Frames {
+	Frame frames[];
+};
+
+const uint ANIMATED_BIT = 0x80000000u;
+const float TURN_STEP = 6.28318531 / 32768.0;
+
+// unit quad as two triangles, sprites have no vertex buffer of their own
+const vec2 corners[6] = vec2[](
+	vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5),
+	vec2(0.5, 0.5), vec2(-0.5, 0.5), vec2(-0.5, -0.5)
+);
+
+// uv rect of the clip frame showing at the current time, mirrors AnimationLibrary::getFrameAt
+vec4 animatedRect(uint clipId, float speed, float start) {
+	Clip clip = clips[clipId];
+	float t = (ubo.time - start) * speed;
+	if (clip.loopMode == 1u) {
+		t = mod(t, clip.duration);
+	} else if (clip.loopMode == 2u) {
+		t = mod(t, 2.0 * clip.duration);
+		if (t > clip.duration) t = 2.0 * clip.duration - t;
+	} else {
+		t = clamp(t, 0.0, clip.duration);
+	}
+
+	uint low = 0u;
+	uint high = clip.frameCount - 1u;
+	while (low < high) {
+		uint mid = (low + high) / 2u;
+		if (frames[clip.firstFrame + mid].endTime > t) {
+			high = mid;
+		} else {
+			low = mid + 1u;
+		}
+	}
+
+	Frame frame = frames[clip.firstFrame + low];
+	return vec4(unpackUnorm2x16(frame.uvOffset), unpackUnorm2x16(frame.uvSize));
+}
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * push.transform * vec4(pos, 0.0, 1.0);
-	fragTexCoord = texCoord;
-}
\ No newline at end of file
+	vec2 corner = corners[gl_VertexIndex];
+	float depth = float(depthRotation & 0xFFFFu) / 65535.0;
+	float angle = float((depthRotation >> 16) & 0x7FFFu) * TURN_STEP;
+	float c = cos(angle);
+	float s = sin(angle);
+	vec2 local = corner * scale;
+	vec2 world = translation + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+	vec4 uvRect;
+	if ((depthRotation & ANIMATED_BIT) != 0u) {
+		uvRect = animatedRect(image.x & 0xFFFFu, unpackHalf2x16(image.x >> 16).x, uintBitsToFloat(image.y));
+	} else {
+		uvRect = vec4(unpackUnorm2x16(image.x), unpackUnorm2x16(image.y));
+	}
+
+	gl_Position = ubo.proj * ubo.view * vec4(world, depth, 1.0);
+	fragTexCoord = uvRect.xy + vec2(0.5 - corner.x, corner.y + 0.5) * uvRect.zw;
+	fragColor = color;
+}
@@ -0,0 +1,24 @@
+#version 450
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) in vec4 fragOutlineColor;
+
+layout(binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) out vec4 outColor;
+
+// distance field value at the glyph edge and at the outer edge of the outline
+const float EDGE = 0.5;
+const float OUTLINE = 0.25;
+
+void main() {
+	float distance = texture(atlas, fragTexCoord).r;
+	//how much the field changes per pixel, keeps edges one pixel soft at any scale
+	float width = max(fwidth(distance), 0.0001);
+
+	float fill = smoothstep(EDGE - width, EDGE + width, distance);
+	float coverage = smoothstep(OUTLINE - width, OUTLINE + width, distance);
+	vec4 color = mix(fragOutlineColor, fragColor, fill);
+	outColor = vec4(color.rgb, color.a * coverage);
+}
@@ -0,0 +1,34 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 size;
+layout(location = 2) in vec2 uvOffset;
+layout(location = 3) in vec2 uvSize;
+layout(location = 4) in vec4 color;
+layout(location = 5) in vec4 outlineColor;
+layout(location = 6) in uint space;	// 0 world, 1 screen
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+layout(location = 2) out vec4 fragOutlineColor;
+
+layout(push_constant) uniform Push {
+	mat4 world;
+	mat4 screen;
+} push;
+
+// glyph quad from its top left corner, y down
+const vec2 corners[6] = vec2[](
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+	vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
+
+void main() {
+	vec2 corner = corners[gl_VertexIndex];
+	mat4 transform = space == 0u ? push.world : push.screen;
+
+	gl_Position = transform * vec4(position + corner * size, 0.0, 1.0);
+	fragTexCoord = uvOffset + corner * uvSize;
+	fragColor = color;
+	fragOutlineColor = outlineColor;
+}
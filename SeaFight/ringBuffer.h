@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// fixed size single producer / single consumer queue
+// push and pop never lock or allocate, so the producer and consumer can live on different threads
+// capacity must be a power of two so the indices can wrap with a mask
+template <typename T, size_t Capacity>
+class RingBuffer {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+public:
+	RingBuffer() = default;
+
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	// producer side, returns false when the queue is full
+	bool push(const T& item) {
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+		items[head & (Capacity - 1)] = item;
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, returns false when the queue is empty
+	bool pop(T& item) {
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == head_.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = items[tail & (Capacity - 1)];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, oldest item without removing it
+	const T* peek() const {
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == head_.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return &items[tail & (Capacity - 1)];
+	}
+
+	size_t size() const {
+		return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+	}
+	bool empty() const { return size() == 0; }
+	static constexpr size_t capacity() { return Capacity; }
+
+private:
+	std::array<T, Capacity> items{};
+
+	// keep the indices on separate cache lines so producer and consumer don't false share
+	alignas(64) std::atomic<size_t> head_{ 0 };
+	alignas(64) std::atomic<size_t> tail_{ 0 };
+};
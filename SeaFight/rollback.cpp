@@ -0,0 +1,248 @@
+#include "rollback.h"
+
+#include "utils.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+//firstTick, ack, count, then one byte of buttons per tick
+static constexpr size_t PACKET_HEADER_SIZE = 9;
+
+RollbackSession::RollbackSession(Simulation& simulation, Transport& transport, uint32_t localPlayer, uint32_t inputDelay, uint32_t maxRollback)
+	: simulation{ simulation },
+	transport{ transport },
+	localPlayer{ localPlayer },
+	remotePlayer{ 1 - localPlayer },
+	inputDelay{ std::min(inputDelay, MAX_INPUT_DELAY) },
+	maxRollback{ std::clamp(maxRollback, 1u, MAX_ROLLBACK) },
+	measure{ Settings::settings.value("measure_rollback", false) } {
+	assert(simulation.getPlayerCount() == 2 && localPlayer < 2 && "Rollback sessions are between two players");
+
+	//nobody can have pressed anything during the delay at the very start
+	uint32_t start = simulation.getTick();
+	for (uint32_t tick = start; tick < start + this->inputDelay; tick++) {
+		slot(localPlayer, tick) = { tick, {}, true };
+		slot(remotePlayer, tick) = { tick, {}, true };
+	}
+	nextLocalTick = start + this->inputDelay;
+	remoteConfirmed = start + this->inputDelay;
+	peerAck = start + this->inputDelay;
+
+	snapshots.resize(HISTORY * Simulation::MAX_SNAPSHOT_SIZE);
+	snapshotTicks.fill(UINT32_MAX);
+	packet.reserve(PACKET_HEADER_SIZE + MAX_INPUTS_PER_PACKET);
+}
+
+bool RollbackSession::advance(PlayerInput localInput) {
+	receiveInputs();
+
+	uint32_t tick = simulation.getTick();
+	if (rollbackTo < tick) {
+		resimulate(rollbackTo, tick);
+	}
+	rollbackTo = NO_ROLLBACK;
+
+	//everything past this would need a snapshot that is about to be overwritten
+	if (tick >= remoteConfirmed + maxRollback) {
+		stalls++;
+		sendInputs();
+		return false;
+	}
+
+	slot(localPlayer, nextLocalTick) = { nextLocalTick, localInput, true };
+	nextLocalTick++;
+	sendInputs();
+
+	saveSnapshot(tick);
+	simulateTick(tick);
+	return true;
+}
+
+void RollbackSession::receiveInputs() {
+	while (transport.receive(packet)) {
+		if (packet.size() < PACKET_HEADER_SIZE) continue;
+
+		uint32_t firstTick, ack;
+		std::memcpy(&firstTick, packet.data(), sizeof(uint32_t));
+		std::memcpy(&ack, packet.data() + 4, sizeof(uint32_t));
+		uint32_t count = std::min<uint32_t>(packet[8], static_cast<uint32_t>(packet.size() - PACKET_HEADER_SIZE));
+		peerAck = std::max(peerAck, ack);
+
+		uint32_t tick = simulation.getTick();
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t inputTick = firstTick + i;
+			//already known, or too far ahead to have a slot
+			if (inputTick < remoteConfirmed || inputTick >= tick + HISTORY / 2) continue;
+
+			InputSlot& remote = slot(remotePlayer, inputTick);
+			if (remote.confirmed && remote.tick == inputTick) continue;
+
+			PlayerInput input{ packet[PACKET_HEADER_SIZE + i] };
+			//a tick already simulated on a wrong guess has to be redone
+			if (inputTick < tick && remote.tick == inputTick && remote.input != input) {
+				rollbackTo = std::min(rollbackTo, inputTick);
+			}
+			remote = { inputTick, input, true };
+		}
+
+		while (slot(remotePlayer, remoteConfirmed).tick == remoteConfirmed && slot(remotePlayer, remoteConfirmed).confirmed) {
+			remoteConfirmed++;
+		}
+	}
+}
+
+void RollbackSession::sendInputs() {
+	//everything the peer hasn't acknowledged goes out again, so a lost packet costs nothing
+	//as long as a later one arrives. stalling keeps the backlog within one packet
+	uint32_t firstTick = peerAck;
+	uint32_t count = std::min(nextLocalTick - firstTick, MAX_INPUTS_PER_PACKET);
+
+	packet.resize(PACKET_HEADER_SIZE + count);
+	std::memcpy(packet.data(), &firstTick, sizeof(uint32_t));
+	std::memcpy(packet.data() + 4, &remoteConfirmed, sizeof(uint32_t));
+	packet[8] = static_cast<uint8_t>(count);
+	for (uint32_t i = 0; i < count; i++) {
+		packet[PACKET_HEADER_SIZE + i] = slot(localPlayer, firstTick + i).input.buttons;
+	}
+	transport.send(packet.data(), packet.size());
+}
+
+void RollbackSession::saveSnapshot(uint32_t tick) {
+	uint32_t index = tick & (HISTORY - 1);
+	uint8_t* snapshot = &snapshots[index * Simulation::MAX_SNAPSHOT_SIZE];
+	snapshotSizes[index] = simulation.save(snapshot);
+	snapshotTicks[index] = tick;
+	checksums[index] = Simulation::checksum(snapshot, snapshotSizes[index]);
+	maxSnapshotSize = std::max(maxSnapshotSize, snapshotSizes[index]);
+}
+
+void RollbackSession::simulateTick(uint32_t tick) {
+	assert(slot(localPlayer, tick).tick == tick && "Local input missing");
+
+	//predict the remote player keeps doing whatever they were last confirmed doing
+	InputSlot& remote = slot(remotePlayer, tick);
+	if (!(remote.confirmed && remote.tick == tick)) {
+		PlayerInput last{};
+		if (remoteConfirmed > 0 && slot(remotePlayer, remoteConfirmed - 1).tick == remoteConfirmed - 1) {
+			last = slot(remotePlayer, remoteConfirmed - 1).input;
+		}
+		remote = { tick, last, false };
+	}
+
+	PlayerInput tickInputs[Simulation::MAX_PLAYERS];
+	tickInputs[localPlayer] = slot(localPlayer, tick).input;
+	tickInputs[remotePlayer] = remote.input;
+	simulation.tick(tickInputs);
+}
+
+void RollbackSession::resimulate(uint32_t from, uint32_t to) {
+	uint32_t index = from & (HISTORY - 1);
+	assert(snapshotTicks[index] == from && "Rollback target is no longer in the history");
+
+	auto start = std::chrono::high_resolution_clock::now();
+	simulation.restore(&snapshots[index * Simulation::MAX_SNAPSHOT_SIZE]);
+	for (uint32_t tick = from; tick < to; tick++) {
+		saveSnapshot(tick);
+		simulateTick(tick);
+	}
+
+	if (measure) {
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		rollbacks++;
+		resimulatedTicks += to - from;
+		maxDepth = std::max(maxDepth, to - from);
+		sumMilliseconds += milliseconds;
+		maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+	}
+}
+
+bool RollbackSession::isFinal(uint32_t tick) const {
+	return tick <= remoteConfirmed && tick <= simulation.getTick() && snapshotTicks[tick & (HISTORY - 1)] == tick;
+}
+
+bool RollbackSession::getChecksum(uint32_t tick, uint64_t& checksum) const {
+	if (!isFinal(tick)) return false;
+	checksum = checksums[tick & (HISTORY - 1)];
+	return true;
+}
+
+bool RollbackSession::getSnapshot(uint32_t tick, const uint8_t*& data, size_t& size) const {
+	if (!isFinal(tick)) return false;
+	uint32_t index = tick & (HISTORY - 1);
+	data = &snapshots[index * Simulation::MAX_SNAPSHOT_SIZE];
+	size = snapshotSizes[index];
+	return true;
+}
+
+void RollbackSession::getInputs(uint32_t tick, PlayerInput* out) const {
+	assert(tick < remoteConfirmed && slot(localPlayer, tick).tick == tick && slot(remotePlayer, tick).tick == tick
+		&& "Inputs of the tick aren't confirmed or no longer in the history");
+	out[localPlayer] = slot(localPlayer, tick).input;
+	out[remotePlayer] = slot(remotePlayer, tick).input;
+}
+
+void RollbackSession::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	LOG_INFO("Rollback tick {} confirmed {}: {} rollbacks, {} ticks resimulated (deepest {}), avg {:.3f}ms max {:.3f}ms, {} stalls, snapshot {} bytes",
+		simulation.getTick(), remoteConfirmed, rollbacks, resimulatedTicks, maxDepth,
+		rollbacks > 0 ? sumMilliseconds / rollbacks : 0.0, maxMilliseconds, stalls, maxSnapshotSize);
+	rollbacks = resimulatedTicks = maxDepth = stalls = 0;
+	sumMilliseconds = maxMilliseconds = 0.0;
+	maxSnapshotSize = 0;
+}
+
+void RollbackSession::benchmark(const Simulation& source, uint32_t maxRollback) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto milliseconds = [](Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+
+	Simulation simulation = source;
+	std::vector<uint8_t> snapshot(Simulation::MAX_SNAPSHOT_SIZE);
+
+	//get some projectiles in the air so the pools aren't empty
+	PlayerInput busy[Simulation::MAX_PLAYERS];
+	for (uint32_t i = 0; i < 240; i++) {
+		for (uint32_t player = 0; player < simulation.getPlayerCount(); player++) {
+			busy[player].buttons = static_cast<uint8_t>(PlayerInput::Fire | (1 << ((i / 30 + player) % 4)));
+		}
+		simulation.tick(busy);
+	}
+
+	const int iterations = 1000;
+	size_t size = 0;
+	auto start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		size = simulation.save(snapshot.data());
+	}
+	double saveMilliseconds = milliseconds(start) / iterations;
+
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		simulation.restore(snapshot.data());
+	}
+	double restoreMilliseconds = milliseconds(start) / iterations;
+
+	//a full depth rollback, restore plus resimulating with a snapshot per tick like a session does
+	const int rollbackIterations = 100;
+	std::vector<uint8_t> history(Simulation::MAX_SNAPSHOT_SIZE);
+	start = Clock::now();
+	for (int i = 0; i < rollbackIterations; i++) {
+		simulation.restore(snapshot.data());
+		for (uint32_t tick = 0; tick < maxRollback; tick++) {
+			size_t saved = simulation.save(history.data());
+			Simulation::checksum(history.data(), saved);
+			simulation.tick(busy);
+		}
+	}
+	double rollbackMilliseconds = milliseconds(start) / rollbackIterations;
+
+	LOG_INFO("Rollback benchmark: snapshot {} bytes ({} max, {} projectiles), save {:.4f}ms, restore {:.4f}ms, {} tick rollback {:.4f}ms",
+		size, Simulation::MAX_SNAPSHOT_SIZE, simulation.getProjectileCount(), saveMilliseconds, restoreMilliseconds, maxRollback, rollbackMilliseconds);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "simulation.h"
+#include "transport.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// two player rollback session driving a Simulation over a Transport
+// local input is scheduled inputDelay ticks ahead, which hides that much latency outright.
+// remote input that hasn't arrived yet is predicted by repeating the last confirmed one,
+// and when the real input turns out different the state is restored from the snapshot of
+// that tick and the ticks since are simulated again. both peers must use the same delay
+class RollbackSession {
+public:
+	// ticks of inputs and snapshots kept, a power of two
+	static constexpr uint32_t HISTORY = 128;
+	static constexpr uint32_t MAX_INPUT_DELAY = 16;
+	static constexpr uint32_t MAX_ROLLBACK = 32;
+
+	RollbackSession(Simulation& simulation, Transport& transport, uint32_t localPlayer, uint32_t inputDelay, uint32_t maxRollback);
+
+	RollbackSession(const RollbackSession&) = delete;
+	RollbackSession& operator=(const RollbackSession&) = delete;
+
+	// takes in remote input, rolls back past any misprediction and runs one new tick
+	// returns false without ticking while the remote peer is maxRollback ticks behind
+	bool advance(PlayerInput localInput);
+
+	uint32_t getTick() const { return simulation.getTick(); }
+	// remote input is known for every tick before this one
+	uint32_t getConfirmedTick() const { return remoteConfirmed; }
+	// checksum of the state at the start of tick, once it can't change anymore and while
+	// it is still in the history
+	bool getChecksum(uint32_t tick, uint64_t& checksum) const;
+	// the same for the snapshot itself, data stays valid until the next advance
+	bool getSnapshot(uint32_t tick, const uint8_t*& data, size_t& size) const;
+	// inputs every player used on a tick before getConfirmedTick that is still in the history
+	void getInputs(uint32_t tick, PlayerInput* out) const;
+
+	// logs rollback counts and costs about once per second
+	void report(double now);
+	// times snapshot, restore and a maxRollback deep resimulation on a copy of simulation
+	static void benchmark(const Simulation& simulation, uint32_t maxRollback);
+
+private:
+	static constexpr uint32_t NO_ROLLBACK = UINT32_MAX;
+	static constexpr uint32_t MAX_INPUTS_PER_PACKET = 64;
+
+	struct InputSlot {
+		uint32_t tick = UINT32_MAX;
+		PlayerInput input{};
+		// false for remote input that was only predicted
+		bool confirmed = false;
+	};
+
+	Simulation& simulation;
+	Transport& transport;
+	uint32_t localPlayer;
+	uint32_t remotePlayer;
+	uint32_t inputDelay;
+	uint32_t maxRollback;
+
+	std::array<std::array<InputSlot, HISTORY>, Simulation::MAX_PLAYERS> inputs{};
+	// next tick the local player's input goes to
+	uint32_t nextLocalTick;
+	uint32_t remoteConfirmed;
+	// the remote peer has every local input before this
+	uint32_t peerAck = 0;
+	uint32_t rollbackTo = NO_ROLLBACK;
+
+	// HISTORY snapshots of MAX_SNAPSHOT_SIZE bytes
+	std::vector<uint8_t> snapshots;
+	std::array<uint32_t, HISTORY> snapshotTicks{};
+	std::array<size_t, HISTORY> snapshotSizes{};
+	std::array<uint64_t, HISTORY> checksums{};
+
+	std::vector<uint8_t> packet;
+
+	const bool measure;
+	uint32_t rollbacks = 0;
+	uint32_t resimulatedTicks = 0;
+	uint32_t maxDepth = 0;
+	uint32_t stalls = 0;
+	double sumMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	size_t maxSnapshotSize = 0;
+	double lastReport = 0.0;
+
+	InputSlot& slot(uint32_t player, uint32_t tick) { return inputs[player][tick & (HISTORY - 1)]; }
+	const InputSlot& slot(uint32_t player, uint32_t tick) const { return inputs[player][tick & (HISTORY - 1)]; }
+	// the snapshot of tick is kept and no input before it can change anymore
+	bool isFinal(uint32_t tick) const;
+
+	void receiveInputs();
+	void sendInputs();
+	void saveSnapshot(uint32_t tick);
+	void simulateTick(uint32_t tick);
+	void resimulate(uint32_t from, uint32_t to);
+};
@@ -0,0 +1,176 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+//arena is [-ARENA, ARENA] on both axes
+static constexpr Simulation::Fixed ARENA = Simulation::FIXED_ONE;
+static constexpr Simulation::Fixed THRUST = Simulation::FIXED_ONE / 2048;
+static constexpr Simulation::Fixed PROJECTILE_SPEED = Simulation::FIXED_ONE / 64;
+static constexpr Simulation::Fixed HIT_RADIUS = Simulation::FIXED_ONE / 20;
+static constexpr uint16_t PROJECTILE_LIFE = 120;
+static constexpr uint8_t FIRE_COOLDOWN = 15;
+static constexpr uint8_t MAX_HEALTH = 5;
+
+Simulation::Simulation(uint32_t playerCount, uint32_t seed) {
+	assert(playerCount > 0 && playerCount <= MAX_PLAYERS && "Unsupported player count");
+	header.playerCount = playerCount;
+	//xorshift can't leave zero
+	header.random = seed != 0 ? seed : 0x9E3779B9u;
+	for (uint32_t player = 0; player < playerCount; player++) {
+		spawnShip(player);
+	}
+}
+
+uint32_t Simulation::nextRandom() {
+	uint32_t x = header.random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	header.random = x;
+	return x;
+}
+
+void Simulation::spawnShip(uint32_t player) {
+	Ship& ship = ships[player];
+	ship = {};
+	ship.x = static_cast<Fixed>(nextRandom() % (2 * ARENA)) - ARENA;
+	ship.y = static_cast<Fixed>(nextRandom() % (2 * ARENA)) - ARENA;
+	ship.facingX = 1;
+	ship.health = MAX_HEALTH;
+}
+
+void Simulation::tick(const PlayerInput* inputs) {
+	moveShips(inputs);
+	moveProjectiles();
+	header.tick++;
+}
+
+void Simulation::moveShips(const PlayerInput* inputs) {
+	for (uint32_t player = 0; player < header.playerCount; player++) {
+		Ship& ship = ships[player];
+		uint8_t buttons = inputs[player].buttons;
+
+		int dx = ((buttons & PlayerInput::Right) ? 1 : 0) - ((buttons & PlayerInput::Left) ? 1 : 0);
+		int dy = ((buttons & PlayerInput::Up) ? 1 : 0) - ((buttons & PlayerInput::Down) ? 1 : 0);
+		if (dx != 0 || dy != 0) {
+			ship.facingX = static_cast<int8_t>(dx);
+			ship.facingY = static_cast<int8_t>(dy);
+		}
+
+		//integer drag of 1/16 per tick, arithmetic shifts round the same way everywhere
+		ship.vx += dx * THRUST - (ship.vx >> 4);
+		ship.vy += dy * THRUST - (ship.vy >> 4);
+		ship.x = std::clamp(ship.x + ship.vx, -ARENA, ARENA);
+		ship.y = std::clamp(ship.y + ship.vy, -ARENA, ARENA);
+
+		if (ship.cooldown > 0) {
+			ship.cooldown--;
+		}
+		else if ((buttons & PlayerInput::Fire) && header.projectileCount < MAX_PROJECTILES) {
+			Projectile& projectile = projectiles[header.projectileCount++];
+			projectile.x = ship.x;
+			projectile.y = ship.y;
+			projectile.vx = ship.vx + ship.facingX * PROJECTILE_SPEED;
+			projectile.vy = ship.vy + ship.facingY * PROJECTILE_SPEED;
+			projectile.owner = static_cast<uint16_t>(player);
+			projectile.life = PROJECTILE_LIFE;
+			projectile.id = header.nextProjectileId++;
+			ship.cooldown = FIRE_COOLDOWN;
+		}
+	}
+}
+
+void Simulation::moveProjectiles() {
+	const int64_t hitRadiusSquared = static_cast<int64_t>(HIT_RADIUS) * HIT_RADIUS;
+
+	uint32_t i = 0;
+	while (i < header.projectileCount) {
+		Projectile& projectile = projectiles[i];
+		Fixed startX = projectile.x;
+		Fixed startY = projectile.y;
+		projectile.x += projectile.vx;
+		projectile.y += projectile.vy;
+		projectile.life--;
+
+		//the whole path since last tick is tested, a fast enough round would otherwise step
+		//clean over a ship. the ship hit earliest along the path takes it
+		const int64_t pathSquared = static_cast<int64_t>(projectile.vx) * projectile.vx + static_cast<int64_t>(projectile.vy) * projectile.vy;
+		uint32_t target = header.playerCount;
+		int64_t earliest = 0;
+		for (uint32_t player = 0; player < header.playerCount; player++) {
+			if (player == projectile.owner) continue;
+
+			const Ship& ship = ships[player];
+			int64_t toShipX = ship.x - startX;
+			int64_t toShipY = ship.y - startY;
+			//closest point of the path as a fraction of pathSquared, integer division truncates
+			//the same way everywhere
+			int64_t along = pathSquared > 0 ? std::clamp<int64_t>(toShipX * projectile.vx + toShipY * projectile.vy, 0, pathSquared) : 0;
+			int64_t dx = toShipX - (pathSquared > 0 ? projectile.vx * along / pathSquared : 0);
+			int64_t dy = toShipY - (pathSquared > 0 ? projectile.vy * along / pathSquared : 0);
+			if (dx * dx + dy * dy <= hitRadiusSquared && (target == header.playerCount || along < earliest)) {
+				target = player;
+				earliest = along;
+			}
+		}
+
+		bool expired = false;
+		if (target != header.playerCount) {
+			expired = true;
+			ships[projectile.owner].score++;
+			if (--ships[target].health == 0) {
+				spawnShip(target);
+			}
+		}
+		expired = expired || projectile.life == 0
+			|| projectile.x < -ARENA || projectile.x > ARENA
+			|| projectile.y < -ARENA || projectile.y > ARENA;
+
+		//swap remove keeps the pool dense, the order is the same on every peer
+		if (expired) {
+			projectiles[i] = projectiles[--header.projectileCount];
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+size_t Simulation::save(uint8_t* out) const {
+	//only the live part of each pool is copied
+	size_t shipBytes = sizeof(Ship) * header.playerCount;
+	size_t projectileBytes = sizeof(Projectile) * header.projectileCount;
+	std::memcpy(out, &header, sizeof(Header));
+	std::memcpy(out + sizeof(Header), ships.data(), shipBytes);
+	std::memcpy(out + sizeof(Header) + shipBytes, projectiles.data(), projectileBytes);
+	return sizeof(Header) + shipBytes + projectileBytes;
+}
+
+void Simulation::restore(const uint8_t* in) {
+	std::memcpy(&header, in, sizeof(Header));
+	size_t shipBytes = sizeof(Ship) * header.playerCount;
+	std::memcpy(ships.data(), in + sizeof(Header), shipBytes);
+	std::memcpy(projectiles.data(), in + sizeof(Header) + shipBytes, sizeof(Projectile) * header.projectileCount);
+}
+
+bool Simulation::isValidSnapshot(const uint8_t* snapshot, size_t size) {
+	if (size < sizeof(Header)) return false;
+
+	Header stored;
+	std::memcpy(&stored, snapshot, sizeof(Header));
+	if (stored.playerCount == 0 || stored.playerCount > MAX_PLAYERS || stored.projectileCount > MAX_PROJECTILES) {
+		return false;
+	}
+	return size == sizeof(Header) + sizeof(Ship) * stored.playerCount + sizeof(Projectile) * stored.projectileCount;
+}
+
+uint64_t Simulation::checksum(const uint8_t* snapshot, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= snapshot[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// what one player pressed during one tick, the only thing peers have to exchange
+struct PlayerInput {
+	enum Button : uint8_t {
+		Up = 1 << 0,
+		Down = 1 << 1,
+		Left = 1 << 2,
+		Right = 1 << 3,
+		Fire = 1 << 4,
+	};
+
+	uint8_t buttons = 0;
+
+	bool operator==(const PlayerInput& other) const { return buttons == other.buttons; }
+	bool operator!=(const PlayerInput& other) const { return buttons != other.buttons; }
+};
+
+// deterministic game state advanced one fixed tick at a time
+// positions are 16.16 fixed point and the only randomness is the state's own generator, so
+// every peer feeding in the same inputs computes the same bits
+// all state lives in fixed capacity pools of plain structs kept dense from the front, so a
+// snapshot is one memcpy per pool and restoring it is the same copies the other way
+class Simulation {
+public:
+	using Fixed = int32_t;
+	static constexpr int FIXED_SHIFT = 16;
+	static constexpr Fixed FIXED_ONE = 1 << FIXED_SHIFT;
+
+	static constexpr uint32_t MAX_PLAYERS = 2;
+	static constexpr uint32_t MAX_PROJECTILES = 256;
+
+	struct Ship {
+		Fixed x, y;
+		Fixed vx, vy;
+		// last direction moved in, -1, 0 or 1 on each axis
+		int8_t facingX, facingY;
+		uint8_t health;
+		uint8_t cooldown;
+		uint32_t score;
+	};
+
+	struct Projectile {
+		Fixed x, y;
+		Fixed vx, vy;
+		uint16_t owner;
+		uint16_t life;
+		// stable across the swap removes that reorder the pool, for replication
+		uint32_t id;
+	};
+
+	Simulation(uint32_t playerCount, uint32_t seed);
+
+	// one input per player
+	void tick(const PlayerInput* inputs);
+
+	// writes the state to out and returns the bytes used, out must hold MAX_SNAPSHOT_SIZE
+	size_t save(uint8_t* out) const;
+	void restore(const uint8_t* in);
+	// whether data from outside, eg a file, is a snapshot restore can take
+	static bool isValidSnapshot(const uint8_t* snapshot, size_t size);
+	// fnv-1a over the saved state, for spotting desyncs between peers
+	static uint64_t checksum(const uint8_t* snapshot, size_t size);
+
+	uint32_t getTick() const { return header.tick; }
+	uint32_t getPlayerCount() const { return header.playerCount; }
+	const Ship& getShip(uint32_t player) const { return ships[player]; }
+	uint32_t getProjectileCount() const { return header.projectileCount; }
+	const Projectile& getProjectile(uint32_t index) const { return projectiles[index]; }
+
+	static float toFloat(Fixed value) { return static_cast<float>(value) / FIXED_ONE; }
+
+private:
+	struct Header {
+		uint32_t tick;
+		uint32_t random;
+		uint32_t playerCount;
+		uint32_t projectileCount;
+		uint32_t nextProjectileId;
+	};
+
+	static_assert(std::is_trivially_copyable<Ship>::value && std::is_trivially_copyable<Projectile>::value,
+		"Simulation pools are copied as raw bytes");
+
+	Header header{};
+	std::array<Ship, MAX_PLAYERS> ships{};
+	std::array<Projectile, MAX_PROJECTILES> projectiles{};
+
+	uint32_t nextRandom();
+	void spawnShip(uint32_t player);
+	void moveShips(const PlayerInput* inputs);
+	void moveProjectiles();
+
+public:
+	// the header plus full pools, what a snapshot buffer has to hold at most
+	static constexpr size_t MAX_SNAPSHOT_SIZE = sizeof(Header) + sizeof(Ship) * MAX_PLAYERS + sizeof(Projectile) * MAX_PROJECTILES;
+};
@@ -0,0 +1,148 @@
+#include "skeleton.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SKELETON_SSE 1
+#endif
+
+Affine2D Affine2D::fromTRS(glm::vec2 translation, float rotation, glm::vec2 scale) {
+	float c = std::cos(rotation);
+	float s = std::sin(rotation);
+	Affine2D result;
+	result.x = glm::vec2(c, s) * scale.x;
+	result.y = glm::vec2(-s, c) * scale.y;
+	result.t = translation;
+	return result;
+}
+
+Affine2D Affine2D::operator*(const Affine2D& other) const {
+	Affine2D result;
+	result.x = x * other.x.x + y * other.x.y;
+	result.y = x * other.y.x + y * other.y.y;
+	result.t = apply(other.t);
+	return result;
+}
+
+Affine2D Affine2D::inverse() const {
+	float det = x.x * y.y - y.x * x.y;
+	float invDet = det != 0.0f ? 1.0f / det : 0.0f;
+	Affine2D result;
+	result.x = glm::vec2(y.y, -x.y) * invDet;
+	result.y = glm::vec2(-y.x, x.x) * invDet;
+	result.t = -(result.x * t.x + result.y * t.y);
+	return result;
+}
+
+void LocalPose::resize(uint32_t paddedBoneCount) {
+	translationX.resize(paddedBoneCount);
+	translationY.resize(paddedBoneCount);
+	rotation.resize(paddedBoneCount);
+	scaleX.resize(paddedBoneCount);
+	scaleY.resize(paddedBoneCount);
+}
+
+uint32_t Skeleton::addBone(int parent, const BoneTransform& bind) {
+	assert(parent < static_cast<int>(parents.size()) && "Bone parents have to be added before their children");
+
+	Affine2D local = Affine2D::fromTRS(bind.translation, bind.rotation, bind.scale);
+	Affine2D world = parent >= 0 ? bindWorld[parent] * local : local;
+
+	parents.push_back(parent);
+	bindPose.push_back(bind);
+	bindWorld.push_back(world);
+	inverseBind.push_back(world.inverse());
+	return static_cast<uint32_t>(parents.size() - 1);
+}
+
+void Skeleton::computeSkinMatrices(const LocalPose& pose, BoneMatrix* out) const {
+	//parents come first, so one forward pass resolves the whole hierarchy
+	thread_local std::vector<Affine2D> world;
+	world.resize(getBoneCount());
+	for (uint32_t bone = 0; bone < getBoneCount(); bone++) {
+		Affine2D local = Affine2D::fromTRS(
+			{ pose.translationX[bone], pose.translationY[bone] },
+			pose.rotation[bone],
+			{ pose.scaleX[bone], pose.scaleY[bone] });
+		world[bone] = parents[bone] >= 0 ? world[parents[bone]] * local : local;
+
+		Affine2D skin = world[bone] * inverseBind[bone];
+		out[bone].linear = { skin.x, skin.y };
+		out[bone].translation = { skin.t, 0.0f, 0.0f };
+	}
+}
+
+SkeletalClip SkeletalClip::bake(const Skeleton& skeleton, float duration, float sampleRate, bool loop, const SampleFn& fn) {
+	assert(duration > 0.0f && sampleRate > 0.0f && "Clip needs a positive duration and sample rate");
+
+	SkeletalClip clip;
+	clip.paddedBoneCount = skeleton.getPaddedBoneCount();
+	clip.frameCount = static_cast<uint32_t>(std::ceil(duration * sampleRate)) + 1;
+	clip.sampleRate = sampleRate;
+	clip.duration = duration;
+	clip.loop = loop;
+	clip.keys.resize(clip.frameCount * clip.paddedBoneCount);
+
+	for (uint32_t frame = 0; frame < clip.frameCount; frame++) {
+		float time = std::min(frame / sampleRate, duration);
+		for (uint32_t bone = 0; bone < clip.paddedBoneCount; bone++) {
+			//padding lanes get an identity so they stay harmless
+			BoneTransform transform = bone < skeleton.getBoneCount() ? fn(bone, time) : BoneTransform{};
+			uint32_t key = frame * clip.paddedBoneCount + bone;
+
+			//unwrap against the previous key so interpolation never spins the long way
+			if (frame > 0) {
+				float previous = clip.keys.rotation[key - clip.paddedBoneCount];
+				float delta = transform.rotation - previous;
+				delta -= glm::two_pi<float>() * std::round(delta / glm::two_pi<float>());
+				transform.rotation = previous + delta;
+			}
+
+			clip.keys.translationX[key] = transform.translation.x;
+			clip.keys.translationY[key] = transform.translation.y;
+			clip.keys.rotation[key] = transform.rotation;
+			clip.keys.scaleX[key] = transform.scale.x;
+			clip.keys.scaleY[key] = transform.scale.y;
+		}
+	}
+	return clip;
+}
+
+static void lerpChannel(const float* a, const float* b, float alpha, float* out, uint32_t count) {
+#ifdef SKELETON_SSE
+	__m128 weight = _mm_set1_ps(alpha);
+	for (uint32_t i = 0; i < count; i += 4) {
+		__m128 from = _mm_loadu_ps(a + i);
+		__m128 to = _mm_loadu_ps(b + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), weight)));
+	}
+#else
+	for (uint32_t i = 0; i < count; i++) {
+		out[i] = a[i] + (b[i] - a[i]) * alpha;
+	}
+#endif
+}
+
+void SkeletalClip::sample(float time, LocalPose& pose) const {
+	assert(pose.rotation.size() >= paddedBoneCount && "Pose is too small for the clip");
+
+	time = loop ? time - duration * std::floor(time / duration) : glm::clamp(time, 0.0f, duration);
+	float position = time * sampleRate;
+	uint32_t frame = std::min(static_cast<uint32_t>(position), frameCount - 1);
+	uint32_t next = std::min(frame + 1, frameCount - 1);
+	float alpha = position - frame;
+
+	//there is a key at the very end of the clip, so next never has to wrap to the start
+	uint32_t a = frame * paddedBoneCount;
+	uint32_t b = next * paddedBoneCount;
+	lerpChannel(&keys.translationX[a], &keys.translationX[b], alpha, pose.translationX.data(), paddedBoneCount);
+	lerpChannel(&keys.translationY[a], &keys.translationY[b], alpha, pose.translationY.data(), paddedBoneCount);
+	lerpChannel(&keys.rotation[a], &keys.rotation[b], alpha, pose.rotation.data(), paddedBoneCount);
+	lerpChannel(&keys.scaleX[a], &keys.scaleX[b], alpha, pose.scaleX.data(), paddedBoneCount);
+	lerpChannel(&keys.scaleY[a], &keys.scaleY[b], alpha, pose.scaleY.data(), paddedBoneCount);
+}
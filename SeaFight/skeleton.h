@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 2d affine transform stored as its two basis columns and a translation
+struct Affine2D {
+	glm::vec2 x{ 1.0f, 0.0f };
+	glm::vec2 y{ 0.0f, 1.0f };
+	glm::vec2 t{ 0.0f, 0.0f };
+
+	static Affine2D fromTRS(glm::vec2 translation, float rotation, glm::vec2 scale);
+	Affine2D operator*(const Affine2D& other) const;
+	Affine2D inverse() const;
+	glm::vec2 apply(glm::vec2 point) const { return x * point.x + y * point.y + t; }
+};
+
+// bone matrix as read by skinned.vert, std430
+struct BoneMatrix {
+	glm::vec4 linear;		// x column then y column
+	glm::vec4 translation;	// xy used
+};
+
+// local transform of one bone relative to its parent
+struct BoneTransform {
+	glm::vec2 translation{ 0.0f };
+	float rotation = 0.0f;
+	glm::vec2 scale{ 1.0f };
+};
+
+// a local pose in structure of arrays form, padded to a multiple of 4 bones for sse
+struct LocalPose {
+	std::vector<float> translationX;
+	std::vector<float> translationY;
+	std::vector<float> rotation;
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+
+	void resize(uint32_t paddedBoneCount);
+};
+
+// bone hierarchy with its bind pose, parents always come before their children
+class Skeleton {
+public:
+	// returns the bone index, parent is -1 for a root
+	uint32_t addBone(int parent, const BoneTransform& bind);
+
+	uint32_t getBoneCount() const { return static_cast<uint32_t>(parents.size()); }
+	uint32_t getPaddedBoneCount() const { return (getBoneCount() + 3) & ~3u; }
+	int getParent(uint32_t bone) const { return parents[bone]; }
+	const BoneTransform& getBindTransform(uint32_t bone) const { return bindPose[bone]; }
+	// bind pose in model space, what mesh vertices are authored against
+	const Affine2D& getBindWorld(uint32_t bone) const { return bindWorld[bone]; }
+
+	// walks the hierarchy and writes world * inverse bind for every bone
+	void computeSkinMatrices(const LocalPose& pose, BoneMatrix* out) const;
+
+private:
+	std::vector<int> parents;
+	std::vector<BoneTransform> bindPose;
+	std::vector<Affine2D> bindWorld;
+	std::vector<Affine2D> inverseBind;
+};
+
+// keyframed clip baked at a fixed sample rate, every bone has a key on every sample so
+// sampling interpolates all bones with the same weights, four at a time with sse
+// rotations are stored unwrapped, so plain interpolation takes the short way round
+class SkeletalClip {
+public:
+	using SampleFn = std::function<BoneTransform(uint32_t bone, float time)>;
+
+	// samples fn over [0, duration] for every bone, looping clips should end where they start
+	static SkeletalClip bake(const Skeleton& skeleton, float duration, float sampleRate, bool loop, const SampleFn& fn);
+
+	float getDuration() const { return duration; }
+	bool isLooping() const { return loop; }
+
+	// interpolated local pose at time, pose must be sized for the skeleton
+	void sample(float time, LocalPose& pose) const;
+
+private:
+	uint32_t paddedBoneCount = 0;
+	uint32_t frameCount = 0;
+	float sampleRate = 30.0f;
+	float duration = 0.0f;
+	bool loop = true;
+
+	// frameCount blocks of paddedBoneCount values each
+	LocalPose keys;
+};
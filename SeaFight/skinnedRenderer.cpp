@@ -0,0 +1,296 @@
+#include "skinnedRenderer.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+static_assert(sizeof(SkinnedMesh::Vertex) == 20, "SkinnedMesh::Vertex must stay tightly packed");
+static_assert(sizeof(BoneMatrix) == 32, "BoneMatrix has to match the std430 layout");
+
+struct SkinnedPushConstants {
+	glm::mat4 transform;
+	uint32_t boneOffset;
+};
+
+SkinnedMesh::Vertex SkinnedMesh::Vertex::pack(glm::vec2 position, glm::vec2 texCoord, glm::uvec4 joints, glm::vec4 weights) {
+	assert(glm::all(glm::lessThan(joints, glm::uvec4(256))) && "Bone index does not fit 8 bits");
+
+	//renormalize so the quantized weights still add up to one
+	float sum = weights.x + weights.y + weights.z + weights.w;
+	Vertex vertex{};
+	vertex.position = position;
+	vertex.texCoord = glm::packUnorm2x16(texCoord);
+	vertex.joints = joints.x | (joints.y << 8) | (joints.z << 16) | (joints.w << 24);
+	vertex.weights = glm::packUnorm4x8(sum > 0.0f ? weights / sum : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+	return vertex;
+}
+
+std::vector<VkVertexInputBindingDescription> SkinnedMesh::Vertex::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(Vertex);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> SkinnedMesh::Vertex::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[0].offset = offsetof(Vertex, position);
+
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R16G16_UNORM;
+	attributeDescriptions[1].offset = offsetof(Vertex, texCoord);
+
+	attributeDescriptions[2].binding = 0;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R8G8B8A8_UINT;
+	attributeDescriptions[2].offset = offsetof(Vertex, joints);
+
+	attributeDescriptions[3].binding = 0;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[3].offset = offsetof(Vertex, weights);
+
+	return attributeDescriptions;
+}
+
+SkinnedMesh::SkinnedMesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices)
+	: indexCount{ static_cast<uint32_t>(indices.size()) } {
+	assert(!vertices.empty() && !indices.empty() && "Skinned mesh has no geometry");
+
+	Buffer vertexStaging{
+		device,
+		sizeof(Vertex),
+		static_cast<uint32_t>(vertices.size()),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+	vertexStaging.map();
+	vertexStaging.writeToBuffer((void*)vertices.data());
+
+	Buffer indexStaging{
+		device,
+		sizeof(uint16_t),
+		indexCount,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+	indexStaging.map();
+	indexStaging.writeToBuffer((void*)indices.data());
+
+	vertexBuffer = std::make_unique<Buffer>(
+		device,
+		sizeof(Vertex),
+		static_cast<uint32_t>(vertices.size()),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	indexBuffer = std::make_unique<Buffer>(
+		device,
+		sizeof(uint16_t),
+		indexCount,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	device.copyBuffer(vertexStaging.getBuffer(), vertexBuffer->getBuffer(), vertexStaging.getBufferSize());
+	device.copyBuffer(indexStaging.getBuffer(), indexBuffer->getBuffer(), indexStaging.getBufferSize());
+}
+
+void SkinnedMesh::bind(VkCommandBuffer commandBuffer) const {
+	VkBuffer buffers[] = { vertexBuffer->getBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
+}
+
+void SkinnedMesh::draw(VkCommandBuffer commandBuffer) const {
+	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+}
+
+SkinnedRenderer::SkinnedRenderer(Device& device, VkRenderPass renderPass, JobSystem& jobs, VkImageView texture, VkSampler sampler)
+	: device{ device }, jobs{ jobs }, texture{ texture }, sampler{ sampler } {
+	for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+		createBoneBuffer(i, 256);
+	}
+	createDescriptors();
+	createPipelineLayout();
+	createPipeline(renderPass);
+}
+
+SkinnedRenderer::~SkinnedRenderer() {
+	vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+}
+
+void SkinnedRenderer::createBoneBuffer(int index, uint32_t capacity) {
+	boneBuffers[index] = std::make_unique<Buffer>(
+		device,
+		sizeof(BoneMatrix),
+		capacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	boneBuffers[index]->map();
+}
+
+void SkinnedRenderer::createDescriptors() {
+	setLayout = DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.build();
+	descriptorPool = DescriptorPool::Builder(device)
+		.setMaxSets(Swapchain::MAX_FRAMES_IN_FLIGHT)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+		.build();
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = texture;
+	imageInfo.sampler = sampler;
+	for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+		auto bufferInfo = boneBuffers[i]->descriptorInfo();
+		DescriptorWriter(*setLayout, *descriptorPool)
+			.writeBuffer(0, &bufferInfo)
+			.writeImage(1, &imageInfo)
+			.build(descriptorSets[i]);
+	}
+}
+
+void SkinnedRenderer::setTexture(int frameIndex, VkImageView newTexture, FrameArena& arena) {
+	texture = newTexture;
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = texture;
+	imageInfo.sampler = sampler;
+	DescriptorWriter(*setLayout, *descriptorPool, arena)
+		.writeImage(1, &imageInfo)
+		.overwrite(descriptorSets[frameIndex]);
+}
+
+void SkinnedRenderer::createPipelineLayout() {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(SkinnedPushConstants);
+
+	VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create skinned pipeline layout!");
+		throw std::runtime_error("Failed to create skinned pipeline layout!");
+	}
+}
+
+void SkinnedRenderer::createPipeline(VkRenderPass renderPass) {
+	//rigged characters are opaque and drawn with the opaque sprites
+	PipelineConfigInfo pipelineConfig{};
+	Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+	pipelineConfig.renderPass = renderPass;
+	pipelineConfig.pipelineLayout = pipelineLayout;
+	pipelineConfig.bindingDescriptions = SkinnedMesh::Vertex::getBindingDescriptions();
+	pipelineConfig.attributeDescriptions = SkinnedMesh::Vertex::getAttributeDescriptions();
+	pipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/skinned.vert.spv",
+		"res/shaders/skinned.frag.spv",
+		pipelineConfig);
+}
+
+void SkinnedRenderer::prepare(int index, const std::vector<Instance>& instances, FrameArena& arena) {
+	assert(index >= 0 && index < Swapchain::MAX_FRAMES_IN_FLIGHT && "Invalid frame index");
+	frameIndex = index;
+	draws.clear();
+	if (instances.empty()) return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//every instance gets its own range of the bone buffer
+	uint32_t boneCount = 0;
+	for (const Instance& instance : instances) {
+		draws.push_back({ instance.mesh, instance.translation, instance.scale, boneCount });
+		boneCount += instance.skeleton->getBoneCount();
+	}
+
+	//the fence for this frame has been waited on, so its buffer and set are free to replace
+	if (boneCount > boneBuffers[frameIndex]->getInstanceCount()) {
+		uint32_t capacity = boneBuffers[frameIndex]->getInstanceCount();
+		while (capacity < boneCount) capacity *= 2;
+		createBoneBuffer(frameIndex, capacity);
+
+		auto bufferInfo = boneBuffers[frameIndex]->descriptorInfo();
+		DescriptorWriter(*setLayout, *descriptorPool, arena)
+			.writeBuffer(0, &bufferInfo)
+			.overwrite(descriptorSets[frameIndex]);
+	}
+
+	//ranges don't overlap, so workers write straight into the mapped buffer
+	BoneMatrix* bones = static_cast<BoneMatrix*>(boneBuffers[frameIndex]->getMappedMemory());
+	jobs.parallelFor(static_cast<uint32_t>(instances.size()), 4, [&](uint32_t begin, uint32_t end) {
+		thread_local LocalPose pose;
+		for (uint32_t i = begin; i < end; i++) {
+			const Instance& instance = instances[i];
+			pose.resize(instance.skeleton->getPaddedBoneCount());
+			instance.clip->sample(instance.clipTime, pose);
+			instance.skeleton->computeSkinMatrices(pose, bones + draws[i].boneOffset);
+		}
+	});
+
+	if (measure) {
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		samples++;
+		sampledBones = boneCount;
+		sumMilliseconds += milliseconds;
+		maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+	}
+}
+
+void SkinnedRenderer::draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProj) {
+	if (draws.empty()) return;
+
+	pipeline->bind(commandBuffer);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipelineLayout,
+		0,
+		1,
+		&descriptorSets[frameIndex],
+		0,
+		nullptr);
+
+	for (const Draw& draw : draws) {
+		SkinnedPushConstants push{};
+		push.transform = glm::scale(glm::translate(viewProj, draw.translation), glm::vec3(draw.scale, draw.scale, 1.0f));
+		push.boneOffset = draw.boneOffset;
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SkinnedPushConstants), &push);
+
+		draw.mesh->bind(commandBuffer);
+		draw.mesh->draw(commandBuffer);
+	}
+}
+
+void SkinnedRenderer::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		LOG_INFO("Skinning {} characters, {} bones on {} threads: avg {:.3f}ms max {:.3f}ms",
+			draws.size(), sampledBones, jobs.getWorkerCount() + 1, sumMilliseconds / samples, maxMilliseconds);
+	}
+	samples = 0;
+	sumMilliseconds = maxMilliseconds = 0.0;
+}
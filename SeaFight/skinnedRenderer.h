@@ -0,0 +1,112 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "frameArena.h"
+#include "jobSystem.h"
+#include "pipeline.h"
+#include "skeleton.h"
+#include "swapchain.h"
+#include "utils.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// mesh authored against a skeleton's bind pose, every vertex follows up to four bones
+class SkinnedMesh {
+public:
+	// 20 bytes
+	struct Vertex {
+		glm::vec2 position;		// model space
+		uint32_t texCoord;		// unorm16x2
+		uint32_t joints;		// 4 x uint8 bone indices
+		uint32_t weights;		// unorm8x4, summing to one
+
+		static Vertex pack(glm::vec2 position, glm::vec2 texCoord, glm::uvec4 joints, glm::vec4 weights);
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	SkinnedMesh(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices);
+
+	SkinnedMesh(const SkinnedMesh&) = delete;
+	SkinnedMesh& operator=(const SkinnedMesh&) = delete;
+
+	void bind(VkCommandBuffer commandBuffer) const;
+	void draw(VkCommandBuffer commandBuffer) const;
+
+private:
+	std::unique_ptr<Buffer> vertexBuffer;
+	std::unique_ptr<Buffer> indexBuffer;
+	uint32_t indexCount;
+};
+
+// evaluates the poses of every rigged character on the job system and skins them in the
+// vertex shader. the bone matrices of all characters go into one storage buffer per frame
+// in flight, each draw only pushes its transform and where its bones start
+class SkinnedRenderer {
+public:
+	struct Instance {
+		const Skeleton* skeleton;
+		const SkeletalClip* clip;
+		const SkinnedMesh* mesh;
+		glm::vec3 translation;		// z is the draw depth
+		float scale;
+		float clipTime;
+	};
+
+	// pipelines are created against renderPass, meshes sample texture
+	SkinnedRenderer(Device& device, VkRenderPass renderPass, JobSystem& jobs, VkImageView texture, VkSampler sampler);
+	~SkinnedRenderer();
+
+	SkinnedRenderer(const SkinnedRenderer&) = delete;
+	SkinnedRenderer& operator=(const SkinnedRenderer&) = delete;
+
+	// samples and skins every instance into this frame's bone buffer
+	void prepare(int frameIndex, const std::vector<Instance>& instances, FrameArena& arena);
+	void draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProj);
+	// points this frame's descriptor set at another texture, for when the old one is unloaded
+	// the fence for frameIndex has to have been waited on
+	void setTexture(int frameIndex, VkImageView texture, FrameArena& arena);
+	// logs the pose evaluation cost about once per second
+	void report(double now);
+
+private:
+	struct Draw {
+		const SkinnedMesh* mesh;
+		glm::vec3 translation;
+		float scale;
+		uint32_t boneOffset;
+	};
+
+	Device& device;
+	JobSystem& jobs;
+	VkImageView texture;
+	VkSampler sampler;
+
+	std::unique_ptr<DescriptorSetLayout> setLayout;
+	std::unique_ptr<DescriptorPool> descriptorPool;
+	std::array<VkDescriptorSet, Swapchain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+	std::array<std::unique_ptr<Buffer>, Swapchain::MAX_FRAMES_IN_FLIGHT> boneBuffers;
+	VkPipelineLayout pipelineLayout;
+	std::unique_ptr<Pipeline> pipeline;
+
+	std::vector<Draw> draws;
+	int frameIndex = 0;
+
+	const bool measure = Settings::settings.value("measure_skinning", false);
+	uint32_t samples = 0;
+	uint32_t sampledBones = 0;
+	double sumMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	double lastReport = 0.0;
+
+	void createBoneBuffer(int index, uint32_t capacity);
+	void createDescriptors();
+	void createPipelineLayout();
+	void createPipeline(VkRenderPass renderPass);
+};
@@ -1,80 +1,59 @@
 #include "sprite.h"
 
-#include <cassert>
-#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
 
-Sprite::Sprite(Device& device, 
-	const std::vector<Vertex>& vertices,
-	const std::vector<uint32_t>& indices) : device{ device } {
-	createVertexBuffers(vertices);
-	createIndexBuffers(indices);
-}
+#include "log.h"
 
-Sprite::~Sprite() {}
-
-void Sprite::createVertexBuffers(const std::vector<Vertex>& vertices) {
-	vertexCount = static_cast<uint32_t>(vertices.size());
-	assert(vertexCount >= 3 && "Vertex count must be at least 3");
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-	uint32_t vertexSize = sizeof(vertices[0]);
-	Buffer stagingBuffer{
-		device,
-		vertexSize,
-		vertexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
-
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void*)vertices.data());
-
-	vertexBuffer = std::make_unique<Buffer>(
-		device,
-		vertexSize,
-		vertexCount,
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-	);
-	device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
-}
-
-void Sprite::createIndexBuffers(const std::vector<uint32_t>& indices) {
-	indexCount = static_cast<uint32_t>(indices.size());
-
-	VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-	uint32_t indexSize = sizeof(indices[0]);
-	Buffer stagingBuffer{
-		device,
-		indexSize,
-		indexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
-
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void*)indices.data());
-
-	indexBuffer = std::make_unique<Buffer>(
-		device,
-		indexSize,
-		indexCount,
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-	);
-	device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+#include <cassert>
+#include <cmath>
+#include <cstring>
 
+//packed sizes are part of the vertex layout contract
+static_assert(sizeof(Sprite::Vertex) == 12, "Sprite::Vertex must stay tightly packed");
+static_assert(sizeof(Sprite::Instance) == 28, "Sprite::Instance must stay tightly packed");
+
+//the full float layouts these formats replaced
+struct FloatVertex { glm::vec2 position; glm::vec3 color; glm::vec2 texCoord; };
+struct PreviousInstance { glm::vec2 translation; glm::vec2 scale; float rotation; glm::vec4 uvRect; glm::vec4 color; };
+static_assert(sizeof(PreviousInstance) == Sprite::PREVIOUS_INSTANCE_SIZE, "Sprite::PREVIOUS_INSTANCE_SIZE is out of date");
+
+Sprite::Vertex Sprite::Vertex::pack(glm::vec2 position, glm::vec4 color, glm::vec2 texCoord) {
+	Vertex vertex{};
+	vertex.position = glm::packHalf2x16(position);
+	vertex.color = glm::packUnorm4x8(color);
+	vertex.texCoord = glm::packUnorm2x16(texCoord);
+	return vertex;
 }
 
-void Sprite::draw(VkCommandBuffer commandBuffer) {
-	//vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
-	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+Sprite::Instance Sprite::Instance::pack(glm::vec3 translation, glm::vec2 scale, float radians, glm::vec4 uvRect, glm::vec4 color,
+	uint32_t clip, float startTime, float speed) {
+	assert(clip <= NO_CLIP && "Animation clip id does not fit 16 bits");
+	Instance instance{};
+	instance.translation = { translation.x, translation.y };
+	float turns = radians / glm::two_pi<float>();
+	uint32_t rotation = static_cast<uint32_t>(std::lround((turns - std::floor(turns)) * 32768.0f)) & 0x7FFF;
+	instance.depthRotation = glm::packUnorm1x16(translation.z) | (rotation << 16);
+	instance.scale = glm::packHalf2x16(scale);
+	instance.color = glm::packUnorm4x8(color);
+	if (clip == NO_CLIP) {
+		instance.image[0] = glm::packUnorm2x16({ uvRect.x, uvRect.y });
+		instance.image[1] = glm::packUnorm2x16({ uvRect.z, uvRect.w });
+	}
+	else {
+		instance.depthRotation |= ANIMATED_BIT;
+		instance.image[0] = clip | (glm::packHalf2x16({ speed, 0.0f }) << 16);
+		std::memcpy(&instance.image[1], &startTime, sizeof(float));
+	}
+	return instance;
 }
 
-void Sprite::bind(VkCommandBuffer commandBuffer) {
-	VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+void Sprite::logFormatSizes() {
+	LOG_DEBUG("Sprite vertex {} bytes (full float {}), index {} bytes (was {}), instance {} bytes (was {}, {}% smaller)",
+		sizeof(Vertex), sizeof(FloatVertex),
+		sizeof(uint16_t), sizeof(uint32_t),
+		sizeof(Instance), PREVIOUS_INSTANCE_SIZE,
+		100 * (PREVIOUS_INSTANCE_SIZE - sizeof(Instance)) / PREVIOUS_INSTANCE_SIZE);
 }
 
 std::vector<VkVertexInputBindingDescription> Sprite::Vertex::getBindingDescriptions() {
@@ -89,18 +68,56 @@ std::vector<VkVertexInputAttributeDescription> Sprite::Vertex::getAttributeDescr
 	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
 	attributeDescriptions[0].binding = 0;
 	attributeDescriptions[0].location = 0;
-	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[0].format = VK_FORMAT_R16G16_SFLOAT;
 	attributeDescriptions[0].offset = offsetof(Vertex, position);
 
 	attributeDescriptions[1].binding = 0;
 	attributeDescriptions[1].location = 1;
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+	attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
 	attributeDescriptions[1].offset = offsetof(Vertex, color);
 
 	attributeDescriptions[2].binding = 0;
 	attributeDescriptions[2].location = 2;
-	attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[2].format = VK_FORMAT_R16G16_UNORM;
 	attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
 
 	return attributeDescriptions;
 }
+
+std::vector<VkVertexInputBindingDescription> Sprite::Instance::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(Instance);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> Sprite::Instance::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[0].offset = offsetof(Instance, translation);
+
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R32_UINT;
+	attributeDescriptions[1].offset = offsetof(Instance, depthRotation);
+
+	attributeDescriptions[2].binding = 0;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+	attributeDescriptions[2].offset = offsetof(Instance, scale);
+
+	attributeDescriptions[3].binding = 0;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[3].offset = offsetof(Instance, color);
+
+	attributeDescriptions[4].binding = 0;
+	attributeDescriptions[4].location = 4;
+	attributeDescriptions[4].format = VK_FORMAT_R32G32_UINT;
+	attributeDescriptions[4].offset = offsetof(Instance, image);
+
+	return attributeDescriptions;
+}
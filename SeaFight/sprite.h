@@ -1,7 +1,6 @@
-#pragma once 
+#pragma once
 
 #include "device.h"
-#include "buffer.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -9,34 +8,63 @@
 
 #include <vector>
 
+// a region of the sprite texture
+// sprites have no geometry of their own, the vertex shader builds the quad corners from
+// gl_VertexIndex and reads everything else from the per instance data
 class Sprite {
 public:
+	// vertex format for geometry baked on the cpu, eg tilemap chunks
+	// 12 bytes, positions are half floats so they should be kept local to the mesh origin
 	struct Vertex {
-		glm::vec2 position;
-		glm::vec3 color;
-		glm::vec2 texCoord;
+		uint32_t position;	// half2
+		uint32_t color;		// rgba8 unorm
+		uint32_t texCoord;	// unorm16x2
 
+		static Vertex pack(glm::vec2 position, glm::vec4 color, glm::vec2 texCoord);
 		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 	};
 
-	Sprite(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-	~Sprite();
+	// clip id of sprites that show their uv rect instead of an animation
+	static constexpr uint32_t NO_CLIP = 0xFFFF;
+
+	// set in Instance::depthRotation when image holds an animation instead of a uv rect
+	static constexpr uint32_t ANIMATED_BIT = 0x80000000u;
+
+	// per instance data for one drawn sprite, 28 bytes
+	// translation stays full float since it is in world space, the rest is packed. a sprite
+	// shows either its uv rect or a frame of its animation clip, so the two share image
+	struct Instance {
+		glm::vec2 translation;
+		uint32_t depthRotation;	// unorm16 depth low, rotation as a 15 bit fraction of a turn above it, then ANIMATED_BIT
+		uint32_t scale;		// half2
+		uint32_t color;		// rgba8 unorm
+		// unorm16x2 uv offset and size, or clip id low 16 bits and half float speed high 16
+		// followed by the float start time, in the same clock as the ubo time
+		uint32_t image[2];
+
+		static Instance pack(glm::vec3 translation, glm::vec2 scale, float radians, glm::vec4 uvRect, glm::vec4 color,
+			uint32_t clip = NO_CLIP, float startTime = 0.0f, float speed = 1.0f);
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	// bytes of the full float instance this replaced, what the packed upload is compared against
+	static constexpr size_t PREVIOUS_INSTANCE_SIZE = 52;
+
+	// every sprite quad is two triangles generated in the vertex shader
+	static constexpr uint32_t QUAD_VERTEX_COUNT = 6;
+
+	// logs the packed formats against the layouts they replaced
+	static void logFormatSizes();
+
+	Sprite(glm::vec4 uvRect = { 0.0f, 0.0f, 1.0f, 1.0f }) : uvRect{ uvRect } {}
 
 	Sprite(const Sprite&) = delete;
 	Sprite& operator=(const Sprite&) = delete;
 
-	void bind(VkCommandBuffer commandBuffer);
-	void draw(VkCommandBuffer commandBuffer);
+	glm::vec4 getUVRect() const { return uvRect; }
 
 private:
-	Device& device;
-
-	std::unique_ptr<Buffer> vertexBuffer;
-	uint32_t vertexCount;
-	std::unique_ptr<Buffer> indexBuffer;
-	uint32_t indexCount;
-
-	void createVertexBuffers(const std::vector<Vertex>& vertices);
-	void createIndexBuffers(const std::vector<uint32_t>& indices);
-};
\ No newline at end of file
+	glm::vec4 uvRect;
+};
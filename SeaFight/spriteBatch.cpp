@@ -0,0 +1,83 @@
+#include "spriteBatch.h"
+
+#include "log.h"
+
+#include <cassert>
+#include <chrono>
+
+SpriteBatch::SpriteBatch(Device& device, uint32_t initialCapacity) : device{ device } {
+	for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+		createInstanceBuffer(i, initialCapacity);
+	}
+	instances.reserve(initialCapacity);
+}
+
+SpriteBatch::~SpriteBatch() {}
+
+void SpriteBatch::createInstanceBuffer(int index, uint32_t capacity) {
+	instanceBuffers[index] = std::make_unique<Buffer>(
+		device,
+		sizeof(Sprite::Instance),
+		capacity,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	instanceBuffers[index]->map();
+}
+
+void SpriteBatch::begin(int index) {
+	assert(index >= 0 && index < Swapchain::MAX_FRAMES_IN_FLIGHT && "Invalid frame index");
+	frameIndex = index;
+	instances.clear();
+}
+
+void SpriteBatch::upload() {
+	if (instances.empty()) return;
+
+	//the fence for this frame has been waited on, so its buffer is free to replace
+	uint32_t count = size();
+	if (count > instanceBuffers[frameIndex]->getInstanceCount()) {
+		uint32_t capacity = instanceBuffers[frameIndex]->getInstanceCount();
+		while (capacity < count) capacity *= 2;
+		createInstanceBuffer(frameIndex, capacity);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	instanceBuffers[frameIndex]->writeToBuffer(instances.data(), sizeof(Sprite::Instance) * count);
+
+	if (measure) {
+		uploads++;
+		uploadedInstances += count;
+		sumMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+void SpriteBatch::draw(VkCommandBuffer commandBuffer, uint32_t firstInstance, uint32_t instanceCount) {
+	if (instanceCount == 0) return;
+	assert(firstInstance + instanceCount <= size() && "Sprite batch range out of bounds");
+
+	//rebound for every range since other geometry may have been drawn in between
+	VkBuffer buffers[] = { instanceBuffers[frameIndex]->getBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+	vkCmdDraw(commandBuffer, Sprite::QUAD_VERTEX_COUNT, instanceCount, 0, firstInstance);
+}
+
+void SpriteBatch::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	double seconds = now - lastReport;
+	lastReport = now;
+
+	if (uploads > 0) {
+		//the copy goes straight into host coherent memory, so its rate is what the bus sees
+		double bytes = static_cast<double>(uploadedInstances) * sizeof(Sprite::Instance);
+		double previousBytes = static_cast<double>(uploadedInstances) * Sprite::PREVIOUS_INSTANCE_SIZE;
+		LOG_INFO("Sprite upload {} instances/frame: {:.1f}KB/frame, {:.2f}MB/s, the previous layout would be {:.1f}KB/frame, {:.2f}MB/s. copy avg {:.3f}ms at {:.2f}GB/s",
+			uploadedInstances / uploads, bytes / uploads / 1024.0, bytes / seconds / (1024.0 * 1024.0),
+			previousBytes / uploads / 1024.0, previousBytes / seconds / (1024.0 * 1024.0),
+			sumMilliseconds / uploads, sumMilliseconds > 0.0 ? bytes / (sumMilliseconds / 1000.0) / 1e9 : 0.0);
+	}
+	uploads = 0;
+	uploadedInstances = 0;
+	sumMilliseconds = 0.0;
+}
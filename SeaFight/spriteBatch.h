@@ -0,0 +1,51 @@
+#pragma once
+
+#include "device.h"
+#include "buffer.h"
+#include "sprite.h"
+#include "swapchain.h"
+#include "utils.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// collects every sprite drawn in a frame into one instance stream
+// each frame in flight owns a persistently mapped instance buffer, so the whole batch is
+// a single memcpy and a single instanced draw with no per sprite binds
+class SpriteBatch {
+public:
+	SpriteBatch(Device& device, uint32_t initialCapacity = 1024);
+	~SpriteBatch();
+
+	SpriteBatch(const SpriteBatch&) = delete;
+	SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+	// clears the batch, frameIndex selects which instance buffer gets written
+	void begin(int frameIndex);
+	void add(const Sprite::Instance& instance) { instances.push_back(instance); }
+	uint32_t size() const { return static_cast<uint32_t>(instances.size()); }
+
+	// copies the batch into this frame's instance buffer, call once per frame after the last add
+	void upload();
+	// binds the instance stream and draws a range of the uploaded instances
+	// expects a pipeline using Sprite::Instance to be bound
+	void draw(VkCommandBuffer commandBuffer, uint32_t firstInstance, uint32_t instanceCount);
+	// logs the bytes and copy time of the instance uploads about once per second
+	void report(double now);
+
+private:
+	Device& device;
+
+	std::array<std::unique_ptr<Buffer>, Swapchain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+	std::vector<Sprite::Instance> instances;
+	int frameIndex = 0;
+
+	const bool measure = Settings::settings.value("measure_sprite_upload", false);
+	uint32_t uploads = 0;
+	uint64_t uploadedInstances = 0;
+	double sumMilliseconds = 0.0;
+	double lastReport = 0.0;
+
+	void createInstanceBuffer(int index, uint32_t capacity);
+};
@@ -1,5 +1,7 @@
 #include "swapchain.h"
 
+#include "log.h"
+
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -23,9 +25,46 @@ void Swapchain::init() {
 	createSwapchain();
 	createImageViews();
 	createRenderPass();
-	createDepthResources();
-	createFramebuffers();
 	createSyncObjects();
+	loadDisplayTiming();
+}
+
+void Swapchain::loadDisplayTiming() {
+	if (!device.displayTimingEnabled) return;
+
+	getRefreshCycleDuration = reinterpret_cast<PFN_vkGetRefreshCycleDurationGOOGLE>(
+		vkGetDeviceProcAddr(device.device(), "vkGetRefreshCycleDurationGOOGLE"));
+	getPastPresentationTiming = reinterpret_cast<PFN_vkGetPastPresentationTimingGOOGLE>(
+		vkGetDeviceProcAddr(device.device(), "vkGetPastPresentationTimingGOOGLE"));
+	if (getRefreshCycleDuration == nullptr || getPastPresentationTiming == nullptr) {
+		LOG_WARN("Display timing enabled but its functions could not be loaded");
+		getRefreshCycleDuration = nullptr;
+		getPastPresentationTiming = nullptr;
+	}
+}
+
+bool Swapchain::getRefreshDuration(uint64_t& nanoseconds) {
+	if (!supportsDisplayTiming()) return false;
+
+	VkRefreshCycleDurationGOOGLE refresh{};
+	if (getRefreshCycleDuration(device.device(), swapchain, &refresh) != VK_SUCCESS) return false;
+	nanoseconds = refresh.refreshDuration;
+	return nanoseconds > 0;
+}
+
+bool Swapchain::getPastPresentationTimings(std::vector<VkPastPresentationTimingGOOGLE>& timings) {
+	if (!supportsDisplayTiming()) return false;
+
+	uint32_t count = 0;
+	if (getPastPresentationTiming(device.device(), swapchain, &count, nullptr) != VK_SUCCESS) return false;
+	if (count == 0) return true;
+
+	size_t first = timings.size();
+	timings.resize(first + count);
+	VkResult result = getPastPresentationTiming(device.device(), swapchain, &count, timings.data() + first);
+	//VK_INCOMPLETE only means more finished in between, they are picked up next call
+	timings.resize(first + count);
+	return result == VK_SUCCESS || result == VK_INCOMPLETE;
 }
 
 Swapchain::~Swapchain() {
@@ -39,20 +78,10 @@ Swapchain::~Swapchain() {
 		swapchain = nullptr;
 	}
 
-	for (int i = 0; i < depthImages.size(); i++) {
-		vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-		vkDestroyImage(device.device(), depthImages[i], nullptr);
-		vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
-	}
-
-	for (auto framebuffer : swapchainFramebuffers) {
-		vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-	}
-
 	vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
-	// cleanup synchronization objects
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+	// cleanup synchronization objects, empty if a newer swapchain took them over
+	for (size_t i = 0; i < inFlightFences.size(); i++) {
 		vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
 		vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
 		vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -78,7 +107,8 @@ VkResult Swapchain::acquireNextImage(uint32_t* imageIndex) {
 	return result;
 }
 
-VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
+VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex,
+	const VkPresentTimeGOOGLE* presentTime) {
 	if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
 		vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
 	}
@@ -103,7 +133,7 @@ VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 	vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
 	if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
 		VK_SUCCESS) {
-		spdlog::critical("Failed to submit draw command buffer!");
+		LOG_CRITICAL("Failed to submit draw command buffer!");
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
 
@@ -119,6 +149,14 @@ VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 
 	presentInfo.pImageIndices = imageIndex;
 
+	VkPresentTimesInfoGOOGLE presentTimes{};
+	if (presentTime != nullptr && supportsDisplayTiming()) {
+		presentTimes.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+		presentTimes.swapchainCount = 1;
+		presentTimes.pTimes = presentTime;
+		presentInfo.pNext = &presentTimes;
+	}
+
 	auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
 	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -149,6 +187,11 @@ void Swapchain::createSwapchain() {
 	createInfo.imageExtent = extent;
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	//lets a lower resolution render target be blitted straight onto the swapchain image
+	if (swapchainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) {
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	}
+	swapchainUsage = createInfo.imageUsage;
 
 	QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
 	uint32_t queueFamilyIndices[] = { indices.graphicsFamily, indices.presentFamily };
@@ -173,7 +216,7 @@ void Swapchain::createSwapchain() {
 	createInfo.oldSwapchain = oldSwapchain == nullptr ? VK_NULL_HANDLE : oldSwapchain->swapchain;
 
 	if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapchain) != VK_SUCCESS) {
-		spdlog::critical("Failed to create swap chain!");
+		LOG_CRITICAL("Failed to create swap chain!");
 		throw std::runtime_error("Failed to create swap chain!");
 	}
 
@@ -205,15 +248,17 @@ void Swapchain::createImageViews() {
 
 		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &swapchainImageViews[i]) !=
 			VK_SUCCESS) {
-			spdlog::critical("Failed to create texture image view!");
+			LOG_CRITICAL("Failed to create texture image view!");
 			throw std::runtime_error("Failed to create texture image view!");
 		}
 	}
 }
 
 void Swapchain::createRenderPass() {
+	swapchainDepthFormat = findDepthFormat();
+
 	VkAttachmentDescription depthAttachment{};
-	depthAttachment.format = findDepthFormat();
+	depthAttachment.format = swapchainDepthFormat;
 	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -268,92 +313,27 @@ void Swapchain::createRenderPass() {
 	renderPassInfo.pDependencies = &dependency;
 
 	if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-		spdlog::critical("Failed to create render pass!");
+		LOG_CRITICAL("Failed to create render pass!");
 		throw std::runtime_error("Failed to create render pass!");
 	}
 }
 
-void Swapchain::createFramebuffers() {
-	swapchainFramebuffers.resize(imageCount());
-	for (size_t i = 0; i < imageCount(); i++) {
-		std::array<VkImageView, 2> attachments = { swapchainImageViews[i], depthImageViews[i] };
-
-		VkExtent2D swapchainExtent = getSwapChainExtent();
-		VkFramebufferCreateInfo framebufferInfo = {};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = renderPass;
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		framebufferInfo.pAttachments = attachments.data();
-		framebufferInfo.width = swapchainExtent.width;
-		framebufferInfo.height = swapchainExtent.height;
-		framebufferInfo.layers = 1;
-
-		if (vkCreateFramebuffer(
-			device.device(),
-			&framebufferInfo,
-			nullptr,
-			&swapchainFramebuffers[i]) != VK_SUCCESS) {
-			spdlog::critical("Failed to create framebuffer!");
-			throw std::runtime_error("Failed to create framebuffer!");
-		}
-	}
-}
-
-void Swapchain::createDepthResources() {
-	VkFormat depthFormat = findDepthFormat();
-	swapchainDepthFormat = depthFormat;
-	VkExtent2D swapchainExtent = getSwapChainExtent();
-
-	depthImages.resize(imageCount());
-	depthImageMemorys.resize(imageCount());
-	depthImageViews.resize(imageCount());
-
-	for (int i = 0; i < depthImages.size(); i++) {
-		VkImageCreateInfo imageInfo{};
-		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = swapchainExtent.width;
-		imageInfo.extent.height = swapchainExtent.height;
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
-		imageInfo.arrayLayers = 1;
-		imageInfo.format = depthFormat;
-		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		imageInfo.flags = 0;
-
-		device.createImageWithInfo(
-			imageInfo,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			depthImages[i],
-			depthImageMemorys[i]);
-
-		VkImageViewCreateInfo viewInfo{};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.image = depthImages[i];
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = depthFormat;
-		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-
-		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
-			spdlog::critical("Failed to create texture image view!");
-			throw std::runtime_error("Failed to create texture image view!");
-		}
+void Swapchain::createSyncObjects() {
+	imagesInFlight.assign(imageCount(), VK_NULL_HANDLE);
+
+	//frames in flight keep their fences and semaphores across recreation, so frames submitted
+	//to the old swapchain can still be waited on without idling the device
+	if (oldSwapchain != nullptr) {
+		imageAvailableSemaphores.swap(oldSwapchain->imageAvailableSemaphores);
+		renderFinishedSemaphores.swap(oldSwapchain->renderFinishedSemaphores);
+		inFlightFences.swap(oldSwapchain->inFlightFences);
+		currentFrame = oldSwapchain->currentFrame;
+		return;
 	}
-}
 
-void Swapchain::createSyncObjects() {
 	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-	imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
 	VkSemaphoreCreateInfo semaphoreInfo = {};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -368,7 +348,7 @@ void Swapchain::createSyncObjects() {
 			vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
 			VK_SUCCESS ||
 			vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-			spdlog::critical("Failed to create synchronization objects for a frame!");
+			LOG_CRITICAL("Failed to create synchronization objects for a frame!");
 			throw std::runtime_error("Failed to create synchronization objects for a frame!");
 		}
 	}
@@ -390,12 +370,12 @@ VkPresentModeKHR Swapchain::chooseSwapPresentMode(
 	const std::vector<VkPresentModeKHR>& availablePresentModes) {
 	for (const auto& availablePresentMode : availablePresentModes) {
 		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-			spdlog::debug("Present Mode: Mailbox");
+			LOG_DEBUG("Present Mode: Mailbox");
 			return availablePresentMode;
 		}
 	}
 
-	spdlog::debug("Present Mode: V-Sync");
+	LOG_DEBUG("Present Mode: V-Sync");
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -20,12 +20,14 @@ public:
 	Swapchain(const Swapchain&) = delete;
 	Swapchain& operator=(const Swapchain&) = delete;
 
-	VkFramebuffer getFrameBuffer(int index) { return swapchainFramebuffers[index]; }
+	// pipelines are created against this render pass, the frame graph builds compatible ones
 	VkRenderPass getRenderPass() { return renderPass; }
 	VkImageView getImageView(int index) { return swapchainImageViews[index]; }
+	VkImage getImage(int index) { return swapchainImages[index]; }
 	size_t imageCount() { return swapchainImages.size(); }
 	VkFormat getSwapChainImageFormat() { return swapchainImageFormat; }
 	VkExtent2D getSwapChainExtent() { return swapchainExtent; }
+	VkImageUsageFlags getSwapChainUsage() { return swapchainUsage; }
 	uint32_t width() { return swapchainExtent.width; }
 	uint32_t height() { return swapchainExtent.height; }
 
@@ -39,19 +41,25 @@ public:
 	VkFormat findDepthFormat();
 
 	VkResult acquireNextImage(uint32_t* imageIndex);
-	VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+	// presentTime asks the presentation engine to hold the image until a given time,
+	// it is ignored without display timing support
+	VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex,
+		const VkPresentTimeGOOGLE* presentTime = nullptr);
+
+	// display timing queries, these return false when the extension isn't enabled
+	bool supportsDisplayTiming() const { return getRefreshCycleDuration != nullptr; }
+	bool getRefreshDuration(uint64_t& nanoseconds);
+	// appends the timings of presents that completed since the last call
+	bool getPastPresentationTimings(std::vector<VkPastPresentationTimingGOOGLE>& timings);
 
 private:
 	VkFormat swapchainImageFormat;
 	VkFormat swapchainDepthFormat;
 	VkExtent2D swapchainExtent;
+	VkImageUsageFlags swapchainUsage;
 
-	std::vector<VkFramebuffer> swapchainFramebuffers;
 	VkRenderPass renderPass;
 
-	std::vector<VkImage> depthImages;
-	std::vector<VkDeviceMemory> depthImageMemorys;
-	std::vector<VkImageView> depthImageViews;
 	std::vector<VkImage> swapchainImages;
 	std::vector<VkImageView> swapchainImageViews;
 
@@ -67,14 +75,16 @@ private:
 	std::vector<VkFence> imagesInFlight;
 	size_t currentFrame = 0;
 
+	PFN_vkGetRefreshCycleDurationGOOGLE getRefreshCycleDuration = nullptr;
+	PFN_vkGetPastPresentationTimingGOOGLE getPastPresentationTiming = nullptr;
+
 	//main functions
 	void init();
 	void createSwapchain();
 	void createImageViews();
-	void createDepthResources();
 	void createRenderPass();
-	void createFramebuffers();
 	void createSyncObjects();
+	void loadDisplayTiming();
 
 	// Helper functions
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -0,0 +1,320 @@
+#include "swarm.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SWARM_SSE 1
+#endif
+
+static constexpr uint32_t PADDING = 3;
+
+#ifdef SWARM_SSE
+static float horizontalSum(__m128 value) {
+	__m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(value, shuffled);
+	shuffled = _mm_movehl_ps(shuffled, sums);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+#endif
+
+Swarm::Swarm(const Params& params) : params{ params } {
+	//cells as wide as the neighbour radius, so the 3x3 around an agent covers its whole radius
+	cellSize = params.neighbourRadius;
+	gridOrigin = glm::vec2(-params.extent);
+	gridWidth = std::max(1, static_cast<int>(std::ceil(2.0f * params.extent / cellSize)));
+	gridHeight = gridWidth;
+	cellStart.resize(static_cast<size_t>(gridWidth) * gridHeight + 1);
+	resizeArrays();
+}
+
+void Swarm::resizeArrays() {
+	size_t size = count + PADDING;
+	for (auto* array : { &posX, &posY, &velX, &velY, &sortedPosX, &sortedPosY, &sortedVelX, &sortedVelY, &accelX, &accelY }) {
+		array->resize(size, 0.0f);
+	}
+	ids.resize(size, 0);
+	sortedIds.resize(size, 0);
+	cellOf.resize(size, 0);
+}
+
+uint32_t Swarm::add(glm::vec2 position, glm::vec2 velocity) {
+	uint32_t index = count++;
+	resizeArrays();
+	posX[index] = position.x;
+	posY[index] = position.y;
+	velX[index] = velocity.x;
+	velY[index] = velocity.y;
+	ids[index] = index;
+	return index;
+}
+
+int Swarm::cellX(float x) const {
+	return std::clamp(static_cast<int>((x - gridOrigin.x) / cellSize), 0, gridWidth - 1);
+}
+
+int Swarm::cellY(float y) const {
+	return std::clamp(static_cast<int>((y - gridOrigin.y) / cellSize), 0, gridHeight - 1);
+}
+
+void Swarm::buildGrid() {
+	//counting sort by cell, agents of a cell and of a row of cells end up contiguous
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+	for (uint32_t i = 0; i < count; i++) {
+		cellOf[i] = static_cast<uint32_t>(cellY(posY[i]) * gridWidth + cellX(posX[i]));
+		cellStart[cellOf[i] + 1]++;
+	}
+	for (size_t cell = 1; cell < cellStart.size(); cell++) {
+		cellStart[cell] += cellStart[cell - 1];
+	}
+
+	//cellOf doubles as the write cursor, it isn't needed after the scatter
+	std::vector<uint32_t>& cursor = cellOf;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t target = cellStart[cursor[i]]++;
+		sortedPosX[target] = posX[i];
+		sortedPosY[target] = posY[i];
+		sortedVelX[target] = velX[i];
+		sortedVelY[target] = velY[i];
+		sortedIds[target] = ids[i];
+	}
+	//the scatter advanced every start to the next cell's, shift them back
+	for (size_t cell = cellStart.size() - 1; cell > 0; cell--) {
+		cellStart[cell] = cellStart[cell - 1];
+	}
+	cellStart[0] = 0;
+
+	posX.swap(sortedPosX);
+	posY.swap(sortedPosY);
+	velX.swap(sortedVelX);
+	velY.swap(sortedVelY);
+	ids.swap(sortedIds);
+}
+
+void Swarm::steer(uint32_t begin, uint32_t end) {
+	const float radiusSquared = params.neighbourRadius * params.neighbourRadius;
+
+	for (uint32_t i = begin; i < end; i++) {
+		float px = posX[i];
+		float py = posY[i];
+		int cx = cellX(px);
+		int cy = cellY(py);
+		int x0 = std::max(cx - 1, 0);
+		int x1 = std::min(cx + 1, gridWidth - 1);
+
+		float separationX = 0.0f, separationY = 0.0f;
+		float velocitySumX = 0.0f, velocitySumY = 0.0f;
+		float positionSumX = 0.0f, positionSumY = 0.0f;
+		float neighbours = 0.0f;
+
+		for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, gridHeight - 1); y++) {
+			uint32_t first = cellStart[y * gridWidth + x0];
+			uint32_t last = cellStart[y * gridWidth + x1 + 1];
+#ifdef SWARM_SSE
+			const __m128 selfX = _mm_set1_ps(px);
+			const __m128 selfY = _mm_set1_ps(py);
+			const __m128 radius = _mm_set1_ps(radiusSquared);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+			const __m128i limit = _mm_set1_epi32(static_cast<int>(last));
+			__m128 sepX = zero, sepY = zero, velSumX = zero, velSumY = zero, posSumX = zero, posSumY = zero, found = zero;
+
+			for (uint32_t j = first; j < last; j += 4) {
+				__m128 otherX = _mm_loadu_ps(&posX[j]);
+				__m128 otherY = _mm_loadu_ps(&posY[j]);
+				__m128 dx = _mm_sub_ps(otherX, selfX);
+				__m128 dy = _mm_sub_ps(otherY, selfY);
+				__m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+				//in radius, not the agent itself, and not past the end of the run
+				__m128i index = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(j)), lanes);
+				__m128 mask = _mm_and_ps(_mm_cmplt_ps(distanceSquared, radius), _mm_cmpgt_ps(distanceSquared, zero));
+				mask = _mm_and_ps(mask, _mm_castsi128_ps(_mm_cmplt_epi32(index, limit)));
+
+				//masked lanes divide by one instead of zero
+				__m128 inverse = _mm_and_ps(mask, _mm_div_ps(one, _mm_or_ps(_mm_and_ps(mask, distanceSquared), _mm_andnot_ps(mask, one))));
+				sepX = _mm_sub_ps(sepX, _mm_mul_ps(dx, inverse));
+				sepY = _mm_sub_ps(sepY, _mm_mul_ps(dy, inverse));
+				velSumX = _mm_add_ps(velSumX, _mm_and_ps(mask, _mm_loadu_ps(&velX[j])));
+				velSumY = _mm_add_ps(velSumY, _mm_and_ps(mask, _mm_loadu_ps(&velY[j])));
+				posSumX = _mm_add_ps(posSumX, _mm_and_ps(mask, otherX));
+				posSumY = _mm_add_ps(posSumY, _mm_and_ps(mask, otherY));
+				found = _mm_add_ps(found, _mm_and_ps(mask, one));
+			}
+
+			separationX += horizontalSum(sepX);
+			separationY += horizontalSum(sepY);
+			velocitySumX += horizontalSum(velSumX);
+			velocitySumY += horizontalSum(velSumY);
+			positionSumX += horizontalSum(posSumX);
+			positionSumY += horizontalSum(posSumY);
+			neighbours += horizontalSum(found);
+#else
+			for (uint32_t j = first; j < last; j++) {
+				float dx = posX[j] - px;
+				float dy = posY[j] - py;
+				float distanceSquared = dx * dx + dy * dy;
+				if (distanceSquared >= radiusSquared || distanceSquared <= 0.0f) continue;
+
+				separationX -= dx / distanceSquared;
+				separationY -= dy / distanceSquared;
+				velocitySumX += velX[j];
+				velocitySumY += velY[j];
+				positionSumX += posX[j];
+				positionSumY += posY[j];
+				neighbours += 1.0f;
+			}
+#endif
+		}
+
+		//every term is scaled to be around maxSpeed per second at full strength
+		glm::vec2 force{ 0.0f };
+		glm::vec2 velocity{ velX[i], velY[i] };
+		if (neighbours > 0.0f) {
+			glm::vec2 averageVelocity = glm::vec2(velocitySumX, velocitySumY) / neighbours;
+			glm::vec2 center = glm::vec2(positionSumX, positionSumY) / neighbours;
+			force += glm::vec2(separationX, separationY) * (params.neighbourRadius * params.separationWeight * params.maxSpeed / neighbours);
+			force += (averageVelocity - velocity) * params.alignmentWeight;
+			force += (center - glm::vec2(px, py)) * (params.cohesionWeight * params.maxSpeed / params.neighbourRadius);
+		}
+
+		//one lookup per agent, however many are heading for the goal
+		if (flowField) {
+			glm::vec2 desired = flowField->getDirection({ px, py }) * params.maxSpeed;
+			force += (desired - velocity) * params.goalWeight;
+		}
+
+		//obstacles push harder the deeper an agent gets into their margin
+		glm::vec2 position{ px, py };
+		for (const Obstacle& obstacle : obstacles) {
+			glm::vec2 away = position - obstacle.center;
+			float reach = obstacle.radius + params.neighbourRadius;
+			float distanceSquared = glm::dot(away, away);
+			if (distanceSquared < reach * reach && distanceSquared > 0.0f) {
+				float distance = std::sqrt(distanceSquared);
+				force += away / distance * ((1.0f - distance / reach) * params.avoidanceWeight * params.maxSpeed);
+			}
+		}
+		//the arena edge works the same way
+		float edge = params.extent - params.neighbourRadius;
+		force.x -= std::max(px - edge, 0.0f) / params.neighbourRadius * params.avoidanceWeight * params.maxSpeed;
+		force.x += std::max(-edge - px, 0.0f) / params.neighbourRadius * params.avoidanceWeight * params.maxSpeed;
+		force.y -= std::max(py - edge, 0.0f) / params.neighbourRadius * params.avoidanceWeight * params.maxSpeed;
+		force.y += std::max(-edge - py, 0.0f) / params.neighbourRadius * params.avoidanceWeight * params.maxSpeed;
+
+		float length = glm::length(force);
+		if (length > params.maxForce) {
+			force *= params.maxForce / length;
+		}
+		accelX[i] = force.x;
+		accelY[i] = force.y;
+	}
+}
+
+void Swarm::integrate(uint32_t begin, uint32_t end, float dt) {
+	uint32_t i = begin;
+#ifdef SWARM_SSE
+	const __m128 step = _mm_set1_ps(dt);
+	const __m128 minSpeedSquared = _mm_set1_ps(params.minSpeed * params.minSpeed);
+	const __m128 maxSpeedSquared = _mm_set1_ps(params.maxSpeed * params.maxSpeed);
+	const __m128 tiny = _mm_set1_ps(1e-12f);
+	//whole groups of four only, a batch's last partial group would overlap the next batch
+	for (; i + 4 <= end; i += 4) {
+		__m128 vx = _mm_add_ps(_mm_loadu_ps(&velX[i]), _mm_mul_ps(_mm_loadu_ps(&accelX[i]), step));
+		__m128 vy = _mm_add_ps(_mm_loadu_ps(&velY[i]), _mm_mul_ps(_mm_loadu_ps(&accelY[i]), step));
+
+		//scale by the clamped speed over the speed, the squares save a sqrt
+		__m128 speedSquared = _mm_max_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), tiny);
+		__m128 clampedSquared = _mm_min_ps(_mm_max_ps(speedSquared, minSpeedSquared), maxSpeedSquared);
+		__m128 scale = _mm_sqrt_ps(_mm_div_ps(clampedSquared, speedSquared));
+		vx = _mm_mul_ps(vx, scale);
+		vy = _mm_mul_ps(vy, scale);
+
+		_mm_storeu_ps(&velX[i], vx);
+		_mm_storeu_ps(&velY[i], vy);
+		_mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, step)));
+		_mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, step)));
+	}
+#endif
+	for (; i < end; i++) {
+		glm::vec2 velocity = glm::vec2(velX[i], velY[i]) + glm::vec2(accelX[i], accelY[i]) * dt;
+		float speed = std::max(glm::length(velocity), 1e-6f);
+		velocity *= std::clamp(speed, params.minSpeed, params.maxSpeed) / speed;
+		velX[i] = velocity.x;
+		velY[i] = velocity.y;
+		posX[i] += velocity.x * dt;
+		posY[i] += velocity.y * dt;
+	}
+}
+
+void Swarm::update(JobSystem& jobs, float dt) {
+	if (count == 0) return;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	buildGrid();
+	//every agent reads the others' positions, so all steering finishes before anyone moves
+	jobs.parallelFor(count, 256, [&](uint32_t begin, uint32_t end) { steer(begin, end); });
+	jobs.parallelFor(count, 1024, [&](uint32_t begin, uint32_t end) { integrate(begin, end, dt); });
+
+	if (measure) {
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		sumMilliseconds += milliseconds;
+		maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+		workers = jobs.getWorkerCount() + 1;
+		samples++;
+	}
+}
+
+void Swarm::report(double now) {
+	if (!measure || now - lastReport < 1.0) return;
+	lastReport = now;
+
+	if (samples > 0) {
+		LOG_INFO("Swarm {} agents on {} threads: avg {:.3f}ms max {:.3f}ms per update",
+			count, workers, sumMilliseconds / samples, maxMilliseconds);
+	}
+	samples = 0;
+	sumMilliseconds = maxMilliseconds = 0.0;
+}
+
+void Swarm::benchmark(JobSystem& jobs) {
+	using Clock = std::chrono::high_resolution_clock;
+	const float dt = 1.0f / 120.0f;
+	//about fifteen agents inside everyone's radius, whatever the swarm size
+	Params params{};
+	const float density = 15.0f / (3.14159265f * params.neighbourRadius * params.neighbourRadius);
+
+	for (uint32_t agents : { 1000u, 10000u, 50000u }) {
+		params.extent = std::sqrt(agents / density) * 0.5f;
+		Swarm swarm{ params };
+		uint32_t random = 2463534242u;
+		auto next = [&]() {
+			random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+			return (random >> 8) / 16777216.0f * 2.0f - 1.0f;
+		};
+		for (uint32_t i = 0; i < agents; i++) {
+			swarm.add(glm::vec2(next(), next()) * params.extent, glm::vec2(next(), next()) * params.maxSpeed);
+		}
+
+		for (int i = 0; i < 10; i++) {
+			swarm.update(jobs, dt);
+		}
+		const int ticks = 120;
+		double maxMilliseconds = 0.0, sumMilliseconds = 0.0;
+		for (int i = 0; i < ticks; i++) {
+			auto start = Clock::now();
+			swarm.update(jobs, dt);
+			double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			sumMilliseconds += milliseconds;
+			maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+		}
+
+		LOG_INFO("Swarm benchmark: {} agents on {} threads, avg {:.3f}ms max {:.3f}ms per tick ({:.1f}% of the 120Hz tick)",
+			agents, jobs.getWorkerCount() + 1, sumMilliseconds / ticks, maxMilliseconds, sumMilliseconds / ticks / (1000.0 * dt) * 100.0);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "flowField.h"
+#include "jobSystem.h"
+#include "utils.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// boids steered by separation, alignment, cohesion and obstacle avoidance
+// agents live in structure of arrays form and are counting sorted into a uniform grid of
+// neighbour radius sized cells every tick, so an agent's neighbours are three contiguous
+// runs of the arrays (one per row of the 3x3 cells around it), scanned four at a time with
+// sse. steering and integration are split into batches across the job system
+class Swarm {
+public:
+	struct Params {
+		float neighbourRadius = 0.08f;
+		float separationWeight = 1.5f;
+		float alignmentWeight = 1.0f;
+		float cohesionWeight = 1.5f;
+		float avoidanceWeight = 6.0f;
+		// pull towards the flow field's direction, when one is set
+		float goalWeight = 1.0f;
+		// speeds are clamped to [minSpeed, maxSpeed], without a floor the forces cancel out to a standstill
+		float minSpeed = 0.15f;
+		float maxSpeed = 0.4f;
+		float maxForce = 1.5f;
+		// agents are kept inside [-extent, extent]
+		float extent = 1.0f;
+	};
+
+	struct Obstacle {
+		glm::vec2 center;
+		float radius;
+	};
+
+	Swarm(const Params& params);
+
+	// returns the agent's id, ids stay with agents while the arrays get reordered
+	uint32_t add(glm::vec2 position, glm::vec2 velocity);
+	void setObstacles(const std::vector<Obstacle>& obstacles) { this->obstacles = obstacles; }
+	// the whole swarm heads for the field's goal, null lets it wander
+	void setFlowField(std::shared_ptr<const FlowField> field) { flowField = std::move(field); }
+
+	void update(JobSystem& jobs, float dt);
+	// logs update timings once a second when measure_swarm is set
+	void report(double now);
+
+	// agents by index, in whatever order the last update sorted them into
+	uint32_t size() const { return count; }
+	uint32_t getId(uint32_t index) const { return ids[index]; }
+	glm::vec2 getPosition(uint32_t index) const { return { posX[index], posY[index] }; }
+	glm::vec2 getVelocity(uint32_t index) const { return { velX[index], velY[index] }; }
+
+	// milliseconds per update for growing swarms at constant density, against the 120Hz budget
+	static void benchmark(JobSystem& jobs);
+
+private:
+	Params params;
+	uint32_t count = 0;
+
+	// sized count + 3 so four wide loads never run off the end
+	std::vector<float> posX, posY, velX, velY;
+	std::vector<uint32_t> ids;
+	std::vector<float> sortedPosX, sortedPosY, sortedVelX, sortedVelY;
+	std::vector<uint32_t> sortedIds;
+	std::vector<float> accelX, accelY;
+
+	float cellSize = 1.0f;
+	glm::vec2 gridOrigin{ 0.0f };
+	int gridWidth = 1;
+	int gridHeight = 1;
+	std::vector<uint32_t> cellOf;
+	// agents of cell c are [cellStart[c], cellStart[c + 1])
+	std::vector<uint32_t> cellStart;
+
+	std::vector<Obstacle> obstacles;
+	std::shared_ptr<const FlowField> flowField;
+
+	const bool measure = Settings::settings.value("measure_swarm", false);
+	uint32_t samples = 0;
+	uint32_t workers = 0;
+	double sumMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	double lastReport = 0.0;
+
+	void resizeArrays();
+	int cellX(float x) const;
+	int cellY(float y) const;
+	void buildGrid();
+	void steer(uint32_t begin, uint32_t end);
+	void integrate(uint32_t begin, uint32_t end, float dt);
+};
@@ -0,0 +1,318 @@
+#include "textRenderer.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "log.h"
+
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+static_assert(sizeof(TextRenderer::Instance) == 32, "TextRenderer::Instance must stay tightly packed");
+
+struct TextPushConstants {
+	glm::mat4 world;
+	glm::mat4 screen;
+};
+
+TextRenderer::TextRenderer(Device& device, VkRenderPass renderPass, uint32_t initialCapacity)
+	: device{ device }, font{ device } {
+	for (int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+		createInstanceBuffer(i, initialCapacity);
+	}
+	instances.reserve(initialCapacity);
+
+	createDescriptors();
+	createPipelineLayout();
+	createPipeline(renderPass);
+}
+
+TextRenderer::~TextRenderer() {
+	vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+	vkDestroySampler(device.device(), sampler, nullptr);
+}
+
+void TextRenderer::createInstanceBuffer(int index, uint32_t capacity) {
+	instanceBuffers[index] = std::make_unique<Buffer>(
+		device,
+		sizeof(Instance),
+		capacity,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	instanceBuffers[index]->map();
+}
+
+void TextRenderer::createDescriptors() {
+	//the distance field is interpolated, so linear filtering is what keeps edges smooth
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create font sampler!");
+		throw std::runtime_error("Failed to create font sampler!");
+	}
+
+	setLayout = DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.build();
+	descriptorPool = DescriptorPool::Builder(device)
+		.setMaxSets(1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+		.build();
+
+	//the atlas never changes, so one set serves every frame
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = font.getAtlasView();
+	imageInfo.sampler = sampler;
+	DescriptorWriter(*setLayout, *descriptorPool)
+		.writeImage(0, &imageInfo)
+		.build(descriptorSet);
+}
+
+void TextRenderer::createPipelineLayout() {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(TextPushConstants);
+
+	VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		LOG_CRITICAL("Failed to create text pipeline layout!");
+		throw std::runtime_error("Failed to create text pipeline layout!");
+	}
+}
+
+void TextRenderer::createPipeline(VkRenderPass renderPass) {
+	//text goes on top of the scene, blended and ignoring depth
+	PipelineConfigInfo pipelineConfig{};
+	Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+	pipelineConfig.renderPass = renderPass;
+	pipelineConfig.pipelineLayout = pipelineLayout;
+	pipelineConfig.bindingDescriptions = Instance::getBindingDescriptions();
+	pipelineConfig.attributeDescriptions = Instance::getAttributeDescriptions();
+	pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+	pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+	pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	pipelineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	pipeline = std::make_unique<Pipeline>(
+		device,
+		"res/shaders/text.vert.spv",
+		"res/shaders/text.frag.spv",
+		pipelineConfig);
+}
+
+const TextRenderer::TextLayout& TextRenderer::getLayout(const std::string& text) {
+	auto cached = layoutCache.find(text);
+	if (cached != layoutCache.end()) return cached->second;
+
+	TextLayout& layout = layoutCache[text];
+	glm::vec2 pen{ 0.0f };
+	int lines = 1;
+	for (char c : text) {
+		if (c == '\n') {
+			pen = { 0.0f, pen.y + font.getLineHeight() };
+			lines++;
+			continue;
+		}
+		if (c != ' ') {
+			Font::GlyphQuad glyph = font.getGlyph(c);
+			glyph.offset += pen;
+			layout.glyphs.push_back(glyph);
+		}
+		pen.x += font.getAdvance();
+		//the last advance includes spacing after the glyph, which isn't part of the text
+		layout.extent.x = std::max(layout.extent.x, pen.x - font.getAdvance() + static_cast<float>(Font::GLYPH_WIDTH) / Font::GLYPH_HEIGHT);
+	}
+	layout.extent.y = (lines - 1) * font.getLineHeight() + 1.0f;
+	return layout;
+}
+
+void TextRenderer::begin(int index) {
+	assert(index >= 0 && index < Swapchain::MAX_FRAMES_IN_FLIGHT && "Invalid frame index");
+	frameIndex = index;
+	instances.clear();
+}
+
+void TextRenderer::addGlyph(const Font::GlyphQuad& glyph, glm::vec2 origin, const TextStyle& style) {
+	Instance instance{};
+	instance.position = origin + glyph.offset * style.size;
+	instance.size = glm::packHalf2x16(glyph.size * style.size);
+	instance.uvOffset = glm::packUnorm2x16({ glyph.uvRect.x, glyph.uvRect.y });
+	instance.uvSize = glm::packUnorm2x16({ glyph.uvRect.z, glyph.uvRect.w });
+	instance.color = glm::packUnorm4x8(style.color);
+	instance.outlineColor = glm::packUnorm4x8(style.outline);
+	instance.space = static_cast<uint32_t>(style.space);
+	instances.push_back(instance);
+}
+
+void TextRenderer::addText(const TextLayout& layout, glm::vec2 position, const TextStyle& style) {
+	glm::vec2 origin = position - style.anchor * layout.extent * style.size;
+	for (const Font::GlyphQuad& glyph : layout.glyphs) {
+		addGlyph(glyph, origin, style);
+	}
+}
+
+void TextRenderer::addNumber(int value, glm::vec2 position, const TextStyle& style) {
+	char digits[16];
+	int count = std::snprintf(digits, sizeof(digits), "%d", value);
+	if (count <= 0) return;
+
+	float advance = font.getAdvance() * style.size;
+	glm::vec2 extent{
+		(count - 1) * font.getAdvance() + static_cast<float>(Font::GLYPH_WIDTH) / Font::GLYPH_HEIGHT,
+		1.0f };
+	glm::vec2 origin = position - style.anchor * extent * style.size;
+	for (int i = 0; i < count; i++) {
+		addGlyph(font.getGlyph(digits[i]), origin, style);
+		origin.x += advance;
+	}
+}
+
+void TextRenderer::upload() {
+	if (instances.empty()) return;
+
+	//the fence for this frame has been waited on, so its buffer is free to replace
+	uint32_t count = size();
+	if (count > instanceBuffers[frameIndex]->getInstanceCount()) {
+		uint32_t capacity = instanceBuffers[frameIndex]->getInstanceCount();
+		while (capacity < count) capacity *= 2;
+		createInstanceBuffer(frameIndex, capacity);
+	}
+
+	instanceBuffers[frameIndex]->writeToBuffer(instances.data(), sizeof(Instance) * count);
+}
+
+void TextRenderer::draw(VkCommandBuffer commandBuffer, const glm::mat4& worldTransform, VkExtent2D screenExtent) {
+	if (instances.empty()) return;
+
+	pipeline->bind(commandBuffer);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipelineLayout,
+		0,
+		1,
+		&descriptorSet,
+		0,
+		nullptr);
+
+	//y down to match vulkan clip space, so screen text lays out like world text
+	TextPushConstants push{};
+	push.world = worldTransform;
+	push.screen = glm::ortho(0.0f, static_cast<float>(screenExtent.width), 0.0f, static_cast<float>(screenExtent.height));
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(TextPushConstants), &push);
+
+	VkBuffer buffers[] = { instanceBuffers[frameIndex]->getBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	vkCmdDraw(commandBuffer, 6, size(), 0, 0);
+}
+
+std::vector<VkVertexInputBindingDescription> TextRenderer::Instance::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(Instance);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> TextRenderer::Instance::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(7);
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributeDescriptions[0].offset = offsetof(Instance, position);
+
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+	attributeDescriptions[1].offset = offsetof(Instance, size);
+
+	attributeDescriptions[2].binding = 0;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R16G16_UNORM;
+	attributeDescriptions[2].offset = offsetof(Instance, uvOffset);
+
+	attributeDescriptions[3].binding = 0;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R16G16_UNORM;
+	attributeDescriptions[3].offset = offsetof(Instance, uvSize);
+
+	attributeDescriptions[4].binding = 0;
+	attributeDescriptions[4].location = 4;
+	attributeDescriptions[4].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[4].offset = offsetof(Instance, color);
+
+	attributeDescriptions[5].binding = 0;
+	attributeDescriptions[5].location = 5;
+	attributeDescriptions[5].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributeDescriptions[5].offset = offsetof(Instance, outlineColor);
+
+	attributeDescriptions[6].binding = 0;
+	attributeDescriptions[6].location = 6;
+	attributeDescriptions[6].format = VK_FORMAT_R32_UINT;
+	attributeDescriptions[6].offset = offsetof(Instance, space);
+
+	return attributeDescriptions;
+}
+
+void FloatingNumbers::spawn(glm::vec2 position, int value, glm::vec4 color) {
+	//a little sideways spread keeps numbers from the same spot readable
+	float drift = static_cast<float>(static_cast<int>(numbers.size() * 37 % 11) - 5) * 0.02f;
+	numbers.push_back({ position, { drift, -0.4f }, color, 0.0f, value });
+}
+
+void FloatingNumbers::update(float deltaTime) {
+	for (size_t i = 0; i < numbers.size();) {
+		Number& number = numbers[i];
+		number.age += deltaTime;
+		if (number.age >= LIFETIME) {
+			//order doesn't matter, so removal is a swap with the last one
+			number = numbers.back();
+			numbers.pop_back();
+			continue;
+		}
+		number.position += number.velocity * deltaTime;
+		number.velocity *= 1.0f - 2.0f * deltaTime;
+		i++;
+	}
+}
+
+void FloatingNumbers::draw(TextRenderer& text) const {
+	TextRenderer::TextStyle style{};
+	style.space = TextRenderer::Space::World;
+	style.anchor = { 0.5f, 0.5f };
+	for (const Number& number : numbers) {
+		//hold full opacity for the first half, then fade out
+		float fade = glm::clamp(2.0f - 2.0f * number.age / LIFETIME, 0.0f, 1.0f);
+		style.size = SIZE * (1.0f + 0.5f * glm::max(0.0f, 0.2f - number.age) / 0.2f);
+		style.color = number.color * glm::vec4(1.0f, 1.0f, 1.0f, fade);
+		style.outline = { 0.0f, 0.0f, 0.0f, fade };
+		text.addNumber(number.value, number.position, style);
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "font.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// draws all text of a frame with a single instanced draw
+// every glyph is one instance carrying its own quad, uv rect and colors, and the vertex
+// shader expands it. text is either placed in the world (damage numbers) or on screen in
+// pixels (hud), the two transforms are push constants so both share the draw
+class TextRenderer {
+public:
+	enum class Space : uint32_t { World = 0, Screen = 1 };
+
+	struct Instance {
+		glm::vec2 position;
+		uint32_t size;				// half2, quad size in units of the space
+		uint32_t uvOffset;			// unorm16x2
+		uint32_t uvSize;			// unorm16x2
+		uint32_t color;				// rgba8
+		uint32_t outlineColor;		// rgba8
+		uint32_t space;
+
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	struct TextStyle {
+		// cap height, in world units or pixels depending on space
+		float size = 16.0f;
+		glm::vec4 color{ 1.0f };
+		glm::vec4 outline{ 0.0f, 0.0f, 0.0f, 1.0f };
+		Space space = Space::Screen;
+		// point of the text box placed at the position, {0.5, 0.5} centers it
+		glm::vec2 anchor{ 0.0f };
+	};
+
+	// glyph quads of a string laid out once, in units of the cap height
+	struct TextLayout {
+		std::vector<Font::GlyphQuad> glyphs;
+		glm::vec2 extent{ 0.0f };
+	};
+
+	// pipelines are created against renderPass
+	TextRenderer(Device& device, VkRenderPass renderPass, uint32_t initialCapacity = 1024);
+	~TextRenderer();
+
+	TextRenderer(const TextRenderer&) = delete;
+	TextRenderer& operator=(const TextRenderer&) = delete;
+
+	// laid out on first use and cached, meant for strings that don't change every frame
+	const TextLayout& getLayout(const std::string& text);
+
+	// clears the batch, frameIndex selects which instance buffer gets written
+	void begin(int frameIndex);
+	void addText(const TextLayout& layout, glm::vec2 position, const TextStyle& style);
+	void addText(const std::string& text, glm::vec2 position, const TextStyle& style) {
+		addText(getLayout(text), position, style);
+	}
+	// lays the digits out directly, numbers change too often to be worth caching
+	void addNumber(int value, glm::vec2 position, const TextStyle& style);
+	uint32_t size() const { return static_cast<uint32_t>(instances.size()); }
+
+	// copies the batch into this frame's instance buffer, call once per frame after the last add
+	void upload();
+	// draws every glyph added this frame, screen positions are pixels of screenExtent
+	void draw(VkCommandBuffer commandBuffer, const glm::mat4& worldTransform, VkExtent2D screenExtent);
+
+private:
+	Device& device;
+	Font font;
+
+	std::unique_ptr<DescriptorSetLayout> setLayout;
+	std::unique_ptr<DescriptorPool> descriptorPool;
+	VkDescriptorSet descriptorSet;
+	VkSampler sampler;
+	VkPipelineLayout pipelineLayout;
+	std::unique_ptr<Pipeline> pipeline;
+
+	std::array<std::unique_ptr<Buffer>, Swapchain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+	std::vector<Instance> instances;
+	int frameIndex = 0;
+
+	std::unordered_map<std::string, TextLayout> layoutCache;
+
+	void addGlyph(const Font::GlyphQuad& glyph, glm::vec2 origin, const TextStyle& style);
+	void createInstanceBuffer(int index, uint32_t capacity);
+	void createDescriptors();
+	void createPipelineLayout();
+	void createPipeline(VkRenderPass renderPass);
+};
+
+// numbers that drift up and fade out, eg damage dealt. they live in world space and are
+// only simulated here, drawing adds them to the frame's text batch
+class FloatingNumbers {
+public:
+	void spawn(glm::vec2 position, int value, glm::vec4 color);
+	void update(float deltaTime);
+	void draw(TextRenderer& text) const;
+
+	size_t size() const { return numbers.size(); }
+
+private:
+	struct Number {
+		glm::vec2 position;
+		glm::vec2 velocity;
+		glm::vec4 color;
+		float age;
+		int value;
+	};
+
+	static constexpr float LIFETIME = 1.0f;
+	static constexpr float SIZE = 0.05f;
+
+	std::vector<Number> numbers;
+};
@@ -1,11 +1,14 @@
 #include "texture.h"
 
+#include "log.h"
+
 #include <iterator>
 
 #include "spdlog/spdlog.h"
 #include "stb_image.h"
 
 #include "device.h"
+#include "layoutTransition.h"
 
 
 Texture::~Texture() {
@@ -20,9 +23,14 @@ void Texture::createTexture(std::string filepath) {
     VkDeviceSize imageSize = texWidth * texHeight * 4;
 
     if (!pixels) {
-        spdlog::critical("Failed to load texture image {}", filepath);
+        LOG_CRITICAL("Failed to load texture image {}", filepath);
     }
 
+    uploadPixels(pixels, imageSize, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    stbi_image_free(pixels);
+}
+
+void Texture::uploadPixels(const void* pixels, VkDeviceSize imageSize, uint32_t width, uint32_t height) {
     //TODO: reworkd to use buffer class
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
@@ -37,10 +45,9 @@ void Texture::createTexture(std::string filepath) {
         memcpy(data, pixels, static_cast<size_t>(imageSize));
     vkUnmapMemory(device.device(), stagingBufferMemory);
 
-    stbi_image_free(pixels);
-    createImage(texWidth, 
-        texHeight, 
-        VK_FORMAT_R8G8B8A8_SRGB, 
+    createImage(width, 
+        height, 
+        format, 
         VK_IMAGE_TILING_OPTIMAL, 
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
@@ -51,13 +58,13 @@ void Texture::createTexture(std::string filepath) {
 
 
 	transitionImageLayout(textureImage, 
-        VK_FORMAT_R8G8B8A8_SRGB, 
+        format, 
         1,
         VK_IMAGE_LAYOUT_UNDEFINED, 
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    device.copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
+    device.copyBufferToImage(stagingBuffer, textureImage, width, height, 1);
     transitionImageLayout(textureImage, 
-        VK_FORMAT_R8G8B8A8_SRGB, 
+        format, 
         1,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -96,7 +103,7 @@ void Texture::createImage(uint32_t width,
     }
 
     if (vkCreateImage(device.device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
-        spdlog::critical("Failed to create image");
+        LOG_CRITICAL("Failed to create image");
     }
 
     VkMemoryRequirements memRequirements;
@@ -120,52 +127,11 @@ void Texture::transitionImageLayout(VkImage image,
         VkImageLayout oldLayout, 
         VkImageLayout newLayout) {
 	VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = arrayLayers;
-
-	VkPipelineStageFlags sourceStage;
-	VkPipelineStageFlags destinationStage;
-
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	} else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	} else {
-		spdlog::critical("Unsupported layout transition");
-	}
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		sourceStage, destinationStage,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
-
+	recordLayoutTransition(commandBuffer, image, format, arrayLayers, oldLayout, newLayout);
 	device.endSingleTimeCommands(commandBuffer);
 }
 void Texture::createTextureImageView(uint32_t arrayLayers, VkImageViewType imageViewType) {
-	textureImageView = createImageView(textureImage, arrayLayers, imageViewType, VK_FORMAT_R8G8B8A8_SRGB);
+	textureImageView = createImageView(textureImage, arrayLayers, imageViewType, format);
 }
 
 VkImageView Texture::createImageView(VkImage image, 
@@ -176,7 +142,7 @@ VkImageView Texture::createImageView(VkImage image,
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewInfo.image = textureImage;
 	viewInfo.viewType = imageViewType;
-	viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+	viewInfo.format = format;
 	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = 1;
@@ -185,7 +151,7 @@ VkImageView Texture::createImageView(VkImage image,
 
 	VkImageView imageView;
 	if (vkCreateImageView(device.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
-		spdlog::critical("Failed to create texture image view");
+		LOG_CRITICAL("Failed to create texture image view");
 	}
 	return imageView;
 }
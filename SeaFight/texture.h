@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
@@ -13,6 +15,12 @@ public:
 		createTexture(filepath);
 		createTextureImageView(1, VK_IMAGE_VIEW_TYPE_2D);
 	};
+	// texture generated at runtime, pixels are tightly packed rows of format
+	Texture(Device& device, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, VkFormat format)
+		: device{ device }, format{ format } {
+		uploadPixels(pixels.data(), pixels.size(), width, height);
+		createTextureImageView(1, VK_IMAGE_VIEW_TYPE_2D);
+	}
 	~Texture();
 
 	VkImageView getImageView() {
@@ -27,8 +35,10 @@ private:
 	VkDeviceMemory stagingBufferMemory;
 
 	VkImageView textureImageView;
+	VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
 
 	void createTexture(std::string filepath);
+	void uploadPixels(const void* pixels, VkDeviceSize imageSize, uint32_t width, uint32_t height);
 	void createTextureImageView(uint32_t arrayLayers, VkImageViewType imageViewType);
 
 	void createImage(uint32_t width, 
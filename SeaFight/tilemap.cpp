@@ -0,0 +1,235 @@
+#include "tilemap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+#include "log.h"
+
+Tilemap::Tilemap(Device& device,
+	DeletionQueue& deletionQueue,
+	int width,
+	int height,
+	float tileSize,
+	glm::vec2 origin,
+	int atlasColumns,
+	int atlasRows)
+	: device{ device },
+	deletionQueue{ deletionQueue },
+	width{ width },
+	height{ height },
+	tileSize{ tileSize },
+	origin{ origin },
+	atlasColumns{ atlasColumns },
+	atlasRows{ atlasRows } {
+	assert(width > 0 && height > 0 && "Tilemap must have at least one tile");
+	assert(atlasColumns > 0 && atlasRows > 0 && "Tile atlas must have at least one cell");
+
+	chunksX = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	chunksY = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	tiles.resize(static_cast<size_t>(width) * height, EMPTY_TILE);
+	chunks.resize(static_cast<size_t>(chunksX) * chunksY);
+}
+
+Tilemap::~Tilemap() {}
+
+void Tilemap::setTile(int x, int y, tile_t tile) {
+	assert(x >= 0 && x < width && y >= 0 && y < height && "Tile out of range");
+
+	tile_t& current = tiles[static_cast<size_t>(y) * width + x];
+	if (current == tile) return;
+	current = tile;
+	markDirty((y / CHUNK_SIZE) * chunksX + x / CHUNK_SIZE);
+}
+
+Tilemap::tile_t Tilemap::getTile(int x, int y) const {
+	if (x < 0 || x >= width || y < 0 || y >= height) {
+		return EMPTY_TILE;
+	}
+	return tiles[static_cast<size_t>(y) * width + x];
+}
+
+void Tilemap::fill(tile_t tile) {
+	std::fill(tiles.begin(), tiles.end(), tile);
+	for (int i = 0; i < static_cast<int>(chunks.size()); i++) {
+		markDirty(i);
+	}
+}
+
+void Tilemap::markDirty(int chunkIndex) {
+	Chunk& chunk = chunks[chunkIndex];
+	if (chunk.dirty) return;
+	chunk.dirty = true;
+	dirtyChunks.push_back(chunkIndex);
+}
+
+void Tilemap::retire(std::unique_ptr<Buffer>& buffer) {
+	if (!buffer) return;
+	//std::function has to be copyable, so the deleter holds a shared pointer
+	std::shared_ptr<Buffer> retired = std::move(buffer);
+	deletionQueue.push([retired]() mutable { retired.reset(); });
+}
+
+glm::vec2 Tilemap::chunkOrigin(int chunkIndex) const {
+	glm::vec2 chunk{ chunkIndex % chunksX, chunkIndex / chunksX };
+	return origin + chunk * (CHUNK_SIZE * tileSize);
+}
+
+void Tilemap::bakeChunk(int chunkIndex,
+	std::vector<Sprite::Vertex>& vertices,
+	std::vector<uint16_t>& indices) const {
+	vertices.clear();
+	indices.clear();
+
+	int startX = (chunkIndex % chunksX) * CHUNK_SIZE;
+	int startY = (chunkIndex / chunksX) * CHUNK_SIZE;
+	int endX = std::min(startX + CHUNK_SIZE, width);
+	int endY = std::min(startY + CHUNK_SIZE, height);
+
+	glm::vec2 cellUV{ 1.0f / atlasColumns, 1.0f / atlasRows };
+	const glm::vec4 white{ 1.0f, 1.0f, 1.0f, 1.0f };
+
+	for (int y = startY; y < endY; y++) {
+		for (int x = startX; x < endX; x++) {
+			tile_t tile = tiles[static_cast<size_t>(y) * width + x];
+			if (tile == EMPTY_TILE) continue;
+
+			int cell = tile - 1;
+			glm::vec2 uvMin{ (cell % atlasColumns) * cellUV.x, (cell / atlasColumns) * cellUV.y };
+			glm::vec2 uvMax = uvMin + cellUV;
+			glm::vec2 min = glm::vec2{ x - startX, y - startY } * tileSize;
+			glm::vec2 max = min + glm::vec2{ tileSize, tileSize };
+
+			uint16_t base = static_cast<uint16_t>(vertices.size());
+			vertices.push_back(Sprite::Vertex::pack({ min.x, min.y }, white, { uvMin.x, uvMin.y }));
+			vertices.push_back(Sprite::Vertex::pack({ max.x, min.y }, white, { uvMax.x, uvMin.y }));
+			vertices.push_back(Sprite::Vertex::pack({ max.x, max.y }, white, { uvMax.x, uvMax.y }));
+			vertices.push_back(Sprite::Vertex::pack({ min.x, max.y }, white, { uvMin.x, uvMax.y }));
+
+			uint16_t quad[] = {
+				base,
+				static_cast<uint16_t>(base + 1),
+				static_cast<uint16_t>(base + 2),
+				static_cast<uint16_t>(base + 2),
+				static_cast<uint16_t>(base + 3),
+				base };
+			indices.insert(indices.end(), std::begin(quad), std::end(quad));
+		}
+	}
+}
+
+void Tilemap::update(VkCommandBuffer commandBuffer) {
+	if (dirtyChunks.empty()) return;
+
+	//staging buffers are read by this frame's copies, so they go once it has completed
+	auto stagingBuffers = std::make_shared<std::vector<std::unique_ptr<Buffer>>>();
+	std::vector<Sprite::Vertex> vertices;
+	std::vector<uint16_t> indices;
+
+	for (int chunkIndex : dirtyChunks) {
+		Chunk& chunk = chunks[chunkIndex];
+		chunk.dirty = false;
+
+		bakeChunk(chunkIndex, vertices, indices);
+		chunk.indexCount = static_cast<uint32_t>(indices.size());
+		//only frames already submitted draw the old buffers, this one draws the new ones
+		retire(chunk.vertexBuffer);
+		retire(chunk.indexBuffer);
+		if (indices.empty()) continue;
+
+		uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		auto vertexStaging = std::make_unique<Buffer>(
+			device,
+			sizeof(Sprite::Vertex),
+			vertexCount,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vertexStaging->map();
+		vertexStaging->writeToBuffer(vertices.data());
+
+		auto indexStaging = std::make_unique<Buffer>(
+			device,
+			sizeof(uint16_t),
+			chunk.indexCount,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		indexStaging->map();
+		indexStaging->writeToBuffer(indices.data());
+
+		chunk.vertexBuffer = std::make_unique<Buffer>(
+			device,
+			sizeof(Sprite::Vertex),
+			vertexCount,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		chunk.indexBuffer = std::make_unique<Buffer>(
+			device,
+			sizeof(uint16_t),
+			chunk.indexCount,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkBufferCopy vertexCopy{};
+		vertexCopy.size = vertexStaging->getBufferSize();
+		vkCmdCopyBuffer(commandBuffer, vertexStaging->getBuffer(), chunk.vertexBuffer->getBuffer(), 1, &vertexCopy);
+		VkBufferCopy indexCopy{};
+		indexCopy.size = indexStaging->getBufferSize();
+		vkCmdCopyBuffer(commandBuffer, indexStaging->getBuffer(), chunk.indexBuffer->getBuffer(), 1, &indexCopy);
+
+		stagingBuffers->push_back(std::move(vertexStaging));
+		stagingBuffers->push_back(std::move(indexStaging));
+	}
+	deletionQueue.pushAfterCurrentFrame([stagingBuffers]() mutable { stagingBuffers.reset(); });
+
+	//the copies have to land before the frame's draws read the chunks
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0,
+		1,
+		&barrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
+	LOG_DEBUG("Tilemap rebuilt {} chunks", dirtyChunks.size());
+	dirtyChunks.clear();
+}
+
+uint32_t Tilemap::draw(VkCommandBuffer commandBuffer,
+	glm::vec2 viewMin,
+	glm::vec2 viewMax,
+	const std::function<void(glm::vec2 chunkOrigin)>& pushChunkOrigin) {
+	float chunkExtent = CHUNK_SIZE * tileSize;
+
+	//only walk the chunk range that overlaps the view
+	int firstX = std::max(0, static_cast<int>(std::floor((viewMin.x - origin.x) / chunkExtent)));
+	int firstY = std::max(0, static_cast<int>(std::floor((viewMin.y - origin.y) / chunkExtent)));
+	int lastX = std::min(chunksX - 1, static_cast<int>(std::floor((viewMax.x - origin.x) / chunkExtent)));
+	int lastY = std::min(chunksY - 1, static_cast<int>(std::floor((viewMax.y - origin.y) / chunkExtent)));
+
+	uint32_t drawCount = 0;
+	for (int cy = firstY; cy <= lastY; cy++) {
+		for (int cx = firstX; cx <= lastX; cx++) {
+			int chunkIndex = cy * chunksX + cx;
+			Chunk& chunk = chunks[chunkIndex];
+			if (chunk.indexCount == 0) continue;
+
+			pushChunkOrigin(chunkOrigin(chunkIndex));
+			VkBuffer buffers[] = { chunk.vertexBuffer->getBuffer() };
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, chunk.indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
+			vkCmdDrawIndexed(commandBuffer, chunk.indexCount, 1, 0, 0, 0);
+			drawCount++;
+		}
+	}
+	return drawCount;
+}
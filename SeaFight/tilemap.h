@@ -0,0 +1,93 @@
+#pragma once
+
+#include "device.h"
+#include "buffer.h"
+#include "deletionQueue.h"
+#include "sprite.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// static tile layer for large backgrounds like the ocean
+// tiles are grouped into square chunks and each chunk is baked into its own device local
+// vertex and index buffer, so a whole chunk draws with a single call and only the chunks
+// overlapping the camera are drawn. changing a tile only rebakes the chunk that holds it
+class Tilemap {
+public:
+	using tile_t = uint16_t;
+
+	// tile value for an empty cell, anything else is (atlas cell index + 1)
+	static constexpr tile_t EMPTY_TILE = 0;
+	static constexpr int CHUNK_SIZE = 32;
+
+	// chunks are indexed with 16 bit indices, so every vertex of a full chunk must be addressable
+	static_assert(CHUNK_SIZE * CHUNK_SIZE * 4 <= 65536, "Tilemap chunks are too large for 16 bit indices");
+
+	Tilemap(Device& device,
+		DeletionQueue& deletionQueue,
+		int width,
+		int height,
+		float tileSize,
+		glm::vec2 origin,
+		int atlasColumns,
+		int atlasRows);
+	~Tilemap();
+
+	Tilemap(const Tilemap&) = delete;
+	Tilemap& operator=(const Tilemap&) = delete;
+
+	void setTile(int x, int y, tile_t tile);
+	tile_t getTile(int x, int y) const;
+	void fill(tile_t tile);
+
+	// rebakes every chunk touched since the last call
+	// the uploads are recorded into the frame's command buffer, so this has to be called
+	// outside of a render pass and before the chunks are drawn. replaced buffers are retired
+	// through the deletion queue, frames in flight can still be drawing them
+	void update(VkCommandBuffer commandBuffer);
+
+	// draws every baked chunk overlapping the world space rect, returns the number of draw calls
+	// chunk vertices are local to the chunk, pushChunkOrigin is called before each draw so the
+	// caller can push the chunk's world space offset
+	uint32_t draw(VkCommandBuffer commandBuffer,
+		glm::vec2 viewMin,
+		glm::vec2 viewMax,
+		const std::function<void(glm::vec2 chunkOrigin)>& pushChunkOrigin);
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	struct Chunk {
+		std::unique_ptr<Buffer> vertexBuffer;
+		std::unique_ptr<Buffer> indexBuffer;
+		uint32_t indexCount = 0;
+		bool dirty = false;
+	};
+
+	Device& device;
+	DeletionQueue& deletionQueue;
+
+	int width;
+	int height;
+	float tileSize;
+	glm::vec2 origin;
+	int atlasColumns;
+	int atlasRows;
+
+	int chunksX;
+	int chunksY;
+	std::vector<tile_t> tiles;
+	std::vector<Chunk> chunks;
+	std::vector<int> dirtyChunks;
+
+	void markDirty(int chunkIndex);
+	void retire(std::unique_ptr<Buffer>& buffer);
+	glm::vec2 chunkOrigin(int chunkIndex) const;
+	void bakeChunk(int chunkIndex, std::vector<Sprite::Vertex>& vertices, std::vector<uint16_t>& indices) const;
+};
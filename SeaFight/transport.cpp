@@ -0,0 +1,73 @@
+#include "transport.h"
+
+#include <chrono>
+
+DelayLine::DelayLine(const LinkConditions& conditions, uint32_t seed)
+	: conditions{ conditions }, random{ seed != 0 ? seed : 1u } {}
+
+float DelayLine::nextRandom() {
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	return (random >> 8) / 16777216.0f;
+}
+
+double DelayLine::now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void DelayLine::push(const uint8_t* data, size_t size) {
+	sent++;
+	if (nextRandom() < conditions.loss) {
+		dropped++;
+		return;
+	}
+
+	Packet packet;
+	packet.deliverAt = now() + conditions.latency + conditions.jitter * nextRandom();
+	packet.data.assign(data, data + size);
+	packets.push_back(std::move(packet));
+}
+
+bool DelayLine::pop(std::vector<uint8_t>& packet) {
+	//only a handful of packets are ever in flight, a linear search is plenty
+	double time = now();
+	auto next = packets.end();
+	for (auto it = packets.begin(); it != packets.end(); ++it) {
+		if (it->deliverAt <= time && (next == packets.end() || it->deliverAt < next->deliverAt)) {
+			next = it;
+		}
+	}
+	if (next == packets.end()) return false;
+
+	packet = std::move(next->data);
+	packets.erase(next);
+	return true;
+}
+
+void LoopbackTransport::createPair(const LinkConditions& conditions, uint32_t seed,
+	std::unique_ptr<LoopbackTransport>& a, std::unique_ptr<LoopbackTransport>& b) {
+	auto toA = std::make_shared<DelayLine>(conditions, seed);
+	auto toB = std::make_shared<DelayLine>(conditions, seed * 2654435761u + 1u);
+	a.reset(new LoopbackTransport(toA, toB));
+	b.reset(new LoopbackTransport(toB, toA));
+}
+
+void LoopbackTransport::send(const uint8_t* data, size_t size) {
+	outgoing->push(data, size);
+}
+
+bool LoopbackTransport::receive(std::vector<uint8_t>& packet) {
+	return incoming->pop(packet);
+}
+
+void ImpairedTransport::send(const uint8_t* data, size_t size) {
+	outgoing.push(data, size);
+}
+
+bool ImpairedTransport::receive(std::vector<uint8_t>& packet) {
+	while (outgoing.pop(due)) {
+		inner.send(due.data(), due.size());
+	}
+	return inner.receive(packet);
+}
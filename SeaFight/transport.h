@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// unreliable datagram channel to one remote peer
+// packets may be lost, duplicated or arrive out of order, the protocol on top has to cope
+class Transport {
+public:
+	virtual ~Transport() = default;
+
+	virtual void send(const uint8_t* data, size_t size) = 0;
+	// pops the next packet that has arrived, returns false when there is none
+	virtual bool receive(std::vector<uint8_t>& packet) = 0;
+};
+
+// simulated network conditions for one direction of a link
+struct LinkConditions {
+	// one way, in seconds
+	double latency = 0.05;
+	// added on top of latency, uniformly random, so packets can overtake each other
+	double jitter = 0.01;
+	// fraction of packets dropped
+	float loss = 0.05f;
+};
+
+// packets held back until their simulated delivery time, some never arrive
+class DelayLine {
+public:
+	DelayLine(const LinkConditions& conditions, uint32_t seed);
+
+	void push(const uint8_t* data, size_t size);
+	// pops the earliest packet that is due
+	bool pop(std::vector<uint8_t>& packet);
+
+	uint64_t getSentCount() const { return sent; }
+	uint64_t getDroppedCount() const { return dropped; }
+
+private:
+	struct Packet {
+		double deliverAt;
+		std::vector<uint8_t> data;
+	};
+
+	LinkConditions conditions;
+	uint32_t random;
+	std::vector<Packet> packets;
+	uint64_t sent = 0;
+	uint64_t dropped = 0;
+
+	float nextRandom();
+	static double now();
+};
+
+// one end of an in process link, for exercising netcode without a network
+// both ends have to be used from the same thread
+class LoopbackTransport : public Transport {
+public:
+	// creates both ends of a link, conditions apply in both directions
+	static void createPair(const LinkConditions& conditions, uint32_t seed,
+		std::unique_ptr<LoopbackTransport>& a, std::unique_ptr<LoopbackTransport>& b);
+
+	void send(const uint8_t* data, size_t size) override;
+	bool receive(std::vector<uint8_t>& packet) override;
+
+	uint64_t getSentCount() const { return outgoing->getSentCount(); }
+	uint64_t getDroppedCount() const { return outgoing->getDroppedCount(); }
+
+private:
+	std::shared_ptr<DelayLine> incoming;
+	std::shared_ptr<DelayLine> outgoing;
+
+	LoopbackTransport(std::shared_ptr<DelayLine> incoming, std::shared_ptr<DelayLine> outgoing)
+		: incoming{ incoming }, outgoing{ outgoing } {}
+};
+
+// impairs the packets sent through another transport, eg a real socket on localhost
+// delayed packets are handed on from receive, so it has to be polled regularly
+class ImpairedTransport : public Transport {
+public:
+	ImpairedTransport(Transport& inner, const LinkConditions& conditions, uint32_t seed)
+		: inner{ inner }, outgoing{ conditions, seed } {}
+
+	void send(const uint8_t* data, size_t size) override;
+	bool receive(std::vector<uint8_t>& packet) override;
+
+private:
+	Transport& inner;
+	DelayLine outgoing;
+	std::vector<uint8_t> due;
+};
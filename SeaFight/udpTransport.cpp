@@ -0,0 +1,149 @@
+#include "udpTransport.h"
+
+#include "log.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using socklen_t = int;
+using NativeSocket = SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using NativeSocket = int;
+#endif
+
+static_assert(sizeof(sockaddr_in) <= 16, "Remote address storage is too small");
+
+#ifdef _WIN32
+//winsock is reference counted, every socket keeps it started
+static std::atomic<int> winsockUsers{ 0 };
+#endif
+
+UdpTransport::UdpTransport(uint16_t localPort, const std::string& remoteAddress, uint16_t remotePort) {
+#ifdef _WIN32
+	if (winsockUsers++ == 0) {
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+			winsockUsers--;
+			LOG_CRITICAL("Failed to start winsock!");
+			throw std::runtime_error("Failed to start winsock!");
+		}
+	}
+	SOCKET handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	bool invalid = handle == INVALID_SOCKET;
+#else
+	int handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	bool invalid = handle < 0;
+#endif
+	if (invalid) {
+#ifdef _WIN32
+		if (--winsockUsers == 0) {
+			WSACleanup();
+		}
+#endif
+		LOG_CRITICAL("Failed to create udp socket!");
+		throw std::runtime_error("Failed to create udp socket!");
+	}
+	socketHandle = static_cast<uintptr_t>(handle);
+
+	sockaddr_in local{};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localPort);
+	if (bind(handle, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+		closeSocket();
+		LOG_CRITICAL("Failed to bind udp port {}!", localPort);
+		throw std::runtime_error("Failed to bind udp port!");
+	}
+
+	//the game loop polls, it must never wait on the socket
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	bool failed = ioctlsocket(handle, FIONBIO, &nonBlocking) != 0;
+#else
+	bool failed = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) != 0;
+#endif
+	if (failed) {
+		closeSocket();
+		LOG_CRITICAL("Failed to make udp socket non blocking!");
+		throw std::runtime_error("Failed to make udp socket non blocking!");
+	}
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(remotePort);
+	if (inet_pton(AF_INET, remoteAddress.c_str(), &address.sin_addr) != 1) {
+		closeSocket();
+		LOG_CRITICAL("Invalid remote address {}!", remoteAddress);
+		throw std::runtime_error("Invalid remote address!");
+	}
+	std::memcpy(remote, &address, sizeof(address));
+
+	LOG_DEBUG("Udp socket on port {} talking to {}:{}", localPort, remoteAddress, remotePort);
+}
+
+UdpTransport::~UdpTransport() {
+	closeSocket();
+}
+
+void UdpTransport::closeSocket() {
+#ifdef _WIN32
+	closesocket(static_cast<SOCKET>(socketHandle));
+	if (--winsockUsers == 0) {
+		WSACleanup();
+	}
+#else
+	close(static_cast<int>(socketHandle));
+#endif
+}
+
+void UdpTransport::send(const uint8_t* data, size_t size) {
+	//a full send buffer is just another lost packet to the protocol
+	auto sent = sendto(static_cast<NativeSocket>(socketHandle), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+		reinterpret_cast<const sockaddr*>(remote), sizeof(sockaddr_in));
+	if (sent > 0) {
+		bytesSent += static_cast<uint64_t>(sent);
+	}
+}
+
+bool UdpTransport::receive(std::vector<uint8_t>& packet) {
+	packet.resize(MAX_PACKET_SIZE);
+	while (true) {
+		sockaddr_in from{};
+		socklen_t fromSize = sizeof(from);
+		auto received = recvfrom(static_cast<NativeSocket>(socketHandle), reinterpret_cast<char*>(packet.data()), static_cast<int>(packet.size()), 0,
+			reinterpret_cast<sockaddr*>(&from), &fromSize);
+		if (received < 0) {
+#ifdef _WIN32
+			//an earlier send hit a closed port, or the datagram was too long for the buffer
+			int error = WSAGetLastError();
+			if (error == WSAECONNRESET || error == WSAEMSGSIZE) continue;
+#endif
+			//would block
+			packet.clear();
+			return false;
+		}
+
+		//anyone can send to an open port, only the peer counts
+		if (received == 0) continue;
+		const sockaddr_in& expected = *reinterpret_cast<const sockaddr_in*>(remote);
+		if (from.sin_port != expected.sin_port || from.sin_addr.s_addr != expected.sin_addr.s_addr) {
+			continue;
+		}
+
+		bytesReceived += static_cast<uint64_t>(received);
+		packet.resize(static_cast<size_t>(received));
+		return true;
+	}
+}
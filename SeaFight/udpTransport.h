@@ -0,0 +1,34 @@
+#pragma once
+
+#include "transport.h"
+
+#include <cstdint>
+#include <string>
+
+// non blocking udp socket bound to a local port and talking to a single remote address
+class UdpTransport : public Transport {
+public:
+	// largest datagram received, anything longer is truncated and dropped
+	static constexpr size_t MAX_PACKET_SIZE = 1400;
+
+	UdpTransport(uint16_t localPort, const std::string& remoteAddress, uint16_t remotePort);
+	~UdpTransport();
+
+	UdpTransport(const UdpTransport&) = delete;
+	UdpTransport& operator=(const UdpTransport&) = delete;
+
+	void send(const uint8_t* data, size_t size) override;
+	bool receive(std::vector<uint8_t>& packet) override;
+
+	uint64_t getBytesSent() const { return bytesSent; }
+	uint64_t getBytesReceived() const { return bytesReceived; }
+
+private:
+	// SOCKET on windows, a file descriptor elsewhere
+	uintptr_t socketHandle;
+	uint8_t remote[16];
+	uint64_t bytesSent = 0;
+	uint64_t bytesReceived = 0;
+
+	void closeSocket();
+};
@@ -3,8 +3,9 @@
 #include <iostream>
 #include <fstream>
 
+#include "log.h"
+
 #include <json.hpp>
-#include <spdlog/spdlog.h>
 
 #include <vulkan/vulkan.h>
 
@@ -22,11 +23,12 @@ public:
 		in >> settings;
 
 		if (settings["dev_mode"] == true) {
-			spdlog::set_level(spdlog::level::debug);
+			Log::setLevel(spdlog::level::debug);
 		}
 		else {
-			spdlog::set_level(spdlog::level::info);
+			Log::setLevel(spdlog::level::info);
 		}
+		Log::start();
 	}
 
 	void writeSettings() {
@@ -1,5 +1,7 @@
 #include "window.h"
 
+#include "log.h"
+
 #include <stdexcept>
 
 #include "spdlog/spdlog.h"
@@ -25,6 +27,7 @@ void Window::initWindow() {
 	glfwSetWindowUserPointer(window, this);
 	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
 	glfwSetKeyCallback(window, InputManager::key_callback);
+	glfwSetCursorPosCallback(window, InputManager::mouse_callback);
 }
 
 bool Window::shouldClose() {
@@ -37,7 +40,7 @@ void Window::setWindowShouldClose() {
 
 void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
 	if (glfwCreateWindowSurface(instance, window, nullptr, surface)) {
-		spdlog::critical("Failed to create window surface");
+		LOG_CRITICAL("Failed to create window surface");
 		throw std::runtime_error("createWindowSurface");
 	}
 }